@@ -0,0 +1,27 @@
+ /**
+ *  \file ipcBenchDemo.h
+ *
+ *  \brief Times request round trips between two application tasks and
+ *  prints the average, to compare routing through the command task with
+ *  direct routing, then the same requests with several in flight
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-10 20:05:00 +1000 (Mon, 10 Jun 2013) $
+ *  \warning Busy for a few seconds at application priority while timing
+ *  \bug No Bugs for now
+ *  \note Build once with CMD_DIRECT_ROUTING set to 0 for the old figure
+ */
+
+#ifndef IPC_BENCH_DEMO_H_
+#define IPC_BENCH_DEMO_H_
+
+/**
+ * \brief Initialise IPC Bench Demo application, both the timing task and
+ * the task it sends to
+ *
+ * \param[in] uxPriority Priority for IPC Bench Demo application.
+ */
+void vIpcBenchDemo_Init(unsigned portBASE_TYPE uxPriority);
+
+#endif /* IPC_BENCH_DEMO_H_ */
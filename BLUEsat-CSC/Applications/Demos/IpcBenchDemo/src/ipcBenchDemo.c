@@ -0,0 +1,236 @@
+ /**
+ *  \file ipcBenchDemo.c
+ *
+ *  \brief Times request round trips between two application tasks and
+ *  prints the average, to compare routing through the command task with
+ *  direct routing, then the same requests with several in flight and
+ *  the same operations sent in batches
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-10 20:05:00 +1000 (Mon, 10 Jun 2013) $
+ *  \warning Busy for a few seconds at application priority while timing
+ *  \bug No Bugs for now
+ *  \note Build once with CMD_DIRECT_ROUTING set to 0 for the old figure
+ */
+
+#include "application.h"
+#include "ipcBenchDemo.h"
+#include "debug.h"
+#include "task.h"
+
+#define ECHO_Q_SIZE			4
+//asynchronous requests kept in flight for the pipelined figure
+#define BENCH_IN_FLIGHT		ECHO_Q_SIZE
+//round trips per timing, enough for the tick to resolve a few microseconds
+#define BENCH_ROUNDS		5000
+//batch sizes timed double from 1 up to this
+#define BENCH_MAX_BATCH		16
+#define SLEEP_TIME			60000
+
+//a vector of operations for the echo task, each only gets a result
+typedef struct
+{
+	unsigned portSHORT	usCount;
+	UnivRetCode			*penResults;
+} EchoBatch;
+
+//task tokens for the timing task and the task answering it
+static TaskToken IpcBench_TaskToken;
+static TaskToken IpcEcho_TaskToken;
+
+static UnivRetCode BatchResults[BENCH_MAX_BATCH];
+
+static portTASK_FUNCTION(vIpcBenchTask, pvParameters);
+static portTASK_FUNCTION(vIpcEchoTask, pvParameters);
+static portTickType xBenchPipelined(unsigned portLONG *pulFailed);
+static portTickType xBenchBatched(unsigned portSHORT usBatch, unsigned portLONG *pulOps, unsigned portLONG *pulFailed);
+
+void vIpcBenchDemo_Init(unsigned portBASE_TYPE uxPriority)
+{
+	IpcBench_TaskToken = ActivateTask(TASK_IPC_BENCH_DEMO,
+									"IpcBench",
+									APP_TASK_TYPE,
+									uxPriority,
+									APP_STACK_SIZE,
+									vIpcBenchTask);
+
+	IpcEcho_TaskToken = ActivateTask(TASK_IPC_ECHO_DEMO,
+									"IpcEcho",
+									APP_TASK_TYPE,
+									uxPriority,
+									APP_STACK_SIZE,
+									vIpcEchoTask);
+
+	vActivateQueue(IpcEcho_TaskToken, ECHO_Q_SIZE);
+}
+
+static portTASK_FUNCTION(vIpcBenchTask, pvParameters)
+{
+	(void) pvParameters;
+	MessagePacket outgoing_packet;
+	unsigned portLONG ulRound;
+	unsigned portLONG ulFailed;
+	unsigned portLONG ulOps;
+	unsigned portSHORT usBatch;
+	unsigned portSHORT usLane;
+	LaneStats xLane;
+	portTickType xStart;
+	portTickType xTaken;
+
+	outgoing_packet.Token = IpcBench_TaskToken;
+	outgoing_packet.Src = TASK_IPC_BENCH_DEMO;
+	outgoing_packet.Dest = TASK_IPC_ECHO_DEMO;
+	//no batch, a bare round trip
+	outgoing_packet.Data = 0;
+
+	for ( ; ; )
+	{
+		ulFailed = 0;
+		xStart = xTaskGetTickCount();
+
+		for (ulRound = 0; ulRound < BENCH_ROUNDS; ++ulRound)
+		{
+			if (enProcessRequest(&outgoing_packet, portMAX_DELAY) != URC_SUCCESS) ulFailed++;
+		}
+
+		xTaken = (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+		vDebugPrint(IpcBench_TaskToken, "Direct routing %d, %d ms for %d round trips\n\r",
+					CMD_DIRECT_ROUTING, xTaken, BENCH_ROUNDS);
+		vDebugPrint(IpcBench_TaskToken, "  %d us each, %d failed\n\r",
+					xTaken * 1000 / BENCH_ROUNDS, ulFailed, NO_INSERT);
+
+		xTaken = xBenchPipelined(&ulFailed);
+		vDebugPrint(IpcBench_TaskToken, "%d in flight, %d ms, %d failed\n\r",
+					BENCH_IN_FLIGHT, xTaken, ulFailed);
+
+		for (usBatch = 1; usBatch <= BENCH_MAX_BATCH; usBatch <<= 1)
+		{
+			xTaken = xBenchBatched(usBatch, &ulOps, &ulFailed);
+			vDebugPrint(IpcBench_TaskToken, "Batches of %d, %d us per operation, %d failed\n\r",
+						usBatch, xTaken * 1000 / ulOps, ulFailed);
+		}
+
+		//queueing delay seen by the echo task so far
+		for (usLane = 0; usLane < CMD_NUM_LANES; ++usLane)
+		{
+			vGetLaneStats(TASK_IPC_ECHO_DEMO, (CmdLane)usLane, &xLane);
+			vDebugPrint(IpcBench_TaskToken, "Lane %d, %d taken, %d ticks longest wait\n\r",
+						usLane, xLane.ulTaken, xLane.ulMaxWait);
+		}
+
+		vSleep(SLEEP_TIME);
+	}
+}
+
+//the same number of requests with several submitted ahead of each wait
+static portTickType xBenchPipelined(unsigned portLONG *pulFailed)
+{
+	MessagePacket outgoing_packet;
+	RequestHandle pxHandles[BENCH_IN_FLIGHT];
+	unsigned portLONG ulSubmitted = 0;
+	unsigned portLONG ulDone = 0;
+	portBASE_TYPE xIndex;
+	portTickType xStart;
+
+	outgoing_packet.Token = IpcBench_TaskToken;
+	outgoing_packet.Src = TASK_IPC_BENCH_DEMO;
+	outgoing_packet.Dest = TASK_IPC_ECHO_DEMO;
+	outgoing_packet.Data = 0;
+	*pulFailed = 0;
+
+	xStart = xTaskGetTickCount();
+
+	for (xIndex = 0; xIndex < BENCH_IN_FLIGHT; ++xIndex)
+	{
+		ulSubmitted++;
+		if (enSubmitRequest(&outgoing_packet, portMAX_DELAY, &pxHandles[xIndex]) != URC_SUCCESS)
+		{
+			pxHandles[xIndex] = NULL;
+			(*pulFailed)++;
+			ulDone++;
+		}
+	}
+
+	while (ulDone < BENCH_ROUNDS)
+	{
+		xIndex = xWaitAnyRequest(pxHandles, BENCH_IN_FLIGHT, portMAX_DELAY);
+		if (xIndex < 0) break;
+
+		if (enWaitRequest(pxHandles[xIndex]) != URC_SUCCESS) (*pulFailed)++;
+		pxHandles[xIndex] = NULL;
+		ulDone++;
+
+		if (ulSubmitted < BENCH_ROUNDS)
+		{
+			ulSubmitted++;
+			if (enSubmitRequest(&outgoing_packet, portMAX_DELAY, &pxHandles[xIndex]) != URC_SUCCESS)
+			{
+				pxHandles[xIndex] = NULL;
+				(*pulFailed)++;
+				ulDone++;
+			}
+		}
+	}
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+//whole batches adding up to at most BENCH_ROUNDS operations, one wake up each
+static portTickType xBenchBatched(unsigned portSHORT usBatch, unsigned portLONG *pulOps, unsigned portLONG *pulFailed)
+{
+	MessagePacket outgoing_packet;
+	EchoBatch xBatch;
+	unsigned portSHORT usIndex;
+	portTickType xStart;
+
+	xBatch.usCount = usBatch;
+	xBatch.penResults = BatchResults;
+
+	outgoing_packet.Token = IpcBench_TaskToken;
+	outgoing_packet.Src = TASK_IPC_BENCH_DEMO;
+	outgoing_packet.Dest = TASK_IPC_ECHO_DEMO;
+	outgoing_packet.Data = (unsigned portLONG)&xBatch;
+	*pulFailed = 0;
+
+	xStart = xTaskGetTickCount();
+
+	for (*pulOps = 0; *pulOps + usBatch <= BENCH_ROUNDS; *pulOps += usBatch)
+	{
+		if (enProcessRequest(&outgoing_packet, portMAX_DELAY) != URC_SUCCESS)
+		{
+			*pulFailed += usBatch;
+			continue;
+		}
+		for (usIndex = 0; usIndex < usBatch; ++usIndex)
+		{
+			if (BatchResults[usIndex] != URC_SUCCESS) (*pulFailed)++;
+		}
+	}
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+static portTASK_FUNCTION(vIpcEchoTask, pvParameters)
+{
+	(void) pvParameters;
+	MessagePacket incoming_packet;
+	EchoBatch *pxBatch;
+	unsigned portSHORT usIndex;
+
+	for ( ; ; )
+	{
+		if (enGetRequest(IpcEcho_TaskToken, &incoming_packet, portMAX_DELAY) != URC_SUCCESS) continue;
+
+		//nothing to do, the round trip is what is being timed
+		pxBatch = (EchoBatch *)incoming_packet.Data;
+		if (pxBatch != NULL)
+		{
+			for (usIndex = 0; usIndex < pxBatch->usCount; ++usIndex)
+			{
+				pxBatch->penResults[usIndex] = URC_SUCCESS;
+			}
+		}
+		vCompleteRequest(incoming_packet.Token, URC_SUCCESS);
+	}
+}
@@ -93,6 +93,7 @@ static portTASK_FUNCTION(vMemDemoTask, pvParameters)
 	for ( ; ; )
 	{
 		vShowAllTaskUnusedStack();
+		vShowAllLockStats();
 
 		vSleep(SLEEP_TIME);
 	}
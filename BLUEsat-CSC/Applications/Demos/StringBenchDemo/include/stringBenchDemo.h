@@ -0,0 +1,26 @@
+ /**
+ *  \file stringBenchDemo.h
+ *
+ *  \brief Times memcpy, memset and memcmp from lib_string on the target
+ *  against their byte at a time references and prints the results
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-09 14:30:00 +1000 (Sun, 09 Jun 2013) $
+ *  \warning Busy for a few seconds at application priority while timing
+ *  \bug No Bugs for now
+ *  \note The same sizes and alignments as the host figures printed by
+ *  test_lib_string
+ */
+
+#ifndef STRING_BENCH_DEMO_H_
+#define STRING_BENCH_DEMO_H_
+
+/**
+ * \brief Initialise String Bench Demo application
+ *
+ * \param[in] uxPriority Priority for String Bench Demo application.
+ */
+void vStringBenchDemo_Init(unsigned portBASE_TYPE uxPriority);
+
+#endif /* STRING_BENCH_DEMO_H_ */
@@ -0,0 +1,189 @@
+ /**
+ *  \file stringBenchDemo.c
+ *
+ *  \brief Times memcpy, memset and memcmp from lib_string on the target
+ *  against their byte at a time references, and fmtUnsigned against the
+ *  digit at a time division loop, and prints the results
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-09 14:30:00 +1000 (Sun, 09 Jun 2013) $
+ *  \warning Busy for a few seconds at application priority while timing
+ *  \bug No Bugs for now
+ *  \note The same sizes and alignments as the host figures printed by
+ *  test_lib_string and test_fmtNum
+ */
+
+#include "application.h"
+#include "stringBenchDemo.h"
+#include "lib_string.h"
+#include "fmtNum.h"
+#include "debug.h"
+#include "task.h"
+
+//bytes moved per timing, enough for the tick to resolve the fast versions
+#define BENCH_BYTES			(256UL * 1024)
+#define BENCH_MAX_SIZE		256
+#define BENCH_SIZES			4
+#define BENCH_ALIGNMENTS	3
+#define BENCH_FORMATS		20000
+#define BENCH_VALUES		4
+#define SLEEP_TIME			60000
+
+//task token for accessing services and other applications
+static TaskToken StrBench_TaskToken;
+
+static unsigned portLONG pulSrc[BENCH_MAX_SIZE / sizeof(unsigned portLONG) + 1];
+static unsigned portLONG pulDst[BENCH_MAX_SIZE / sizeof(unsigned portLONG) + 1];
+
+static const unsigned portSHORT pusSizes[BENCH_SIZES] = { 16, 64, 148, 256 };
+//aligned, both off by the same amount, never lining up
+static const unsigned portCHAR pucSrcOff[BENCH_ALIGNMENTS] = { 0, 3, 3 };
+static const unsigned portCHAR pucDstOff[BENCH_ALIGNMENTS] = { 0, 3, 1 };
+//volatile so the values are not folded into the loops
+static volatile unsigned portLONG pulValues[BENCH_VALUES] = { 7, 1234, 65535, 3000000000UL };
+
+static portTASK_FUNCTION(vStrBenchTask, pvParameters);
+static portTickType xBenchCopy(void * (*pvCopy)(void *, const void *, unsigned long),
+								unsigned portCHAR *pucDst, const unsigned portCHAR *pucSrc,
+								unsigned portSHORT usSize);
+static portTickType xBenchSet(void * (*pvSet)(void *, int, unsigned long),
+								unsigned portCHAR *pucDst, unsigned portSHORT usSize);
+static portTickType xBenchCompare(int (*iCompare)(const void *, const void *, unsigned long),
+								const unsigned portCHAR *pucA, const unsigned portCHAR *pucB,
+								unsigned portSHORT usSize);
+static portTickType xBenchFormat(unsigned int (*uiFormat)(char *, unsigned int, unsigned int),
+								unsigned portLONG ulValue);
+static unsigned int uiDivisionLoop(char *pcOut, unsigned int uiValue, unsigned int uiMinDigits);
+
+void vStringBenchDemo_Init(unsigned portBASE_TYPE uxPriority)
+{
+	StrBench_TaskToken = ActivateTask(TASK_STRING_BENCH_DEMO,
+									"StringBench",
+									APP_TASK_TYPE,
+									uxPriority,
+									APP_STACK_SIZE,
+									vStrBenchTask);
+}
+
+static portTASK_FUNCTION(vStrBenchTask, pvParameters)
+{
+	(void) pvParameters;
+	unsigned portCHAR *pucSrc = (unsigned portCHAR *)pulSrc;
+	unsigned portCHAR *pucDst = (unsigned portCHAR *)pulDst;
+	unsigned portCHAR ucSize;
+	unsigned portCHAR ucAlign;
+	unsigned portSHORT usSize;
+
+	for ( ; ; )
+	{
+		vDebugPrint(StrBench_TaskToken, "ms per %d bytes, byte loop then word version\n\r", BENCH_BYTES, NO_INSERT, NO_INSERT);
+
+		for (ucSize = 0; ucSize < BENCH_SIZES; ++ucSize)
+		{
+			usSize = pusSizes[ucSize];
+			for (ucAlign = 0; ucAlign < BENCH_ALIGNMENTS; ++ucAlign)
+			{
+				vDebugPrint(StrBench_TaskToken, "memcpy %d bytes src+%d dst+%d\n\r",
+							usSize, pucSrcOff[ucAlign], pucDstOff[ucAlign]);
+				vDebugPrint(StrBench_TaskToken, "  %d %d\n\r",
+							xBenchCopy(memcpy_byte, &pucDst[pucDstOff[ucAlign]], &pucSrc[pucSrcOff[ucAlign]], usSize),
+							xBenchCopy(memcpy, &pucDst[pucDstOff[ucAlign]], &pucSrc[pucSrcOff[ucAlign]], usSize),
+							NO_INSERT);
+			}
+
+			vDebugPrint(StrBench_TaskToken, "memset %d bytes\n\r", usSize, NO_INSERT, NO_INSERT);
+			vDebugPrint(StrBench_TaskToken, "  %d %d\n\r",
+						xBenchSet(memset_byte, pucDst, usSize),
+						xBenchSet(memset, pucDst, usSize),
+						NO_INSERT);
+
+			//equal buffers, so every byte is looked at
+			memset(pucSrc, 0x5A, usSize);
+			memset(pucDst, 0x5A, usSize);
+			vDebugPrint(StrBench_TaskToken, "memcmp %d bytes\n\r", usSize, NO_INSERT, NO_INSERT);
+			vDebugPrint(StrBench_TaskToken, "  %d %d\n\r",
+						xBenchCompare(memcmp_byte, pucDst, pucSrc, usSize),
+						xBenchCompare(memcmp, pucDst, pucSrc, usSize),
+						NO_INSERT);
+		}
+
+		vDebugPrint(StrBench_TaskToken, "ms per %d numbers, division loop then table\n\r", BENCH_FORMATS, NO_INSERT, NO_INSERT);
+
+		for (ucSize = 0; ucSize < BENCH_VALUES; ++ucSize)
+		{
+			vDebugPrint(StrBench_TaskToken, "  %d: %d %d\n\r",
+						pulValues[ucSize],
+						xBenchFormat(uiDivisionLoop, pulValues[ucSize]),
+						xBenchFormat(fmtUnsigned, pulValues[ucSize]));
+		}
+
+		vSleep(SLEEP_TIME);
+	}
+}
+
+static portTickType xBenchCopy(void * (*pvCopy)(void *, const void *, unsigned long),
+								unsigned portCHAR *pucDst, const unsigned portCHAR *pucSrc,
+								unsigned portSHORT usSize)
+{
+	unsigned portLONG ulRounds = BENCH_BYTES / usSize;
+	portTickType xStart = xTaskGetTickCount();
+
+	while (ulRounds--) pvCopy(pucDst, pucSrc, usSize);
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+static portTickType xBenchSet(void * (*pvSet)(void *, int, unsigned long),
+								unsigned portCHAR *pucDst, unsigned portSHORT usSize)
+{
+	unsigned portLONG ulRounds = BENCH_BYTES / usSize;
+	portTickType xStart = xTaskGetTickCount();
+
+	while (ulRounds--) pvSet(pucDst, (int)ulRounds, usSize);
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+static portTickType xBenchCompare(int (*iCompare)(const void *, const void *, unsigned long),
+								const unsigned portCHAR *pucA, const unsigned portCHAR *pucB,
+								unsigned portSHORT usSize)
+{
+	unsigned portLONG ulRounds = BENCH_BYTES / usSize;
+	portTickType xStart = xTaskGetTickCount();
+
+	while (ulRounds--) iCompare(pucA, pucB, usSize);
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+static portTickType xBenchFormat(unsigned int (*uiFormat)(char *, unsigned int, unsigned int),
+								unsigned portLONG ulValue)
+{
+	portCHAR pcBuffer[FMT_UNSIGNED_MAX_LEN];
+	unsigned portLONG ulRounds = BENCH_FORMATS;
+	portTickType xStart = xTaskGetTickCount();
+
+	while (ulRounds--) uiFormat(pcBuffer, ulValue, 0);
+
+	return (xTaskGetTickCount() - xStart) * portTICK_RATE_MS;
+}
+
+//what vPrintDecimal used to do
+static unsigned int uiDivisionLoop(char *pcOut, unsigned int uiValue, unsigned int uiMinDigits)
+{
+	char pcScratch[FMT_UNSIGNED_MAX_LEN];
+	unsigned int uiPos = 0;
+	unsigned int uiLength = 0;
+
+	(void) uiMinDigits;
+	do
+	{
+		pcScratch[uiPos++] = '0' + uiValue % 10;
+		uiValue /= 10;
+	}
+	while (uiValue > 0);
+
+	while (uiPos > 0) pcOut[uiLength++] = pcScratch[--uiPos];
+	return uiLength;
+}
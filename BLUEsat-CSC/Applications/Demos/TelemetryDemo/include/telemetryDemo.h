@@ -2,11 +2,13 @@
 #define TELEMETRYDEMO_H_
 
 #define TELEM_DEMO_SENSOR_COUNT 40
+#define TELEM_DEMO_RANGE_MAX 4
 
 typedef enum
 {
 	TELEM_DEMO_READ_SINGLE = 1,
-	TELEM_DEMO_READ_LATEST
+	TELEM_DEMO_READ_LATEST,
+	TELEM_DEMO_READ_RANGE
 } TelemDemoCalls;
 
 struct telem_demo_storage_entry_t
@@ -14,6 +14,11 @@
 static TaskToken telemDemoTaskToken;
 static telem_command_t command;
 
+/* Range reads go out as one batch, too big for the task stack. */
+static telem_command_t rangeCommands[TELEM_DEMO_RANGE_MAX];
+static UnivRetCode rangeResults[TELEM_DEMO_RANGE_MAX];
+static struct telem_demo_storage_entry_t rangeEntries[TELEM_DEMO_RANGE_MAX];
+
 static portTASK_FUNCTION(vTelemDemoTask, pvParameters);
 
 static inline UnivRetCode
@@ -33,6 +38,8 @@ vTelemPrintMenu(void)
 				NO_INSERT, NO_INSERT);
 	vDebugPrint(telemDemoTaskToken, "(2): Read latest sensor (no arg)\n\r", NO_INSERT,
 				NO_INSERT, NO_INSERT);
+	vDebugPrint(telemDemoTaskToken, "(3): Read range (index[arg0], count[arg1] up to %d)\n\r",
+				TELEM_DEMO_RANGE_MAX, NO_INSERT, NO_INSERT);
 }
 
 static void
@@ -74,6 +81,22 @@ vTelemReadLatest(struct telem_demo_storage_entry_t *entry,
     enTelemMessageSend(token);
 }
 
+static unsigned int
+uxTelemReadRange(int index, unsigned int count, TaskToken token)
+{
+    unsigned int i;
+
+    if (count > TELEM_DEMO_RANGE_MAX) count = TELEM_DEMO_RANGE_MAX;
+    for (i = 0; i < count; i++) {
+        rangeCommands[i].operation = TELEM_READ_SINGLE;
+        rangeCommands[i].index = index + i;
+        rangeCommands[i].buffer = (char*)&rangeEntries[i];
+        rangeCommands[i].size = sizeof(struct telem_demo_storage_entry_t);
+    }
+    enTelemBatch(token, rangeCommands, count, rangeResults);
+    return count;
+}
+
 static void
 vTelemPrintResult(struct telem_demo_storage_entry_t *entry)
 {
@@ -92,6 +115,8 @@ portTASK_FUNCTION(vTelemDemoTask, pvParameters)
 	unsigned int usReadLen;
 	unsigned int commandBuffer[TELEM_INPUT_BUFFER_SIZE - 1];
 	struct telem_demo_storage_entry_t entry;
+	unsigned int rangeCount;
+	unsigned int i;
 
 	vDebugPrint(telemDemoTaskToken, "%s", (unsigned portLONG)TELEM_CLEAR_SCREEN,
 			NO_INSERT, NO_INSERT);
@@ -127,6 +152,14 @@ portTASK_FUNCTION(vTelemDemoTask, pvParameters)
 							NO_INSERT, NO_INSERT);
 				vTelemReadLatest(&entry, telemDemoTaskToken);
 				break;
+			case TELEM_DEMO_READ_RANGE:
+				rangeCount = uxTelemReadRange(commandBuffer[1], commandBuffer[2], telemDemoTaskToken);
+				for (i = 0; i < rangeCount; i++) {
+					vDebugPrint(telemDemoTaskToken, "Entry %d result %d\n\r",
+							(unsigned portLONG)(commandBuffer[1] + i), rangeResults[i], NO_INSERT);
+					if (rangeResults[i] == URC_SUCCESS) vTelemPrintResult(&rangeEntries[i]);
+				}
+				continue;
 			default:
 				/* Should never get here. */
 				break;
@@ -21,6 +21,7 @@
 #include "FreeRTOS.h"
 #include "DTMF_Common.h"
 
+//tone ring, a power of two
 #define DTMF_SIZE 64
 
 /**
@@ -28,5 +29,16 @@
  */
 void Comms_DTMF_Init(void);
 
+/**
+ * \brief Take the tones received since the last call, oldest first. Only
+ * one task may read them.
+ *
+ * \param[out] pcTones Destination, one tone value 0 to 15 a byte
+ * \param[in] usMax Room in pcTones
+ *
+ * \returns Tones copied
+ */
+unsigned portSHORT Comms_DTMF_Read(portCHAR *pcTones, unsigned portSHORT usMax);
+
 
 #endif /* COMMS_DTMF_H_ */
@@ -29,7 +29,9 @@
 #include "command.h"
 #include "UniversalReturnCode.h"
 #include "switching.h"
+#include "channel.h"
 #include "debug.h"
+#include "ring.h"
 
 
 /* DTMF  Settings*/
@@ -80,16 +82,23 @@ enum eBoolean {
 */
 typedef enum eBoolean Boolean;
 
-char DTMF_BUFF[DTMF_SIZE];
-int DTMF_BUFF_SP = 0; //Start position
-int DTMF_BUFF_EP = 0; //End position
+//tones for the downlink, filled here and drained by the comms task
+static unsigned char DTMF_BUFF[DTMF_SIZE];
+static ringBuffer xDtmfRing;
+//tones are paired into a command code, first of the pair held here
+static unsigned char ucFirstTone;
+static unsigned char ucTonesHeld = 0;
 int num = 0;
 
+static void vDtmfPushTone(unsigned char ucTone, portBASE_TYPE *pxHigherPriorityTaskWoken);
+
 void Comms_DTMF_Init(void)
 {
 	/*Set up Queue and content counter*/
 	//DTMF_BUFF = xQueueCreate( DTMF_BUFF_LENGTH, ( unsigned portBASE_TYPE ) sizeof( DtmfTone ) );
 
+	ringInit(&xDtmfRing, DTMF_BUFF, DTMF_SIZE);
+
 	//disable EXT3 interrupt first, noting all P[2] GPIO pins share EXT3 Interrupt
 	VICIntEnable &= ~BIT(17);
 
@@ -192,8 +201,7 @@ void Comms_DTMF_Handler (void)
          tone.tone = (getGPIO(2,9))+(getGPIO(2,8)<<1)+(getGPIO(2,7)<<2)+(getGPIO(2,6)<<3);
 
     	 if (num == 1){
-    		 DTMF_BUFF[DTMF_BUFF_EP] = tone.tone;
-			 DTMF_BUFF_EP = (DTMF_BUFF_EP+1)%DTMF_SIZE;
+    		 vDtmfPushTone(tone.tone, &xHigherPriorityTaskWoken);
     	 }
          //xQueueSendFromISR(DTMF_BUFF,&tone,&xHigherPriorityTaskWoken);
          bPriDecodeFailed = false;
@@ -203,31 +211,16 @@ void Comms_DTMF_Handler (void)
       {//Check if the second decoder is ready
          tone.decoder = DTMF_DECODER2;
          tone.tone = (getGPIO(2,4))+(getGPIO(2,3)<<1)+(getGPIO(2,2)<<2)+(getGPIO(2,1)<<3);
-    	  DTMF_BUFF[DTMF_BUFF_EP] = tone.tone;
+         vDtmfPushTone(tone.tone, &xHigherPriorityTaskWoken);
          //xQueueSendFromISR(DTMF_BUFF,&tone,&xHigherPriorityTaskWoken);
-    	  DTMF_BUFF_EP = (DTMF_BUFF_EP+1)%DTMF_SIZE;
       }
       if ((FIO2PIN&(DTMF_INT_1)) && bPriDecodeFailed)
       {// If the first decoder was not ready try it again
          tone.decoder = DTMF_DECODER1;
          tone.tone = (getGPIO(2,9))+(getGPIO(2,8)<<1)+(getGPIO(2,7)<<2)+(getGPIO(2,6)<<3);
-          DTMF_BUFF[DTMF_BUFF_EP] = tone.tone;
-          DTMF_BUFF_EP = (DTMF_BUFF_EP+1)%DTMF_SIZE;
+         vDtmfPushTone(tone.tone, &xHigherPriorityTaskWoken);
          //xQueueSendFromISR(DTMF_BUFF,&tone,&xHigherPriorityTaskWoken);
       }
-      if (DTMF_BUFF_EP%2==0){
-    	  // Push the tone to the Command task
-		  MessagePacket outgoingPacket;
-		  outgoingPacket.Src         = TASK_COMMAND; // XXX: Pretend we are the Command task, since we're not really a task
-		  outgoingPacket.Dest        = TASK_COMMAND;
-		  outgoingPacket.Token       = enGetTaskToken(TASK_COMMAND);
-		  if(DTMF_BUFF_EP != 0){
-			  outgoingPacket.Data = DTMF_BUFF[DTMF_BUFF_EP-2]*16+DTMF_BUFF[DTMF_BUFF_EP-1]; // We don't care about the decoder
-		  } else {
-			  outgoingPacket.Data = DTMF_BUFF[DTMF_SIZE-2]*16+DTMF_BUFF[DTMF_SIZE-1];
-		  }
-		  UnivRetCode ret = dtmfRequest(&outgoingPacket);
-      }
    }
 
 
@@ -238,6 +231,32 @@ void Comms_DTMF_Handler (void)
 
 }
 
+/*
+ * Interrupt context. The tone is kept for the downlink echo, dropped if the
+ * comms task has fallen behind, and every second tone completes a command
+ * code for the command task.
+ */
+static void vDtmfPushTone(unsigned char ucTone, portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+   ringPutByte(&xDtmfRing, ucTone);
+
+   if (ucTonesHeld == 0)
+   {
+      ucFirstTone = ucTone;
+      ucTonesHeld = 1;
+      return;
+   }
+   ucTonesHeld = 0;
+
+   // Onto the command task's event ring, we don't care about the decoder
+   enPostEventFromISR(CMD_EVT_DTMF, ucFirstTone*16+ucTone, pxHigherPriorityTaskWoken);
+}
+
+unsigned portSHORT Comms_DTMF_Read(portCHAR *pcTones, unsigned portSHORT usMax)
+{
+   return (unsigned portSHORT)ringPop(&xDtmfRing, (unsigned char *)pcTones, usMax);
+}
+
 // void Comms_DTMF_Wrapper(void)
 // Renamed to GPIO handler to make it a generic handler of GPIO interrupts
 // Check the interrupt pins here and call the appropriate functions
@@ -249,17 +268,12 @@ void GPIO_Handler(void)
    if (FIO2PIN&DTMF_INT_PINS_SIN) {//Will only be necessary/have effect if we have other GPIO Interrupt sources
        Comms_DTMF_Handler();
        IO2IntClr = DTMF_INT_PINS_SIN;//clear the GPIO interrupts
-   } else if (IO0IntStatR & BIT(17) || IO0IntStatR & BIT(20)){
-       // Rising edge of DET pin on modem
-       // Turn on the switching circuit from TX -> RX
-       switching_OPMODE(REPEATER_MODE);
-       IO0IntClr = BIT(17) | BIT(20);//clear the GPIO interrupts
-   } else if (IO0IntStatF & BIT(17) || IO0IntStatF & BIT(20)){
-       // Falling edge of DET pin on modem
-       // Turn off switching circuit from TX -> RX
-       switching_OPMODE(DEVICE_MODE);
-       switching_RX_Device(GMSK_1);
-       IO0IntClr = BIT(17) | BIT(20);//clear the GPIO interrupts
+   } else if ((IO0IntStatR | IO0IntStatF) & CHANNEL_DET_PINS){
+       // Edge of DET pin on modem, the channel layer tracks carrier and
+       // switches TX -> RX through the repeater unless we are keyed up
+       vChannel_CarrierEdgeFromISR(IO0IntStatR & CHANNEL_DET_PINS,
+                                   IO0IntStatF & CHANNEL_DET_PINS);
+       IO0IntClr = CHANNEL_DET_PINS;//clear the GPIO interrupts
    }
    EXTINT|= 0x1<<3;//clear the intterupt
    VICVectAddr =0;
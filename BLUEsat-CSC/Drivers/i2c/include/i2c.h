@@ -28,6 +28,7 @@
 #ifndef I2C_H_
 #define I2C_H_
 #include "semphr.h"
+#include "lock.h"
 
 /*
  * Address of Devices
@@ -180,5 +181,24 @@ signed portBASE_TYPE Comms_I2C_Slave(I2C_SLAVE_MODE mode, volatile portCHAR * lo
  */
 signed portBASE_TYPE Comms_I2C_Slave_Clear(I2C_BUS_CHOICE bus , I2C_SLAVE_MODE mode);
 
+/**
+ * \brief Hold a bus for a sequence of master operations, such as a 1-wire
+ * transaction through a bridge, so other tasks cannot slip operations in
+ * between. Single operations do not need it.
+ *
+ * \param[in] bus Bus to hold
+ * \param[in] xBlockTime Time to wait, in ticks
+ *
+ * \returns pdPASS once held or pdFAIL if the wait timed out
+ */
+signed portBASE_TYPE Comms_I2C_Lock(I2C_BUS_CHOICE bus, portTickType xBlockTime);
+
+/**
+ * \brief Give a bus held with Comms_I2C_Lock back
+ *
+ * \param[in] bus Bus to release
+ */
+void Comms_I2C_Unlock(I2C_BUS_CHOICE bus);
+
 
 #endif /* I2C_H_ */
@@ -123,6 +123,8 @@ static volatile Bus_Master_Ctrl Bus_M_Ctrl[I2C_MAX_BUS];
 static volatile Bus_Slave_Ctrl 	Bus_S_Ctrl[I2C_MAX_BUS];
 static xQueueHandle 			I2C_Bus[I2C_MAX_BUS];
 static portCHAR 				I2C_Bus_Free;
+static Lock						I2C_Lock[I2C_MAX_BUS];
+static const portCHAR * const	I2C_Lock_Name[I2C_MAX_BUS] = {"I2C0", "I2C1", "I2C2"};
 
 /*-----------------------------------------------------------*/
 /*Internal functions*/
@@ -213,6 +215,10 @@ void Comms_I2C_Init(void)
 		}
 	}
 	taskEXIT_CRITICAL();
+
+	for (count=0; count<I2C_MAX_BUS;count++){
+		xLockCreate(&I2C_Lock[count], I2C_Lock_Name[count]);
+	}
 }
 
 
@@ -591,6 +597,28 @@ signed portBASE_TYPE Comms_I2C_Slave_Clear(I2C_BUS_CHOICE bus , I2C_SLAVE_MODE m
 	return outcome;
 }
 
+/*-----------------------------------------------------------*/
+
+/*
+ * 	Bus Lock
+ *
+ * 	Held by a task across a sequence of master operations. The driver
+ * 	itself never takes it, operations queue as before whether or not
+ * 	the caller holds the bus.
+ *
+ * */
+
+signed portBASE_TYPE Comms_I2C_Lock(I2C_BUS_CHOICE bus, portTickType xBlockTime)
+{
+	if (bus>=I2C_MAX_BUS) return pdFAIL;
+	return xLockTake(&I2C_Lock[bus], xBlockTime);
+}
+
+void Comms_I2C_Unlock(I2C_BUS_CHOICE bus)
+{
+	if (bus<I2C_MAX_BUS) vLockGive(&I2C_Lock[bus]);
+}
+
 
 /*--------------------------------------------------------*
  * The Following functions are called from within the ISR *
@@ -0,0 +1,64 @@
+/**
+ *  \file afskDac.h
+ *
+ *  \brief Software AFSK transmit path through the on-chip DAC
+ *
+ *  Timer 2 clocks samples from the afsk library out of AOUT (P0.26) at
+ *  AFSK_DAC_RATE. It takes the same NRZI bitstream the modem chips are
+ *  fed, so frames built for Comms_Modem_Queue_Frame can be sent here
+ *  instead, and higher rates need no new hardware.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-28 19:40:00 +1000 (Tue, 28 May 2013) $
+ *  \warning The sample clock is divided from the same 9MHz peripheral clock
+ *  the modem timer assumes, so the baud rate is 0.16% fast
+ *  \bug No Bugs for now
+ *  \note Scripts/bert_check.pl decodes wav dumps of the same synthesiser,
+ *  see the afsk library tests
+ *  \note Not started at boot, nothing downlinks through it yet. Whoever
+ *  takes it on calls Comms_AfskDac_Init first, it claims timer 2, VIC
+ *  channel 26 and P0.26.
+ */
+
+#ifdef APPLICATION_H_
+	#error "Applications should access drivers via services!"
+#endif
+
+#ifndef AFSKDAC_H_
+#define AFSKDAC_H_
+
+#include "FreeRTOS.h"
+#include "afsk.h"
+
+#define AFSK_DAC_INTERRUPTS		( ( unsigned portCHAR ) 26 )
+//32 samples a bit at 1200 baud, 8 at 4800
+#define AFSK_DAC_RATE			38400
+
+/**
+ * \brief Power up the DAC and timer 2 and park the output at mid scale
+ */
+void Comms_AfskDac_Init(void);
+
+/**
+ * \brief Start sending a bitstream. Returns straight away, the buffer must
+ * stay valid until Comms_AfskDac_Wait says it has gone out.
+ *
+ * \param[in] pcData Encoded bitstream, LSB first
+ * \param[in] usLength Bytes to send
+ * \param[in] enRate Tone set and baud rate
+ *
+ * \returns pdTRUE if started, pdFALSE if a bitstream is still being sent
+ */
+signed portBASE_TYPE Comms_AfskDac_Send(const portCHAR *pcData, unsigned portSHORT usLength, afskRate enRate);
+
+/**
+ * \brief Wait for the bitstream being sent to finish
+ *
+ * \param[in] xBlockTime Longest time to wait
+ *
+ * \returns pdTRUE once the DAC is idle
+ */
+signed portBASE_TYPE Comms_AfskDac_Wait(portTickType xBlockTime);
+
+#endif /* AFSKDAC_H_ */
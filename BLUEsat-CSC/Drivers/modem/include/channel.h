@@ -0,0 +1,118 @@
+/**
+ *  \file channel.h
+ *
+ *  \brief Carrier-sense channel access for the half-duplex AFSK link
+ *
+ *  The DET (energy detect) outputs of the two modems raise GPIO edge
+ *  interrupts on P0.17 and P0.20. The GPIO handler feeds those edges
+ *  in here so the channel-busy state is known at all times. Before
+ *  keying up, a transmitter calls enChannel_Acquire which performs
+ *  p-persistent CSMA in slot time units, and vChannel_Release once the
+ *  modem has drained. Claims are counted, so one holder releasing does
+ *  not free the channel under another.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-18 14:10:00 +1000 (Sat, 18 May 2013) $
+ *  \warning Occupancy is sampled from task context, so it has slot
+ *  time resolution rather than edge resolution
+ *  \bug No Bugs for now
+ *  \note While we hold the channel, DET edges are recorded but do not
+ *  switch the RF path over to repeater mode
+ */
+
+#ifdef APPLICATION_H_
+	#error "Applications should access drivers via services!"
+#endif
+
+#ifndef CHANNEL_H_
+#define CHANNEL_H_
+
+#include "FreeRTOS.h"
+#include "UniversalReturnCode.h"
+
+//DET lines of AFSK 1 and AFSK 2 on port 0
+#define CHANNEL_DET_PINS			((unsigned portLONG)((0x1 << 17) | (0x1 << 20)))
+
+//default slot time in ticks and persistence (p = (value+1)/256)
+#define CHANNEL_DEF_SLOT_TIME		100
+#define CHANNEL_DEF_PERSISTENCE		63
+
+//longest time a transmitter will defer before forcing the channel
+#define CHANNEL_DEF_MAX_WAIT		3000
+
+typedef struct
+{
+	unsigned portLONG	ulCarrierCount;		//busy transitions seen on DET
+	unsigned portLONG	ulObservedTicks;	//ticks covered by the statistics
+	unsigned portLONG	ulBusyTicks;		//ticks someone else held the channel
+	unsigned portLONG	ulTxTicks;			//ticks we held the channel
+	unsigned portLONG	ulTxCount;			//successful acquisitions
+	unsigned portLONG	ulDeferrals;		//slots deferred because of carrier
+	unsigned portLONG	ulBackoffs;			//slots lost to the persistence draw
+	unsigned portLONG	ulForced;			//acquisitions that timed out
+	unsigned portCHAR	ucOccupancy;		//busy percentage of observed time
+} ChannelStats;
+
+/**
+ * \brief Reset channel state and statistics. Call once at start up
+ * after the DET interrupts are configured.
+ */
+void vChannel_Init(void);
+
+/**
+ * \brief Set CSMA parameters
+ *
+ * \param[in] xSlotTime Slot time in ticks, 0 keeps the current value
+ * \param[in] ucPersistence Persistence, transmit with p = (value+1)/256
+ */
+void vChannel_SetParams(portTickType xSlotTime, unsigned portCHAR ucPersistence);
+
+/**
+ * \brief Record DET edges. Must only be called from the GPIO interrupt.
+ *
+ * \param[in] ulRising DET pins with a pending rising edge
+ * \param[in] ulFalling DET pins with a pending falling edge
+ */
+void vChannel_CarrierEdgeFromISR(unsigned portLONG ulRising, unsigned portLONG ulFalling);
+
+/**
+ * \brief Check for carrier on any DET line
+ *
+ * \returns pdTRUE if the channel is busy
+ */
+portBASE_TYPE xChannel_IsBusy(void);
+
+/**
+ * \brief Check if we are currently holding the channel
+ *
+ * \returns pdTRUE between enChannel_Acquire and vChannel_Release
+ */
+portBASE_TYPE xChannel_IsTransmitting(void);
+
+/**
+ * \brief Wait for a clear channel using p-persistent CSMA and claim it
+ *
+ * \param[in] xMaxWait Ticks to defer before giving up
+ *
+ * \returns URC_SUCCESS when the channel was clear, URC_BUSY when the wait
+ * timed out. The channel is claimed in both cases so a stuck DET line
+ * can not silence the spacecraft. A channel we already hold is joined at
+ * once with URC_SUCCESS.
+ */
+UnivRetCode enChannel_Acquire(portTickType xMaxWait);
+
+/**
+ * \brief Drop one claim after the modem has finished sending, the channel
+ * is freed with the last
+ */
+void vChannel_Release(void);
+
+/**
+ * \brief Take a snapshot of channel statistics
+ *
+ * \param[out] pxStats Destination for the snapshot
+ */
+void vChannel_GetStats(ChannelStats *pxStats);
+
+#endif /* CHANNEL_H_ */
@@ -24,12 +24,32 @@
 #define CLEAR_VIC_INTERRUPT		( ( unsigned portLONG ) 0 )
 
 #define MAX_INFO_SIZE						256
-#define BUFFER_SIZE						(20+MAX_INFO_SIZE)
+//character ring, a power of two with room for a full frame
+#define BUFFER_SIZE						512
 
 #define MODEM_1 1
 #define MODEM_2 2
 
 #define MODEM_NO_BLOCK 0
+//ticks to wait for TX_BUFF space, several bytes drain in this time at 1200 bps
+#define MODEM_WRITE_BLOCK 100
+
+//frames the timer interrupt can have lined up behind the current one
+#define MODEM_FRAME_Q_SIZE 4
+
+/**
+ * \brief Called from the timer interrupt once the last bit of a queued frame
+ * has gone out. Must be ISR safe and set *pxHigherPriorityTaskWoken if it
+ * wakes a task.
+ */
+typedef void (*ModemTxDoneHook)(void *pvTag, signed portBASE_TYPE *pxHigherPriorityTaskWoken);
+
+typedef struct
+{
+	const portCHAR		*pcData;	//owner keeps this valid until the hook runs
+	unsigned portSHORT	usLength;
+	void				*pvTag;		//handed back to the hook
+} ModemFrame;
 
 void Comms_Modem_Timer_Init(void);
 
@@ -40,4 +60,32 @@ void setModemTransmit(portSHORT sel);
 void setModemReceive(portSHORT sel);
 void modem_takeSemaphore(void);
 void modem_giveSemaphore(void);
+
+/**
+ * \brief Queue a frame to be sent from the caller's buffer without copying.
+ * Frames follow each other with no idle gap between them.
+ *
+ * \param[in] pcData Encoded bitstream, NRZI is applied by the modem
+ * \param[in] usLength Bytes to send
+ * \param[in] pvTag Passed to the tx done hook when the frame has gone out
+ *
+ * \returns pdTRUE if queued, pdFALSE if MODEM_FRAME_Q_SIZE frames are pending
+ */
+signed portBASE_TYPE Comms_Modem_Queue_Frame(const portCHAR *pcData, unsigned portSHORT usLength, void *pvTag);
+
+/**
+ * \brief Register the completion hook for queued frames
+ *
+ * \param[in] pxHook Hook run from the timer interrupt, NULL to disable
+ */
+void Comms_Modem_Set_TxDone_Hook(ModemTxDoneHook pxHook);
+
+/**
+ * \brief Check if the modem is still keyed, a frame queued now follows the
+ * last one without a gap. Call inside a critical section to keep the
+ * answer true until the next frame is queued.
+ *
+ * \returns pdTRUE while a frame or ring character is being sent or waiting
+ */
+portBASE_TYPE Comms_Modem_Is_Sending(void);
 #endif /* MODEM_H_ */
@@ -0,0 +1,125 @@
+/**
+ *  \file afskDac.c
+ *
+ *  \brief Software AFSK transmit path through the on-chip DAC
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-28 19:40:00 +1000 (Tue, 28 May 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note The next sample is worked out ahead of time so every interrupt
+ *  writes the DAC at the same point after the timer match
+ */
+
+#include "FreeRTOS.h"
+#include "lpc24xx.h"
+#include "afskDac.h"
+#include "modem.h"
+#include "irq.h"
+#include "gpio.h"
+#include "semphr.h"
+#include "task.h"
+
+#define AFSK_DAC_PCLK			9000000
+#define AFSK_DAC_AOUT_FUNC		2
+#define AFSK_DAC_VALUE_SHIFT	6
+
+static afskMod xModulator;
+static volatile unsigned portSHORT usNextSample = AFSK_DAC_MID;
+static xSemaphoreHandle xDacDone;
+
+void Comms_AfskDac_Timer_Handler(void);
+void Comms_AfskDac_Timer_Wrapper( void ) __attribute__ ((naked));
+
+void Comms_AfskDac_Timer_Handler(void)
+{
+	signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+	DACR = usNextSample << AFSK_DAC_VALUE_SHIFT;
+
+	if (afskBusy(&xModulator))
+	{
+		usNextSample = afskSample(&xModulator);
+	}
+	else
+	{
+		//last sample is out, park at mid scale and stop the clock
+		usNextSample = AFSK_DAC_MID;
+		DACR = AFSK_DAC_MID << AFSK_DAC_VALUE_SHIFT;
+		T2TCR = 0;
+		disable_VIC_irq(AFSK_DAC_INTERRUPTS);
+		xSemaphoreGiveFromISR(xDacDone, &xHigherPriorityTaskWoken);
+	}
+
+	T2IR = 0xFF;
+	/* Clear the ISR in the VIC. */
+	VICVectAddr = CLEAR_VIC_INTERRUPT;
+
+	if (xHigherPriorityTaskWoken)
+	{
+		portYIELD_FROM_ISR();
+	}
+}
+
+void Comms_AfskDac_Timer_Wrapper( void )
+{
+	portSAVE_CONTEXT();		// Save the context
+	Comms_AfskDac_Timer_Handler();
+	portRESTORE_CONTEXT(); 	// Restore the context
+}
+
+void Comms_AfskDac_Init(void)
+{
+	// step 1: turn on the power for timer 2, the DAC is always powered
+	PCONP = PCONP | (0x1 << 22);
+
+	// step 2: timer 2 and DAC peripheral clocks to CCLK / 4
+	PCLKSEL1 = PCLKSEL1 & (~(0x3 << 12));
+	PCLKSEL0 = PCLKSEL0 & (~(0x3 << 22));
+
+	// step 3: P0.26 to AOUT and park it at mid scale
+	set_Gpio_func(0, 26, AFSK_DAC_AOUT_FUNC);
+	DACR = AFSK_DAC_MID << AFSK_DAC_VALUE_SHIFT;
+
+	// step 4: interrupt and reset on MR0, one match a sample
+	T2TCR = 0;
+	T2CTCR = T2CTCR & (~(0x3));
+	T2PR = 0;
+	T2MR0 = AFSK_DAC_PCLK / AFSK_DAC_RATE - 1;
+	T2MCR = 3;
+	T2IR = 0xFF;
+	install_irq(AFSK_DAC_INTERRUPTS, Comms_AfskDac_Timer_Wrapper, HIGHEST_PRIORITY);
+	disable_VIC_irq(AFSK_DAC_INTERRUPTS);
+
+	vSemaphoreCreateBinary(xDacDone);
+	afskInit(&xModulator, AFSK_1200, AFSK_DAC_RATE);
+}
+
+signed portBASE_TYPE Comms_AfskDac_Send(const portCHAR *pcData, unsigned portSHORT usLength, afskRate enRate)
+{
+	if (pcData == NULL || usLength == 0) return pdFALSE;
+	if (T2TCR & 0x1) return pdFALSE;
+
+	//the phase accumulator carries on from the last bitstream unless the rate changes
+	if (xModulator.baud != (1200u << enRate))
+	{
+		if (afskInit(&xModulator, enRate, AFSK_DAC_RATE) != URC_SUCCESS) return pdFALSE;
+	}
+	if (afskLoad(&xModulator, (const unsigned char *)pcData, usLength) != URC_SUCCESS) return pdFALSE;
+
+	xSemaphoreTake(xDacDone, 0);
+	usNextSample = afskSample(&xModulator);
+
+	T2TCR = 0x2;	//reset the counters
+	T2IR = 0xFF;
+	enable_VIC_irq(AFSK_DAC_INTERRUPTS);
+	T2TCR = 0x1;	//and run
+	return pdTRUE;
+}
+
+signed portBASE_TYPE Comms_AfskDac_Wait(portTickType xBlockTime)
+{
+	if (!(T2TCR & 0x1)) return pdTRUE;
+	return xSemaphoreTake(xDacDone, xBlockTime);
+}
@@ -0,0 +1,227 @@
+/**
+ *  \file channel.c
+ *
+ *  \brief Carrier-sense channel access for the half-duplex AFSK link
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-18 14:10:00 +1000 (Sat, 18 May 2013) $
+ *  \warning Occupancy is sampled from task context, so it has slot
+ *  time resolution rather than edge resolution
+ *  \bug No Bugs for now
+ *  \note No Notes for now
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "channel.h"
+#include "switching.h"
+#include "lib_string.h"
+
+//DET lines currently asserted, written by the GPIO interrupt
+static volatile unsigned portLONG ulCarrierLines = 0;
+//set by the interrupt when carrier appeared since the last sample
+static volatile portBASE_TYPE xCarrierSeen = pdFALSE;
+static volatile portBASE_TYPE xTransmitting = pdFALSE;
+//holders of the channel, protocols and a BERT run can overlap
+static unsigned portBASE_TYPE uxClaims = 0;
+
+static portTickType xSlotTime = CHANNEL_DEF_SLOT_TIME;
+static unsigned portCHAR ucPersistence = CHANNEL_DEF_PERSISTENCE;
+
+static ChannelStats xStats;
+static portTickType xLastSample;
+static unsigned portLONG ulSeed;
+
+static void vChannelSample(void);
+static unsigned portCHAR ucChannelRandom(void);
+static void vChannelSwitchRF(void);
+
+void vChannel_Init(void)
+{
+	portENTER_CRITICAL();
+	{
+		ulCarrierLines = 0;
+		xCarrierSeen = pdFALSE;
+		xTransmitting = pdFALSE;
+		uxClaims = 0;
+		memset(&xStats, 0, sizeof(xStats));
+		xLastSample = xTaskGetTickCount();
+		ulSeed = xLastSample ^ 0x2468ACE1;
+	}
+	portEXIT_CRITICAL();
+}
+
+void vChannel_SetParams(portTickType xNewSlotTime, unsigned portCHAR ucNewPersistence)
+{
+	if (xNewSlotTime != 0) xSlotTime = xNewSlotTime;
+	ucPersistence = ucNewPersistence;
+}
+
+void vChannel_CarrierEdgeFromISR(unsigned portLONG ulRising, unsigned portLONG ulFalling)
+{
+	unsigned portLONG ulPrevious = ulCarrierLines;
+
+	ulCarrierLines = (ulCarrierLines | ulRising) & ~ulFalling;
+
+	if (ulPrevious == 0 && ulRising != 0)
+	{
+		xCarrierSeen = pdTRUE;
+		xStats.ulCarrierCount++;
+	}
+
+	//half-duplex: leave the RF path alone while we are keyed up
+	if (!xTransmitting) vChannelSwitchRF();
+}
+
+portBASE_TYPE xChannel_IsBusy(void)
+{
+	return (ulCarrierLines != 0) ? pdTRUE : pdFALSE;
+}
+
+portBASE_TYPE xChannel_IsTransmitting(void)
+{
+	return xTransmitting;
+}
+
+UnivRetCode enChannel_Acquire(portTickType xMaxWait)
+{
+	portTickType xStart = xTaskGetTickCount();
+	portBASE_TYPE xClaimed = pdFALSE;
+
+	//already keyed up for another holder, join its claim
+	portENTER_CRITICAL();
+	{
+		if (uxClaims != 0)
+		{
+			uxClaims++;
+			xClaimed = pdTRUE;
+		}
+	}
+	portEXIT_CRITICAL();
+	if (xClaimed) return URC_SUCCESS;
+
+	for ( ; ; )
+	{
+		vChannelSample();
+
+		if ((xTaskGetTickCount() - xStart) >= xMaxWait) break;
+
+		portENTER_CRITICAL();
+		{
+			if (ulCarrierLines != 0)
+			{
+				xStats.ulDeferrals++;
+			}
+			else if (ucChannelRandom() <= ucPersistence)
+			{
+				xTransmitting = pdTRUE;
+				uxClaims++;
+				xStats.ulTxCount++;
+				xClaimed = pdTRUE;
+			}
+			else
+			{
+				xStats.ulBackoffs++;
+			}
+		}
+		portEXIT_CRITICAL();
+
+		if (xClaimed) return URC_SUCCESS;
+
+		vTaskDelay(xSlotTime);
+	}
+
+	portENTER_CRITICAL();
+	{
+		xTransmitting = pdTRUE;
+		uxClaims++;
+		xStats.ulForced++;
+		xStats.ulTxCount++;
+	}
+	portEXIT_CRITICAL();
+
+	return URC_BUSY;
+}
+
+void vChannel_Release(void)
+{
+	vChannelSample();
+
+	portENTER_CRITICAL();
+	{
+		//the last holder gives the channel back
+		if (uxClaims > 0) uxClaims--;
+		if (uxClaims == 0)
+		{
+			xTransmitting = pdFALSE;
+			//catch up on any carrier change we ignored while keyed up
+			vChannelSwitchRF();
+		}
+	}
+	portEXIT_CRITICAL();
+}
+
+void vChannel_GetStats(ChannelStats *pxStats)
+{
+	vChannelSample();
+
+	portENTER_CRITICAL();
+	{
+		*pxStats = xStats;
+	}
+	portEXIT_CRITICAL();
+
+	pxStats->ucOccupancy = (pxStats->ulObservedTicks == 0) ? 0 :
+		(unsigned portCHAR)((unsigned long long)pxStats->ulBusyTicks * 100 / pxStats->ulObservedTicks);
+}
+
+/*
+ * Charge the ticks since the last sample to busy, transmit or idle.
+ * An interval is counted busy if carrier was present at either end of it.
+ */
+static void vChannelSample(void)
+{
+	portTickType xNow;
+	portTickType xDelta;
+
+	portENTER_CRITICAL();
+	{
+		xNow = xTaskGetTickCount();
+		xDelta = xNow - xLastSample;
+		xLastSample = xNow;
+
+		xStats.ulObservedTicks += xDelta;
+		if (xTransmitting)
+		{
+			xStats.ulTxTicks += xDelta;
+		}
+		else if (xCarrierSeen || ulCarrierLines != 0)
+		{
+			xStats.ulBusyTicks += xDelta;
+		}
+		xCarrierSeen = (ulCarrierLines != 0) ? pdTRUE : pdFALSE;
+	}
+	portEXIT_CRITICAL();
+}
+
+//linear congruential generator, the high byte is good enough for backoff
+static unsigned portCHAR ucChannelRandom(void)
+{
+	ulSeed = ulSeed * 1103515245 + 12345;
+	return (unsigned portCHAR)(ulSeed >> 16);
+}
+
+//route received carrier through the repeater, otherwise back to the device
+static void vChannelSwitchRF(void)
+{
+	if (ulCarrierLines != 0)
+	{
+		switching_OPMODE(REPEATER_MODE);
+	}
+	else
+	{
+		switching_OPMODE(DEVICE_MODE);
+		switching_RX_Device(GMSK_1);
+	}
+}
@@ -16,18 +16,28 @@
 #include "FreeRTOS.h"
 #include "lpc24xx.h"
 #include "modem.h"
+#include "channel.h"
 #include "irq.h"
 #include "gpio.h"
 #include "semphr.h"
+#include "queue.h"
+#include "task.h"
+#include "ring.h"
 /*-----------------------------------------------------------*/
-/* Cyclic buffer to store characters waiting to be
-transmitted. */
-static char TX_BUFF[BUFFER_SIZE];
-static int TX_BUFF_SP = 0; //Start position
-static int TX_BUFF_EP = 0; //End position
+/* Characters waiting to be transmitted, filled by tasks and
+drained by the timer interrupt without a critical section. */
+static unsigned char TX_BUFF[BUFFER_SIZE];
+static ringBuffer xTxRing;
 static int TX_BUFF_BC = 0; //bit count
 static char buffer = 0; //current output
 
+/* Frames sent straight from the owner's buffer, see Comms_Modem_Queue_Frame */
+static xQueueHandle xFrameQueue;
+static ModemFrame xCurrentFrame;
+static volatile portBASE_TYPE xFrameActive = pdFALSE;
+static unsigned portSHORT usFramePos = 0;
+static ModemTxDoneHook pxTxDoneHook = NULL;
+
 void Comms_Modem_Timer_Handler(void);
 void Comms_Modem_Timer_Wrapper( void ) __attribute__ ((naked));
 
@@ -57,7 +67,26 @@ void modem_giveSemaphore(void)
 
 void Comms_Modem_Timer_Handler(void)
 {
-	if (((TX_BUFF[TX_BUFF_SP]&(0x1<<TX_BUFF_BC))>>TX_BUFF_BC)== 0) {
+	signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	unsigned char *pucNext = NULL;
+	char cByte;
+
+	//the character ring has priority, queued frames follow once it drains
+	if (!xFrameActive && ringPeek(&xTxRing, &pucNext) == 0)
+	{
+		xFrameActive = xQueueReceiveFromISR(xFrameQueue, &xCurrentFrame, &xHigherPriorityTaskWoken);
+		usFramePos = 0;
+		if (!xFrameActive)
+		{
+			disable_VIC_irq(MODEM_INTERRUPTS);
+			T1IR = 0xFF;
+			VICVectAddr = CLEAR_VIC_INTERRUPT;
+			return;
+		}
+	}
+	cByte = (xFrameActive) ? xCurrentFrame.pcData[usFramePos] : (char)*pucNext;
+
+	if (((cByte&(0x1<<TX_BUFF_BC))>>TX_BUFF_BC)== 0) {
 		buffer = !buffer;
 		setGPIO(0,15,buffer);
 		setGPIO(4,22,buffer);
@@ -67,10 +96,33 @@ void Comms_Modem_Timer_Handler(void)
 	}
 	if (TX_BUFF_BC == 7){
 		TX_BUFF_BC = 0;
-		TX_BUFF_SP = (TX_BUFF_SP+1)%BUFFER_SIZE;
-		if (TX_BUFF_SP == TX_BUFF_EP){
-			modem_giveSemaphore();
-			disable_VIC_irq(MODEM_INTERRUPTS);
+		if (xFrameActive)
+		{
+			if (++usFramePos == xCurrentFrame.usLength)
+			{
+				xFrameActive = pdFALSE;
+				if (pxTxDoneHook != NULL)
+				{
+					pxTxDoneHook(xCurrentFrame.pvTag, &xHigherPriorityTaskWoken);
+				}
+				//chain straight into the next frame so the bitstream stays continuous
+				xFrameActive = xQueueReceiveFromISR(xFrameQueue, &xCurrentFrame, &xHigherPriorityTaskWoken);
+				usFramePos = 0;
+				//characters written during the frame go out from the next tick
+				if (!xFrameActive && ringCount(&xTxRing) == 0) disable_VIC_irq(MODEM_INTERRUPTS);
+			}
+		}
+		else
+		{
+			ringConsume(&xTxRing, 1);
+			if (ringCount(&xTxRing) == 0){
+				modem_giveSemaphore();
+				//leave the interrupt on if frames are waiting
+				if (uxQueueMessagesWaitingFromISR(xFrameQueue) == 0)
+				{
+					disable_VIC_irq(MODEM_INTERRUPTS);
+				}
+			}
 		}
 	} else {
 		TX_BUFF_BC++;
@@ -79,6 +131,11 @@ void Comms_Modem_Timer_Handler(void)
 	T1IR = 0xFF;
 	/* Clear the ISR in the VIC. */
 	VICVectAddr = CLEAR_VIC_INTERRUPT;
+
+	if (xHigherPriorityTaskWoken)
+	{
+		portYIELD_FROM_ISR();
+	}
 }
 
 
@@ -149,6 +206,9 @@ void Comms_Modem_Timer_Init(void)
 	// enable_VIC_irq(17);
 
 	createModem_Semaphore();
+	ringInit(&xTxRing, TX_BUFF, BUFFER_SIZE);
+	xFrameQueue = xQueueCreate(MODEM_FRAME_Q_SIZE, sizeof(ModemFrame));
+	vChannel_Init();
 }
 
 /*
@@ -178,10 +238,15 @@ signed portBASE_TYPE Comms_Modem_Read_Char( signed portCHAR *pcRxedChar, portTic
 
 signed portBASE_TYPE Comms_Modem_Write_Char( portCHAR cOutChar, portTickType xBlockTime)
 {
-	(void) xBlockTime;
-	TX_BUFF[TX_BUFF_EP] = cOutChar;
-	TX_BUFF_EP = (TX_BUFF_EP+1)%BUFFER_SIZE;
-	return 0;
+	while (ringPutByte(&xTxRing, (unsigned char)cOutChar) != URC_SUCCESS)
+	{
+		if (xBlockTime == MODEM_NO_BLOCK) return pdFALSE;
+		//the timer is draining the buffer while we wait
+		enable_VIC_irq(MODEM_INTERRUPTS);
+		vTaskDelay(1);
+		xBlockTime--;
+	}
+	return pdTRUE;
 }
 
 /*
@@ -205,23 +270,54 @@ unsigned portSHORT Comms_Modem_Read_Str( portCHAR * pcString, unsigned portSHORT
 
 void Comms_Modem_Write_Str( const portCHAR * const pcString, unsigned portSHORT usStringLength)
 {
-	const signed portCHAR *pxNext;
 	unsigned portSHORT usLength = 0;
-	//signed portBASE_TYPE ret;
-	/* Send each character in the string, one at a time. */
-	pxNext = ( const signed portCHAR * ) pcString;
+	unsigned portSHORT usPushed;
+	portTickType xBlockTime = MODEM_WRITE_BLOCK;
+
+	while (usLength < usStringLength)
 	{
-		while(usLength < usStringLength)
+		usPushed = ringPush(&xTxRing, (const unsigned char *)&pcString[usLength], usStringLength - usLength);
+		usLength += usPushed;
+		if (usPushed != 0)
 		{
-
-			Comms_Modem_Write_Char( *pxNext, 1);
-			pxNext++;
-			usLength++;
+			xBlockTime = MODEM_WRITE_BLOCK;
+			continue;
 		}
+		//streams longer than TX_BUFF are fed while the timer sends,
+		//a stalled modem drops the rest of the string
+		if (xBlockTime-- == 0) break;
+		enable_VIC_irq(MODEM_INTERRUPTS);
+		vTaskDelay(1);
 	}
 	enable_VIC_irq(MODEM_INTERRUPTS);
 }
 
+signed portBASE_TYPE Comms_Modem_Queue_Frame(const portCHAR *pcData, unsigned portSHORT usLength, void *pvTag)
+{
+	ModemFrame xFrame;
+
+	if (pcData == NULL || usLength == 0) return pdFALSE;
+
+	xFrame.pcData = pcData;
+	xFrame.usLength = usLength;
+	xFrame.pvTag = pvTag;
+	if (xQueueSend(xFrameQueue, &xFrame, MODEM_NO_BLOCK) != pdTRUE) return pdFALSE;
+
+	//starts the timer if idle, a running frame picks this one up when it ends
+	enable_VIC_irq(MODEM_INTERRUPTS);
+	return pdTRUE;
+}
+
+void Comms_Modem_Set_TxDone_Hook(ModemTxDoneHook pxHook)
+{
+	pxTxDoneHook = pxHook;
+}
+
+portBASE_TYPE Comms_Modem_Is_Sending(void)
+{
+	return (xFrameActive || ringCount(&xTxRing) != 0 || uxQueueMessagesWaiting(xFrameQueue) != 0) ? pdTRUE : pdFALSE;
+}
+
 /*-----------------------------------------------------------*/
 void Comms_Modem_Write_Hex(const void * const loc, unsigned portSHORT usStringLength)
 {
@@ -17,7 +17,7 @@
 #include "queue.h"
 #include "task.h"
 #include "irq.h"
-#include "semphr.h"
+#include "lock.h"
 
 #define UART_PWR_CTRL		PCONP
 #define UART_PWR_EN			( ( unsigned portLONG ) 1)
@@ -66,8 +66,8 @@ transmitted. */
 static xQueueHandle RX_BUFF;
 static xQueueHandle TX_BUFF;
 static volatile portLONG UART_FREE;
-static xSemaphoreHandle RX_MUTEX;
-static xSemaphoreHandle TX_MUTEX;
+static Lock RX_LOCK;
+static Lock TX_LOCK;
 
 void Comms_UART_Handler(void);
 void Comms_UART_Wrapper( void ) __attribute__ ((naked));
@@ -136,10 +136,10 @@ unsigned portLONG Comms_UART_Init(void)
 	/* Set up the peripheral clock for UART0 */
 	UART01_CLK_SEL |= UART_CLK_FULL << UART0_CLK_OFFSET;
 
-	// Setup UART mutex
-	vSemaphoreCreateBinary( RX_MUTEX );
-	vSemaphoreCreateBinary( TX_MUTEX );
-	if(!TX_MUTEX && !RX_MUTEX) return pdFAIL;
+	// Setup UART locks, a low priority print holding the port is raised
+	// while a higher priority task waits for it
+	if (xLockCreate( &RX_LOCK, "UART RX" ) != pdPASS) return pdFAIL;
+	if (xLockCreate( &TX_LOCK, "UART TX" ) != pdPASS) return pdFAIL;
 
 	/* Set up queues and Empty Flag */
 	RX_BUFF 	= xQueueCreate( serBUFF_LENGTH, ( unsigned portBASE_TYPE ) sizeof( signed portCHAR ) );
@@ -237,10 +237,10 @@ void vAcquireUARTChannel(enum UART_CHANNEL_ID enChannelID, portTickType xBlockTi
 {
 	switch(enChannelID)
 	{
-		case READ0	:	xSemaphoreTake( RX_MUTEX, xBlockTime );
+		case READ0	:	xLockTake( &RX_LOCK, xBlockTime );
 						break;
 
-		case WRITE0	:	xSemaphoreTake( TX_MUTEX, xBlockTime );
+		case WRITE0	:	xLockTake( &TX_LOCK, xBlockTime );
 						break;
 
 		default		:	/* There is nothing to do */
@@ -253,10 +253,10 @@ void vReleaseUARTChannel(enum UART_CHANNEL_ID enChannelID)
 {
 	switch(enChannelID)
 	{
-		case READ0	:	xSemaphoreGive( RX_MUTEX );
+		case READ0	:	vLockGive( &RX_LOCK );
 						break;
 
-		case WRITE0	:	xSemaphoreGive( TX_MUTEX );
+		case WRITE0	:	vLockGive( &TX_LOCK );
 						break;
 
 		default		:	/* There is nothing to do */
@@ -76,12 +76,18 @@
 #define configTICK_RATE_HZ			( ( portTickType ) 1000 )
 #define configMAX_PRIORITIES		( ( unsigned portBASE_TYPE ) 5 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 128 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 16 * 1024 ) ) // ( ( size_t ) ( 24 * 1024 ) )
+/* heap_1 never frees, so the heap holds everything boot creates: about
+17 KB of task stacks (Telem and Comms 4 KB each, Protocols 2 KB, Mailbox
+and Uplink 1 KB, ten more of 512 bytes with idle), 1 KB of TCBs and 7 KB
+of queues and semaphores. The rest is headroom, a task that still does
+not fit is reported by the command task. */
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 28 * 1024 ) )
 #define configMAX_TASK_NAME_LEN		( 16 )
 #define configUSE_TRACE_FACILITY	0
 #define configUSE_16_BIT_TICKS		0
 #define configIDLE_SHOULD_YIELD		1
 #define configQUEUE_REGISTRY_SIZE	0
+#define configUSE_MUTEXES			1 /* priority inheritance for lock.h */
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
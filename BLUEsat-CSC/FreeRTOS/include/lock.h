@@ -0,0 +1,97 @@
+/**
+ *  \file lock.h
+ *
+ *  \brief Locks for buses and ports shared between tasks. Built on the
+ *  kernel mutex, so a task holding a lock runs at the priority of the
+ *  highest task waiting for it until the lock is given back. That only
+ *  helps across levels, an application holding a bus is raised for a
+ *  service or the command task, tasks of one level just take turns.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-13 20:40:00 +1000 (Thu, 13 Jun 2013) $
+ *  \warning Locks are task level only, never take or give one from an
+ *  interrupt. Completion signals from an ISR stay binary semaphores.
+ *  \bug No Bugs for now
+ *  \note Every lock records how long it was held and waited for, in ticks.
+ */
+
+#ifndef LOCK_H_
+#define LOCK_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+//locks kept in the table read by uxLockCount and pxLockGet
+#define LOCK_MAX_REGISTERED		8
+
+typedef struct
+{
+	unsigned portLONG	ulTaken;
+	unsigned portLONG	ulContended;	//takes that found the lock held
+	unsigned portLONG	ulTimeouts;
+	portTickType		xMaxHeld;
+	portTickType		xMaxWait;
+} LockStats;
+
+typedef struct
+{
+	xSemaphoreHandle	xMutex;
+	const portCHAR		*pcName;
+	xTaskHandle			xHolder;
+	portTickType		xTakenAt;
+	LockStats			xStats;
+} Lock;
+
+/**
+ * \brief Create the kernel mutex behind a lock and add the lock to the table
+ *
+ * \param[in] pxLock Lock to set up, must stay valid for good
+ * \param[in] pcName Name shown with the statistics
+ *
+ * \returns pdPASS or pdFAIL if the mutex could not be created
+ */
+signed portBASE_TYPE xLockCreate(Lock *pxLock, const portCHAR *pcName);
+
+/**
+ * \brief Take a lock
+ *
+ * \param[in] pxLock Lock to take
+ * \param[in] xBlockTime Time to wait, in ticks
+ *
+ * \returns pdPASS once held or pdFAIL if the wait timed out
+ */
+signed portBASE_TYPE xLockTake(Lock *pxLock, portTickType xBlockTime);
+
+/**
+ * \brief Give a lock back. Does nothing unless the calling task holds it,
+ * so a take that timed out can be followed by a give.
+ *
+ * \param[in] pxLock Lock to give
+ */
+void vLockGive(Lock *pxLock);
+
+/**
+ * \brief Copy out the statistics of a lock
+ *
+ * \param[in] pxLock Lock to read
+ * \param[out] pxStats Destination for the snapshot
+ */
+void vLockGetStats(const Lock *pxLock, LockStats *pxStats);
+
+/**
+ * \brief Number of locks created so far
+ */
+unsigned portBASE_TYPE uxLockCount(void);
+
+/**
+ * \brief Lock by creation order
+ *
+ * \param[in] uxIndex Less than uxLockCount
+ *
+ * \returns The lock or NULL for a bad index
+ */
+const Lock *pxLockGet(unsigned portBASE_TYPE uxIndex);
+
+#endif /* LOCK_H_ */
@@ -0,0 +1,108 @@
+/**
+ *  \file lock.c
+ *
+ *  \brief Locks for buses and ports shared between tasks, on the kernel
+ *  mutex for priority inheritance.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-13 20:40:00 +1000 (Thu, 13 Jun 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note The wait is only timed when the first look finds the lock held,
+ *  an uncontended take costs one extra tick count read.
+ */
+
+#include "lock.h"
+
+static Lock *pxLocks[LOCK_MAX_REGISTERED];
+static unsigned portBASE_TYPE uxLocks = 0;
+
+signed portBASE_TYPE xLockCreate(Lock *pxLock, const portCHAR *pcName)
+{
+	pxLock->xMutex = xSemaphoreCreateMutex();
+	if (pxLock->xMutex == NULL) return pdFAIL;
+
+	pxLock->pcName = pcName;
+	pxLock->xHolder = NULL;
+	pxLock->xTakenAt = 0;
+	pxLock->xStats.ulTaken = 0;
+	pxLock->xStats.ulContended = 0;
+	pxLock->xStats.ulTimeouts = 0;
+	pxLock->xStats.xMaxHeld = 0;
+	pxLock->xStats.xMaxWait = 0;
+
+	//a lock past the end of the table still works, it just is not listed
+	portENTER_CRITICAL();
+	{
+		if (uxLocks < LOCK_MAX_REGISTERED) pxLocks[uxLocks++] = pxLock;
+	}
+	portEXIT_CRITICAL();
+
+	return pdPASS;
+}
+
+signed portBASE_TYPE xLockTake(Lock *pxLock, portTickType xBlockTime)
+{
+	portTickType xStart;
+	portTickType xWait = 0;
+	portBASE_TYPE xContended = pdFALSE;
+
+	if (xSemaphoreTake(pxLock->xMutex, 0) != pdTRUE)
+	{
+		xStart = xTaskGetTickCount();
+		if (xBlockTime == 0 || xSemaphoreTake(pxLock->xMutex, xBlockTime) != pdTRUE)
+		{
+			portENTER_CRITICAL();
+			{
+				pxLock->xStats.ulTimeouts++;
+			}
+			portEXIT_CRITICAL();
+			return pdFAIL;
+		}
+		xWait = xTaskGetTickCount() - xStart;
+		xContended = pdTRUE;
+	}
+
+	//held from here, the rest needs no other protection
+	pxLock->xHolder = xTaskGetCurrentTaskHandle();
+	pxLock->xTakenAt = xTaskGetTickCount();
+	pxLock->xStats.ulTaken++;
+	if (xContended) pxLock->xStats.ulContended++;
+	if (xWait > pxLock->xStats.xMaxWait) pxLock->xStats.xMaxWait = xWait;
+
+	return pdPASS;
+}
+
+void vLockGive(Lock *pxLock)
+{
+	portTickType xHeld;
+
+	if (pxLock->xHolder != xTaskGetCurrentTaskHandle()) return;
+
+	xHeld = xTaskGetTickCount() - pxLock->xTakenAt;
+	if (xHeld > pxLock->xStats.xMaxHeld) pxLock->xStats.xMaxHeld = xHeld;
+	pxLock->xHolder = NULL;
+
+	xSemaphoreGive(pxLock->xMutex);
+}
+
+void vLockGetStats(const Lock *pxLock, LockStats *pxStats)
+{
+	portENTER_CRITICAL();
+	{
+		*pxStats = pxLock->xStats;
+	}
+	portEXIT_CRITICAL();
+}
+
+unsigned portBASE_TYPE uxLockCount(void)
+{
+	return uxLocks;
+}
+
+const Lock *pxLockGet(unsigned portBASE_TYPE uxIndex)
+{
+	if (uxIndex >= uxLocks) return NULL;
+	return pxLocks[uxIndex];
+}
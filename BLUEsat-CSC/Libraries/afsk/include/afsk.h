@@ -0,0 +1,59 @@
+/*
+ * afsk.h
+ *
+ *  Created on: May 28, 2013
+ *
+ *  Direct digital synthesis of AFSK baseband. A 32 bit phase accumulator
+ *  steps through a quarter wave sine table at the mark or space rate and
+ *  is never reset, so the waveform stays phase continuous across bit and
+ *  frame boundaries. Input is the same bitstream the modem chips are fed,
+ *  LSB first, and NRZI is applied here the same way: a 0 changes tone.
+ *  Samples are unsigned AFSK_DAC_BITS wide, centred on AFSK_DAC_MID.
+ */
+
+#ifndef AFSK_H_
+#define AFSK_H_
+#include "UniversalReturnCode.h"
+
+#define AFSK_DAC_BITS      10
+#define AFSK_DAC_MID       512
+#define AFSK_SINE_STEPS    64      // table entries per quarter wave
+
+typedef enum //afskRate
+{
+   AFSK_1200,     // Bell 202, 1200/2200 Hz
+   AFSK_2400,     // Bell 202 tones and baud doubled
+   AFSK_4800,     // and doubled again
+   AFSK_NUM_RATES,
+}afskRate;
+
+typedef struct //afskMod
+{
+   unsigned int  phase;
+   unsigned int  markStep;
+   unsigned int  spaceStep;
+   unsigned int  baud;
+   unsigned int  sampleRate;
+   unsigned int  bitClock;        // gains baud per sample, the bit ends at sampleRate
+   const unsigned char * data;
+   unsigned int  dataBits;
+   unsigned int  bitIndex;
+   unsigned char mark;            // tone being sent, kept between frames for NRZI
+}afskMod;
+
+// sampleRate must be a multiple of the baud rate, above twice the space tone
+// and below 65536
+UnivRetCode afskInit (afskMod * mod, afskRate rate, unsigned int sampleRate);
+
+// Starts sending a bitstream, the previous one must have finished
+UnivRetCode afskLoad (afskMod * mod, const unsigned char * data, unsigned int dataSize);
+
+unsigned char afskBusy (afskMod * mod);
+
+// Next DAC sample, AFSK_DAC_MID once the bitstream has finished
+unsigned short afskSample (afskMod * mod);
+
+// Fills up to outputSize samples, returns how many were written
+unsigned int afskRender (afskMod * mod, unsigned short * output, unsigned int outputSize);
+
+#endif /* AFSK_H_ */
@@ -0,0 +1,124 @@
+/*
+ * afsk.c
+ *
+ *  Created on: May 28, 2013
+ */
+#include "afsk.h"
+
+typedef struct //afskTones
+{
+   unsigned short markHz;
+   unsigned short spaceHz;
+   unsigned short baud;
+}afskTones;
+
+static const afskTones tones [AFSK_NUM_RATES] =
+{
+   {1200, 2200, 1200},
+   {2400, 4400, 2400},
+   {4800, 8800, 4800},
+};
+
+// sin over the first quarter wave scaled to half the DAC range
+static const unsigned short quarterSine [AFSK_SINE_STEPS + 1] =
+{
+     0,  13,  25,  38,  50,  63,  75,  87, 100, 112, 124, 136, 148,
+   160, 172, 184, 196, 207, 218, 230, 241, 252, 263, 273, 284, 294,
+   304, 314, 324, 334, 343, 352, 361, 370, 379, 387, 395, 403, 410,
+   418, 425, 432, 438, 445, 451, 456, 462, 467, 472, 477, 481, 485,
+   489, 492, 496, 499, 501, 503, 505, 507, 509, 510, 510, 511, 511
+};
+
+static unsigned int phaseStep (unsigned int hz, unsigned int sampleRate);
+static void startBit (afskMod * mod);
+
+UnivRetCode afskInit (afskMod * mod, afskRate rate, unsigned int sampleRate)
+{
+   if (mod == NULL || rate >= AFSK_NUM_RATES) return URC_FAIL;
+   if (sampleRate % tones[rate].baud != 0)    return URC_FAIL;
+   if (sampleRate <= 2 * tones[rate].spaceHz) return URC_FAIL;
+   if (sampleRate > 0xFFFF)                   return URC_FAIL;
+   mod->phase      = 0;
+   mod->markStep   = phaseStep (tones[rate].markHz, sampleRate);
+   mod->spaceStep  = phaseStep (tones[rate].spaceHz, sampleRate);
+   mod->baud       = tones[rate].baud;
+   mod->sampleRate = sampleRate;
+   mod->bitClock   = 0;
+   mod->data       = NULL;
+   mod->dataBits   = 0;
+   mod->bitIndex   = 0;
+   mod->mark       = 1;
+   return URC_SUCCESS;
+}
+
+UnivRetCode afskLoad (afskMod * mod, const unsigned char * data, unsigned int dataSize)
+{
+   if (mod == NULL || data == NULL || dataSize == 0) return URC_FAIL;
+   if (afskBusy (mod)) return URC_BUSY;
+   mod->data     = data;
+   mod->dataBits = dataSize * 8;
+   mod->bitIndex = 0;
+   mod->bitClock = 0;
+   startBit (mod);
+   return URC_SUCCESS;
+}
+
+unsigned char afskBusy (afskMod * mod)
+{
+   return mod->bitIndex < mod->dataBits;
+}
+
+unsigned short afskSample (afskMod * mod)
+{
+   unsigned int index, step;
+   unsigned short sample;
+   if (!afskBusy (mod)) return AFSK_DAC_MID;
+
+   // top 8 bits of the phase pick the table entry, the quadrant folds it
+   index = mod->phase >> 24;
+   step  = index % AFSK_SINE_STEPS;
+   switch (index / AFSK_SINE_STEPS)
+   {
+      case 0:  sample = AFSK_DAC_MID + quarterSine[step];                   break;
+      case 1:  sample = AFSK_DAC_MID + quarterSine[AFSK_SINE_STEPS - step]; break;
+      case 2:  sample = AFSK_DAC_MID - quarterSine[step];                   break;
+      default: sample = AFSK_DAC_MID - quarterSine[AFSK_SINE_STEPS - step]; break;
+   }
+   mod->phase += (mod->mark)?mod->markStep:mod->spaceStep;
+
+   mod->bitClock += mod->baud;
+   if (mod->bitClock >= mod->sampleRate)
+   {
+      mod->bitClock -= mod->sampleRate;
+      mod->bitIndex++;
+      if (afskBusy (mod)) startBit (mod);
+   }
+   return sample;
+}
+
+unsigned int afskRender (afskMod * mod, unsigned short * output, unsigned int outputSize)
+{
+   unsigned int count = 0;
+   if (mod == NULL || output == NULL) return 0;
+   while (count < outputSize && afskBusy (mod))
+   {
+      output[count++] = afskSample (mod);
+   }
+   return count;
+}
+
+// hz * 2^32 / sampleRate in two halves so no 64 bit division is needed
+static unsigned int phaseStep (unsigned int hz, unsigned int sampleRate)
+{
+   unsigned int high = (hz << 16) / sampleRate;
+   unsigned int rem  = (hz << 16) % sampleRate;
+   return (high << 16) + ((rem << 16) / sampleRate);
+}
+
+static void startBit (afskMod * mod)
+{
+   if (((mod->data[mod->bitIndex / 8] >> (mod->bitIndex % 8)) & 1) == 0)
+   {
+      mod->mark = !mod->mark;
+   }
+}
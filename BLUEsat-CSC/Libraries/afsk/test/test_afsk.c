@@ -0,0 +1,188 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "afsk.h"
+
+#define TEST_RATE       38400
+#define WAV_SECONDS     4
+
+#define TEST_PI         3.14159265358979
+
+// Taylor series so the test does not need libm
+static double testSin (double x)
+{
+   double term, sum;
+   unsigned int n;
+   while (x >  TEST_PI) x -= 2 * TEST_PI;
+   while (x < -TEST_PI) x += 2 * TEST_PI;
+   term = sum = x;
+   for (n = 1; n < 10; ++n)
+   {
+      term *= -x * x / ((2 * n) * (2 * n + 1));
+      sum  += term;
+   }
+   return sum;
+}
+
+static double toneEnergy (unsigned short * samples, unsigned int count, double hz)
+{
+   double i = 0, q = 0, w = 2 * TEST_PI * hz / TEST_RATE;
+   unsigned int n;
+   for (n = 0; n < count; ++n)
+   {
+      i += ((int)samples[n] - AFSK_DAC_MID) * testSin (w * n + TEST_PI / 2);
+      q += ((int)samples[n] - AFSK_DAC_MID) * testSin (w * n);
+   }
+   return i * i + q * q;
+}
+
+// Tone of each bit by correlating against mark and space over the bit
+static void decodeTones (unsigned short * samples, unsigned int bits, unsigned int perBit,
+                         double markHz, unsigned char * tonesOut)
+{
+   unsigned int bit;
+   for (bit = 0; bit < bits; ++bit)
+   {
+      tonesOut[bit] = toneEnergy (&samples[bit * perBit], perBit, markHz) >
+                      toneEnergy (&samples[bit * perBit], perBit, markHz * 11 / 6);
+   }
+}
+
+static unsigned char prbs9 (unsigned short * state)
+{
+   unsigned char bit = ((*state >> 8) ^ (*state >> 4)) & 1;
+   *state = ((*state << 1) | bit) & 0x1FF;
+   return bit;
+}
+
+static void putLe (FILE * fp, unsigned int value, unsigned int bytes)
+{
+   while (bytes-- > 0)
+   {
+      fputc (value & 0xFF, fp);
+      value >>= 8;
+   }
+}
+
+// Set AFSK_WAV to a path to get PRBS9 at 1200 baud for Scripts/bert_check.pl
+static void dumpWav (const char * path)
+{
+   static unsigned char data [WAV_SECONDS * 1200 / 8];
+   static unsigned short samples [WAV_SECONDS * TEST_RATE];
+   afskMod mod;
+   unsigned short state = 0x1FF;
+   unsigned int index, bit, count;
+   FILE * fp;
+
+   for (index = 0; index < sizeof (data); ++index)
+   {
+      data[index] = 0;
+      for (bit = 0; bit < 8; ++bit) data[index] |= prbs9 (&state) << bit;
+   }
+   afskInit (&mod, AFSK_1200, TEST_RATE);
+   afskLoad (&mod, data, sizeof (data));
+   count = afskRender (&mod, samples, WAV_SECONDS * TEST_RATE);
+
+   fp = fopen (path, "wb");
+   if (fp == NULL) return;
+   fputs ("RIFF", fp); putLe (fp, 36 + count * 2, 4); fputs ("WAVE", fp);
+   fputs ("fmt ", fp); putLe (fp, 16, 4); putLe (fp, 1, 2); putLe (fp, 1, 2);
+   putLe (fp, TEST_RATE, 4); putLe (fp, TEST_RATE * 2, 4); putLe (fp, 2, 2); putLe (fp, 16, 2);
+   fputs ("data", fp); putLe (fp, count * 2, 4);
+   for (index = 0; index < count; ++index)
+   {
+      putLe (fp, (unsigned short)(((int)samples[index] - AFSK_DAC_MID) * 64), 2);
+   }
+   fclose (fp);
+}
+
+void TestAfskInitChecks(CuTest* tc)
+{
+   afskMod mod;
+   CuAssertTrue(tc, afskInit (&mod, AFSK_1200, TEST_RATE) == URC_SUCCESS);
+   CuAssertTrue(tc, afskInit (&mod, AFSK_4800, TEST_RATE) == URC_SUCCESS);
+   CuAssertTrue(tc, afskInit (&mod, AFSK_1200, 10000) == URC_FAIL);
+   CuAssertTrue(tc, afskInit (&mod, AFSK_4800, 9600) == URC_FAIL);
+   CuAssertTrue(tc, afskInit (&mod, AFSK_1200, 76800) == URC_FAIL);
+   CuAssertTrue(tc, afskInit (&mod, AFSK_NUM_RATES, TEST_RATE) == URC_FAIL);
+   CuAssertTrue(tc, afskBusy (&mod) == 0);
+   CuAssertTrue(tc, afskSample (&mod) == AFSK_DAC_MID);
+}
+
+void TestAfskSampleCount(CuTest* tc)
+{
+   afskMod mod;
+   unsigned char data[4] = {0x7E, 0x00, 0xFF, 0x55};
+   unsigned short samples[2000];
+   afskInit (&mod, AFSK_1200, 44400);
+   CuAssertTrue(tc, afskLoad (&mod, data, 4) == URC_SUCCESS);
+   CuAssertTrue(tc, afskLoad (&mod, data, 4) == URC_BUSY);
+   CuAssertTrue(tc, afskRender (&mod, samples, 2000) == 32 * 37);
+   CuAssertTrue(tc, afskBusy (&mod) == 0);
+}
+
+void TestAfskPhaseContinuous(CuTest* tc)
+{
+   afskMod mod;
+   unsigned char data[3] = {0x00, 0xA5, 0xFF};
+   unsigned int index, before;
+   unsigned int frame;
+   afskInit (&mod, AFSK_2400, TEST_RATE);
+   // the accumulator only ever advances by a tone step, across bits and frames
+   for (frame = 0; frame < 2; ++frame)
+   {
+      afskLoad (&mod, data, 3);
+      for (index = 0; afskBusy (&mod); ++index)
+      {
+         before = mod.phase;
+         afskSample (&mod);
+         CuAssertTrue(tc, mod.phase - before == mod.markStep || mod.phase - before == mod.spaceStep);
+      }
+      CuAssertTrue(tc, index == 24 * 16);
+   }
+}
+
+void TestAfskTonesFollowNrzi(CuTest* tc)
+{
+   afskMod mod;
+   afskRate rate;
+   unsigned char data[8] = {0x7E, 0x96, 0x70, 0x9A, 0x9A, 0x9E, 0x40, 0xE0};
+   unsigned short samples[64 * 32];
+   unsigned char tones[64];
+   unsigned int perBit, count, bit;
+   unsigned char previous;
+   for (rate = AFSK_1200; rate < AFSK_NUM_RATES; ++rate)
+   {
+      afskInit (&mod, rate, TEST_RATE);
+      perBit = TEST_RATE / (1200 << rate);
+      afskLoad (&mod, data, 8);
+      count = afskRender (&mod, samples, sizeof (samples) / sizeof (samples[0]));
+      CuAssertTrue(tc, count == 64 * perBit);
+      decodeTones (samples, 64, perBit, 1200 << rate, tones);
+      previous = 1;
+      for (bit = 0; bit < 64; ++bit)
+      {
+         CuAssertTrue(tc, (tones[bit] == previous) == ((data[bit / 8] >> (bit % 8)) & 1));
+         previous = tones[bit];
+      }
+   }
+   if (getenv ("AFSK_WAV") != NULL) dumpWav (getenv ("AFSK_WAV"));
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestAfskInitChecks);
+   SUITE_ADD_TEST(suite, TestAfskSampleCount);
+   SUITE_ADD_TEST(suite, TestAfskPhaseContinuous);
+   SUITE_ADD_TEST(suite, TestAfskTonesFollowNrzi);
+   return suite;
+}
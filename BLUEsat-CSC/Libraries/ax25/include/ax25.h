@@ -10,6 +10,7 @@
 #include "UniversalReturnCode.h"
 #include "command.h"
 #include "ax25Config.h"
+#include "commsBuffer.h"
 
 /*Delivery Location Structures*/
 
@@ -184,12 +185,23 @@
          unsigned int info_size;
       } rawPacket;
 
+      typedef struct //burstBlock
+      {
+         buffer out;             // Bit level position in the burst output
+         unsigned int frames;    // Frames added so far
+      }burstBlock;
+
 /**************************************************************************/
 
 void vSetToken(TaskToken         taskToken);
 
 protoReturn ax25Entry (stateBlock* presentState, char* output, unsigned int * outputSize );
 
+// Burst mode: TXDELAY flags, frames sharing one flag between them, TXTAIL flags
+protoReturn ax25BurstStart (burstBlock * burst, char * output, unsigned int outputSize, unsigned int txDelay);
+protoReturn ax25BurstAdd   (burstBlock * burst, stateBlock * presentState);
+protoReturn ax25BurstEnd   (burstBlock * burst, unsigned int txTail, unsigned int * outputSize);
+
 #ifdef UNIT_TEST
 //Encode
 UnivRetCode test_buildLocation (LocSubField ** destBuffer, unsigned int * sizeLeft, Location * loc,
@@ -202,8 +214,5 @@ UnivRetCode test_InfoBuilder (stateBlock * presentState, rawPacket* output);
 UnivRetCode test_unconnectedEngine (stateBlock* presentState,  rawPacket* output);
 UnivRetCode test_AX25fcsCalc( rawPacket* input, unsigned char *fcsByte0, unsigned char * fcsByte1);
 
-//Decode
-decodeOptions test_determineDest ( rxPktStubs* input, const Location * self);
-protoReturn test_ax25Receive (receivedPacket* out, char* input, unsigned int inputSize, const Location * self );
 #endif
 #endif /* AX25_H_ */
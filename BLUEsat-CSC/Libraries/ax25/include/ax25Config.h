@@ -32,4 +32,8 @@
 
 #define MAX_ADDR_FIELD     7*4
 
+/*Burst defaults in flags, one flag takes 6.67ms at 1200 baud*/
+#define TXDELAY_FLAGS      30
+#define TXTAIL_FLAGS       3
+
 #endif /* AX25CONFIG_H_ */
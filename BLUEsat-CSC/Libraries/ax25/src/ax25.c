@@ -14,6 +14,9 @@ static UnivRetCode unconnectedEngine (stateBlock* presentState,  rawPacket* outp
 static UnivRetCode addrBuilder (char * output, unsigned int * outputSize, DeliveryInfo * addrInfo);
 static UnivRetCode InfoBuilder (stateBlock * presentState, rawPacket* output);
 static UnivRetCode buildPacket (rawPacket * inputDetails, char * outFinal, unsigned int * outFinalSize );
+static UnivRetCode appendFrame (rawPacket * inputDetails, buffer * outBuff);
+static UnivRetCode pushFlags (buffer * outBuff, unsigned int count);
+static protoReturn preparePacket (stateBlock * presentState, rawPacket * packet, char * addrBuff);
 
 
 
@@ -36,15 +39,80 @@ protoReturn ax25Entry (stateBlock* presentState, char* output, unsigned int * ou
    rawPacket packet;
    stateBlock tempState;
    char addrBuff [MAX_ADDR_FIELD];
-   unsigned int addrBuffSize = MAX_ADDR_FIELD;
+   protoReturn result;
    if ( output == NULL || outputSize == NULL) return destBuffError;
    if ( presentState == NULL)                 return stateError;
 
    tempState = *presentState;
+   result = preparePacket (&tempState, &packet, addrBuff);
+   if (result != generationSuccess) return result;
+   //build packet in output buffer
+   if ( buildPacket (&packet, output, outputSize ) == URC_FAIL) return packError;
+
+   *presentState = tempState;
+
+   return generationSuccess;
+}
+
+/*
+ * Burst Functions
+ * ---------------
+ * A burst is one continuous bitstream: a TXDELAY preamble of flags, frames
+ * separated by a single shared flag, then a TXTAIL of flags. The caller
+ * must hand in a zeroed output buffer as the bits are OR'd in.
+ * */
+
+protoReturn ax25BurstStart (burstBlock * burst, char * output, unsigned int outputSize, unsigned int txDelay)
+{
+   if (burst == NULL) return stateError;
+   if (initBuffer (&burst->out, output, outputSize) == URC_FAIL) return destBuffError;
+   burst->frames = 0;
+   // At least one flag is required to open the first frame
+   if (pushFlags (&burst->out, (txDelay == 0)?1:txDelay) == URC_FAIL) return destBuffError;
+   return generationSuccess;
+}
+
+protoReturn ax25BurstAdd (burstBlock * burst, stateBlock * presentState)
+{
+   rawPacket packet;
+   stateBlock tempState;
+   buffer tempOut;
+   char addrBuff [MAX_ADDR_FIELD];
+   protoReturn result;
+   if (burst == NULL)        return destBuffError;
+   if (presentState == NULL) return stateError;
+
+   tempState = *presentState;
+   tempOut = burst->out;
+   result = preparePacket (&tempState, &packet, addrBuff);
+   if (result != generationSuccess) return result;
+   // The flag closing the previous frame opens this one
+   if (appendFrame (&packet, &tempOut) == URC_FAIL) return packError;
+
+   burst->out = tempOut;
+   burst->frames++;
+   *presentState = tempState;
+   return generationSuccess;
+}
+
+protoReturn ax25BurstEnd (burstBlock * burst, unsigned int txTail, unsigned int * outputSize)
+{
+   if (burst == NULL || outputSize == NULL) return destBuffError;
+   if (burst->frames == 0) return packError;
+   if (pushFlags (&burst->out, txTail) == URC_FAIL) return destBuffError;
+   // Include the partially filled last byte
+   *outputSize = burst->out.index + ((burst->out.byte_pos != 0)?1:0);
+   return generationSuccess;
+}
+
+// Runs the state engine and builds the address and info fields of the next frame
+static protoReturn preparePacket (stateBlock * presentState, rawPacket * packet, char * addrBuff)
+{
+   unsigned int addrBuffSize = MAX_ADDR_FIELD;
    // Process State
    switch (presentState->mode)
    {
-      case unconnected:   if (unconnectedEngine (&tempState,  &packet) == URC_FAIL) return stateError;
+      case unconnected:   if (unconnectedEngine (presentState,  packet) == URC_FAIL) return stateError;
                      break;
       case connected:                             //TODO: Create connected state
       default:
@@ -52,17 +120,12 @@ protoReturn ax25Entry (stateBlock* presentState, char* output, unsigned int * ou
    }
 
    // Build Address
-   if (addrBuilder (addrBuff, &addrBuffSize, &(tempState.route)) == URC_FAIL) return addrGenError;
-   packet.addr       = addrBuff;
-   packet.addr_size  = addrBuffSize;
+   if (addrBuilder (addrBuff, &addrBuffSize, &(presentState->route)) == URC_FAIL) return addrGenError;
+   packet->addr       = addrBuff;
+   packet->addr_size  = addrBuffSize;
    // BUild Info
 
-   if (InfoBuilder (&tempState,  &packet) == URC_FAIL) return infoGenError;
-   //build packet in output buffer
-   if ( buildPacket (&packet, output, outputSize ) == URC_FAIL) return packError;
-
-   *presentState = tempState;
-
+   if (InfoBuilder (presentState,  packet) == URC_FAIL) return infoGenError;
    return generationSuccess;
 }
 
@@ -358,59 +421,128 @@ static UnivRetCode buildPacket (rawPacket * inputDetails, char * outFinal, unsig
 {
 
    UnivRetCode result = URC_FAIL;
-   char flag = FLAG;
-   char testitem = 0xFF;
    buffer outBuff;
+
+   if (outFinalSize == NULL) {return result;}
+   // Init Output buffer
+
+   if (initBuffer(&outBuff, outFinal,*outFinalSize) == URC_FAIL)return result;
+
+   // Stuff data into output packet
+   if (pushFlags (&outBuff, 1) == URC_FAIL ) return result;
+   //vDebugPrint(sharedTaskToken, "Flag > %300x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
+
+   if (appendFrame (inputDetails, &outBuff) == URC_FAIL ) return result;
+
+   // The index the the present location in the buffer not the total size.
+   // The result returns the total size in the buffer
+   *outFinalSize = outBuff.index + 1;
+   return URC_SUCCESS;
+}
+
+// Stuffs one frame and its closing flag onto the end of the output buffer.
+// The opening flag must already be in the buffer.
+static UnivRetCode appendFrame (rawPacket * inputDetails, buffer * outBuff)
+{
+
+   UnivRetCode result = URC_FAIL;
    unsigned char fcs0, fcs1;
 
-   if (inputDetails==NULL) {return result;}
+   if (inputDetails==NULL || outBuff==NULL) {return result;}
 
    if (inputDetails->addr == NULL ||
        inputDetails->info == NULL){return result;}
 
    if (inputDetails->addr_size == 0 ||
        inputDetails->info_size == 0){return result;}
-   // Init Output buffer
-
-   if (initBuffer(&outBuff, outFinal,*outFinalSize) == URC_FAIL)return result;
    // Calculate FCS
 
    if (AX25fcsCalc( inputDetails, &fcs0, &fcs1) == URC_FAIL ) return result;
 
-   // Stuff data into output packet
-   if (pushBuf  (&flag, 1, &outBuff) == URC_FAIL ) return result;
-   //vDebugPrint(sharedTaskToken, "Flag > %300x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
-
-   if (stuffBufLSBtoMSB (inputDetails->addr, inputDetails->addr_size, &outBuff) == URC_FAIL ) return result;
+   if (stuffBufLSBtoMSB (inputDetails->addr, inputDetails->addr_size, outBuff) == URC_FAIL ) return result;
    //vDebugPrint(sharedTaskToken, "adderess > %300x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
 
-   if (stuffBufLSBtoMSB ((char *) &inputDetails->ctrl, sizeOfControlFrame, &outBuff) == URC_FAIL ) return result;
+   if (stuffBufLSBtoMSB ((char *) &inputDetails->ctrl, sizeOfControlFrame, outBuff) == URC_FAIL ) return result;
    //vDebugPrint(sharedTaskToken, "Control > %1x\n\r",(char *)&inputDetails->ctrl , NO_INSERT, NO_INSERT);
    //vDebugPrint(sharedTaskToken, "Control > %23x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
 
    if (inputDetails->pid!=NULL)
    {
-      if (stuffBufLSBtoMSB ((char *) inputDetails->pid,  1, &outBuff) == URC_FAIL ) return result; // Assume PID is of size 1 byte
+      if (stuffBufLSBtoMSB ((char *) inputDetails->pid,  1, outBuff) == URC_FAIL ) return result; // Assume PID is of size 1 byte
       //vDebugPrint(sharedTaskToken, "PID > %1x\n\r",(char *)inputDetails->pid , NO_INSERT, NO_INSERT);
       //vDebugPrint(sharedTaskToken, "PID > %23x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
    }
 
 
-   if (stuffBufLSBtoMSB (inputDetails->info, inputDetails->info_size, &outBuff) == URC_FAIL ) return result;
+   if (stuffBufLSBtoMSB (inputDetails->info, inputDetails->info_size, outBuff) == URC_FAIL ) return result;
 
    //vDebugPrint(sharedTaskToken, "info> %39s \n\r%39x\n\r",(char *)inputDetails->info , (char *)inputDetails->info, NO_INSERT);
    //vDebugPrint(sharedTaskToken, "FCS0> %d FCS1> %d\n\r",fcs0 , fcs1, NO_INSERT);
    //vDebugPrint(sharedTaskToken, "before FCS> %23x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
-   if (stuffBufLSBtoMSB ((char *)&fcs0, 1 , &outBuff) == URC_FAIL ) return result;
+   if (stuffBufLSBtoMSB ((char *)&fcs0, 1 , outBuff) == URC_FAIL ) return result;
 
    //vDebugPrint(sharedTaskToken, "FCS0> %23x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
-   if (stuffBufLSBtoMSB ((char *)&fcs1, 1 , &outBuff) == URC_FAIL ) return result;
+   if (stuffBufLSBtoMSB ((char *)&fcs1, 1 , outBuff) == URC_FAIL ) return result;
 
    //vDebugPrint(sharedTaskToken, "FCS1> %23x\n\r",(char *)outFinal , NO_INSERT, NO_INSERT);
-   if (pushBuf (&flag, 1,  &outBuff) == URC_FAIL ) return result;
+   if (pushFlags (outBuff, 1) == URC_FAIL ) return result;
 
-   // The index the the present location in the buffer not the total size.
-   // The result returns the total size in the buffer
-   *outFinalSize = outBuff.index + 1;
    return URC_SUCCESS;
 }
+
+// Flags are never stuffed and reset the run of ones for the next frame
+static UnivRetCode pushFlags (buffer * outBuff, unsigned int count)
+{
+   char flag = FLAG;
+   unsigned int index;
+   for (index = 0; index < count; ++index)
+   {
+      if (pushBuf (&flag, 1, outBuff) == URC_FAIL ) return URC_FAIL;
+   }
+   outBuff->connectedOnes = 0;
+   return URC_SUCCESS;
+}
+
+#ifdef UNIT_TEST
+/*
+ * Test Hooks
+ * ----------
+ * */
+
+UnivRetCode test_buildLocation (LocSubField ** destBuffer, unsigned int * sizeLeft, Location * loc,
+                                  MessageType msgType, LocationType locType,
+                                  Bool visitedRepeater, Bool isLastRepeater)
+{
+   return buildLocation (destBuffer, sizeLeft, loc, msgType, locType, visitedRepeater, isLastRepeater);
+}
+
+UnivRetCode test_addrBuilder (char * output, unsigned int * outputSize, DeliveryInfo * addrInfo)
+{
+   return addrBuilder (output, outputSize, addrInfo);
+}
+
+UnivRetCode test_ctrlBuilder (ControlFrame * output,  ControlInfo* input)
+{
+   return ctrlBuilder (output, input);
+}
+
+UnivRetCode test_buildPacket (rawPacket * inputDetails, char * outFinal, unsigned int * outFinalSize )
+{
+   return buildPacket (inputDetails, outFinal, outFinalSize);
+}
+
+UnivRetCode test_InfoBuilder (stateBlock * presentState, rawPacket* output)
+{
+   return InfoBuilder (presentState, output);
+}
+
+UnivRetCode test_unconnectedEngine (stateBlock* presentState,  rawPacket* output)
+{
+   return unconnectedEngine (presentState, output);
+}
+
+UnivRetCode test_AX25fcsCalc( rawPacket* input, unsigned char *fcsByte0, unsigned char * fcsByte1)
+{
+   return AX25fcsCalc (input, fcsByte0, fcsByte1);
+}
+#endif
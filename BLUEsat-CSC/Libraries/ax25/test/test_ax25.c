@@ -500,6 +500,198 @@ void AX25fcsCalc( char input[], int len,unsigned char *fcsByte0, unsigned char *
    (*fcsByte1) = (shiftRegister&0xFF00)>>8;
    return;
 }
+/*
+ * Burst tests
+ * -----------
+ * Bits go out LSB first. Stuffing keeps six ones in a row out of the
+ * frames, so every run of six ones in the stream is a flag.
+ * */
+
+#define BURST_BUFF_SIZE 400
+
+static void burstState (stateBlock * present, char * text, unsigned int size)
+{
+   memset (present, 0, sizeof (stateBlock));
+   present->src = text;
+   present->srcSize = size;
+   memcpy (present->route.dest.callSign,"BLUEGS",6);
+   memcpy (present->route.src.callSign, "BLUSAT",6);
+   present->route.dest.callSignSize = 6;
+   present->route.src.callSignSize = 6;
+   present->route.dest.ssid = BLUESAT_GS_SSID;
+   present->route.src.ssid = BLUESAT_SAT_SSID;
+   present->route.repeats  = NULL;
+   present->route.type = Response;
+   present->presState = stateless;
+   present->pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
+   present->mode = unconnected;
+   present->completed = false;
+}
+
+static unsigned int burstBits (const char * in, unsigned int bytes, unsigned char * bits)
+{
+   unsigned int index;
+   for (index = 0; index < bytes * 8; ++index)
+   {
+      bits[index] = (in[index / 8] >> (index % 8)) & 1;
+   }
+   return bytes * 8;
+}
+
+static unsigned int burstFlags (const unsigned char * bits, unsigned int count)
+{
+   unsigned int index;
+   unsigned int ones = 0;
+   unsigned int flags = 0;
+   for (index = 0; index < count; ++index)
+   {
+      ones = (bits[index])?ones + 1:0;
+      if (ones == 6) flags++;
+   }
+   return flags;
+}
+
+// Bits up to and including the zero closing the last flag
+static unsigned int burstEnd (const unsigned char * bits, unsigned int count)
+{
+   unsigned int index;
+   unsigned int ones = 0;
+   unsigned int end = 0;
+   for (index = 0; index < count; ++index)
+   {
+      ones = (bits[index])?ones + 1:0;
+      if (ones == 6) end = index + 2;
+   }
+   return end;
+}
+
+void TestAX25BurstPreambleAndTail (CuTest* tc)
+{
+   burstBlock burst;
+   stateBlock present;
+   char text[] = "abcdefghij";
+   char output [BURST_BUFF_SIZE];
+   unsigned char bits [BURST_BUFF_SIZE * 8];
+   unsigned int size = 0;
+   unsigned int count;
+   unsigned int index;
+
+   memset (output, 0, BURST_BUFF_SIZE);
+   burstState (&present, text, 10);
+   CuAssertTrue(tc, generationSuccess == ax25BurstStart (&burst, output, BURST_BUFF_SIZE, 5));
+   CuAssertTrue(tc, generationSuccess == ax25BurstAdd (&burst, &present));
+   CuAssertTrue(tc, generationSuccess == ax25BurstEnd (&burst, 3, &size));
+
+   // TXDELAY is whole flags from the first byte
+   for (index = 0; index < 5; ++index)
+   {
+      CuAssertTrue(tc, (unsigned char)output[index] == FLAG);
+   }
+   CuAssertTrue(tc, (unsigned char)output[5] != FLAG);
+
+   // The last TXDELAY flag opens the frame, one flag closes it, then TXTAIL
+   count = burstBits (output, size, bits);
+   CuAssertTrue(tc, burstFlags (bits, count) == 5 + 1 + 3);
+   count = burstEnd (bits, count);
+   for (index = 0; index < 4 * 8; ++index)
+   {
+      CuAssertTrue(tc, bits[count - 4 * 8 + index] == ((FLAG >> (index % 8)) & 1));
+   }
+
+   // A TXDELAY of 0 still opens the frame, and a burst needs a frame
+   memset (output, 0, BURST_BUFF_SIZE);
+   CuAssertTrue(tc, generationSuccess == ax25BurstStart (&burst, output, BURST_BUFF_SIZE, 0));
+   CuAssertTrue(tc, (unsigned char)output[0] == FLAG);
+   CuAssertTrue(tc, packError == ax25BurstEnd (&burst, 3, &size));
+}
+
+void TestAX25BurstSharedFlags (CuTest* tc)
+{
+   burstBlock burst;
+   stateBlock present;
+   char first[] = "first frame";
+   char second[] = "\xff\xfe second";
+   char single [BURST_BUFF_SIZE];
+   char output [BURST_BUFF_SIZE];
+   unsigned char expected [BURST_BUFF_SIZE * 8];
+   unsigned char actual [BURST_BUFF_SIZE * 8];
+   unsigned int singleSize;
+   unsigned int expectedCount;
+   unsigned int actualCount;
+   unsigned int count;
+   unsigned int size = 0;
+
+   // Each frame on its own is flag, frame, flag
+   memset (single, 0, BURST_BUFF_SIZE);
+   singleSize = BURST_BUFF_SIZE;
+   burstState (&present, first, sizeof (first) - 1);
+   CuAssertTrue(tc, generationSuccess == ax25Entry (&present, single, &singleSize));
+   count = burstBits (single, singleSize, expected);
+   expectedCount = burstEnd (expected, count);
+
+   memset (single, 0, BURST_BUFF_SIZE);
+   singleSize = BURST_BUFF_SIZE;
+   burstState (&present, second, sizeof (second) - 1);
+   CuAssertTrue(tc, generationSuccess == ax25Entry (&present, single, &singleSize));
+   count = burstBits (single, singleSize, actual);
+   count = burstEnd (actual, count);
+   // The flag closing the first frame opens the second
+   memcpy (&expected[expectedCount], &actual[8], count - 8);
+   expectedCount += count - 8;
+
+   memset (output, 0, BURST_BUFF_SIZE);
+   CuAssertTrue(tc, generationSuccess == ax25BurstStart (&burst, output, BURST_BUFF_SIZE, 1));
+   burstState (&present, first, sizeof (first) - 1);
+   CuAssertTrue(tc, generationSuccess == ax25BurstAdd (&burst, &present));
+   burstState (&present, second, sizeof (second) - 1);
+   CuAssertTrue(tc, generationSuccess == ax25BurstAdd (&burst, &present));
+   CuAssertTrue(tc, generationSuccess == ax25BurstEnd (&burst, 0, &size));
+   CuAssertTrue(tc, burst.frames == 2);
+
+   actualCount = burstBits (output, size, actual);
+   CuAssertTrue(tc, burstFlags (actual, actualCount) == 3);
+   CuAssertTrue(tc, burstEnd (actual, actualCount) == expectedCount);
+   CuAssertTrue(tc, memcmp (actual, expected, expectedCount) == 0);
+}
+
+void TestAX25BurstPartialByte (CuTest* tc)
+{
+   burstBlock burst;
+   stateBlock present;
+   char text[] = "\xff\xff\xff";
+   char output [BURST_BUFF_SIZE];
+   unsigned char bits [BURST_BUFF_SIZE * 8];
+   unsigned int size = 0;
+   unsigned int used;
+   unsigned int count;
+   unsigned int index;
+
+   memset (output, 0, BURST_BUFF_SIZE);
+   burstState (&present, text, 3);
+   CuAssertTrue(tc, generationSuccess == ax25BurstStart (&burst, output, BURST_BUFF_SIZE, 2));
+   CuAssertTrue(tc, generationSuccess == ax25BurstAdd (&burst, &present));
+   CuAssertTrue(tc, generationSuccess == ax25BurstEnd (&burst, 2, &size));
+
+   // The stuffed zeros leave the burst part way through a byte
+   used = burst.out.index * 8 + burst.out.byte_pos;
+   CuAssertTrue(tc, burst.out.byte_pos != 0);
+   CuAssertTrue(tc, size == burst.out.index + 1);
+
+   count = burstBits (output, size, bits);
+   CuAssertTrue(tc, burstEnd (bits, count) == used);
+   CuAssertTrue(tc, burstFlags (bits, count) == 2 + 1 + 2);
+   // Closing flag and TXTAIL run right up to the last bit used
+   for (index = 0; index < 3 * 8; ++index)
+   {
+      CuAssertTrue(tc, bits[used - 3 * 8 + index] == ((FLAG >> (index % 8)) & 1));
+   }
+   // The rest of the last byte is left clear
+   for (index = used; index < count; ++index)
+   {
+      CuAssertTrue(tc, bits[index] == 0);
+   }
+}
+
 /*-------------------------------------------------------------------------*
  * main
  *-------------------------------------------------------------------------*/
@@ -513,6 +705,9 @@ CuSuite* CuGetSuite(void)
    SUITE_ADD_TEST(suite, TestInfoBuilder);
    SUITE_ADD_TEST(suite, TestAX25FcsCalc);
    SUITE_ADD_TEST(suite, TestAX25Entry);
+   SUITE_ADD_TEST(suite, TestAX25BurstPreambleAndTail);
+   SUITE_ADD_TEST(suite, TestAX25BurstSharedFlags);
+   SUITE_ADD_TEST(suite, TestAX25BurstPartialByte);
 
 
    return suite;
@@ -0,0 +1,115 @@
+/*
+ * cmdFrame.h
+ *
+ *  Created on: May 30, 2013
+ *
+ *  Binary command frames carried in the info field of AX.25 UI frames.
+ *
+ *     magic | seq | opcode hi | opcode lo | TLV args ... | crc lo | crc hi
+ *
+ *  Each argument is type, length and value. The crc is the AX.25 FCS over
+ *  everything before it. A response carries the same seq, the opcode with
+ *  CMD_RESPONSE set and a CMD_ARG_STATUS argument holding the handler's
+ *  UnivRetCode after any arguments the handler added.
+ *
+ *  Handlers are registered in a table sorted by opcode and found by binary
+ *  search. A frame repeated with the same seq and crc, as the ground
+ *  station does when it sends copies, is answered from the last response
+ *  without running the handler again.
+ */
+
+#ifndef CMDFRAME_H_
+#define CMDFRAME_H_
+#include "UniversalReturnCode.h"
+
+#define CMD_MAGIC          0xC5
+#define CMD_HEADER_SIZE    4
+#define CMD_CRC_SIZE       2
+#define CMD_MAX_FRAME      200
+#define CMD_MAX_HANDLERS   32
+#define CMD_RESPONSE       0x8000
+#define CMD_ARG_STATUS     0x00
+
+typedef struct //cmdArg
+{
+   unsigned char         type;
+   unsigned char         length;
+   const unsigned char * value;
+}cmdArg;
+
+typedef struct //cmdRequest
+{
+   unsigned char         seq;
+   unsigned short        opcode;
+   const unsigned char * args;
+   unsigned int          argsSize;
+}cmdRequest;
+
+typedef struct //cmdBuilder
+{
+   unsigned char * out;
+   unsigned int    size;
+   unsigned int    index;
+   unsigned char   overflow;
+}cmdBuilder;
+
+// Runs a command, arguments for the response go into the builder. Returning
+// URC_CMD_NO_REPLY sends nothing back, for streams acknowledged in batches.
+typedef UnivRetCode (*cmdHandler) (const cmdRequest * request, cmdBuilder * response);
+
+typedef struct //cmdEntry
+{
+   unsigned short opcode;
+   cmdHandler     handler;
+}cmdEntry;
+
+typedef struct //cmdDispatcher
+{
+   cmdEntry       table[CMD_MAX_HANDLERS];
+   unsigned int   count;
+   // last frame handled, for answering repeats
+   unsigned char  haveLast;
+   unsigned char  lastSeq;
+   unsigned short lastCrc;
+   unsigned char  lastResponse[CMD_MAX_FRAME];
+   unsigned int   lastResponseSize;
+   // audit counters
+   unsigned int   handled;
+   unsigned int   repeats;
+   unsigned int   rejected;
+}cmdDispatcher;
+
+unsigned short cmdCrc (const unsigned char * data, unsigned int size);
+
+// Checks magic, crc and that the arguments are well formed
+UnivRetCode cmdParse (const unsigned char * frame, unsigned int size, cmdRequest * request);
+
+// Steps through the arguments, start with *pos at 0
+UnivRetCode cmdNextArg (const cmdRequest * request, unsigned int * pos, cmdArg * arg);
+
+// First argument of a type, length must match unless it is 0
+UnivRetCode cmdFindArg (const cmdRequest * request, unsigned char type, unsigned char length, cmdArg * arg);
+
+void cmdBuildStart (cmdBuilder * builder, unsigned char * out, unsigned int size,
+                    unsigned char seq, unsigned short opcode);
+UnivRetCode cmdBuildArg (cmdBuilder * builder, unsigned char type, unsigned char length, const void * value);
+UnivRetCode cmdBuildEnd (cmdBuilder * builder, unsigned int * size);
+
+void cmdInit (cmdDispatcher * dispatcher);
+
+// Keeps the table sorted, an opcode can only be registered once
+UnivRetCode cmdRegister (cmdDispatcher * dispatcher, unsigned short opcode, cmdHandler handler);
+
+cmdHandler cmdLookup (cmdDispatcher * dispatcher, unsigned short opcode);
+
+// Handles one received frame and builds the response. Frames that fail
+// parsing and handlers with no reply get no response, *responseSize is 0.
+UnivRetCode cmdDispatch (cmdDispatcher * dispatcher, const unsigned char * frame, unsigned int size,
+                         unsigned char * response, unsigned int * responseSize);
+
+// Runs an already parsed request and builds the response the same way,
+// without the repeat check, for commands that were stored to run later
+UnivRetCode cmdExecute (cmdDispatcher * dispatcher, const cmdRequest * request,
+                        unsigned char * response, unsigned int * responseSize);
+
+#endif /* CMDFRAME_H_ */
@@ -0,0 +1,216 @@
+/*
+ * cmdFrame.c
+ *
+ *  Created on: May 30, 2013
+ */
+#include "cmdFrame.h"
+
+#define CMD_CRC_POLYNOMIAL 0x8408   // AX.25 FCS, bit reversed
+
+unsigned short cmdCrc (const unsigned char * data, unsigned int size)
+{
+   unsigned short crc = 0xFFFF;
+   unsigned int index, bit;
+   for (index = 0; index < size; ++index)
+   {
+      crc ^= data[index];
+      for (bit = 0; bit < 8; ++bit)
+      {
+         crc = (crc & 1)?((crc >> 1) ^ CMD_CRC_POLYNOMIAL):(crc >> 1);
+      }
+   }
+   return ~crc;
+}
+
+UnivRetCode cmdParse (const unsigned char * frame, unsigned int size, cmdRequest * request)
+{
+   unsigned int pos = 0;
+   cmdArg arg;
+   if (frame == NULL || request == NULL) return URC_FAIL;
+   if (size < CMD_HEADER_SIZE + CMD_CRC_SIZE || size > CMD_MAX_FRAME) return URC_FAIL;
+   if (frame[0] != CMD_MAGIC) return URC_FAIL;
+   if (cmdCrc (frame, size - CMD_CRC_SIZE) !=
+       (frame[size - 2] | (frame[size - 1] << 8))) return URC_FAIL;
+
+   request->seq      = frame[1];
+   request->opcode   = (frame[2] << 8) | frame[3];
+   request->args     = &frame[CMD_HEADER_SIZE];
+   request->argsSize = size - CMD_HEADER_SIZE - CMD_CRC_SIZE;
+
+   // walk the arguments once so handlers can trust the lengths
+   while (cmdNextArg (request, &pos, &arg) == URC_SUCCESS);
+   return (pos == request->argsSize)?URC_SUCCESS:URC_FAIL;
+}
+
+UnivRetCode cmdNextArg (const cmdRequest * request, unsigned int * pos, cmdArg * arg)
+{
+   if (request == NULL || pos == NULL || arg == NULL) return URC_FAIL;
+   if (*pos + 2 > request->argsSize) return URC_FAIL;
+   if (*pos + 2 + request->args[*pos + 1] > request->argsSize) return URC_FAIL;
+   arg->type   = request->args[*pos];
+   arg->length = request->args[*pos + 1];
+   arg->value  = &request->args[*pos + 2];
+   *pos += 2 + arg->length;
+   return URC_SUCCESS;
+}
+
+UnivRetCode cmdFindArg (const cmdRequest * request, unsigned char type, unsigned char length, cmdArg * arg)
+{
+   unsigned int pos = 0;
+   while (cmdNextArg (request, &pos, arg) == URC_SUCCESS)
+   {
+      if (arg->type != type) continue;
+      return (length == 0 || arg->length == length)?URC_SUCCESS:URC_CMD_BAD_ARG;
+   }
+   return URC_CMD_BAD_ARG;
+}
+
+void cmdBuildStart (cmdBuilder * builder, unsigned char * out, unsigned int size,
+                    unsigned char seq, unsigned short opcode)
+{
+   builder->out      = out;
+   builder->size     = size;
+   builder->index    = 0;
+   builder->overflow = (size < CMD_HEADER_SIZE + CMD_CRC_SIZE);
+   if (builder->overflow) return;
+   out[0] = CMD_MAGIC;
+   out[1] = seq;
+   out[2] = opcode >> 8;
+   out[3] = opcode & 0xFF;
+   builder->index = CMD_HEADER_SIZE;
+}
+
+UnivRetCode cmdBuildArg (cmdBuilder * builder, unsigned char type, unsigned char length, const void * value)
+{
+   unsigned int pos;
+   if (builder == NULL || builder->overflow) return URC_FAIL;
+   if (builder->index + 2 + length + CMD_CRC_SIZE > builder->size)
+   {
+      builder->overflow = 1;
+      return URC_FAIL;
+   }
+   builder->out[builder->index++] = type;
+   builder->out[builder->index++] = length;
+   for (pos = 0; pos < length; ++pos)
+   {
+      builder->out[builder->index++] = ((const unsigned char *)value)[pos];
+   }
+   return URC_SUCCESS;
+}
+
+UnivRetCode cmdBuildEnd (cmdBuilder * builder, unsigned int * size)
+{
+   unsigned short crc;
+   if (builder == NULL || size == NULL || builder->overflow) return URC_FAIL;
+   crc = cmdCrc (builder->out, builder->index);
+   builder->out[builder->index++] = crc & 0xFF;
+   builder->out[builder->index++] = crc >> 8;
+   *size = builder->index;
+   return URC_SUCCESS;
+}
+
+void cmdInit (cmdDispatcher * dispatcher)
+{
+   if (dispatcher == NULL) return;
+   dispatcher->count            = 0;
+   dispatcher->haveLast         = 0;
+   dispatcher->lastResponseSize = 0;
+   dispatcher->handled          = 0;
+   dispatcher->repeats          = 0;
+   dispatcher->rejected         = 0;
+}
+
+UnivRetCode cmdRegister (cmdDispatcher * dispatcher, unsigned short opcode, cmdHandler handler)
+{
+   unsigned int pos;
+   if (dispatcher == NULL || handler == NULL) return URC_FAIL;
+   if (dispatcher->count >= CMD_MAX_HANDLERS || (opcode & CMD_RESPONSE)) return URC_FAIL;
+   if (cmdLookup (dispatcher, opcode) != NULL) return URC_FAIL;
+   for (pos = dispatcher->count; pos > 0 && dispatcher->table[pos - 1].opcode > opcode; --pos)
+   {
+      dispatcher->table[pos] = dispatcher->table[pos - 1];
+   }
+   dispatcher->table[pos].opcode  = opcode;
+   dispatcher->table[pos].handler = handler;
+   dispatcher->count++;
+   return URC_SUCCESS;
+}
+
+cmdHandler cmdLookup (cmdDispatcher * dispatcher, unsigned short opcode)
+{
+   unsigned int low = 0, high, mid;
+   if (dispatcher == NULL) return NULL;
+   high = dispatcher->count;
+   while (low < high)
+   {
+      mid = (low + high) / 2;
+      if (dispatcher->table[mid].opcode == opcode) return dispatcher->table[mid].handler;
+      if (dispatcher->table[mid].opcode < opcode) low  = mid + 1;
+      else                                        high = mid;
+   }
+   return NULL;
+}
+
+UnivRetCode cmdDispatch (cmdDispatcher * dispatcher, const unsigned char * frame, unsigned int size,
+                         unsigned char * response, unsigned int * responseSize)
+{
+   cmdRequest request;
+   unsigned short crc;
+   unsigned int pos;
+
+   if (dispatcher == NULL || response == NULL || responseSize == NULL) return URC_FAIL;
+   *responseSize = 0;
+   if (cmdParse (frame, size, &request) != URC_SUCCESS)
+   {
+      dispatcher->rejected++;
+      return URC_FAIL;
+   }
+
+   crc = frame[size - 2] | (frame[size - 1] << 8);
+   if (dispatcher->haveLast && dispatcher->lastSeq == request.seq && dispatcher->lastCrc == crc)
+   {
+      dispatcher->repeats++;
+      for (pos = 0; pos < dispatcher->lastResponseSize; ++pos) response[pos] = dispatcher->lastResponse[pos];
+      *responseSize = dispatcher->lastResponseSize;
+      return URC_SUCCESS;
+   }
+
+   cmdExecute (dispatcher, &request, response, responseSize);
+
+   // no reply is cached too, so a repeated copy stays quiet as well
+   dispatcher->haveLast = 1;
+   dispatcher->lastSeq  = request.seq;
+   dispatcher->lastCrc  = crc;
+   for (pos = 0; pos < *responseSize; ++pos) dispatcher->lastResponse[pos] = response[pos];
+   dispatcher->lastResponseSize = *responseSize;
+   return URC_SUCCESS;
+}
+
+UnivRetCode cmdExecute (cmdDispatcher * dispatcher, const cmdRequest * request,
+                        unsigned char * response, unsigned int * responseSize)
+{
+   cmdBuilder builder;
+   cmdHandler handler;
+   unsigned char status;
+   UnivRetCode result;
+
+   if (dispatcher == NULL || request == NULL || response == NULL || responseSize == NULL) return URC_FAIL;
+   *responseSize = 0;
+
+   cmdBuildStart (&builder, response, CMD_MAX_FRAME, request->seq, request->opcode | CMD_RESPONSE);
+   handler = cmdLookup (dispatcher, request->opcode);
+   result  = (handler != NULL)?handler (request, &builder):URC_CMD_NO_HANDLER;
+   dispatcher->handled++;
+   if (result == URC_CMD_NO_REPLY) return URC_SUCCESS;
+
+   // the status always fits, drop what the handler added if it does not
+   if (builder.overflow || builder.index + 3 + CMD_CRC_SIZE > CMD_MAX_FRAME)
+   {
+      cmdBuildStart (&builder, response, CMD_MAX_FRAME, request->seq, request->opcode | CMD_RESPONSE);
+      result = URC_FAIL;
+   }
+   status = (unsigned char)result;
+   cmdBuildArg (&builder, CMD_ARG_STATUS, 1, &status);
+   cmdBuildEnd (&builder, responseSize);
+   return URC_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "cmdFrame.h"
+
+static unsigned int echoCalls;
+
+static UnivRetCode echoHandler (const cmdRequest * request, cmdBuilder * response)
+{
+   cmdArg arg;
+   echoCalls++;
+   if (cmdFindArg (request, 1, 0, &arg) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+   return cmdBuildArg (response, 1, arg.length, arg.value);
+}
+
+static UnivRetCode pingHandler (const cmdRequest * request, cmdBuilder * response)
+{
+   (void) request;
+   (void) response;
+   return URC_SUCCESS;
+}
+
+static UnivRetCode quietHandler (const cmdRequest * request, cmdBuilder * response)
+{
+   (void) request;
+   (void) response;
+   return URC_CMD_NO_REPLY;
+}
+
+static unsigned int buildFrame (unsigned char * out, unsigned char seq, unsigned short opcode,
+                                const char * text)
+{
+   cmdBuilder builder;
+   unsigned int size = 0;
+   cmdBuildStart (&builder, out, CMD_MAX_FRAME, seq, opcode);
+   if (text != NULL) cmdBuildArg (&builder, 1, strlen (text), text);
+   cmdBuildEnd (&builder, &size);
+   return size;
+}
+
+void TestCmdCrcMatchesAx25(CuTest* tc)
+{
+   // AX.25 / X.25 check value
+   CuAssertTrue(tc, cmdCrc ((const unsigned char *)"123456789", 9) == 0x906E);
+}
+
+void TestCmdBuildParse(CuTest* tc)
+{
+   unsigned char frame[CMD_MAX_FRAME];
+   unsigned int size;
+   cmdRequest request;
+   cmdArg arg;
+   size = buildFrame (frame, 7, 0x0102, "hello");
+   CuAssertTrue(tc, size == CMD_HEADER_SIZE + 2 + 5 + CMD_CRC_SIZE);
+   CuAssertTrue(tc, cmdParse (frame, size, &request) == URC_SUCCESS);
+   CuAssertTrue(tc, request.seq == 7);
+   CuAssertTrue(tc, request.opcode == 0x0102);
+   CuAssertTrue(tc, cmdFindArg (&request, 1, 5, &arg) == URC_SUCCESS);
+   CuAssertTrue(tc, memcmp (arg.value, "hello", 5) == 0);
+   CuAssertTrue(tc, cmdFindArg (&request, 1, 4, &arg) == URC_CMD_BAD_ARG);
+   CuAssertTrue(tc, cmdFindArg (&request, 2, 0, &arg) == URC_CMD_BAD_ARG);
+
+   // any damage is rejected
+   frame[5] ^= 0x10;
+   CuAssertTrue(tc, cmdParse (frame, size, &request) == URC_FAIL);
+   frame[5] ^= 0x10;
+   CuAssertTrue(tc, cmdParse (frame, size - 1, &request) == URC_FAIL);
+   frame[0] = 0;
+   CuAssertTrue(tc, cmdParse (frame, size, &request) == URC_FAIL);
+}
+
+void TestCmdRegisterLookup(CuTest* tc)
+{
+   cmdDispatcher dispatcher;
+   unsigned int index;
+   cmdInit (&dispatcher);
+   CuAssertTrue(tc, cmdRegister (&dispatcher, 0x0020, echoHandler) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdRegister (&dispatcher, 0x0001, pingHandler) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdRegister (&dispatcher, 0x0010, echoHandler) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdRegister (&dispatcher, 0x0010, pingHandler) == URC_FAIL);
+   CuAssertTrue(tc, cmdRegister (&dispatcher, 0x8001, pingHandler) == URC_FAIL);
+   for (index = 1; index < dispatcher.count; ++index)
+   {
+      CuAssertTrue(tc, dispatcher.table[index - 1].opcode < dispatcher.table[index].opcode);
+   }
+   CuAssertTrue(tc, cmdLookup (&dispatcher, 0x0001) == pingHandler);
+   CuAssertTrue(tc, cmdLookup (&dispatcher, 0x0020) == echoHandler);
+   CuAssertTrue(tc, cmdLookup (&dispatcher, 0x0002) == NULL);
+   while (cmdRegister (&dispatcher, 0x100 + dispatcher.count, pingHandler) == URC_SUCCESS);
+   CuAssertTrue(tc, dispatcher.count == CMD_MAX_HANDLERS);
+}
+
+void TestCmdDispatch(CuTest* tc)
+{
+   cmdDispatcher dispatcher;
+   unsigned char frame[CMD_MAX_FRAME];
+   unsigned char response[CMD_MAX_FRAME];
+   unsigned int size, responseSize;
+   cmdRequest reply;
+   cmdArg arg;
+   cmdInit (&dispatcher);
+   cmdRegister (&dispatcher, 0x0020, echoHandler);
+   echoCalls = 0;
+
+   size = buildFrame (frame, 3, 0x0020, "abc");
+   CuAssertTrue(tc, cmdDispatch (&dispatcher, frame, size, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdParse (response, responseSize, &reply) == URC_SUCCESS);
+   CuAssertTrue(tc, reply.seq == 3);
+   CuAssertTrue(tc, reply.opcode == (0x0020 | CMD_RESPONSE));
+   CuAssertTrue(tc, cmdFindArg (&reply, 1, 3, &arg) == URC_SUCCESS);
+   CuAssertTrue(tc, memcmp (arg.value, "abc", 3) == 0);
+   CuAssertTrue(tc, cmdFindArg (&reply, CMD_ARG_STATUS, 1, &arg) == URC_SUCCESS);
+   CuAssertTrue(tc, arg.value[0] == URC_SUCCESS);
+
+   // a repeated copy is answered without running the handler again
+   CuAssertTrue(tc, cmdDispatch (&dispatcher, frame, size, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, echoCalls == 1);
+   CuAssertTrue(tc, dispatcher.repeats == 1);
+   CuAssertTrue(tc, cmdParse (response, responseSize, &reply) == URC_SUCCESS);
+
+   // handler errors and unknown opcodes come back in the status
+   size = buildFrame (frame, 4, 0x0020, NULL);
+   cmdDispatch (&dispatcher, frame, size, response, &responseSize);
+   CuAssertTrue(tc, echoCalls == 2);
+   cmdParse (response, responseSize, &reply);
+   cmdFindArg (&reply, CMD_ARG_STATUS, 1, &arg);
+   CuAssertTrue(tc, arg.value[0] == URC_CMD_BAD_ARG);
+
+   size = buildFrame (frame, 5, 0x0033, NULL);
+   cmdDispatch (&dispatcher, frame, size, response, &responseSize);
+   cmdParse (response, responseSize, &reply);
+   cmdFindArg (&reply, CMD_ARG_STATUS, 1, &arg);
+   CuAssertTrue(tc, arg.value[0] == URC_CMD_NO_HANDLER);
+
+   // damaged frames get no answer at all
+   frame[2] ^= 1;
+   CuAssertTrue(tc, cmdDispatch (&dispatcher, frame, size, response, &responseSize) == URC_FAIL);
+   CuAssertTrue(tc, responseSize == 0);
+   CuAssertTrue(tc, dispatcher.rejected == 1);
+}
+
+void TestCmdDispatchNoReply(CuTest* tc)
+{
+   cmdDispatcher dispatcher;
+   unsigned char frame[CMD_MAX_FRAME];
+   unsigned char response[CMD_MAX_FRAME];
+   unsigned int size, responseSize = 1;
+   cmdInit (&dispatcher);
+   cmdRegister (&dispatcher, 0x0031, quietHandler);
+   size = buildFrame (frame, 9, 0x0031, "data");
+   CuAssertTrue(tc, cmdDispatch (&dispatcher, frame, size, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, responseSize == 0);
+   responseSize = 1;
+   CuAssertTrue(tc, cmdDispatch (&dispatcher, frame, size, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, responseSize == 0);
+   CuAssertTrue(tc, dispatcher.repeats == 1);
+}
+
+void TestCmdExecute(CuTest* tc)
+{
+   cmdDispatcher dispatcher;
+   unsigned char frame[CMD_MAX_FRAME];
+   unsigned char response[CMD_MAX_FRAME];
+   unsigned int size, responseSize;
+   cmdRequest request, reply;
+   cmdArg arg;
+   cmdInit (&dispatcher);
+   cmdRegister (&dispatcher, 0x0020, echoHandler);
+   echoCalls = 0;
+
+   size = buildFrame (frame, 6, 0x0020, "xyz");
+   CuAssertTrue(tc, cmdParse (frame, size, &request) == URC_SUCCESS);
+   cmdDispatch (&dispatcher, frame, size, response, &responseSize);
+   // stored commands run every time, even straight after the same frame
+   CuAssertTrue(tc, cmdExecute (&dispatcher, &request, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdExecute (&dispatcher, &request, response, &responseSize) == URC_SUCCESS);
+   CuAssertTrue(tc, echoCalls == 3);
+   CuAssertTrue(tc, dispatcher.repeats == 0);
+   CuAssertTrue(tc, cmdParse (response, responseSize, &reply) == URC_SUCCESS);
+   CuAssertTrue(tc, reply.seq == 6);
+   CuAssertTrue(tc, cmdFindArg (&reply, 1, 3, &arg) == URC_SUCCESS);
+   CuAssertTrue(tc, cmdFindArg (&reply, CMD_ARG_STATUS, 1, &arg) == URC_SUCCESS);
+   CuAssertTrue(tc, arg.value[0] == URC_SUCCESS);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestCmdCrcMatchesAx25);
+   SUITE_ADD_TEST(suite, TestCmdBuildParse);
+   SUITE_ADD_TEST(suite, TestCmdRegisterLookup);
+   SUITE_ADD_TEST(suite, TestCmdDispatch);
+   SUITE_ADD_TEST(suite, TestCmdDispatchNoReply);
+   SUITE_ADD_TEST(suite, TestCmdExecute);
+   return suite;
+}
@@ -0,0 +1,78 @@
+/*
+ * dltPatch.h
+ *
+ *  Created on: Jun 3, 2013
+ *
+ *  Applies a binary delta against the image in flash. A patch is a header
+ *  followed by opcodes, numbers are LEB128 varints and source moves are
+ *  zigzag coded relative to where the last copy ended.
+ *
+ *     COPY   move, length                   bytes straight from the source
+ *     INSERT length, bytes                  new bytes
+ *     EDIT   move, length, count,           source bytes with count runs
+ *            count x (gap, n, n bytes)      replaced, gap counts from the
+ *                                           end of the previous run
+ *     END
+ *
+ *  EDIT covers code that only moved, where branch offsets and pointers
+ *  change but everything around them is the same. The patch is pulled in
+ *  through a small buffer and the result pushed out a block at a time, so
+ *  neither has to fit in RAM.
+ */
+
+#ifndef DLTPATCH_H_
+#define DLTPATCH_H_
+#include "UniversalReturnCode.h"
+
+#define DLT_MAGIC          0x31544C44UL   // "DLT1"
+#define DLT_HEADER_SIZE    20
+#define DLT_IN_BUFFER      64
+
+#define DLT_OP_END         0x00
+#define DLT_OP_COPY        0x01
+#define DLT_OP_INSERT      0x02
+#define DLT_OP_EDIT        0x03
+
+// Patch bytes from offset, returns how many were read
+typedef unsigned int (*dltReadFn) (void * ctx, unsigned long offset, unsigned char * buffer, unsigned int size);
+// Result bytes for offset, a whole out buffer at a time except the last
+typedef UnivRetCode (*dltWriteFn) (void * ctx, unsigned long offset, const unsigned char * data, unsigned int size);
+
+typedef struct //dltHeader
+{
+   unsigned long sourceSize;
+   unsigned long sourceCrc;
+   unsigned long targetSize;
+   unsigned long targetCrc;
+}dltHeader;
+
+typedef struct //dltPatch
+{
+   dltReadFn       read;
+   dltWriteFn      write;
+   void *          ctx;
+   unsigned char   in[DLT_IN_BUFFER];
+   unsigned int    inFill;
+   unsigned int    inPos;
+   unsigned long   inOffset;      // patch offset of the next refill
+   unsigned char * out;
+   unsigned int    outSize;
+   unsigned int    outFill;
+   unsigned long   written;       // result bytes produced so far
+   unsigned long   crc;
+   dltHeader       header;
+}dltPatch;
+
+void dltInit (dltPatch * patch, dltReadFn read, dltWriteFn write, void * ctx,
+              unsigned char * out, unsigned int outSize);
+
+UnivRetCode dltReadHeader (dltPatch * patch, dltHeader * header);
+
+// Source must be the image the patch was made against, it is checked first.
+// It is not checked for NULL, the running image starts at address 0.
+UnivRetCode dltApply (dltPatch * patch, const unsigned char * source);
+
+// CRC-32 as used by zip, chain by passing the previous result, start at 0
+unsigned long dltCrc32 (unsigned long crc, const unsigned char * data, unsigned long size);
+
+#endif /* DLTPATCH_H_ */
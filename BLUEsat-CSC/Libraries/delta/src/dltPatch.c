@@ -0,0 +1,212 @@
+/*
+ * dltPatch.c
+ *
+ *  Created on: Jun 3, 2013
+ */
+#include "dltPatch.h"
+
+#define DLT_CRC32_POLYNOMIAL 0xEDB88320UL
+#define DLT_VARINT_BYTES     5
+
+static UnivRetCode getByte (dltPatch * patch, unsigned char * byte);
+static UnivRetCode getLong (dltPatch * patch, unsigned long * value);
+static UnivRetCode getVarint (dltPatch * patch, unsigned long * value);
+static UnivRetCode getMove (dltPatch * patch, unsigned long * sourcePos);
+static UnivRetCode put (dltPatch * patch, const unsigned char * data, unsigned long size);
+static UnivRetCode putPatch (dltPatch * patch, unsigned long size);
+static UnivRetCode flush (dltPatch * patch);
+
+void dltInit (dltPatch * patch, dltReadFn read, dltWriteFn write, void * ctx,
+              unsigned char * out, unsigned int outSize)
+{
+   if (patch == NULL) return;
+   patch->read     = read;
+   patch->write    = write;
+   patch->ctx      = ctx;
+   patch->inFill   = 0;
+   patch->inPos    = 0;
+   patch->inOffset = 0;
+   patch->out      = out;
+   patch->outSize  = outSize;
+   patch->outFill  = 0;
+   patch->written  = 0;
+   patch->crc      = 0;
+}
+
+UnivRetCode dltReadHeader (dltPatch * patch, dltHeader * header)
+{
+   unsigned long magic;
+   if (patch == NULL || patch->read == NULL) return URC_FAIL;
+   if (getLong (patch, &magic) != URC_SUCCESS || magic != DLT_MAGIC) return URC_FAIL;
+   if (getLong (patch, &patch->header.sourceSize) != URC_SUCCESS) return URC_FAIL;
+   if (getLong (patch, &patch->header.sourceCrc) != URC_SUCCESS) return URC_FAIL;
+   if (getLong (patch, &patch->header.targetSize) != URC_SUCCESS) return URC_FAIL;
+   if (getLong (patch, &patch->header.targetCrc) != URC_SUCCESS) return URC_FAIL;
+   if (header != NULL) *header = patch->header;
+   return URC_SUCCESS;
+}
+
+UnivRetCode dltApply (dltPatch * patch, const unsigned char * source)
+{
+   unsigned char op;
+   unsigned long sourcePos = 0;
+   unsigned long length, count, gap, run;
+   if (patch == NULL || patch->write == NULL || patch->outSize == 0) return URC_FAIL;
+   if (dltCrc32 (0, source, patch->header.sourceSize) != patch->header.sourceCrc) return URC_FAIL;
+
+   for (;;)
+   {
+      if (getByte (patch, &op) != URC_SUCCESS) return URC_FAIL;
+      switch (op)
+      {
+         case DLT_OP_END:
+            if (flush (patch) != URC_SUCCESS) return URC_FAIL;
+            if (patch->written != patch->header.targetSize) return URC_FAIL;
+            return (patch->crc == patch->header.targetCrc)?URC_SUCCESS:URC_FAIL;
+
+         case DLT_OP_COPY:
+            if (getMove (patch, &sourcePos) != URC_SUCCESS) return URC_FAIL;
+            if (getVarint (patch, &length) != URC_SUCCESS) return URC_FAIL;
+            if (length > patch->header.sourceSize - sourcePos) return URC_FAIL;
+            if (put (patch, &source[sourcePos], length) != URC_SUCCESS) return URC_FAIL;
+            sourcePos += length;
+            break;
+
+         case DLT_OP_INSERT:
+            if (getVarint (patch, &length) != URC_SUCCESS) return URC_FAIL;
+            if (putPatch (patch, length) != URC_SUCCESS) return URC_FAIL;
+            break;
+
+         case DLT_OP_EDIT:
+            if (getMove (patch, &sourcePos) != URC_SUCCESS) return URC_FAIL;
+            if (getVarint (patch, &length) != URC_SUCCESS) return URC_FAIL;
+            if (getVarint (patch, &count) != URC_SUCCESS) return URC_FAIL;
+            if (length > patch->header.sourceSize - sourcePos) return URC_FAIL;
+            while (count-- > 0)
+            {
+               if (getVarint (patch, &gap) != URC_SUCCESS) return URC_FAIL;
+               if (getVarint (patch, &run) != URC_SUCCESS) return URC_FAIL;
+               if (gap > length || run > length - gap) return URC_FAIL;
+               if (put (patch, &source[sourcePos], gap) != URC_SUCCESS) return URC_FAIL;
+               if (putPatch (patch, run) != URC_SUCCESS) return URC_FAIL;
+               sourcePos += gap + run;
+               length    -= gap + run;
+            }
+            if (put (patch, &source[sourcePos], length) != URC_SUCCESS) return URC_FAIL;
+            sourcePos += length;
+            break;
+
+         default:
+            return URC_FAIL;
+      }
+   }
+}
+
+unsigned long dltCrc32 (unsigned long crc, const unsigned char * data, unsigned long size)
+{
+   unsigned long index;
+   unsigned int bit;
+   crc = ~crc & 0xFFFFFFFFUL;
+   for (index = 0; index < size; ++index)
+   {
+      crc ^= data[index];
+      for (bit = 0; bit < 8; ++bit)
+      {
+         crc = (crc & 1)?((crc >> 1) ^ DLT_CRC32_POLYNOMIAL):(crc >> 1);
+      }
+   }
+   return ~crc & 0xFFFFFFFFUL;
+}
+
+static UnivRetCode getByte (dltPatch * patch, unsigned char * byte)
+{
+   if (patch->inPos >= patch->inFill)
+   {
+      patch->inFill    = patch->read (patch->ctx, patch->inOffset, patch->in, DLT_IN_BUFFER);
+      patch->inOffset += patch->inFill;
+      patch->inPos     = 0;
+      if (patch->inFill == 0) return URC_FAIL;
+   }
+   *byte = patch->in[patch->inPos++];
+   return URC_SUCCESS;
+}
+
+// Header fields are little endian
+static UnivRetCode getLong (dltPatch * patch, unsigned long * value)
+{
+   unsigned char byte;
+   unsigned int index;
+   *value = 0;
+   for (index = 0; index < 4; ++index)
+   {
+      if (getByte (patch, &byte) != URC_SUCCESS) return URC_FAIL;
+      *value |= (unsigned long)byte << (8 * index);
+   }
+   return URC_SUCCESS;
+}
+
+static UnivRetCode getVarint (dltPatch * patch, unsigned long * value)
+{
+   unsigned char byte;
+   unsigned int index;
+   *value = 0;
+   for (index = 0; index < DLT_VARINT_BYTES; ++index)
+   {
+      if (getByte (patch, &byte) != URC_SUCCESS) return URC_FAIL;
+      *value |= (unsigned long)(byte & 0x7F) << (7 * index);
+      if (!(byte & 0x80)) return URC_SUCCESS;
+   }
+   return URC_FAIL;
+}
+
+static UnivRetCode getMove (dltPatch * patch, unsigned long * sourcePos)
+{
+   unsigned long zigzag;
+   unsigned long distance;
+   if (getVarint (patch, &zigzag) != URC_SUCCESS) return URC_FAIL;
+   distance = (zigzag >> 1) + (zigzag & 1);
+   if (zigzag & 1)
+   {
+      if (distance > *sourcePos) return URC_FAIL;
+      *sourcePos -= distance;
+   }
+   else
+   {
+      if (distance > patch->header.sourceSize - *sourcePos) return URC_FAIL;
+      *sourcePos += distance;
+   }
+   return URC_SUCCESS;
+}
+
+static UnivRetCode put (dltPatch * patch, const unsigned char * data, unsigned long size)
+{
+   unsigned long index;
+   if (size > patch->header.targetSize - patch->written - patch->outFill) return URC_FAIL;
+   for (index = 0; index < size; ++index)
+   {
+      patch->out[patch->outFill++] = data[index];
+      if (patch->outFill == patch->outSize && flush (patch) != URC_SUCCESS) return URC_FAIL;
+   }
+   return URC_SUCCESS;
+}
+
+static UnivRetCode putPatch (dltPatch * patch, unsigned long size)
+{
+   unsigned char byte;
+   while (size-- > 0)
+   {
+      if (getByte (patch, &byte) != URC_SUCCESS) return URC_FAIL;
+      if (put (patch, &byte, 1) != URC_SUCCESS) return URC_FAIL;
+   }
+   return URC_SUCCESS;
+}
+
+static UnivRetCode flush (dltPatch * patch)
+{
+   if (patch->outFill == 0) return URC_SUCCESS;
+   patch->crc = dltCrc32 (patch->crc, patch->out, patch->outFill);
+   if (patch->write (patch->ctx, patch->written, patch->out, patch->outFill) != URC_SUCCESS) return URC_FAIL;
+   patch->written += patch->outFill;
+   patch->outFill  = 0;
+   return URC_SUCCESS;
+}
@@ -0,0 +1,295 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "dltPatch.h"
+
+#define IMAGE_SIZE   8192
+#define INSERT_AT    3000
+#define INSERT_SIZE  64
+
+typedef struct
+{
+   const unsigned char * data;
+   unsigned long         size;
+   unsigned char *       result;
+   unsigned long         resultSize;
+   unsigned int          lastWrite;
+   unsigned int          writes;
+}memCtx;
+
+static unsigned char patchBuf[IMAGE_SIZE];
+static unsigned long patchSize;
+static unsigned char source[IMAGE_SIZE];
+static unsigned char target[IMAGE_SIZE + INSERT_SIZE];
+static unsigned char result[IMAGE_SIZE + INSERT_SIZE];
+
+static unsigned int memRead (void * ctx, unsigned long offset, unsigned char * buffer, unsigned int size)
+{
+   memCtx * mem = ctx;
+   // hand out odd sized pieces to shake the refill logic
+   if (size > 13) size = 13;
+   if (offset >= mem->size) return 0;
+   if (size > mem->size - offset) size = mem->size - offset;
+   memcpy (buffer, &mem->data[offset], size);
+   return size;
+}
+
+static UnivRetCode memWrite (void * ctx, unsigned long offset, const unsigned char * data, unsigned int size)
+{
+   memCtx * mem = ctx;
+   if (offset != mem->resultSize) return URC_FAIL;
+   memcpy (&mem->result[offset], data, size);
+   mem->resultSize += size;
+   mem->lastWrite = size;
+   mem->writes++;
+   return URC_SUCCESS;
+}
+
+static void emitByte (unsigned char byte)
+{
+   patchBuf[patchSize++] = byte;
+}
+
+static void emitLong (unsigned long value)
+{
+   unsigned int index;
+   for (index = 0; index < 4; ++index) emitByte ((value >> (8 * index)) & 0xFF);
+}
+
+static void emitVarint (unsigned long value)
+{
+   while (value >= 0x80)
+   {
+      emitByte ((value & 0x7F) | 0x80);
+      value >>= 7;
+   }
+   emitByte (value);
+}
+
+static void emitMove (long move)
+{
+   emitVarint ((move < 0)?(unsigned long)(-move * 2 - 1):(unsigned long)(move * 2));
+}
+
+static void emitHeader (const unsigned char * from, unsigned long fromSize,
+                        const unsigned char * to, unsigned long toSize)
+{
+   patchSize = 0;
+   emitLong (DLT_MAGIC);
+   emitLong (fromSize);
+   emitLong (dltCrc32 (0, from, fromSize));
+   emitLong (toSize);
+   emitLong (dltCrc32 (0, to, toSize));
+}
+
+// COPY when the bytes match, otherwise EDIT with a run for each difference
+static void emitRegion (long move, const unsigned char * from, const unsigned char * to, unsigned long length)
+{
+   unsigned long index, runs = 0, last = 0, start;
+   for (index = 0; index < length; ++index)
+   {
+      if (from[index] != to[index] && (index == 0 || from[index - 1] == to[index - 1])) runs++;
+   }
+   emitByte (runs?DLT_OP_EDIT:DLT_OP_COPY);
+   emitMove (move);
+   emitVarint (length);
+   if (!runs) return;
+   emitVarint (runs);
+   for (index = 0; index < length; )
+   {
+      if (from[index] == to[index])
+      {
+         ++index;
+         continue;
+      }
+      for (start = index; index < length && from[index] != to[index]; ++index);
+      emitVarint (start - last);
+      emitVarint (index - start);
+      while (start < index) emitByte (to[start++]);
+      last = index;
+   }
+}
+
+static UnivRetCode applyPatch (const unsigned char * from, unsigned int outSize, memCtx * mem)
+{
+   dltPatch patch;
+   unsigned char out[4096];
+   mem->data       = patchBuf;
+   mem->size       = patchSize;
+   mem->result     = result;
+   mem->resultSize = 0;
+   mem->writes     = 0;
+   dltInit (&patch, memRead, memWrite, mem, out, outSize);
+   if (dltReadHeader (&patch, NULL) != URC_SUCCESS) return URC_FAIL;
+   return dltApply (&patch, from);
+}
+
+static void storeWord (unsigned char * image, unsigned long offset, unsigned long word)
+{
+   image[offset]     = word & 0xFF;
+   image[offset + 1] = (word >> 8) & 0xFF;
+   image[offset + 2] = (word >> 16) & 0xFF;
+   image[offset + 3] = word >> 24;
+}
+
+/*
+ * Code with a call every few words and a literal pool every 64, then the
+ * same code with a function inserted. Calls across the new function and
+ * pool entries pointing past it change, nothing else does.
+ */
+static void makeImages (void)
+{
+   unsigned long offset, word, dest;
+   unsigned long seed = 12345;
+   for (offset = 0; offset < IMAGE_SIZE; offset += 4)
+   {
+      seed = seed * 1103515245 + 12345;
+      if (offset % 64 == 60)      word = 0x1000 + (seed >> 8) % IMAGE_SIZE;
+      else if (offset % 16 == 8)  word = 0xEB000000 | (((seed >> 8) % (IMAGE_SIZE / 4)) & 0xFFFFFF);
+      else                        word = 0xE0000000 | (seed >> 4 & 0x0FFFFFFF);
+      storeWord (source, offset, word);
+   }
+   for (offset = 0; offset < IMAGE_SIZE; offset += 4)
+   {
+      word = source[offset] | (source[offset + 1] << 8) | (source[offset + 2] << 16) | ((unsigned long)source[offset + 3] << 24);
+      if (offset % 64 == 60)
+      {
+         if (word - 0x1000 >= INSERT_AT) word += INSERT_SIZE;
+      }
+      else if (offset % 16 == 8)
+      {
+         dest = (word & 0xFFFFFF) * 4;
+         if ((offset < INSERT_AT) != (dest < INSERT_AT)) word += (offset < INSERT_AT)?INSERT_SIZE / 4:-(INSERT_SIZE / 4);
+      }
+      storeWord (target, (offset < INSERT_AT)?offset:offset + INSERT_SIZE, word);
+   }
+   for (offset = 0; offset < INSERT_SIZE; ++offset) target[INSERT_AT + offset] = offset * 3;
+}
+
+void TestDltCrc32(CuTest* tc)
+{
+   CuAssertTrue(tc, dltCrc32 (0, (const unsigned char *)"123456789", 9) == 0xCBF43926UL);
+}
+
+void TestDltOps(CuTest* tc)
+{
+   const unsigned char from[] = "the quick brown fox";
+   const unsigned char to[]   = "quick the crowd fox!";
+   memCtx mem;
+   emitHeader (from, 19, to, 20);
+   emitByte (DLT_OP_COPY);     // "quick "
+   emitMove (4);
+   emitVarint (6);
+   emitByte (DLT_OP_COPY);     // "the "
+   emitMove (-10);
+   emitVarint (4);
+   emitByte (DLT_OP_EDIT);     // "brown fox" with two letters changed
+   emitMove (6);
+   emitVarint (9);
+   emitVarint (2);
+   emitVarint (0);
+   emitVarint (1);
+   emitByte ('c');
+   emitVarint (3);
+   emitVarint (1);
+   emitByte ('d');
+   emitByte (DLT_OP_INSERT);
+   emitVarint (1);
+   emitByte ('!');
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 7, &mem) == URC_SUCCESS);
+   CuAssertTrue(tc, mem.resultSize == 20);
+   CuAssertTrue(tc, memcmp (result, to, 20) == 0);
+   // a block at a time, the last one short
+   CuAssertTrue(tc, mem.writes == 3);
+   CuAssertTrue(tc, mem.lastWrite == 6);
+}
+
+void TestDltShiftedImage(CuTest* tc)
+{
+   memCtx mem;
+   makeImages ();
+   emitHeader (source, IMAGE_SIZE, target, IMAGE_SIZE + INSERT_SIZE);
+   emitRegion (0, source, target, INSERT_AT);
+   emitByte (DLT_OP_INSERT);
+   emitVarint (INSERT_SIZE);
+   memcpy (&patchBuf[patchSize], &target[INSERT_AT], INSERT_SIZE);
+   patchSize += INSERT_SIZE;
+   emitRegion (0, &source[INSERT_AT], &target[INSERT_AT + INSERT_SIZE], IMAGE_SIZE - INSERT_AT);
+   emitByte (DLT_OP_END);
+
+   CuAssertTrue(tc, applyPatch (source, 512, &mem) == URC_SUCCESS);
+   CuAssertTrue(tc, mem.resultSize == IMAGE_SIZE + INSERT_SIZE);
+   CuAssertTrue(tc, memcmp (result, target, IMAGE_SIZE + INSERT_SIZE) == 0);
+   CuAssertTrue(tc, patchSize * 4 < IMAGE_SIZE);
+}
+
+void TestDltRejects(CuTest* tc)
+{
+   const unsigned char from[] = "abcdefgh";
+   memCtx mem;
+
+   // made against a different image
+   emitHeader ((const unsigned char *)"abcdefgX", 8, from, 4);
+   emitByte (DLT_OP_COPY);
+   emitMove (0);
+   emitVarint (4);
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+
+   // copy past the end of the source
+   emitHeader (from, 8, from, 8);
+   emitByte (DLT_OP_COPY);
+   emitMove (4);
+   emitVarint (8);
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+
+   // more output than the header allows
+   emitHeader (from, 8, from, 4);
+   emitByte (DLT_OP_COPY);
+   emitMove (0);
+   emitVarint (8);
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+
+   // result does not match the target CRC
+   emitHeader (from, 8, (const unsigned char *)"abcX", 4);
+   emitByte (DLT_OP_COPY);
+   emitMove (0);
+   emitVarint (4);
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+
+   // truncated before END
+   emitHeader (from, 8, from, 4);
+   emitByte (DLT_OP_COPY);
+   emitMove (0);
+   emitVarint (4);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+
+   // the good version of the same
+   emitByte (DLT_OP_END);
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_SUCCESS);
+
+   patchBuf[0] ^= 1;
+   CuAssertTrue(tc, applyPatch (from, 16, &mem) == URC_FAIL);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestDltCrc32);
+   SUITE_ADD_TEST(suite, TestDltOps);
+   SUITE_ADD_TEST(suite, TestDltShiftedImage);
+   SUITE_ADD_TEST(suite, TestDltRejects);
+   return suite;
+}
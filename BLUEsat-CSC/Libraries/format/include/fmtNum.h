@@ -0,0 +1,46 @@
+/*
+ * fmtNum.h
+ *
+ *  Created on: Jun 9, 2013
+ *
+ *  Number to text without division. The ARM7 has no divide instruction,
+ *  every / and % is a library call, so digits come two at a time from a
+ *  table indexed by the remainder of a multiply by the reciprocal of 100.
+ *
+ *  Each call writes into the caller's buffer, which must hold the
+ *  FMT_*_MAX_LEN for the call, and returns the characters written. No
+ *  terminator is added. Values are 32 bit.
+ */
+
+#ifndef FMTNUM_H_
+#define FMTNUM_H_
+
+#define FMT_UNSIGNED_MAX_LEN  10      // 4294967295
+#define FMT_SIGNED_MAX_LEN    11      // -2147483648
+#define FMT_FIXED_MAX_LEN     12      // minus, point and 10 digits
+#define FMT_HEX_MAX_LEN       8
+#define FMT_MAX_FRAC_DIGITS   9
+// "mm:ss\r" + label + ":\r" then "n:dd.h\r" a reading, the downlink columns
+#define FMT_READINGS_LEN(labelLen, count)   (8 + (labelLen) + 7 * (count))
+#define FMT_READINGS_MAX      16
+
+// Decimal, zero padded to minDigits (at most FMT_UNSIGNED_MAX_LEN)
+unsigned int fmtUnsigned (char * out, unsigned int value, unsigned int minDigits);
+
+// Decimal with a leading minus when negative, the padding is after it
+unsigned int fmtSigned (char * out, int value, unsigned int minDigits);
+
+// value / 10^fracDigits with fracDigits after the point, "-0.05" for -5 and 2
+unsigned int fmtFixed (char * out, int value, unsigned int fracDigits);
+
+// Upper case hex without a prefix, zero padded to minDigits
+unsigned int fmtHex (char * out, unsigned int value, unsigned int minDigits);
+
+// Telemetry block as the ground decodes it: minute and second of the
+// timestamp (bits 11-6 and 5-0), the label, then each reading held in half
+// units as its hex index and "dd.h", clamped at 99.5 to keep the columns.
+// Writes FMT_READINGS_LEN, count is at most FMT_READINGS_MAX
+unsigned int fmtReadings (char * out, unsigned int timestamp, const char * label,
+                          const unsigned short * halves, unsigned int count);
+
+#endif /* FMTNUM_H_ */
@@ -0,0 +1,144 @@
+/*
+ * fmtNum.c
+ *
+ *  Created on: Jun 9, 2013
+ */
+#include "fmtNum.h"
+
+static const char digitPairs[200] =
+{
+   '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+   '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+   '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+   '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+   '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+   '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+   '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+   '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+   '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+   '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static const char hexDigits[16] =
+{
+   '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'
+};
+
+// Exact for every 32 bit value, one umull on the ARM7
+static unsigned int div100 (unsigned int value)
+{
+   return (unsigned int)(((unsigned long long)value * 0x51EB851FULL) >> 37);
+}
+
+// Comparisons only, a binary search over the powers of ten
+static unsigned int countDigits (unsigned int value)
+{
+   if (value < 100000)
+   {
+      if (value < 100) return (value < 10) ? 1 : 2;
+      if (value < 10000) return (value < 1000) ? 3 : 4;
+      return 5;
+   }
+   if (value < 10000000) return (value < 1000000) ? 6 : 7;
+   if (value < 1000000000) return (value < 100000000) ? 8 : 9;
+   return 10;
+}
+
+// Fills out[0..length) from the right, pairs first, zero padding last
+static void writeDigits (char * out, unsigned int length, unsigned int value)
+{
+   unsigned int quotient, pair;
+   while (value >= 100)
+   {
+      quotient = div100 (value);
+      pair = (value - quotient * 100) * 2;
+      out[--length] = digitPairs[pair + 1];
+      out[--length] = digitPairs[pair];
+      value = quotient;
+   }
+   if (value >= 10)
+   {
+      out[--length] = digitPairs[value * 2 + 1];
+      out[--length] = digitPairs[value * 2];
+   }
+   else
+   {
+      out[--length] = '0' + value;
+   }
+   while (length > 0) out[--length] = '0';
+}
+
+unsigned int fmtUnsigned (char * out, unsigned int value, unsigned int minDigits)
+{
+   unsigned int length = countDigits (value);
+   if (minDigits > FMT_UNSIGNED_MAX_LEN) minDigits = FMT_UNSIGNED_MAX_LEN;
+   if (length < minDigits) length = minDigits;
+   writeDigits (out, length, value);
+   return length;
+}
+
+unsigned int fmtSigned (char * out, int value, unsigned int minDigits)
+{
+   if (value >= 0) return fmtUnsigned (out, (unsigned int)value, minDigits);
+   out[0] = '-';
+   // negated as unsigned so the most negative value survives
+   return 1 + fmtUnsigned (&out[1], 0U - (unsigned int)value, minDigits);
+}
+
+unsigned int fmtFixed (char * out, int value, unsigned int fracDigits)
+{
+   unsigned int magnitude = (value < 0) ? 0U - (unsigned int)value : (unsigned int)value;
+   unsigned int length = 0;
+   unsigned int digits, whole;
+   if (fracDigits > FMT_MAX_FRAC_DIGITS) fracDigits = FMT_MAX_FRAC_DIGITS;
+   if (value < 0) out[length++] = '-';
+   // at least one digit ahead of the point
+   digits = fmtUnsigned (&out[length], magnitude, fracDigits + 1);
+   if (fracDigits == 0) return length + digits;
+   whole = length + digits - fracDigits;
+   for (length = length + digits; length > whole; --length) out[length] = out[length - 1];
+   out[whole] = '.';
+   return whole + 1 + fracDigits;
+}
+
+unsigned int fmtHex (char * out, unsigned int value, unsigned int minDigits)
+{
+   unsigned int digits = 1;
+   unsigned int length;
+   while (digits < FMT_HEX_MAX_LEN && (value >> (digits * 4)) != 0) digits++;
+   if (minDigits > FMT_HEX_MAX_LEN) minDigits = FMT_HEX_MAX_LEN;
+   if (digits < minDigits) digits = minDigits;
+   for (length = 0; length < digits; ++length)
+   {
+      out[length] = hexDigits[(value >> ((digits - 1 - length) * 4)) & 0xF];
+   }
+   return length;
+}
+
+unsigned int fmtReadings (char * out, unsigned int timestamp, const char * label,
+                          const unsigned short * halves, unsigned int count)
+{
+   unsigned int length = 0;
+   unsigned int index, value;
+   if (count > FMT_READINGS_MAX) count = FMT_READINGS_MAX;
+   writeDigits (&out[length], 2, (timestamp >> 6) & 63);
+   out[length + 2] = ':';
+   writeDigits (&out[length + 3], 2, timestamp & 63);
+   out[length + 5] = '\r';
+   length += 6;
+   while (*label != '\0') out[length++] = *label++;
+   out[length++] = ':';
+   out[length++] = '\r';
+   for (index = 0; index < count; ++index)
+   {
+      value = (halves[index] > 199) ? 199 : halves[index];
+      out[length] = hexDigits[index];
+      out[length + 1] = ':';
+      writeDigits (&out[length + 2], 2, value >> 1);
+      out[length + 4] = '.';
+      out[length + 5] = (value & 1) ? '5' : '0';
+      out[length + 6] = '\r';
+      length += 7;
+   }
+   return length;
+}
@@ -0,0 +1,235 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+
+#include "CuTest.h"
+#include "fmtNum.h"
+
+#define EXHAUSTIVE_TOP    1000000U
+#define RANDOM_COUNT      1000000U
+#define BENCH_CALLS       2000000U
+
+static unsigned int lcgState = 12345;
+
+static unsigned int nextRandom (void)
+{
+   lcgState = lcgState * 1664525U + 1013904223U;
+   return lcgState;
+}
+
+// formats with ours and snprintf, reports a mismatch
+static int checkUnsigned (unsigned int value, unsigned int minDigits)
+{
+   char got[FMT_UNSIGNED_MAX_LEN + 1];
+   char expect[32];
+   unsigned int len = fmtUnsigned (got, value, minDigits);
+   got[len] = '\0';
+   snprintf (expect, sizeof(expect), "%0*u", (int)minDigits, value);
+   return strcmp (got, expect) == 0;
+}
+
+static int checkSigned (int value, unsigned int minDigits)
+{
+   char got[FMT_SIGNED_MAX_LEN + 1];
+   char expect[32];
+   unsigned int len = fmtSigned (got, value, minDigits);
+   got[len] = '\0';
+   // printf counts the minus in the width, ours pads the digits only
+   if (value < 0) snprintf (expect, sizeof(expect), "-%0*u", (int)minDigits, 0U - (unsigned int)value);
+   else snprintf (expect, sizeof(expect), "%0*d", (int)minDigits, value);
+   return strcmp (got, expect) == 0;
+}
+
+static int checkHex (unsigned int value, unsigned int minDigits)
+{
+   char got[FMT_HEX_MAX_LEN + 1];
+   char expect[32];
+   unsigned int len = fmtHex (got, value, minDigits);
+   got[len] = '\0';
+   snprintf (expect, sizeof(expect), "%0*X", (int)minDigits, value);
+   return strcmp (got, expect) == 0;
+}
+
+static int checkFixed (int value, unsigned int fracDigits)
+{
+   static const unsigned int scale[FMT_MAX_FRAC_DIGITS + 1] =
+      { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+   char got[FMT_FIXED_MAX_LEN + 1];
+   char expect[32];
+   unsigned int magnitude = (value < 0) ? 0U - (unsigned int)value : (unsigned int)value;
+   unsigned int len = fmtFixed (got, value, fracDigits);
+   got[len] = '\0';
+   if (fracDigits == 0) snprintf (expect, sizeof(expect), "%s%u", (value < 0) ? "-" : "", magnitude);
+   else snprintf (expect, sizeof(expect), "%s%u.%0*u", (value < 0) ? "-" : "",
+                  magnitude / scale[fracDigits], (int)fracDigits, magnitude % scale[fracDigits]);
+   return strcmp (got, expect) == 0;
+}
+
+void TestFmtUnsignedMatchesPrintf(CuTest* tc)
+{
+   unsigned int value, power, pad, bad = 0;
+   for (value = 0; value < EXHAUSTIVE_TOP; ++value)
+   {
+      if (!checkUnsigned (value, 0)) bad++;
+   }
+   // either side of every power of ten, with every padding
+   for (power = 1; power <= 1000000000U; power *= 10)
+   for (pad = 0; pad <= FMT_UNSIGNED_MAX_LEN; ++pad)
+   {
+      if (!checkUnsigned (power - 1, pad) || !checkUnsigned (power, pad) || !checkUnsigned (power + 1, pad)) bad++;
+      if (power == 1000000000U) break;
+   }
+   for (value = 0; value < RANDOM_COUNT; ++value)
+   {
+      if (!checkUnsigned (nextRandom (), value % (FMT_UNSIGNED_MAX_LEN + 1))) bad++;
+   }
+   if (!checkUnsigned (UINT_MAX, 0) || !checkUnsigned (UINT_MAX - 1, 0)) bad++;
+   CuAssertTrue(tc, bad == 0);
+}
+
+void TestFmtSignedMatchesPrintf(CuTest* tc)
+{
+   int value;
+   unsigned int count, bad = 0;
+   for (value = -(int)EXHAUSTIVE_TOP; value < (int)EXHAUSTIVE_TOP; ++value)
+   {
+      if (!checkSigned (value, 0)) bad++;
+   }
+   for (count = 0; count < RANDOM_COUNT; ++count)
+   {
+      if (!checkSigned ((int)nextRandom (), count % 11)) bad++;
+   }
+   if (!checkSigned (INT_MAX, 0) || !checkSigned (INT_MIN, 0) || !checkSigned (INT_MIN, 10)) bad++;
+   CuAssertTrue(tc, bad == 0);
+   // limits fit the advertised sizes
+   {
+      char buffer[FMT_SIGNED_MAX_LEN];
+      CuAssertTrue(tc, fmtSigned (buffer, INT_MIN, 0) == FMT_SIGNED_MAX_LEN);
+      CuAssertTrue(tc, fmtUnsigned (buffer, UINT_MAX, 0) == FMT_UNSIGNED_MAX_LEN);
+      CuAssertTrue(tc, fmtUnsigned (buffer, 7, 99) == FMT_UNSIGNED_MAX_LEN);
+   }
+}
+
+void TestFmtFixedAndHex(CuTest* tc)
+{
+   char buffer[FMT_FIXED_MAX_LEN + 1];
+   unsigned int len, frac, count, bad = 0;
+   int value;
+   len = fmtFixed (buffer, -5, 2);
+   buffer[len] = '\0';
+   CuAssertStrEquals(tc, "-0.05", buffer);
+   len = fmtFixed (buffer, 1234, 1);
+   buffer[len] = '\0';
+   CuAssertStrEquals(tc, "123.4", buffer);
+   len = fmtFixed (buffer, INT_MIN, FMT_MAX_FRAC_DIGITS);
+   CuAssertTrue(tc, len == FMT_FIXED_MAX_LEN);
+   for (value = -100000; value <= 100000; ++value)
+   for (frac = 0; frac <= 3; ++frac)
+   {
+      if (!checkFixed (value, frac)) bad++;
+   }
+   for (count = 0; count < RANDOM_COUNT; ++count)
+   {
+      if (!checkFixed ((int)nextRandom (), count % (FMT_MAX_FRAC_DIGITS + 1))) bad++;
+      if (!checkHex (nextRandom () >> (count % 32), count % 9)) bad++;
+   }
+   for (count = 0; count < 0x10000; ++count)
+   {
+      if (!checkHex (count, 0)) bad++;
+   }
+   if (!checkHex (0xFFFFFFFFU, 0) || !checkHex (0, 0) || !checkHex (0, 4)) bad++;
+   CuAssertTrue(tc, bad == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * Host timing against the digit at a time division loop the firmware used
+ * and against snprintf. The target figures come from the string bench demo.
+ *-------------------------------------------------------------------------*/
+
+static unsigned int divisionLoop (char * out, unsigned int value)
+{
+   char scratch[FMT_UNSIGNED_MAX_LEN];
+   unsigned int pos = 0, length = 0;
+   do
+   {
+      scratch[pos++] = '0' + value % 10;
+      value /= 10;
+   } while (value > 0);
+   while (pos > 0) out[length++] = scratch[--pos];
+   return length;
+}
+
+void TestFmtBenchmark(CuTest* tc)
+{
+   // volatile so the compiler can not see the values are known
+   static volatile unsigned int values[4] = { 7, 1234, 65535, 3000000000U };
+   char buffer[32];
+   unsigned int which, call;
+   unsigned long total;
+   clock_t start;
+   double divisionNs, tableNs, printfNs;
+   printf ("unsigned to text ns per call, division loop, table and snprintf\n");
+   for (which = 0; which < 4; ++which)
+   {
+      unsigned int value = values[which];
+      total = 0;
+      start = clock ();
+      for (call = 0; call < BENCH_CALLS; ++call) total += divisionLoop (buffer, value + (call & 1));
+      divisionNs = (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / BENCH_CALLS;
+      start = clock ();
+      for (call = 0; call < BENCH_CALLS; ++call) total -= fmtUnsigned (buffer, value + (call & 1), 0);
+      tableNs = (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / BENCH_CALLS;
+      start = clock ();
+      for (call = 0; call < BENCH_CALLS / 10; ++call) snprintf (buffer, sizeof(buffer), "%u", value + (call & 1));
+      printfNs = (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / (BENCH_CALLS / 10);
+      printf ("  %10u: %.1f against %.1f, snprintf %.1f\n", value, divisionNs, tableNs, printfNs);
+      CuAssertTrue(tc, total == 0);
+   }
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+// sent by the comms task before fmtNum, the ground decoder splits on these columns
+static const char telemBaseline[] =
+   "07:05\rTX:\r0:00.0\r1:00.5\r2:09.5\r3:10.0\r4:62.5\r5:99.0\r6:99.5\r";
+
+void TestFmtReadingsMatchesBaseline(CuTest* tc)
+{
+   static const unsigned short halves[FMT_READINGS_MAX] =
+      { 0, 1, 19, 20, 125, 198, 199, 200, 65535, 7, 8, 9, 10, 11, 12, 13 };
+   char got[FMT_READINGS_LEN(7, FMT_READINGS_MAX) + 1];
+   unsigned int timestamp = (3U << 17) | (14U << 12) | (7U << 6) | 5U;
+   unsigned int len;
+
+   len = fmtReadings (got, timestamp, "TX", halves, 7);
+   CuAssertIntEquals (tc, sizeof(telemBaseline) - 1, len);
+   CuAssertIntEquals (tc, 59, len);
+   CuAssertTrue (tc, memcmp (got, telemBaseline, len) == 0);
+
+   // the old fixed frame lengths, 78 and 81 bytes
+   CuAssertIntEquals (tc, 78, fmtReadings (got, timestamp, "Battery", halves, 9));
+   CuAssertIntEquals (tc, 81, fmtReadings (got, timestamp, "CSC", halves, 10));
+
+   // out of range readings keep the column width
+   len = fmtReadings (got, 0, "RX", halves, FMT_READINGS_MAX);
+   CuAssertIntEquals (tc, FMT_READINGS_LEN(2, FMT_READINGS_MAX), len);
+   CuAssertTrue (tc, memcmp (&got[10 + 7 * 7], "7:99.5\r8:99.5\r9:03.5\rA:04.0\r", 28) == 0);
+   CuAssertTrue (tc, memcmp (&got[len - 7], "F:06.5\r", 7) == 0);
+}
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestFmtUnsignedMatchesPrintf);
+   SUITE_ADD_TEST(suite, TestFmtSignedMatchesPrintf);
+   SUITE_ADD_TEST(suite, TestFmtFixedAndHex);
+   SUITE_ADD_TEST(suite, TestFmtReadingsMatchesBaseline);
+   SUITE_ADD_TEST(suite, TestFmtBenchmark);
+   return suite;
+}
@@ -34,7 +34,10 @@ typedef enum
 	//command
 	URC_CMD_NO_QUEUE,
 	URC_CMD_INVALID_TASK,
-	URC_CMD_NO_TASK
+	URC_CMD_NO_TASK,
+	URC_CMD_NO_HANDLER,
+	URC_CMD_BAD_ARG,
+	URC_CMD_NO_REPLY
 } UnivRetCode;
 
 #endif /* UNIVERSALRETURNCODE_H_ */
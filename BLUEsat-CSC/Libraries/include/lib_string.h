@@ -48,6 +48,18 @@ void * memcpy(void * dest, const void *src, unsigned long count);
 */
 int memcmp(const void * s1, const void * s2, unsigned long size);
 
+/**
+* memset_byte, memcpy_byte, memcmp_byte - Byte at a time versions
+*
+* Same results as the word versions above, slower. Kept as the reference
+* those are tested and timed against.
+*/
+void * memset_byte(void * s, int c, unsigned long count);
+
+void * memcpy_byte(void * dest, const void *src, unsigned long count);
+
+int memcmp_byte(const void * s1, const void * s2, unsigned long size);
+
 /**
  * Convert value to hex decimal
  */
@@ -0,0 +1,65 @@
+/*
+ * mbxIndex.h
+ *
+ *  Created on: May 29, 2013
+ *
+ *  In RAM index of the store and forward mailbox. Entries are kept sorted
+ *  by recipient callsign, ssid and sequence number, so finding a message
+ *  is a binary search and listing a recipient's messages is a binary
+ *  search to the first one followed by a walk over that recipient only.
+ *  Each message lives in its own storage slot, slots are handed out from
+ *  a bitmap.
+ */
+
+#ifndef MBXINDEX_H_
+#define MBXINDEX_H_
+#include "UniversalReturnCode.h"
+
+#define MBX_CALL_SIZE      6
+#define MBX_MAX_MSGS       64      // one storage DID a message
+#define MBX_NO_SLOT        0xFF
+
+typedef struct //mbxAddr
+{
+   char          call[MBX_CALL_SIZE];    // padded with spaces
+   unsigned char ssid;
+}mbxAddr;
+
+typedef struct //mbxEntry
+{
+   mbxAddr        to;
+   unsigned short seq;
+   unsigned short size;                  // body bytes
+   unsigned char  slot;
+}mbxEntry;
+
+typedef struct //mbxIndex
+{
+   mbxEntry       entries[MBX_MAX_MSGS];
+   unsigned int   count;
+   unsigned char  usedSlots[MBX_MAX_MSGS / 8];
+   unsigned short nextSeq;
+}mbxIndex;
+
+void mbxInit (mbxIndex * index);
+
+// Pads or truncates a callsign the way the index stores it
+void mbxMakeAddr (mbxAddr * addr, const char * call, unsigned int callSize, unsigned char ssid);
+
+// Free storage slot for a new message, MBX_NO_SLOT when full
+unsigned char mbxFreeSlot (mbxIndex * index);
+
+// Adds a message, nextSeq moves past seq so rebuilt indexes keep counting up
+UnivRetCode mbxInsert (mbxIndex * index, const mbxEntry * entry);
+
+// Position of a message or -1
+int mbxFind (mbxIndex * index, const mbxAddr * to, unsigned short seq);
+
+UnivRetCode mbxRemove (mbxIndex * index, const mbxAddr * to, unsigned short seq, unsigned char * slot);
+
+// Copies up to outputSize of the recipient's messages after afterSeq, oldest
+// first, pass 0 to start from the beginning. Returns how many were copied.
+unsigned int mbxList (mbxIndex * index, const mbxAddr * to, unsigned short afterSeq,
+                      mbxEntry * output, unsigned int outputSize);
+
+#endif /* MBXINDEX_H_ */
@@ -0,0 +1,127 @@
+/*
+ * mbxIndex.c
+ *
+ *  Created on: May 29, 2013
+ */
+#include "mbxIndex.h"
+
+static int compareKey (const mbxAddr * a, unsigned short aSeq, const mbxAddr * b, unsigned short bSeq);
+static unsigned int lowerBound (mbxIndex * index, const mbxAddr * to, unsigned short seq);
+
+void mbxInit (mbxIndex * index)
+{
+   unsigned int byte;
+   if (index == NULL) return;
+   index->count   = 0;
+   index->nextSeq = 1;
+   for (byte = 0; byte < sizeof (index->usedSlots); ++byte) index->usedSlots[byte] = 0;
+}
+
+void mbxMakeAddr (mbxAddr * addr, const char * call, unsigned int callSize, unsigned char ssid)
+{
+   unsigned int pos;
+   for (pos = 0; pos < MBX_CALL_SIZE; ++pos)
+   {
+      addr->call[pos] = (pos < callSize && call[pos] != '\0')?call[pos]:' ';
+   }
+   addr->ssid = ssid;
+}
+
+unsigned char mbxFreeSlot (mbxIndex * index)
+{
+   unsigned int byte, bit;
+   for (byte = 0; byte < sizeof (index->usedSlots); ++byte)
+   {
+      if (index->usedSlots[byte] == 0xFF) continue;
+      for (bit = 0; bit < 8; ++bit)
+      {
+         if (!(index->usedSlots[byte] & (1 << bit))) return byte * 8 + bit;
+      }
+   }
+   return MBX_NO_SLOT;
+}
+
+UnivRetCode mbxInsert (mbxIndex * index, const mbxEntry * entry)
+{
+   unsigned int pos, move;
+   if (index == NULL || entry == NULL) return URC_FAIL;
+   if (index->count >= MBX_MAX_MSGS || entry->slot >= MBX_MAX_MSGS) return URC_FAIL;
+   if (index->usedSlots[entry->slot / 8] & (1 << (entry->slot % 8))) return URC_FAIL;
+
+   pos = lowerBound (index, &entry->to, entry->seq);
+   if (pos < index->count && compareKey (&index->entries[pos].to, index->entries[pos].seq,
+                                         &entry->to, entry->seq) == 0) return URC_FAIL;
+   for (move = index->count; move > pos; --move) index->entries[move] = index->entries[move - 1];
+   index->entries[pos] = *entry;
+   index->count++;
+   index->usedSlots[entry->slot / 8] |= 1 << (entry->slot % 8);
+   if ((unsigned short)(entry->seq + 1) > index->nextSeq) index->nextSeq = entry->seq + 1;
+   return URC_SUCCESS;
+}
+
+int mbxFind (mbxIndex * index, const mbxAddr * to, unsigned short seq)
+{
+   unsigned int pos;
+   if (index == NULL || to == NULL) return -1;
+   pos = lowerBound (index, to, seq);
+   if (pos < index->count && compareKey (&index->entries[pos].to, index->entries[pos].seq, to, seq) == 0)
+   {
+      return pos;
+   }
+   return -1;
+}
+
+UnivRetCode mbxRemove (mbxIndex * index, const mbxAddr * to, unsigned short seq, unsigned char * slot)
+{
+   int found;
+   unsigned int pos;
+   unsigned char freed;
+   found = mbxFind (index, to, seq);
+   if (found < 0) return URC_FAIL;
+   freed = index->entries[found].slot;
+   for (pos = found; pos + 1 < index->count; ++pos) index->entries[pos] = index->entries[pos + 1];
+   index->count--;
+   index->usedSlots[freed / 8] &= ~(1 << (freed % 8));
+   if (slot != NULL) *slot = freed;
+   return URC_SUCCESS;
+}
+
+unsigned int mbxList (mbxIndex * index, const mbxAddr * to, unsigned short afterSeq,
+                      mbxEntry * output, unsigned int outputSize)
+{
+   unsigned int pos, copied = 0;
+   if (index == NULL || to == NULL || output == NULL) return 0;
+   if (afterSeq == 0xFFFF) return 0;
+   pos = lowerBound (index, to, afterSeq + 1);
+   while (pos < index->count && copied < outputSize
+          && compareKey (&index->entries[pos].to, 0, to, 0) == 0)
+   {
+      output[copied++] = index->entries[pos++];
+   }
+   return copied;
+}
+
+// Orders by callsign, then ssid, then sequence number
+static int compareKey (const mbxAddr * a, unsigned short aSeq, const mbxAddr * b, unsigned short bSeq)
+{
+   unsigned int pos;
+   for (pos = 0; pos < MBX_CALL_SIZE; ++pos)
+   {
+      if (a->call[pos] != b->call[pos]) return (unsigned char)a->call[pos] - (unsigned char)b->call[pos];
+   }
+   if (a->ssid != b->ssid) return a->ssid - b->ssid;
+   return (int)aSeq - (int)bSeq;
+}
+
+// First position whose key is not below the one given
+static unsigned int lowerBound (mbxIndex * index, const mbxAddr * to, unsigned short seq)
+{
+   unsigned int low = 0, high = index->count, mid;
+   while (low < high)
+   {
+      mid = (low + high) / 2;
+      if (compareKey (&index->entries[mid].to, index->entries[mid].seq, to, seq) < 0) low = mid + 1;
+      else                                                                           high = mid;
+   }
+   return low;
+}
@@ -0,0 +1,122 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "mbxIndex.h"
+
+static mbxEntry makeEntry (const char * call, unsigned char ssid, unsigned short seq, unsigned char slot)
+{
+   mbxEntry entry;
+   mbxMakeAddr (&entry.to, call, strlen (call), ssid);
+   entry.seq  = seq;
+   entry.size = 10;
+   entry.slot = slot;
+   return entry;
+}
+
+void TestMbxMakeAddrPads(CuTest* tc)
+{
+   mbxAddr addr;
+   mbxMakeAddr (&addr, "VK2", 3, 4);
+   CuAssertTrue(tc, memcmp (addr.call, "VK2   ", MBX_CALL_SIZE) == 0);
+   CuAssertTrue(tc, addr.ssid == 4);
+   mbxMakeAddr (&addr, "VK2ABCDE", 8, 0);
+   CuAssertTrue(tc, memcmp (addr.call, "VK2ABC", MBX_CALL_SIZE) == 0);
+}
+
+void TestMbxInsertFind(CuTest* tc)
+{
+   mbxIndex index;
+   mbxEntry entry;
+   mbxAddr to;
+   mbxInit (&index);
+   entry = makeEntry ("VK2XYZ", 0, 5, 0);
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_SUCCESS);
+   entry = makeEntry ("VK2ABC", 0, 7, 1);
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_SUCCESS);
+   entry = makeEntry ("VK2ABC", 0, 3, 2);
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_SUCCESS);
+   // same key twice and a slot in use are refused
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_FAIL);
+   entry = makeEntry ("VK2QQQ", 0, 1, 1);
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_FAIL);
+
+   CuAssertTrue(tc, index.count == 3);
+   CuAssertTrue(tc, index.nextSeq == 8);
+   mbxMakeAddr (&to, "VK2ABC", 6, 0);
+   CuAssertTrue(tc, mbxFind (&index, &to, 3) == 0);
+   CuAssertTrue(tc, mbxFind (&index, &to, 7) == 1);
+   CuAssertTrue(tc, mbxFind (&index, &to, 5) == -1);
+   mbxMakeAddr (&to, "VK2ABC", 6, 1);
+   CuAssertTrue(tc, mbxFind (&index, &to, 3) == -1);
+}
+
+void TestMbxListPages(CuTest* tc)
+{
+   mbxIndex index;
+   mbxEntry entry, out[4];
+   mbxAddr to;
+   unsigned int seq;
+   mbxInit (&index);
+   // interleave two recipients so the listing has to skip the other one
+   for (seq = 1; seq <= 20; ++seq)
+   {
+      entry = makeEntry ((seq % 2)?"VK2AAA":"VK2BBB", 0, seq, seq);
+      mbxInsert (&index, &entry);
+   }
+   mbxMakeAddr (&to, "VK2BBB", 6, 0);
+   CuAssertTrue(tc, mbxList (&index, &to, 0, out, 4) == 4);
+   CuAssertTrue(tc, out[0].seq == 2 && out[3].seq == 8);
+   CuAssertTrue(tc, mbxList (&index, &to, 8, out, 4) == 4);
+   CuAssertTrue(tc, out[0].seq == 10);
+   CuAssertTrue(tc, mbxList (&index, &to, 16, out, 4) == 2);
+   CuAssertTrue(tc, out[1].seq == 20);
+   CuAssertTrue(tc, mbxList (&index, &to, 20, out, 4) == 0);
+   mbxMakeAddr (&to, "VK2CCC", 6, 0);
+   CuAssertTrue(tc, mbxList (&index, &to, 0, out, 4) == 0);
+}
+
+void TestMbxRemoveFreesSlot(CuTest* tc)
+{
+   mbxIndex index;
+   mbxEntry entry;
+   mbxAddr to;
+   unsigned char slot;
+   unsigned int count;
+   mbxInit (&index);
+   for (count = 0; count < MBX_MAX_MSGS; ++count)
+   {
+      slot = mbxFreeSlot (&index);
+      CuAssertTrue(tc, slot == count);
+      entry = makeEntry ("VK2AAA", 0, count + 1, slot);
+      CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_SUCCESS);
+   }
+   CuAssertTrue(tc, mbxFreeSlot (&index) == MBX_NO_SLOT);
+   entry = makeEntry ("VK2AAA", 0, 100, 0);
+   CuAssertTrue(tc, mbxInsert (&index, &entry) == URC_FAIL);
+
+   mbxMakeAddr (&to, "VK2AAA", 6, 0);
+   CuAssertTrue(tc, mbxRemove (&index, &to, 10, &slot) == URC_SUCCESS);
+   CuAssertTrue(tc, slot == 9);
+   CuAssertTrue(tc, mbxFreeSlot (&index) == 9);
+   CuAssertTrue(tc, mbxFind (&index, &to, 10) == -1);
+   CuAssertTrue(tc, mbxFind (&index, &to, 11) == 9);
+   CuAssertTrue(tc, mbxRemove (&index, &to, 10, &slot) == URC_FAIL);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestMbxMakeAddrPads);
+   SUITE_ADD_TEST(suite, TestMbxInsertFind);
+   SUITE_ADD_TEST(suite, TestMbxListPages);
+   SUITE_ADD_TEST(suite, TestMbxRemoveFreesSlot);
+   return suite;
+}
@@ -0,0 +1,47 @@
+/*
+ * modImage.h
+ *
+ *  Created on: Jun 5, 2013
+ *
+ *  Loadable module images. A module is linked at address 0 and packed on
+ *  the ground by Scripts/mod_pack.pl into a little endian header, the
+ *  code and initialised data, then one word per relocation giving the
+ *  offset of a word that holds an address inside the module.
+ *
+ *     magic, image size, bss size, entry offset, relocations, exports
+ *
+ *  Code inside the module is reached pc relative, so only those words
+ *  change when it is loaded somewhere else. The firmware is never called
+ *  directly, the entry point is handed a table of firmware functions and
+ *  exports is the table version the module needs.
+ */
+
+#ifndef MODIMAGE_H_
+#define MODIMAGE_H_
+#include "UniversalReturnCode.h"
+
+#define MOD_MAGIC          0x31444F4DUL   // "MOD1"
+#define MOD_HEADER_SIZE    24
+#define MOD_RELOC_SIZE     4
+
+typedef struct //modHeader
+{
+   unsigned long imageSize;
+   unsigned long bssSize;
+   unsigned long entry;       // bit 0 set for a Thumb entry point
+   unsigned long relocCount;
+   unsigned long exports;
+}modHeader;
+
+// Checks the header against the size of the stored object
+UnivRetCode modReadHeader (const unsigned char * data, unsigned long objectSize, modHeader * header);
+
+// Bytes needed to load, image and bss rounded up to a word
+unsigned long modSpace (const modHeader * header);
+
+// Apply count relocations from raw table bytes to the image at load,
+// which will run at base. Call again with the next part of the table.
+UnivRetCode modRelocate (unsigned char * load, const modHeader * header,
+                         const unsigned char * relocs, unsigned int count, unsigned long base);
+
+#endif /* MODIMAGE_H_ */
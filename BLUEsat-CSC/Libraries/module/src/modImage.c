@@ -0,0 +1,68 @@
+/*
+ * modImage.c
+ *
+ *  Created on: Jun 5, 2013
+ */
+#include "modImage.h"
+
+static unsigned long getLong (const unsigned char * data);
+static void putLong (unsigned char * data, unsigned long value);
+
+UnivRetCode modReadHeader (const unsigned char * data, unsigned long objectSize, modHeader * header)
+{
+   if (data == NULL || header == NULL || objectSize < MOD_HEADER_SIZE) return URC_FAIL;
+   if (getLong (data) != MOD_MAGIC) return URC_FAIL;
+   header->imageSize  = getLong (&data[4]);
+   header->bssSize    = getLong (&data[8]);
+   header->entry      = getLong (&data[12]);
+   header->relocCount = getLong (&data[16]);
+   header->exports    = getLong (&data[20]);
+
+   if (header->imageSize == 0 || (header->imageSize & 3) != 0) return URC_FAIL;
+   if ((header->entry & ~1UL) >= header->imageSize) return URC_FAIL;
+   // each term is checked before it is added so a huge count can not wrap
+   if (header->imageSize > objectSize - MOD_HEADER_SIZE) return URC_FAIL;
+   if (header->relocCount != (objectSize - MOD_HEADER_SIZE - header->imageSize) / MOD_RELOC_SIZE) return URC_FAIL;
+   if ((objectSize - MOD_HEADER_SIZE - header->imageSize) % MOD_RELOC_SIZE != 0) return URC_FAIL;
+   return URC_SUCCESS;
+}
+
+unsigned long modSpace (const modHeader * header)
+{
+   if (header == NULL) return 0;
+   return header->imageSize + ((header->bssSize + 3) & ~3UL);
+}
+
+UnivRetCode modRelocate (unsigned char * load, const modHeader * header,
+                         const unsigned char * relocs, unsigned int count, unsigned long base)
+{
+   unsigned long offset;
+   unsigned int index;
+   if (load == NULL || header == NULL || (relocs == NULL && count > 0)) return URC_FAIL;
+   // all offsets first, a bad table leaves the image as it was
+   for (index = 0; index < count; ++index)
+   {
+      offset = getLong (&relocs[index * MOD_RELOC_SIZE]);
+      if ((offset & 3) != 0 || offset > header->imageSize - 4) return URC_FAIL;
+   }
+   for (index = 0; index < count; ++index)
+   {
+      offset = getLong (&relocs[index * MOD_RELOC_SIZE]);
+      putLong (&load[offset], getLong (&load[offset]) + base);
+   }
+   return URC_SUCCESS;
+}
+
+static unsigned long getLong (const unsigned char * data)
+{
+   return (unsigned long)data[0] | ((unsigned long)data[1] << 8) |
+          ((unsigned long)data[2] << 16) | ((unsigned long)data[3] << 24);
+}
+
+static void putLong (unsigned char * data, unsigned long value)
+{
+   data[0] = value & 0xFF;
+   data[1] = (value >> 8) & 0xFF;
+   data[2] = (value >> 16) & 0xFF;
+   data[3] = (value >> 24) & 0xFF;
+}
@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "modImage.h"
+
+#define LOAD_BASE 0x81004000UL
+
+static unsigned char object[256];
+
+static void putLong (unsigned char * data, unsigned long value)
+{
+   data[0] = value & 0xFF;
+   data[1] = (value >> 8) & 0xFF;
+   data[2] = (value >> 16) & 0xFF;
+   data[3] = (value >> 24) & 0xFF;
+}
+
+static unsigned long getLong (const unsigned char * data)
+{
+   return (unsigned long)data[0] | ((unsigned long)data[1] << 8) |
+          ((unsigned long)data[2] << 16) | ((unsigned long)data[3] << 24);
+}
+
+// 64 byte image, words 4 and 10 point into the module, three relocations
+// with the third one given as an argument so tests can spoil it
+static unsigned long buildObject (unsigned long thirdReloc)
+{
+   unsigned int index;
+   putLong (&object[0], MOD_MAGIC);
+   putLong (&object[4], 64);
+   putLong (&object[8], 30);
+   putLong (&object[12], 8 | 1);
+   putLong (&object[16], 3);
+   putLong (&object[20], 2);
+   for (index = 0; index < 16; ++index) putLong (&object[MOD_HEADER_SIZE + index * 4], 0xE1A00000 + index);
+   putLong (&object[MOD_HEADER_SIZE + 16], 0x30);
+   putLong (&object[MOD_HEADER_SIZE + 40], 0x3C);
+   putLong (&object[MOD_HEADER_SIZE + 64], 16);
+   putLong (&object[MOD_HEADER_SIZE + 68], 40);
+   putLong (&object[MOD_HEADER_SIZE + 72], thirdReloc);
+   return MOD_HEADER_SIZE + 64 + 12;
+}
+
+void TestModReadHeader(CuTest* tc)
+{
+   modHeader header;
+   unsigned long size = buildObject (60);
+   CuAssertTrue(tc, modReadHeader (object, size, &header) == URC_SUCCESS);
+   CuAssertTrue(tc, header.imageSize == 64);
+   CuAssertTrue(tc, header.bssSize == 30);
+   CuAssertTrue(tc, header.entry == 9);
+   CuAssertTrue(tc, header.relocCount == 3);
+   CuAssertTrue(tc, header.exports == 2);
+   // bss rounds up to a word
+   CuAssertTrue(tc, modSpace (&header) == 96);
+}
+
+void TestModRejectsHeader(CuTest* tc)
+{
+   modHeader header;
+   unsigned long size = buildObject (60);
+   // truncated, or a stray byte on the end
+   CuAssertTrue(tc, modReadHeader (object, size - 4, &header) == URC_FAIL);
+   CuAssertTrue(tc, modReadHeader (object, size + 1, &header) == URC_FAIL);
+   CuAssertTrue(tc, modReadHeader (object, 10, &header) == URC_FAIL);
+   // entry outside the image
+   putLong (&object[12], 64);
+   CuAssertTrue(tc, modReadHeader (object, size, &header) == URC_FAIL);
+   // image larger than the object
+   buildObject (60);
+   putLong (&object[4], 0xFFFFFFF0UL);
+   CuAssertTrue(tc, modReadHeader (object, size, &header) == URC_FAIL);
+   buildObject (60);
+   object[0] ^= 1;
+   CuAssertTrue(tc, modReadHeader (object, size, &header) == URC_FAIL);
+}
+
+void TestModRelocate(CuTest* tc)
+{
+   modHeader header;
+   unsigned char load[64];
+   unsigned long size = buildObject (60);
+   const unsigned char * relocs = &object[MOD_HEADER_SIZE + 64];
+   modReadHeader (object, size, &header);
+   memcpy (load, &object[MOD_HEADER_SIZE], 64);
+   // table handed over in two parts, as it is read from storage
+   CuAssertTrue(tc, modRelocate (load, &header, relocs, 2, LOAD_BASE) == URC_SUCCESS);
+   CuAssertTrue(tc, modRelocate (load, &header, &relocs[8], 1, LOAD_BASE) == URC_SUCCESS);
+   CuAssertTrue(tc, getLong (&load[16]) == LOAD_BASE + 0x30);
+   CuAssertTrue(tc, getLong (&load[40]) == LOAD_BASE + 0x3C);
+   CuAssertTrue(tc, getLong (&load[60]) == ((LOAD_BASE + 0xE1A0000F) & 0xFFFFFFFFUL));
+   // everything else untouched
+   CuAssertTrue(tc, getLong (&load[12]) == 0xE1A00003);
+   CuAssertTrue(tc, getLong (&load[44]) == 0xE1A0000B);
+}
+
+void TestModRelocateRejects(CuTest* tc)
+{
+   modHeader header;
+   unsigned char load[64];
+   unsigned long size;
+   const unsigned char * relocs = &object[MOD_HEADER_SIZE + 64];
+   // past the end, then not word aligned
+   size = buildObject (64);
+   modReadHeader (object, size, &header);
+   memcpy (load, &object[MOD_HEADER_SIZE], 64);
+   CuAssertTrue(tc, modRelocate (load, &header, relocs, 3, LOAD_BASE) == URC_FAIL);
+   CuAssertTrue(tc, memcmp (load, &object[MOD_HEADER_SIZE], 64) == 0);
+   buildObject (22);
+   CuAssertTrue(tc, modRelocate (load, &header, relocs, 3, LOAD_BASE) == URC_FAIL);
+   CuAssertTrue(tc, memcmp (load, &object[MOD_HEADER_SIZE], 64) == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestModReadHeader);
+   SUITE_ADD_TEST(suite, TestModRejectsHeader);
+   SUITE_ADD_TEST(suite, TestModRelocate);
+   SUITE_ADD_TEST(suite, TestModRelocateRejects);
+   return suite;
+}
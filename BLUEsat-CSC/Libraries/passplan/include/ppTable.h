@@ -0,0 +1,59 @@
+/*
+ * ppTable.h
+ *
+ *  Created on: Jun 7, 2013
+ *
+ *  Ground station pass schedule. Passes are uplinked as start and stop
+ *  times in seconds since 2000-01-01 00:00:00 UTC, kept in start order,
+ *  and the phase for a given time tells the downlink what to do:
+ *
+ *     IDLE     nothing in view, stay quiet
+ *     STAGE    a pass starts within the lead time, encode and hold frames
+ *     PASS     in view, send
+ */
+
+#ifndef PPTABLE_H_
+#define PPTABLE_H_
+#include "UniversalReturnCode.h"
+
+#define PP_MAX_PASSES      16
+#define PP_EPOCH_YEAR      2000
+
+typedef enum //ppPhase
+{
+   PP_PHASE_IDLE,
+   PP_PHASE_STAGE,
+   PP_PHASE_PASS
+}ppPhase;
+
+typedef struct //ppPass
+{
+   unsigned long start;
+   unsigned long stop;
+}ppPass;
+
+typedef struct //ppTable
+{
+   ppPass       pass[PP_MAX_PASSES];
+   unsigned int count;
+}ppTable;
+
+void ppInit (ppTable * table);
+
+// Fails for an empty window, a full table or overlap with a pass held
+UnivRetCode ppAdd (ppTable * table, unsigned long start, unsigned long stop);
+
+// Drops passes that have ended, returns how many went
+unsigned int ppExpire (ppTable * table, unsigned long now);
+
+// Phase at now, and seconds until it next changes (0 if it never will)
+ppPhase ppGetPhase (const ppTable * table, unsigned long now, unsigned long lead, unsigned long * untilChange);
+
+// Calendar time to seconds since the epoch, 0 for a date before it
+unsigned long ppSeconds (unsigned int year, unsigned int month, unsigned int day,
+                         unsigned int hour, unsigned int minute, unsigned int second);
+
+void ppCalendar (unsigned long seconds, unsigned int * year, unsigned int * month, unsigned int * day,
+                 unsigned int * hour, unsigned int * minute, unsigned int * second);
+
+#endif /* PPTABLE_H_ */
@@ -0,0 +1,114 @@
+/*
+ * ppTable.c
+ *
+ *  Created on: Jun 7, 2013
+ */
+#include "ppTable.h"
+
+#define PP_SECONDS_PER_DAY 86400UL
+
+static const unsigned short daysBefore[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+static unsigned int isLeap (unsigned int year);
+
+void ppInit (ppTable * table)
+{
+   if (table == NULL) return;
+   table->count = 0;
+}
+
+UnivRetCode ppAdd (ppTable * table, unsigned long start, unsigned long stop)
+{
+   unsigned int index, place;
+   if (table == NULL || stop <= start || table->count >= PP_MAX_PASSES) return URC_FAIL;
+   for (place = 0; place < table->count && table->pass[place].start < start; ++place);
+   if (place > 0 && table->pass[place - 1].stop > start) return URC_FAIL;
+   if (place < table->count && table->pass[place].start < stop) return URC_FAIL;
+   for (index = table->count; index > place; --index) table->pass[index] = table->pass[index - 1];
+   table->pass[place].start = start;
+   table->pass[place].stop  = stop;
+   table->count++;
+   return URC_SUCCESS;
+}
+
+unsigned int ppExpire (ppTable * table, unsigned long now)
+{
+   unsigned int gone, index;
+   if (table == NULL) return 0;
+   for (gone = 0; gone < table->count && table->pass[gone].stop <= now; ++gone);
+   for (index = gone; index < table->count; ++index) table->pass[index - gone] = table->pass[index];
+   table->count -= gone;
+   return gone;
+}
+
+ppPhase ppGetPhase (const ppTable * table, unsigned long now, unsigned long lead, unsigned long * untilChange)
+{
+   unsigned int index;
+   unsigned long until = 0;
+   ppPhase phase = PP_PHASE_IDLE;
+   if (table != NULL)
+   {
+      // ended passes may still be held, skip them
+      for (index = 0; index < table->count && table->pass[index].stop <= now; ++index);
+      if (index < table->count)
+      {
+         const ppPass * next = &table->pass[index];
+         if (now >= next->start)
+         {
+            phase = PP_PHASE_PASS;
+            until = next->stop - now;
+         }
+         else if (next->start - now <= lead)
+         {
+            phase = PP_PHASE_STAGE;
+            until = next->start - now;
+         }
+         else
+         {
+            until = next->start - now - lead;
+         }
+      }
+   }
+   if (untilChange != NULL) *untilChange = until;
+   return phase;
+}
+
+unsigned long ppSeconds (unsigned int year, unsigned int month, unsigned int day,
+                         unsigned int hour, unsigned int minute, unsigned int second)
+{
+   unsigned long days;
+   unsigned int y;
+   if (year < PP_EPOCH_YEAR || month < 1 || month > 12 || day < 1) return 0;
+   days = (year - PP_EPOCH_YEAR) * 365UL;
+   for (y = PP_EPOCH_YEAR; y < year; y += 4) days += isLeap (y);
+   days += daysBefore[month - 1] + (day - 1);
+   if (month > 2) days += isLeap (year);
+   return days * PP_SECONDS_PER_DAY + hour * 3600UL + minute * 60UL + second;
+}
+
+void ppCalendar (unsigned long seconds, unsigned int * year, unsigned int * month, unsigned int * day,
+                 unsigned int * hour, unsigned int * minute, unsigned int * second)
+{
+   unsigned long days = seconds / PP_SECONDS_PER_DAY;
+   unsigned long rest = seconds % PP_SECONDS_PER_DAY;
+   unsigned int y = PP_EPOCH_YEAR, m = 1, length;
+   while (days >= (length = 365 + isLeap (y)))
+   {
+      days -= length;
+      ++y;
+   }
+   while (m < 12 && days >= (unsigned long)daysBefore[m] + ((m >= 2)?isLeap (y):0)) ++m;
+   days -= daysBefore[m - 1] + ((m > 2)?isLeap (y):0);
+   if (year   != NULL) *year   = y;
+   if (month  != NULL) *month  = m;
+   if (day    != NULL) *day    = days + 1;
+   if (hour   != NULL) *hour   = rest / 3600;
+   if (minute != NULL) *minute = (rest / 60) % 60;
+   if (second != NULL) *second = rest % 60;
+}
+
+// Good to 2099, which the year 2100 rule does not matter for
+static unsigned int isLeap (unsigned int year)
+{
+   return (year % 4 == 0)?1:0;
+}
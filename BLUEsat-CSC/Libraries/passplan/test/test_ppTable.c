@@ -0,0 +1,93 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "ppTable.h"
+
+void TestPpSeconds(CuTest* tc)
+{
+   CuAssertTrue(tc, ppSeconds (2000, 1, 1, 0, 0, 0) == 0);
+   CuAssertTrue(tc, ppSeconds (2013, 6, 7, 12, 30, 15) == 423923415UL);
+   CuAssertTrue(tc, ppSeconds (2012, 2, 29, 23, 59, 59) == 383875199UL);
+   CuAssertTrue(tc, ppSeconds (2012, 3, 1, 0, 0, 0) == 383875200UL);
+   CuAssertTrue(tc, ppSeconds (2099, 12, 31, 23, 59, 59) == 3155759999UL);
+   // the RTC powers up in 1337, that is not a time
+   CuAssertTrue(tc, ppSeconds (1337, 1, 1, 0, 0, 0) == 0);
+}
+
+void TestPpCalendarRoundTrip(CuTest* tc)
+{
+   unsigned int year, month, day, hour, minute, second;
+   unsigned long seconds;
+   ppCalendar (423923415UL, &year, &month, &day, &hour, &minute, &second);
+   CuAssertTrue(tc, year == 2013 && month == 6 && day == 7);
+   CuAssertTrue(tc, hour == 12 && minute == 30 && second == 15);
+   ppCalendar (383875199UL, &year, &month, &day, &hour, &minute, &second);
+   CuAssertTrue(tc, year == 2012 && month == 2 && day == 29 && second == 59);
+   // every day boundary for five years, leap days included
+   for (seconds = 0; seconds < 5 * 366 * 86400UL; seconds += 86400UL - 1)
+   {
+      ppCalendar (seconds, &year, &month, &day, &hour, &minute, &second);
+      CuAssertTrue(tc, ppSeconds (year, month, day, hour, minute, second) == seconds);
+   }
+}
+
+void TestPpAddKeepsOrder(CuTest* tc)
+{
+   ppTable table;
+   unsigned int index;
+   ppInit (&table);
+   CuAssertTrue(tc, ppAdd (&table, 5000, 5600) == URC_SUCCESS);
+   CuAssertTrue(tc, ppAdd (&table, 1000, 1600) == URC_SUCCESS);
+   CuAssertTrue(tc, ppAdd (&table, 3000, 3600) == URC_SUCCESS);
+   CuAssertTrue(tc, table.count == 3);
+   CuAssertTrue(tc, table.pass[0].start == 1000 && table.pass[1].start == 3000 && table.pass[2].start == 5000);
+   // overlap either side, empty window
+   CuAssertTrue(tc, ppAdd (&table, 1500, 2000) == URC_FAIL);
+   CuAssertTrue(tc, ppAdd (&table, 2500, 3001) == URC_FAIL);
+   CuAssertTrue(tc, ppAdd (&table, 4000, 4000) == URC_FAIL);
+   // touching is fine
+   CuAssertTrue(tc, ppAdd (&table, 1600, 3000) == URC_SUCCESS);
+   for (index = table.count; index < PP_MAX_PASSES; ++index)
+   {
+      CuAssertTrue(tc, ppAdd (&table, 10000 + index * 1000, 10500 + index * 1000) == URC_SUCCESS);
+   }
+   CuAssertTrue(tc, ppAdd (&table, 100000, 100500) == URC_FAIL);
+}
+
+void TestPpPhase(CuTest* tc)
+{
+   ppTable table;
+   unsigned long until;
+   ppInit (&table);
+   CuAssertTrue(tc, ppGetPhase (&table, 500, 60, &until) == PP_PHASE_IDLE && until == 0);
+   ppAdd (&table, 1000, 1600);
+   ppAdd (&table, 3000, 3600);
+   CuAssertTrue(tc, ppGetPhase (&table, 500, 60, &until) == PP_PHASE_IDLE && until == 440);
+   CuAssertTrue(tc, ppGetPhase (&table, 940, 60, &until) == PP_PHASE_STAGE && until == 60);
+   CuAssertTrue(tc, ppGetPhase (&table, 1000, 60, &until) == PP_PHASE_PASS && until == 600);
+   CuAssertTrue(tc, ppGetPhase (&table, 1599, 60, &until) == PP_PHASE_PASS && until == 1);
+   // an ended pass is skipped whether or not it has been expired
+   CuAssertTrue(tc, ppGetPhase (&table, 1600, 60, &until) == PP_PHASE_IDLE && until == 1340);
+   CuAssertTrue(tc, ppExpire (&table, 1600) == 1);
+   CuAssertTrue(tc, table.count == 1 && table.pass[0].start == 3000);
+   CuAssertTrue(tc, ppExpire (&table, 1600) == 0);
+   CuAssertTrue(tc, ppExpire (&table, 4000) == 1 && table.count == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestPpSeconds);
+   SUITE_ADD_TEST(suite, TestPpCalendarRoundTrip);
+   SUITE_ADD_TEST(suite, TestPpAddKeepsOrder);
+   SUITE_ADD_TEST(suite, TestPpPhase);
+   return suite;
+}
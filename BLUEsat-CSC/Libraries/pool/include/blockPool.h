@@ -0,0 +1,42 @@
+/*
+ * blockPool.h
+ *
+ *  Created on: Jun 11, 2013
+ *
+ *  Fixed size blocks carved out of memory given once at start up, handed
+ *  out and taken back in any order. Free blocks are chained through their
+ *  first word. There is no locking, callers that share a pool between
+ *  tasks wrap the calls in a critical section.
+ */
+
+#ifndef BLOCKPOOL_H_
+#define BLOCKPOOL_H_
+#include "UniversalReturnCode.h"
+
+// Blocks are rounded up to this, enough for any member alignment
+#define BP_ALIGN              sizeof(unsigned long)
+#define BP_BLOCK_SIZE(size)   (((size) + BP_ALIGN - 1) & ~(BP_ALIGN - 1))
+
+typedef struct //blockPool
+{
+   unsigned char * base;
+   void *          free;       // first free block, NULL when all are out
+   unsigned short  size;       // block size after rounding
+   unsigned short  count;
+   unsigned short  used;
+   unsigned short  peak;       // most blocks out at once
+}blockPool;
+
+// memory must be word aligned and hold count * BP_BLOCK_SIZE(size) bytes
+void bpInit (blockPool * pool, void * memory, unsigned short size, unsigned short count);
+
+// NULL when every block is out
+void * bpAlloc (blockPool * pool);
+
+// Fails for a pointer that is not the start of one of this pool's blocks
+UnivRetCode bpFree (blockPool * pool, void * block);
+
+// Non zero when block lies inside the pool's memory
+int bpOwns (const blockPool * pool, const void * block);
+
+#endif /* BLOCKPOOL_H_ */
@@ -0,0 +1,55 @@
+/*
+ * blockPool.c
+ *
+ *  Created on: Jun 11, 2013
+ */
+#include "blockPool.h"
+
+#ifndef NULL
+#define NULL ((void *)0)
+#endif
+
+void bpInit (blockPool * pool, void * memory, unsigned short size, unsigned short count)
+{
+   unsigned short index;
+   pool->base = (unsigned char *)memory;
+   pool->size = BP_BLOCK_SIZE(size < sizeof(void *) ? sizeof(void *) : size);
+   pool->count = count;
+   pool->used = 0;
+   pool->peak = 0;
+   pool->free = (count > 0) ? memory : NULL;
+   // chain every block to the one after it, the last ends the list
+   for (index = 0; index < count; ++index)
+   {
+      void ** link = (void **)(pool->base + index * pool->size);
+      *link = (index + 1 < count) ? pool->base + (index + 1) * pool->size : NULL;
+   }
+}
+
+void * bpAlloc (blockPool * pool)
+{
+   void * block = pool->free;
+   if (block == NULL) return NULL;
+   pool->free = *(void **)block;
+   pool->used++;
+   if (pool->used > pool->peak) pool->peak = pool->used;
+   return block;
+}
+
+UnivRetCode bpFree (blockPool * pool, void * block)
+{
+   unsigned long offset;
+   if (!bpOwns (pool, block)) return URC_FAIL;
+   offset = (unsigned long)((unsigned char *)block - pool->base);
+   if (offset % pool->size != 0 || pool->used == 0) return URC_FAIL;
+   *(void **)block = pool->free;
+   pool->free = block;
+   pool->used--;
+   return URC_SUCCESS;
+}
+
+int bpOwns (const blockPool * pool, const void * block)
+{
+   const unsigned char * address = (const unsigned char *)block;
+   return address >= pool->base && address < pool->base + (unsigned long)pool->size * pool->count;
+}
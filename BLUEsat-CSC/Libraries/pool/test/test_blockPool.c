@@ -0,0 +1,88 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "blockPool.h"
+
+#define BLOCKS        8
+#define BLOCK_SIZE    13
+
+static unsigned long memory[BLOCKS * BP_BLOCK_SIZE(BLOCK_SIZE) / sizeof(unsigned long)];
+
+void TestBpAllocAll(CuTest* tc)
+{
+   blockPool pool;
+   void * blocks[BLOCKS];
+   unsigned int index, other;
+   bpInit (&pool, memory, BLOCK_SIZE, BLOCKS);
+   CuAssertTrue(tc, pool.size == BP_BLOCK_SIZE(BLOCK_SIZE) && pool.size % BP_ALIGN == 0);
+   for (index = 0; index < BLOCKS; ++index)
+   {
+      blocks[index] = bpAlloc (&pool);
+      CuAssertPtrNotNull(tc, blocks[index]);
+      CuAssertTrue(tc, ((unsigned long)blocks[index] % BP_ALIGN) == 0);
+      // the whole block is ours, filling it must not upset the pool
+      memset (blocks[index], 0xA5, BLOCK_SIZE);
+   }
+   CuAssertTrue(tc, bpAlloc (&pool) == NULL);
+   CuAssertTrue(tc, pool.used == BLOCKS && pool.peak == BLOCKS);
+   // no block handed out twice
+   for (index = 0; index < BLOCKS; ++index)
+   for (other = index + 1; other < BLOCKS; ++other)
+   {
+      CuAssertTrue(tc, blocks[index] != blocks[other]);
+   }
+}
+
+void TestBpFreeReuses(CuTest* tc)
+{
+   blockPool pool;
+   void * blocks[BLOCKS];
+   unsigned int index, round;
+   bpInit (&pool, memory, BLOCK_SIZE, BLOCKS);
+   for (round = 0; round < 100; ++round)
+   {
+      for (index = 0; index < BLOCKS; ++index) blocks[index] = bpAlloc (&pool);
+      // back in a different order every round
+      for (index = 0; index < BLOCKS; ++index)
+      {
+         CuAssertTrue(tc, bpFree (&pool, blocks[(index * 3 + round) % BLOCKS]) == URC_SUCCESS);
+      }
+      CuAssertTrue(tc, pool.used == 0);
+   }
+   CuAssertTrue(tc, pool.peak == BLOCKS);
+}
+
+void TestBpRejectsForeign(CuTest* tc)
+{
+   blockPool pool;
+   unsigned long outside;
+   unsigned char * block;
+   bpInit (&pool, memory, BLOCK_SIZE, BLOCKS);
+   block = (unsigned char *)bpAlloc (&pool);
+   CuAssertTrue(tc, bpOwns (&pool, block));
+   CuAssertTrue(tc, !bpOwns (&pool, &outside));
+   CuAssertTrue(tc, bpFree (&pool, &outside) == URC_FAIL);
+   // inside the pool but not the start of a block
+   CuAssertTrue(tc, bpFree (&pool, block + 1) == URC_FAIL);
+   CuAssertTrue(tc, bpFree (&pool, block) == URC_SUCCESS);
+   // nothing out, a second free is caught
+   CuAssertTrue(tc, bpFree (&pool, block) == URC_FAIL);
+   CuAssertTrue(tc, pool.used == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestBpAllocAll);
+   SUITE_ADD_TEST(suite, TestBpFreeReuses);
+   SUITE_ADD_TEST(suite, TestBpRejectsForeign);
+   return suite;
+}
@@ -0,0 +1,44 @@
+/*
+ * prbs.h
+ *
+ *  Created on: May 27, 2013
+ *
+ *  Pseudo random bit sequences for bit error rate testing. PRBS9 is
+ *  x^9 + x^5 + 1 and PRBS15 is x^15 + x^14 + 1, both sent without the
+ *  output inversion O.150 applies to PRBS15. Bytes are packed least
+ *  significant bit first, the order the modem sends them in, so the
+ *  sequence on air is the generator output. Scripts/bert_check.pl is the
+ *  matching ground checker.
+ */
+
+#ifndef PRBS_H_
+#define PRBS_H_
+#include "UniversalReturnCode.h"
+
+#define PRBS9_PERIOD       511
+#define PRBS15_PERIOD      32767
+
+typedef enum //prbsType
+{
+   PRBS_9,
+   PRBS_15,
+   PRBS_NUM_TYPES,
+}prbsType;
+
+typedef struct //prbsGen
+{
+   unsigned short state;      // last order bits sent, newest in bit 0
+   unsigned short mask;
+   unsigned char  order;
+   unsigned char  tap;
+}prbsGen;
+
+// Starts from the all ones state
+UnivRetCode prbsInit (prbsGen * gen, prbsType type);
+
+unsigned char prbsNextBit (prbsGen * gen);
+
+// Fills bytes LSB first so consecutive calls form one continuous sequence
+void prbsFill (prbsGen * gen, unsigned char * output, unsigned int outputSize);
+
+#endif /* PRBS_H_ */
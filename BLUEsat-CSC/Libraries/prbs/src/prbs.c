@@ -0,0 +1,45 @@
+/*
+ * prbs.c
+ *
+ *  Created on: May 27, 2013
+ */
+#include "prbs.h"
+
+UnivRetCode prbsInit (prbsGen * gen, prbsType type)
+{
+   if (gen == NULL) return URC_FAIL;
+   switch (type)
+   {
+      case PRBS_9:  gen->order = 9;  gen->tap = 5;  break;
+      case PRBS_15: gen->order = 15; gen->tap = 14; break;
+      default:      return URC_FAIL;
+   }
+   gen->mask  = (unsigned short)((1 << gen->order) - 1);
+   gen->state = gen->mask;
+   return URC_SUCCESS;
+}
+
+// Fibonacci form, each bit is the xor of the bits order and tap places back
+unsigned char prbsNextBit (prbsGen * gen)
+{
+   unsigned char bit;
+   bit = ((gen->state >> (gen->order - 1)) ^ (gen->state >> (gen->tap - 1))) & 1;
+   gen->state = ((gen->state << 1) | bit) & gen->mask;
+   return bit;
+}
+
+void prbsFill (prbsGen * gen, unsigned char * output, unsigned int outputSize)
+{
+   unsigned int index;
+   unsigned char bit, byte;
+   if (gen == NULL || output == NULL) return;
+   for (index = 0; index < outputSize; ++index)
+   {
+      byte = 0;
+      for (bit = 0; bit < 8; ++bit)
+      {
+         byte |= prbsNextBit (gen) << bit;
+      }
+      output[index] = byte;
+   }
+}
@@ -0,0 +1,61 @@
+/*
+ * redundancy.h
+ *
+ *  Created on: May 26, 2013
+ *
+ *  Picks how many back to back copies of a downlink frame to send per
+ *  traffic class. The ground station reports sequence number gaps for a
+ *  pass, the per-copy loss is estimated from that and the smallest repeat
+ *  count that meets the class target for residual frame loss is used.
+ *  Probabilities are Q15 fixed point, RED_Q_ONE is certainty.
+ */
+
+#ifndef REDUNDANCY_H_
+#define REDUNDANCY_H_
+#include "UniversalReturnCode.h"
+
+#define RED_Q_ONE          32768
+#define RED_MAX_REPEAT     4
+#define RED_DEF_TARGET     328     // 1% of unique frames lost after repeats
+#define RED_DEF_LOSS       3277    // 10% per copy assumed before feedback, gives 2 copies
+
+typedef enum //redClass
+{
+   RED_CLASS_TELEM,     // periodic telemetry, cheap to lose one
+   RED_CLASS_STATUS,    // command echo and status
+   RED_CLASS_BULK,      // stored data and file transfers
+   RED_NUM_CLASSES,
+}redClass;
+
+typedef struct //redClassState
+{
+   unsigned int  lossQ15;                     // estimated per copy loss
+   unsigned int  targetQ15;                   // acceptable unique frame loss
+   unsigned char maxRepeat;
+   unsigned char repeat;                      // present choice
+   unsigned char seq;                         // next downlink sequence number
+   // audit counters
+   unsigned int  framesSent;                  // unique frames
+   unsigned int  copiesSent;
+   unsigned int  feedbacks;
+   unsigned int  repeatChanges;
+   unsigned int  repeatUse[RED_MAX_REPEAT];   // frames sent with 1..RED_MAX_REPEAT copies
+}redClassState;
+
+typedef struct //redController
+{
+   redClassState cls[RED_NUM_CLASSES];
+}redController;
+
+void redInit (redController * ctl);
+
+// targetQ15 of 0 keeps the present target, maxRepeat is capped at RED_MAX_REPEAT
+UnivRetCode redConfigure (redController * ctl, redClass cls, unsigned int targetQ15, unsigned char maxRepeat);
+
+// Allocates the next sequence number and returns the copies to send
+unsigned char redNextFrame (redController * ctl, redClass cls, unsigned char * seq);
+
+// Ground station report for a pass: sequence numbers spanned and missing
+UnivRetCode redFeedback (redController * ctl, redClass cls, unsigned int expected, unsigned int lost);
+
+#endif /* REDUNDANCY_H_ */
@@ -0,0 +1,124 @@
+/*
+ * redundancy.c
+ *
+ *  Created on: May 26, 2013
+ */
+#include "redundancy.h"
+
+static unsigned int powQ15 (unsigned int base, unsigned char exponent);
+static unsigned int rootQ15 (unsigned int value, unsigned char degree);
+static unsigned char chooseRepeat (redClassState * state);
+
+void redInit (redController * ctl)
+{
+   unsigned int index, use;
+   redClassState * state;
+   if (ctl == NULL) return;
+   for (index = 0; index < RED_NUM_CLASSES; ++index)
+   {
+      state = &ctl->cls[index];
+      state->lossQ15       = RED_DEF_LOSS;
+      state->targetQ15     = RED_DEF_TARGET;
+      state->maxRepeat     = RED_MAX_REPEAT;
+      state->seq           = 0;
+      state->framesSent    = 0;
+      state->copiesSent    = 0;
+      state->feedbacks     = 0;
+      state->repeatChanges = 0;
+      for (use = 0; use < RED_MAX_REPEAT; ++use) state->repeatUse[use] = 0;
+      state->repeat        = chooseRepeat (state);
+   }
+}
+
+UnivRetCode redConfigure (redController * ctl, redClass cls, unsigned int targetQ15, unsigned char maxRepeat)
+{
+   redClassState * state;
+   if (ctl == NULL || cls >= RED_NUM_CLASSES) return URC_FAIL;
+   if (targetQ15 > RED_Q_ONE || maxRepeat == 0) return URC_FAIL;
+   state = &ctl->cls[cls];
+   if (targetQ15 != 0) state->targetQ15 = targetQ15;
+   state->maxRepeat = (maxRepeat > RED_MAX_REPEAT)?RED_MAX_REPEAT:maxRepeat;
+   state->repeat    = chooseRepeat (state);
+   return URC_SUCCESS;
+}
+
+unsigned char redNextFrame (redController * ctl, redClass cls, unsigned char * seq)
+{
+   redClassState * state;
+   if (ctl == NULL || cls >= RED_NUM_CLASSES) return 1;
+   state = &ctl->cls[cls];
+   if (seq != NULL) *seq = state->seq;
+   state->seq++;
+   state->framesSent++;
+   state->copiesSent += state->repeat;
+   state->repeatUse[state->repeat - 1]++;
+   return state->repeat;
+}
+
+/*
+ * A unique frame is lost only if every copy is, so the reported loss is
+ * the per copy loss to the power of the copies sent. The root recovers the
+ * per copy loss which is smoothed into the running estimate.
+ */
+UnivRetCode redFeedback (redController * ctl, redClass cls, unsigned int expected, unsigned int lost)
+{
+   redClassState * state;
+   unsigned int frameLoss;
+   unsigned int copyLoss;
+   unsigned char previous;
+   if (ctl == NULL || cls >= RED_NUM_CLASSES) return URC_FAIL;
+   if (expected == 0 || lost > expected) return URC_FAIL;
+   state = &ctl->cls[cls];
+
+   // scale down together so the Q15 product does not overflow
+   while (expected > 0xFFFF)
+   {
+      expected >>= 1;
+      lost     >>= 1;
+   }
+   frameLoss = (lost * RED_Q_ONE) / expected;
+   copyLoss  = rootQ15 (frameLoss, state->repeat);
+
+   state->lossQ15 = (state->lossQ15 * 3 + copyLoss) / 4;
+   state->feedbacks++;
+
+   previous = state->repeat;
+   state->repeat = chooseRepeat (state);
+   if (state->repeat != previous) state->repeatChanges++;
+   return URC_SUCCESS;
+}
+
+// Smallest number of copies that brings the unique frame loss under target
+static unsigned char chooseRepeat (redClassState * state)
+{
+   unsigned char repeat = 1;
+   unsigned int residual = state->lossQ15;
+   while (residual > state->targetQ15 && repeat < state->maxRepeat)
+   {
+      residual = (residual * state->lossQ15) >> 15;
+      ++repeat;
+   }
+   return repeat;
+}
+
+static unsigned int powQ15 (unsigned int base, unsigned char exponent)
+{
+   unsigned int result = RED_Q_ONE;
+   while (exponent-- > 0) result = (result * base) >> 15;
+   return result;
+}
+
+// Smallest x with x^degree >= value, by bisection over the Q15 range.
+// Rounding this way keeps a clean pass at exactly zero loss.
+static unsigned int rootQ15 (unsigned int value, unsigned char degree)
+{
+   unsigned int low = 0, high = RED_Q_ONE, mid;
+   if (degree <= 1) return value;
+   while (low < high)
+   {
+      mid = (low + high) / 2;
+      if (powQ15 (mid, degree) >= value) high = mid;
+      else                               low  = mid + 1;
+   }
+   return low;
+}
@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "redundancy.h"
+
+void TestRedInitDefault(CuTest* tc)
+{
+   redController ctl;
+   unsigned int index;
+   redInit (&ctl);
+   // 10% per copy loss needs two copies for 1% residual, same as before
+   for (index = 0; index < RED_NUM_CLASSES; ++index)
+   {
+      CuAssertTrue(tc, ctl.cls[index].repeat == 2);
+      CuAssertTrue(tc, ctl.cls[index].framesSent == 0);
+   }
+}
+
+void TestRedNextFrameCounters(CuTest* tc)
+{
+   redController ctl;
+   unsigned char seq = 0xFF;
+   unsigned int index;
+   redInit (&ctl);
+   for (index = 0; index < 300; ++index)
+   {
+      CuAssertTrue(tc, redNextFrame (&ctl, RED_CLASS_TELEM, &seq) == 2);
+      CuAssertTrue(tc, seq == (index & 0xFF));
+   }
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].framesSent == 300);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].copiesSent == 600);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].repeatUse[1] == 300);
+   // other classes keep their own sequence
+   redNextFrame (&ctl, RED_CLASS_STATUS, &seq);
+   CuAssertTrue(tc, seq == 0);
+}
+
+void TestRedCleanPassDropsRepeat(CuTest* tc)
+{
+   redController ctl;
+   unsigned int pass;
+   redInit (&ctl);
+   for (pass = 0; pass < 10; ++pass)
+   {
+      CuAssertTrue(tc, redFeedback (&ctl, RED_CLASS_TELEM, 200, 0) == URC_SUCCESS);
+   }
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].repeat == 1);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].repeatChanges == 1);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].feedbacks == 10);
+   // untouched class is unchanged
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_BULK].repeat == 2);
+}
+
+void TestRedLossyPassRaisesRepeat(CuTest* tc)
+{
+   redController ctl;
+   unsigned int pass;
+   redInit (&ctl);
+   // 9% of unique frames lost at two copies is 30% per copy
+   for (pass = 0; pass < 20; ++pass)
+   {
+      redFeedback (&ctl, RED_CLASS_BULK, 100, 9);
+   }
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_BULK].lossQ15 > 9000);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_BULK].repeat == 4);
+}
+
+void TestRedConfigureCaps(CuTest* tc)
+{
+   redController ctl;
+   redInit (&ctl);
+   CuAssertTrue(tc, redConfigure (&ctl, RED_CLASS_TELEM, 0, 1) == URC_SUCCESS);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].repeat == 1);
+   CuAssertTrue(tc, redConfigure (&ctl, RED_CLASS_TELEM, 0, 9) == URC_SUCCESS);
+   CuAssertTrue(tc, ctl.cls[RED_CLASS_TELEM].maxRepeat == RED_MAX_REPEAT);
+   CuAssertTrue(tc, redConfigure (&ctl, RED_NUM_CLASSES, 0, 2) == URC_FAIL);
+   CuAssertTrue(tc, redConfigure (&ctl, RED_CLASS_TELEM, 0, 0) == URC_FAIL);
+   CuAssertTrue(tc, redFeedback (&ctl, RED_CLASS_TELEM, 0, 0) == URC_FAIL);
+   CuAssertTrue(tc, redFeedback (&ctl, RED_CLASS_TELEM, 5, 6) == URC_FAIL);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestRedInitDefault);
+   SUITE_ADD_TEST(suite, TestRedNextFrameCounters);
+   SUITE_ADD_TEST(suite, TestRedCleanPassDropsRepeat);
+   SUITE_ADD_TEST(suite, TestRedLossyPassRaisesRepeat);
+   SUITE_ADD_TEST(suite, TestRedConfigureCaps);
+   return suite;
+}
@@ -0,0 +1,47 @@
+/*
+ * ring.h
+ *
+ *  Created on: Jun 8, 2013
+ *
+ *  Single producer, single consumer byte ring for handing data between an
+ *  interrupt and a task. The producer only ever writes head and the
+ *  consumer only ever writes tail, so neither side needs a critical
+ *  section. Both count up freely and are masked into the storage, which
+ *  has to be a power of two in size; every byte of it is usable.
+ *
+ *  Reserve and commit let the producer fill the storage in place, peek
+ *  and consume let the consumer read it in place. Both hand out the
+ *  contiguous part only, call again after the wrap for the rest.
+ */
+
+#ifndef RING_H_
+#define RING_H_
+#include "UniversalReturnCode.h"
+
+typedef struct //ringBuffer
+{
+   unsigned char *         data;
+   unsigned int            mask;     // size - 1
+   volatile unsigned int   head;     // bytes ever pushed, producer side only
+   volatile unsigned int   tail;     // bytes ever popped, consumer side only
+}ringBuffer;
+
+// Fails unless size is a power of two
+UnivRetCode ringInit (ringBuffer * ring, unsigned char * storage, unsigned int size);
+
+unsigned int ringCount (const ringBuffer * ring);
+unsigned int ringSpace (const ringBuffer * ring);
+
+// Producer side
+UnivRetCode  ringPutByte (ringBuffer * ring, unsigned char byte);
+unsigned int ringPush    (ringBuffer * ring, const unsigned char * input, unsigned int size);
+unsigned int ringReserve (ringBuffer * ring, unsigned char ** where);
+void         ringCommit  (ringBuffer * ring, unsigned int size);
+
+// Consumer side
+UnivRetCode  ringGetByte (ringBuffer * ring, unsigned char * byte);
+unsigned int ringPop     (ringBuffer * ring, unsigned char * output, unsigned int size);
+unsigned int ringPeek    (ringBuffer * ring, unsigned char ** where);
+void         ringConsume (ringBuffer * ring, unsigned int size);
+
+#endif /* RING_H_ */
@@ -0,0 +1,113 @@
+/*
+ * ring.c
+ *
+ *  Created on: Jun 8, 2013
+ */
+#include "ring.h"
+
+// The ARM7 is a single in order core, the compiler is all that can move a
+// store to head or tail across the data it publishes. Host tests run the
+// two sides on separate cores and need the real fence.
+#ifdef UNIT_TEST
+#define RING_BARRIER()  __sync_synchronize ()
+#else
+#define RING_BARRIER()  __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+UnivRetCode ringInit (ringBuffer * ring, unsigned char * storage, unsigned int size)
+{
+   if (ring == NULL || storage == NULL || size == 0 || (size & (size - 1)) != 0) return URC_FAIL;
+   ring->data = storage;
+   ring->mask = size - 1;
+   ring->head = 0;
+   ring->tail = 0;
+   return URC_SUCCESS;
+}
+
+unsigned int ringCount (const ringBuffer * ring)
+{
+   return ring->head - ring->tail;
+}
+
+unsigned int ringSpace (const ringBuffer * ring)
+{
+   return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+UnivRetCode ringPutByte (ringBuffer * ring, unsigned char byte)
+{
+   unsigned int head = ring->head;
+   if (head - ring->tail > ring->mask) return URC_FAIL;
+   ring->data[head & ring->mask] = byte;
+   RING_BARRIER ();
+   ring->head = head + 1;
+   return URC_SUCCESS;
+}
+
+unsigned int ringPush (ringBuffer * ring, const unsigned char * input, unsigned int size)
+{
+   unsigned int head = ring->head;
+   unsigned int space = ring->mask + 1 - (head - ring->tail);
+   unsigned int pos;
+   if (size > space) size = space;
+   for (pos = 0; pos < size; ++pos) ring->data[(head + pos) & ring->mask] = input[pos];
+   RING_BARRIER ();
+   ring->head = head + size;
+   return size;
+}
+
+unsigned int ringReserve (ringBuffer * ring, unsigned char ** where)
+{
+   unsigned int head = ring->head;
+   unsigned int space = ring->mask + 1 - (head - ring->tail);
+   unsigned int toEnd = ring->mask + 1 - (head & ring->mask);
+   RING_BARRIER ();
+   *where = &ring->data[head & ring->mask];
+   return (space < toEnd) ? space : toEnd;
+}
+
+void ringCommit (ringBuffer * ring, unsigned int size)
+{
+   RING_BARRIER ();
+   ring->head += size;
+}
+
+UnivRetCode ringGetByte (ringBuffer * ring, unsigned char * byte)
+{
+   unsigned int tail = ring->tail;
+   if (ring->head == tail) return URC_FAIL;
+   RING_BARRIER ();
+   *byte = ring->data[tail & ring->mask];
+   RING_BARRIER ();
+   ring->tail = tail + 1;
+   return URC_SUCCESS;
+}
+
+unsigned int ringPop (ringBuffer * ring, unsigned char * output, unsigned int size)
+{
+   unsigned int tail = ring->tail;
+   unsigned int count = ring->head - tail;
+   unsigned int pos;
+   if (size > count) size = count;
+   RING_BARRIER ();
+   for (pos = 0; pos < size; ++pos) output[pos] = ring->data[(tail + pos) & ring->mask];
+   RING_BARRIER ();
+   ring->tail = tail + size;
+   return size;
+}
+
+unsigned int ringPeek (ringBuffer * ring, unsigned char ** where)
+{
+   unsigned int tail = ring->tail;
+   unsigned int count = ring->head - tail;
+   unsigned int toEnd = ring->mask + 1 - (tail & ring->mask);
+   RING_BARRIER ();
+   *where = &ring->data[tail & ring->mask];
+   return (count < toEnd) ? count : toEnd;
+}
+
+void ringConsume (ringBuffer * ring, unsigned int size)
+{
+   RING_BARRIER ();
+   ring->tail += size;
+}
@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "CuTest.h"
+#include "ring.h"
+
+#define STRESS_BYTES    1000000UL
+
+void TestRingInit(CuTest* tc)
+{
+   ringBuffer ring;
+   unsigned char storage[64];
+   CuAssertTrue(tc, ringInit (&ring, storage, 0) == URC_FAIL);
+   CuAssertTrue(tc, ringInit (&ring, storage, 48) == URC_FAIL);
+   CuAssertTrue(tc, ringInit (&ring, NULL, 64) == URC_FAIL);
+   CuAssertTrue(tc, ringInit (&ring, storage, 64) == URC_SUCCESS);
+   CuAssertTrue(tc, ringCount (&ring) == 0 && ringSpace (&ring) == 64);
+}
+
+void TestRingFullAndWrap(CuTest* tc)
+{
+   ringBuffer ring;
+   unsigned char storage[8];
+   unsigned char input[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+   unsigned char output[12];
+   unsigned char byte;
+   ringInit (&ring, storage, sizeof(storage));
+   // every byte of the storage holds data, the next one is refused
+   CuAssertTrue(tc, ringPush (&ring, input, sizeof(input)) == 8);
+   CuAssertTrue(tc, ringSpace (&ring) == 0);
+   CuAssertTrue(tc, ringPutByte (&ring, 99) == URC_FAIL);
+   CuAssertTrue(tc, ringPop (&ring, output, 5) == 5);
+   CuAssertTrue(tc, memcmp (output, input, 5) == 0);
+   // across the end of the storage
+   CuAssertTrue(tc, ringPush (&ring, &input[8], 4) == 4);
+   CuAssertTrue(tc, ringCount (&ring) == 7);
+   CuAssertTrue(tc, ringPop (&ring, output, sizeof(output)) == 7);
+   CuAssertTrue(tc, memcmp (output, &input[5], 7) == 0);
+   CuAssertTrue(tc, ringGetByte (&ring, &byte) == URC_FAIL);
+   // the free running counters wrap too
+   ring.head = ring.tail = 0xFFFFFFFEU;
+   CuAssertTrue(tc, ringPutByte (&ring, 21) == URC_SUCCESS);
+   CuAssertTrue(tc, ringPutByte (&ring, 22) == URC_SUCCESS);
+   CuAssertTrue(tc, ringPutByte (&ring, 23) == URC_SUCCESS);
+   CuAssertTrue(tc, ringCount (&ring) == 3);
+   CuAssertTrue(tc, ringGetByte (&ring, &byte) == URC_SUCCESS && byte == 21);
+   CuAssertTrue(tc, ringGetByte (&ring, &byte) == URC_SUCCESS && byte == 22);
+   CuAssertTrue(tc, ringGetByte (&ring, &byte) == URC_SUCCESS && byte == 23);
+}
+
+void TestRingReservePeek(CuTest* tc)
+{
+   ringBuffer ring;
+   unsigned char storage[16];
+   unsigned char input[10] = { 0 };
+   unsigned char * where;
+   ringInit (&ring, storage, sizeof(storage));
+   ringPush (&ring, input, 10);
+   ringConsume (&ring, 10);
+   // 6 bytes up to the end, the rest only after the wrap
+   CuAssertTrue(tc, ringReserve (&ring, &where) == 6 && where == &storage[10]);
+   memset (where, 0xA5, 6);
+   ringCommit (&ring, 6);
+   CuAssertTrue(tc, ringReserve (&ring, &where) == 10 && where == &storage[0]);
+   where[0] = 0x5A;
+   ringCommit (&ring, 1);
+   CuAssertTrue(tc, ringCount (&ring) == 7);
+   CuAssertTrue(tc, ringPeek (&ring, &where) == 6 && where == &storage[10] && where[5] == 0xA5);
+   ringConsume (&ring, 6);
+   CuAssertTrue(tc, ringPeek (&ring, &where) == 1 && where[0] == 0x5A);
+   ringConsume (&ring, 1);
+   CuAssertTrue(tc, ringPeek (&ring, &where) == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * Two threads, each side using a different mix of calls. The consumer
+ * checks every byte against the sequence the producer wrote. A side that
+ * finds nothing to do yields, the host may only have the one core.
+ *-------------------------------------------------------------------------*/
+
+static ringBuffer stressRing;
+static unsigned char stressStorage[64];
+
+static void * stressProducer (void * arg)
+{
+   unsigned long sent = 0;
+   unsigned char block[13];
+   unsigned char * where;
+   unsigned int size, pos;
+   (void) arg;
+   while (sent < STRESS_BYTES)
+   {
+      switch (sent % 3)
+      {
+         case 0:
+            if (ringPutByte (&stressRing, (unsigned char)sent) == URC_SUCCESS) sent++;
+            else sched_yield ();
+            break;
+         case 1:
+            for (pos = 0; pos < sizeof(block); ++pos) block[pos] = (unsigned char)(sent + pos);
+            size = sizeof(block);
+            if (size > STRESS_BYTES - sent) size = STRESS_BYTES - sent;
+            size = ringPush (&stressRing, block, size);
+            if (size == 0) sched_yield ();
+            sent += size;
+            break;
+         default:
+            size = ringReserve (&stressRing, &where);
+            if (size > STRESS_BYTES - sent) size = STRESS_BYTES - sent;
+            for (pos = 0; pos < size; ++pos) where[pos] = (unsigned char)(sent + pos);
+            ringCommit (&stressRing, size);
+            if (size == 0) sched_yield ();
+            sent += size;
+            break;
+      }
+   }
+   return NULL;
+}
+
+static unsigned long stressConsume (void)
+{
+   unsigned long received = 0;
+   unsigned long errors = 0;
+   unsigned char block[7];
+   unsigned char * where;
+   unsigned char byte;
+   unsigned int size, pos;
+   while (received < STRESS_BYTES)
+   {
+      switch (received % 3)
+      {
+         case 0:
+            if (ringGetByte (&stressRing, &byte) == URC_SUCCESS)
+            {
+               errors += (byte != (unsigned char)received);
+               received++;
+            }
+            else sched_yield ();
+            break;
+         case 1:
+            size = ringPop (&stressRing, block, sizeof(block));
+            for (pos = 0; pos < size; ++pos) errors += (block[pos] != (unsigned char)(received + pos));
+            if (size == 0) sched_yield ();
+            received += size;
+            break;
+         default:
+            size = ringPeek (&stressRing, &where);
+            for (pos = 0; pos < size; ++pos) errors += (where[pos] != (unsigned char)(received + pos));
+            ringConsume (&stressRing, size);
+            if (size == 0) sched_yield ();
+            received += size;
+            break;
+      }
+   }
+   return errors;
+}
+
+void TestRingTwoThreads(CuTest* tc)
+{
+   pthread_t producer;
+   unsigned long errors;
+   ringInit (&stressRing, stressStorage, sizeof(stressStorage));
+   CuAssertTrue(tc, pthread_create (&producer, NULL, stressProducer, NULL) == 0);
+   errors = stressConsume ();
+   pthread_join (producer, NULL);
+   CuAssertTrue(tc, errors == 0);
+   CuAssertTrue(tc, ringCount (&stressRing) == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestRingInit);
+   SUITE_ADD_TEST(suite, TestRingFullAndWrap);
+   SUITE_ADD_TEST(suite, TestRingReservePeek);
+   SUITE_ADD_TEST(suite, TestRingTwoThreads);
+   return suite;
+}
@@ -0,0 +1,34 @@
+/*
+ * scale.h
+ *
+ *  Created on: Jun 10, 2013
+ *
+ *  Raw sensor codes to engineering units as raw * num / den without a
+ *  divide per sample. The ratio is split once, when a channel is
+ *  calibrated, into a whole part and a Q format fraction with its shift,
+ *  chosen so the result is exactly floor(raw * num / den) for every raw
+ *  code up to the channel's full scale. Converting is then a multiply by
+ *  the whole part and a long multiply and shift for the fraction.
+ */
+
+#ifndef SCALE_H_
+#define SCALE_H_
+#include "UniversalReturnCode.h"
+
+typedef struct //scaleChannel
+{
+   unsigned int  whole;
+   unsigned int  frac;        // fraction of the ratio times 2^shift, rounded up
+   unsigned char shift;
+}scaleChannel;
+
+// Fails when den is 0, when the whole part is past 32 bits or when no shift
+// is exact over 0..maxRaw. maxRaw times den, with the common factors of num
+// and den taken out, below 2^32 always succeeds.
+UnivRetCode scaleMake (scaleChannel * channel, unsigned long long num,
+                       unsigned long long den, unsigned int maxRaw);
+
+// Only exact up to the maxRaw given to scaleMake
+unsigned int scaleApply (const scaleChannel * channel, unsigned int raw);
+
+#endif /* SCALE_H_ */
@@ -0,0 +1,69 @@
+/*
+ * scale.c
+ *
+ *  Created on: Jun 10, 2013
+ */
+#include "scale.h"
+
+#define SCALE_MAX_SHIFT    63
+
+static unsigned long long gcd (unsigned long long a, unsigned long long b)
+{
+   unsigned long long t;
+   while (b != 0)
+   {
+      t = a % b;
+      a = b;
+      b = t;
+   }
+   return a;
+}
+
+/*
+ * frac = ceil(rem * 2^shift / den) overshoots rem / den by
+ * err / (den * 2^shift) with err = frac * den - rem * 2^shift. The
+ * fraction part of raw * rem / den is at most (den - 1) / den, so the
+ * floor is unchanged while raw * err < 2^shift. err is below den, which
+ * is why the common factors come out first. The smallest such shift is
+ * taken, it keeps the multiplier small.
+ */
+UnivRetCode scaleMake (scaleChannel * channel, unsigned long long num,
+                       unsigned long long den, unsigned int maxRaw)
+{
+   unsigned long long common, whole, rem, scaled, frac, left, err;
+   unsigned int shift;
+   if (den == 0) return URC_FAIL;
+   common = gcd (num, den);
+   if (common > 1)
+   {
+      num /= common;
+      den /= common;
+   }
+   whole = num / den;
+   rem = num % den;
+   if (whole > 0xFFFFFFFFULL) return URC_FAIL;
+   for (shift = 0; shift <= SCALE_MAX_SHIFT; ++shift)
+   {
+      if (rem > (~0ULL >> shift)) break;
+      scaled = rem << shift;
+      left = scaled % den;
+      frac = scaled / den + (left != 0);
+      if (frac > 0xFFFFFFFFULL) break;
+      err = (left != 0) ? den - left : 0;
+      // a product that would overflow is past any shift anyway
+      if (maxRaw != 0 && err > ~0ULL / maxRaw) continue;
+      if ((unsigned long long)maxRaw * err < (1ULL << shift))
+      {
+         channel->whole = (unsigned int)whole;
+         channel->frac = (unsigned int)frac;
+         channel->shift = (unsigned char)shift;
+         return URC_SUCCESS;
+      }
+   }
+   return URC_FAIL;
+}
+
+unsigned int scaleApply (const scaleChannel * channel, unsigned int raw)
+{
+   return raw * channel->whole + (unsigned int)(((unsigned long long)raw * channel->frac) >> channel->shift);
+}
@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "CuTest.h"
+#include "scale.h"
+
+#define PM_CODE_MAX        4095
+#define BENCH_SAMPLES      10000000U
+
+// The power monitor conversions as they were written, the references
+static unsigned int voltageDivide (unsigned int vCode, unsigned int vRange)
+{
+   return vCode * (vRange ? 26520 : 6650) / 4096;
+}
+
+static unsigned int currentDivide (unsigned int iCode, unsigned int shuntOhm)
+{
+   return (iCode * 105840 / 4096) * 1000 / shuntOhm;
+}
+
+static unsigned int currentExact (unsigned int iCode, unsigned int shuntOhm)
+{
+   return (unsigned int)((unsigned long long)iCode * 105840 * 1000 / (4096ULL * shuntOhm));
+}
+
+void TestScaleVoltageMatchesDivide(CuTest* tc)
+{
+   scaleChannel range[2];
+   unsigned int code, bad = 0;
+   CuAssertTrue(tc, scaleMake (&range[0], 6650, 4096, PM_CODE_MAX) == URC_SUCCESS);
+   CuAssertTrue(tc, scaleMake (&range[1], 26520, 4096, PM_CODE_MAX) == URC_SUCCESS);
+   for (code = 0; code <= PM_CODE_MAX; ++code)
+   {
+      if (scaleApply (&range[0], code) != voltageDivide (code, 0)) bad++;
+      if (scaleApply (&range[1], code) != voltageDivide (code, 1)) bad++;
+   }
+   CuAssertTrue(tc, bad == 0);
+}
+
+/*
+ * The old current math rounds down twice, once per divide, and the first
+ * loss is multiplied by 1000 / shunt before the second. The scaled result
+ * is a single rounding of the same ratio, never below the old value and
+ * above it by at most what the first rounding threw away.
+ */
+void TestScaleCurrentMatchesDivide(CuTest* tc)
+{
+   static const unsigned int shunts[] = { 1, 2, 5, 10, 22, 47, 100, 1000, 33333, 1000000 };
+   scaleChannel channel;
+   unsigned int shunt, code, scaled, old, bad = 0, above = 0;
+   for (shunt = 0; shunt < sizeof(shunts) / sizeof(shunts[0]); ++shunt)
+   {
+      CuAssertTrue(tc, scaleMake (&channel, 105840ULL * 1000, 4096ULL * shunts[shunt], PM_CODE_MAX) == URC_SUCCESS);
+      for (code = 0; code <= PM_CODE_MAX; ++code)
+      {
+         scaled = scaleApply (&channel, code);
+         old = currentDivide (code, shunts[shunt]);
+         if (scaled != currentExact (code, shunts[shunt])) bad++;
+         if (scaled < old || scaled > old + 1000 / shunts[shunt] + 1) bad++;
+         if (scaled != old) above++;
+      }
+   }
+   CuAssertTrue(tc, bad == 0);
+   printf ("current codes above the double rounding: %u\n", above);
+}
+
+void TestScaleMakeIsExact(CuTest* tc)
+{
+   scaleChannel channel;
+   unsigned int trial, raw, maxRaw, bad = 0;
+   unsigned long long num, den;
+   srand (7);
+   for (trial = 0; trial < 2000; ++trial)
+   {
+      num = (unsigned long long)(rand () % 1000000 + 1);
+      den = (unsigned long long)(rand () % 60000 + 1);
+      maxRaw = (trial & 1) ? 4095 : 65535;
+      // ratios that leave the result within 32 bits
+      if (num * maxRaw / den > 0xFFFFFFFFULL) continue;
+      if (scaleMake (&channel, num, den, maxRaw) != URC_SUCCESS) { bad++; continue; }
+      for (raw = 0; raw <= maxRaw; raw += (maxRaw > 4095) ? 7 : 1)
+      {
+         if (scaleApply (&channel, raw) != (unsigned int)(raw * num / den)) bad++;
+      }
+      if (scaleApply (&channel, maxRaw) != (unsigned int)(maxRaw * num / den)) bad++;
+   }
+   CuAssertTrue(tc, bad == 0);
+   CuAssertTrue(tc, scaleMake (&channel, 1, 0, 10) == URC_FAIL);
+   // power of two denominators need no rounding at all
+   CuAssertTrue(tc, scaleMake (&channel, 3, 8, 0xFFFFFFFFU) == URC_SUCCESS);
+   CuAssertTrue(tc, scaleApply (&channel, 0xFFFFFFFFU) == (unsigned int)(0xFFFFFFFFULL * 3 / 8));
+}
+
+void TestScaleBenchmark(CuTest* tc)
+{
+   static volatile unsigned int sink;
+   static volatile unsigned int shuntOhm = 47;
+   scaleChannel channel;
+   unsigned int sample;
+   clock_t start;
+   double divideNs, scaleNs;
+   scaleMake (&channel, 105840ULL * 1000, 4096ULL * 47, PM_CODE_MAX);
+   start = clock ();
+   for (sample = 0; sample < BENCH_SAMPLES; ++sample) sink = currentDivide (sample & PM_CODE_MAX, shuntOhm);
+   divideNs = (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / BENCH_SAMPLES;
+   start = clock ();
+   for (sample = 0; sample < BENCH_SAMPLES; ++sample) sink = scaleApply (&channel, sample & PM_CODE_MAX);
+   scaleNs = (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / BENCH_SAMPLES;
+   printf ("current ns per sample, divide %.2f against scale %.2f\n", divideNs, scaleNs);
+   CuAssertTrue(tc, sink <= currentExact (PM_CODE_MAX, 47));
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestScaleVoltageMatchesDivide);
+   SUITE_ADD_TEST(suite, TestScaleCurrentMatchesDivide);
+   SUITE_ADD_TEST(suite, TestScaleMakeIsExact);
+   SUITE_ADD_TEST(suite, TestScaleBenchmark);
+   return suite;
+}
@@ -5,9 +5,58 @@
 
 #include "lib_string.h"
 
+/*
+ * memcpy, memset and memcmp work a machine word at a time once the
+ * pointers are aligned, four words a loop. Copies of a block or more on
+ * the ARM move eight registers at a time with ldm/stm. Short lengths,
+ * and pointers that can never line up, go a byte at a time. The _byte
+ * versions are the plain loops these started as, kept to test against.
+ */
+
+typedef unsigned long	lib_word;
+
+#define WORD_SIZE		sizeof(lib_word)
+#define WORD_MASK		(WORD_SIZE - 1)
+//below this the alignment work costs more than it saves
+#define WORD_MIN_COUNT	(4 * WORD_SIZE)
+//bytes moved per ldm/stm pair
+#define BURST_SIZE		32
+
+#define IS_ALIGNED(p)	((((unsigned long)(p)) & WORD_MASK) == 0)
+
 void * memset(void * s, int c, unsigned long count)
 {
-	char *xs = (char *) s;
+	unsigned char *xs = (unsigned char *) s;
+	lib_word *ws;
+	lib_word pattern;
+
+	if (count >= WORD_MIN_COUNT)
+	{
+		while (!IS_ALIGNED(xs))
+		{
+			*xs++ = c;
+			count--;
+		}
+
+		pattern = (unsigned char) c;
+		pattern |= pattern << 8;
+		pattern |= pattern << 16;
+		if (WORD_SIZE > 4) pattern |= (pattern << 16) << 16;
+
+		for (ws = (lib_word *) xs; count >= 4 * WORD_SIZE; count -= 4 * WORD_SIZE)
+		{
+			ws[0] = pattern;
+			ws[1] = pattern;
+			ws[2] = pattern;
+			ws[3] = pattern;
+			ws += 4;
+		}
+		for ( ; count >= WORD_SIZE; count -= WORD_SIZE)
+		{
+			*ws++ = pattern;
+		}
+		xs = (unsigned char *) ws;
+	}
 
 	while (count--)
 		*xs++ = c;
@@ -27,7 +76,66 @@ char * strncpy(char * dest, const char *src, unsigned long count)
 
 void * memcpy(void * dest, const void *src, unsigned long count)
 {
-	char *tmp = (char *) dest, *s = (char *) src;
+	unsigned char *tmp = (unsigned char *) dest;
+	const unsigned char *s = (const unsigned char *) src;
+	lib_word *wd;
+	const lib_word *ws;
+
+	if (count >= WORD_MIN_COUNT && ((((unsigned long) tmp) ^ ((unsigned long) s)) & WORD_MASK) == 0)
+	{
+		while (!IS_ALIGNED(tmp))
+		{
+			*tmp++ = *s++;
+			count--;
+		}
+		wd = (lib_word *) tmp;
+		ws = (const lib_word *) s;
+
+#if defined(__arm__) && !defined(UNIT_TEST)
+		if (count >= BURST_SIZE)
+		{
+			unsigned long bursts = count / BURST_SIZE;
+
+			count -= bursts * BURST_SIZE;
+			__asm__ __volatile__ (
+				"1:	ldmia	%0!, {r3-r6, r8-r10, r12}	\n\t"
+				"	stmia	%1!, {r3-r6, r8-r10, r12}	\n\t"
+				"	subs	%2, %2, #1					\n\t"
+				"	bne		1b							\n\t"
+				: "+r" (ws), "+r" (wd), "+r" (bursts)
+				:
+				: "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory");
+		}
+#endif
+		for ( ; count >= 4 * WORD_SIZE; count -= 4 * WORD_SIZE)
+		{
+			wd[0] = ws[0];
+			wd[1] = ws[1];
+			wd[2] = ws[2];
+			wd[3] = ws[3];
+			wd += 4;
+			ws += 4;
+		}
+		for ( ; count >= WORD_SIZE; count -= WORD_SIZE)
+		{
+			*wd++ = *ws++;
+		}
+		tmp = (unsigned char *) wd;
+		s = (const unsigned char *) ws;
+	}
+	else
+	{
+		//never lines up, at least save the loop overhead
+		for ( ; count >= 4; count -= 4)
+		{
+			tmp[0] = s[0];
+			tmp[1] = s[1];
+			tmp[2] = s[2];
+			tmp[3] = s[3];
+			tmp += 4;
+			s += 4;
+		}
+	}
 
 	while (count--)
 		*tmp++ = *s++;
@@ -37,10 +145,61 @@ void * memcpy(void * dest, const void *src, unsigned long count)
 
 
 int memcmp(const void * s1, const void * s2, unsigned long size)
+{
+   const unsigned char *u1 = (const unsigned char*)s1;
+   const unsigned char *u2 = (const unsigned char*)s2;
+   const lib_word *w1;
+   const lib_word *w2;
+
+   if (size >= WORD_MIN_COUNT && ((((unsigned long) u1) ^ ((unsigned long) u2)) & WORD_MASK) == 0)
+   {
+      for ( ; !IS_ALIGNED(u1); u1++, u2++, size--) {
+         if (*u1 != *u2) {
+             return (*u1 > *u2 ? 1 : -1);
+         }
+      }
+      //stop at the first word that differs, the bytes say which way
+      w1 = (const lib_word *) u1;
+      w2 = (const lib_word *) u2;
+      for ( ; size >= WORD_SIZE && *w1 == *w2; w1++, w2++, size -= WORD_SIZE)
+         /* nothing */;
+      u1 = (const unsigned char *) w1;
+      u2 = (const unsigned char *) w2;
+   }
+
+   for ( ; size > 0; u1++, u2++, size--) {
+      if (*u1 != *u2) {
+          return (*u1 > *u2 ? 1 : -1);
+      }
+   }
+   return 0;
+}
+
+void * memset_byte(void * s, int c, unsigned long count)
+{
+	char *xs = (char *) s;
+
+	while (count--)
+		*xs++ = c;
+
+	return s;
+}
+
+void * memcpy_byte(void * dest, const void *src, unsigned long count)
+{
+	char *tmp = (char *) dest, *s = (char *) src;
+
+	while (count--)
+		*tmp++ = *s++;
+
+	return dest;
+}
+
+int memcmp_byte(const void * s1, const void * s2, unsigned long size)
 {
    unsigned char *u1 = (unsigned char*)s1;
    unsigned char *u2 = (unsigned char*)s2;
-   
+
    for ( ; size > 0; u1++, u2++, size--) {
       if (*u1 != *u2) {
           return (*u1 > *u2 ? 1 : -1);
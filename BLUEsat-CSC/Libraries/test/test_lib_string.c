@@ -0,0 +1,148 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "CuTest.h"
+#include "lib_string.h"
+
+#define MAX_LEN        300
+#define MAX_OFFSET     8
+#define GUARD          16
+#define AREA           (GUARD + MAX_OFFSET + MAX_LEN + GUARD)
+#define BENCH_BYTES    (16UL * 1024 * 1024)
+
+static unsigned long areaBuf[2][AREA / sizeof(unsigned long) + 1];
+static unsigned long expectBuf[AREA / sizeof(unsigned long) + 1];
+
+static void fillPattern (unsigned char * area, unsigned char seed)
+{
+   unsigned int pos;
+   for (pos = 0; pos < AREA; ++pos) area[pos] = (unsigned char)(seed + pos * 7);
+}
+
+void TestMemcpyMatchesReference(CuTest* tc)
+{
+   unsigned char * src = (unsigned char *)areaBuf[0];
+   unsigned char * dst = (unsigned char *)areaBuf[1];
+   unsigned char * expect = (unsigned char *)expectBuf;
+   unsigned int srcOff, dstOff, len, bad = 0;
+   fillPattern (src, 1);
+   for (srcOff = 0; srcOff < MAX_OFFSET; ++srcOff)
+   for (dstOff = 0; dstOff < MAX_OFFSET; ++dstOff)
+   for (len = 0; len <= MAX_LEN; ++len)
+   {
+      fillPattern (dst, 99);
+      fillPattern (expect, 99);
+      memcpy_byte (&expect[GUARD + dstOff], &src[GUARD + srcOff], len);
+      if (memcpy (&dst[GUARD + dstOff], &src[GUARD + srcOff], len) != &dst[GUARD + dstOff]) bad++;
+      // guard bytes either side untouched too
+      if (memcmp_byte (dst, expect, AREA) != 0) bad++;
+   }
+   CuAssertTrue(tc, bad == 0);
+}
+
+void TestMemsetMatchesReference(CuTest* tc)
+{
+   unsigned char * dst = (unsigned char *)areaBuf[1];
+   unsigned char * expect = (unsigned char *)expectBuf;
+   int values[4] = { 0, 0xA5, -1, 0x15A };
+   unsigned int value, dstOff, len, bad = 0;
+   for (value = 0; value < 4; ++value)
+   for (dstOff = 0; dstOff < MAX_OFFSET; ++dstOff)
+   for (len = 0; len <= MAX_LEN; ++len)
+   {
+      fillPattern (dst, 3);
+      fillPattern (expect, 3);
+      memset_byte (&expect[GUARD + dstOff], values[value], len);
+      if (memset (&dst[GUARD + dstOff], values[value], len) != &dst[GUARD + dstOff]) bad++;
+      if (memcmp_byte (dst, expect, AREA) != 0) bad++;
+   }
+   CuAssertTrue(tc, bad == 0);
+}
+
+void TestMemcmpMatchesReference(CuTest* tc)
+{
+   unsigned char * a = (unsigned char *)areaBuf[0];
+   unsigned char * b = (unsigned char *)areaBuf[1];
+   unsigned int aOff, bOff, len, diff, bad = 0;
+   fillPattern (a, 5);
+   fillPattern (b, 5);
+   for (aOff = 0; aOff < MAX_OFFSET; ++aOff)
+   for (bOff = 0; bOff < MAX_OFFSET; ++bOff)
+   {
+      // equal unless the offsets differ, and then the same as the reference
+      for (len = 0; len <= MAX_LEN; len += 13)
+      {
+         if (memcmp (&a[GUARD + aOff], &b[GUARD + bOff], len) !=
+             memcmp_byte (&a[GUARD + aOff], &b[GUARD + bOff], len)) bad++;
+      }
+   }
+   // a single byte raised or lowered anywhere, the first difference decides
+   for (aOff = 0; aOff < MAX_OFFSET; ++aOff)
+   for (diff = 0; diff < 64; ++diff)
+   {
+      b[GUARD + aOff + diff] ^= 0x80;
+      b[GUARD + aOff + 63] ^= 0x01;
+      if (memcmp (&a[GUARD + aOff], &b[GUARD + aOff], 64) !=
+          memcmp_byte (&a[GUARD + aOff], &b[GUARD + aOff], 64)) bad++;
+      if (memcmp (&b[GUARD + aOff], &a[GUARD + aOff], 64) !=
+          memcmp_byte (&b[GUARD + aOff], &a[GUARD + aOff], 64)) bad++;
+      if (memcmp (&a[GUARD + aOff], &b[GUARD + aOff], diff) != 0) bad++;
+      b[GUARD + aOff + diff] ^= 0x80;
+      b[GUARD + aOff + 63] ^= 0x01;
+   }
+   CuAssertTrue(tc, bad == 0);
+}
+
+/*-------------------------------------------------------------------------*
+ * Host timing across sizes and alignments, printed for comparison with
+ * the target figures from the string bench demo.
+ *-------------------------------------------------------------------------*/
+
+static double benchCopy (void * (*copy)(void *, const void *, unsigned long),
+                         unsigned char * dst, const unsigned char * src, unsigned long len)
+{
+   unsigned long rounds = BENCH_BYTES / len;
+   unsigned long round;
+   clock_t start = clock ();
+   for (round = 0; round < rounds; ++round) copy (dst, src, len);
+   return (double)(clock () - start) * 1e9 / CLOCKS_PER_SEC / (rounds * len);
+}
+
+void TestStringBenchmark(CuTest* tc)
+{
+   static const unsigned long sizes[4] = { 16, 64, 148, 256 };
+   unsigned char * src = (unsigned char *)areaBuf[0];
+   unsigned char * dst = (unsigned char *)areaBuf[1];
+   unsigned int size, offset;
+   double byteNs, wordNs;
+   fillPattern (src, 9);
+   printf ("memcpy ns per byte, byte loop against word version\n");
+   for (size = 0; size < 4; ++size)
+   for (offset = 0; offset < 3; ++offset)
+   {
+      // aligned, both off by the same amount, never lining up
+      unsigned int srcOff = (offset == 0) ? 0 : 3;
+      unsigned int dstOff = (offset == 2) ? 1 : srcOff;
+      byteNs = benchCopy (memcpy_byte, &dst[dstOff], &src[srcOff], sizes[size]);
+      wordNs = benchCopy (memcpy, &dst[dstOff], &src[srcOff], sizes[size]);
+      printf ("  %3lu bytes src+%u dst+%u: %.2f against %.2f\n", sizes[size], srcOff, dstOff, byteNs, wordNs);
+      CuAssertTrue(tc, memcmp_byte (&dst[dstOff], &src[srcOff], sizes[size]) == 0);
+   }
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestMemcpyMatchesReference);
+   SUITE_ADD_TEST(suite, TestMemsetMatchesReference);
+   SUITE_ADD_TEST(suite, TestMemcmpMatchesReference);
+   SUITE_ADD_TEST(suite, TestStringBenchmark);
+   return suite;
+}
@@ -0,0 +1,63 @@
+/*
+ * upWindow.h
+ *
+ *  Created on: Jun 1, 2013
+ *
+ *  Receive window for uploading an object in numbered chunks. Chunks may
+ *  arrive out of order and repeated, they are held until a whole group is
+ *  in and the group is then written out in one piece. Only the window is
+ *  held in RAM, never the object.
+ *
+ *  Groups are UP_FLUSH_CHUNKS chunks starting on a multiple of that, so
+ *  whatever has been written out is always a whole number of groups and
+ *  an interrupted upload resumes from the size already written.
+ */
+
+#ifndef UPWINDOW_H_
+#define UPWINDOW_H_
+#include "UniversalReturnCode.h"
+
+#define UP_CHUNK_SIZE      128
+#define UP_WINDOW          16      // chunks, one bit each in the bitmaps
+#define UP_FLUSH_CHUNKS    4       // one storage block
+#define UP_MAX_CHUNKS      0xFFFF
+
+typedef struct //upAck
+{
+   unsigned short next;       // every chunk before this one is held or written
+   unsigned short received;   // bit n set when chunk base + n is held
+   unsigned short missing;    // bit n set when base + n is a gap below the highest seen
+   unsigned short base;       // first chunk not written out yet
+}upAck;
+
+typedef struct //upWindow
+{
+   unsigned long  size;
+   unsigned short chunks;
+   unsigned short base;
+   unsigned short received;
+   unsigned short highest;    // one past the highest chunk seen
+   unsigned char  data[UP_WINDOW][UP_CHUNK_SIZE];
+}upWindow;
+
+// Chunks written out already are counted from the stored size
+UnivRetCode upInit (upWindow * win, unsigned long size, unsigned long written);
+
+// Holds a chunk. Repeats are accepted and ignored, chunks past the window
+// or of the wrong length are refused.
+UnivRetCode upAccept (upWindow * win, unsigned short index, const unsigned char * data, unsigned int length);
+
+// Next group ready to write out, 0 when there is none
+unsigned int upReady (upWindow * win, const unsigned char ** data);
+
+// The group from upReady has been written out
+void upWritten (upWindow * win);
+
+unsigned char upComplete (upWindow * win);
+
+void upGetAck (upWindow * win, upAck * ack);
+
+// CRC-32 as used by zip, chain by passing the previous result, start at 0
+unsigned long upCrc32 (unsigned long crc, const unsigned char * data, unsigned int size);
+
+#endif /* UPWINDOW_H_ */
@@ -0,0 +1,114 @@
+/*
+ * upWindow.c
+ *
+ *  Created on: Jun 1, 2013
+ */
+#include "upWindow.h"
+
+#define UP_CRC32_POLYNOMIAL 0xEDB88320UL
+
+static unsigned int chunkLength (upWindow * win, unsigned short index);
+static unsigned int groupChunks (upWindow * win);
+
+UnivRetCode upInit (upWindow * win, unsigned long size, unsigned long written)
+{
+   unsigned long chunks;
+   if (win == NULL || size == 0) return URC_FAIL;
+   chunks = (size + UP_CHUNK_SIZE - 1) / UP_CHUNK_SIZE;
+   if (chunks > UP_MAX_CHUNKS) return URC_FAIL;
+   // anything but whole groups or the whole object means a torn write
+   if (written != size && (written > size || written % (UP_CHUNK_SIZE * UP_FLUSH_CHUNKS) != 0)) return URC_FAIL;
+   win->size     = size;
+   win->chunks   = (unsigned short)chunks;
+   win->base     = (written == size)?win->chunks:(unsigned short)(written / UP_CHUNK_SIZE);
+   win->received = 0;
+   win->highest  = win->base;
+   return URC_SUCCESS;
+}
+
+UnivRetCode upAccept (upWindow * win, unsigned short index, const unsigned char * data, unsigned int length)
+{
+   unsigned int pos;
+   unsigned char * slot;
+   if (win == NULL || data == NULL || index >= win->chunks) return URC_FAIL;
+   if (length != chunkLength (win, index)) return URC_FAIL;
+   if (index < win->base) return URC_SUCCESS;
+   if (index >= win->base + UP_WINDOW) return URC_FAIL;
+   if (win->received & (1 << (index - win->base))) return URC_SUCCESS;
+
+   slot = win->data[index % UP_WINDOW];
+   for (pos = 0; pos < length; ++pos) slot[pos] = data[pos];
+   win->received |= 1 << (index - win->base);
+   if (index >= win->highest) win->highest = index + 1;
+   return URC_SUCCESS;
+}
+
+unsigned int upReady (upWindow * win, const unsigned char ** data)
+{
+   unsigned int count;
+   unsigned short group;
+   if (win == NULL || win->base >= win->chunks) return 0;
+   count = groupChunks (win);
+   group = (1 << count) - 1;
+   if ((win->received & group) != group) return 0;
+   // groups start on a multiple of UP_FLUSH_CHUNKS so never wrap the window
+   if (data != NULL) *data = win->data[win->base % UP_WINDOW];
+   return (count - 1) * UP_CHUNK_SIZE + chunkLength (win, win->base + count - 1);
+}
+
+void upWritten (upWindow * win)
+{
+   unsigned int count;
+   if (win == NULL || win->base >= win->chunks) return;
+   count = groupChunks (win);
+   win->base     += count;
+   win->received >>= count;
+}
+
+unsigned char upComplete (upWindow * win)
+{
+   return (win != NULL && win->base >= win->chunks);
+}
+
+void upGetAck (upWindow * win, upAck * ack)
+{
+   unsigned int bit;
+   if (win == NULL || ack == NULL) return;
+   ack->base     = win->base;
+   ack->received = win->received;
+   ack->next     = win->base;
+   for (bit = 0; bit < UP_WINDOW && (win->received & (1 << bit)); ++bit) ack->next++;
+   ack->missing  = 0;
+   for (bit = 0; bit < UP_WINDOW && win->base + bit < win->highest; ++bit)
+   {
+      if (!(win->received & (1 << bit))) ack->missing |= 1 << bit;
+   }
+}
+
+unsigned long upCrc32 (unsigned long crc, const unsigned char * data, unsigned int size)
+{
+   unsigned int index, bit;
+   crc = ~crc & 0xFFFFFFFFUL;
+   for (index = 0; index < size; ++index)
+   {
+      crc ^= data[index];
+      for (bit = 0; bit < 8; ++bit)
+      {
+         crc = (crc & 1)?((crc >> 1) ^ UP_CRC32_POLYNOMIAL):(crc >> 1);
+      }
+   }
+   return ~crc & 0xFFFFFFFFUL;
+}
+
+static unsigned int chunkLength (upWindow * win, unsigned short index)
+{
+   if (index + 1 < win->chunks) return UP_CHUNK_SIZE;
+   return win->size - (unsigned long)index * UP_CHUNK_SIZE;
+}
+
+// A whole group, or whatever is left of the object
+static unsigned int groupChunks (upWindow * win)
+{
+   unsigned int left = win->chunks - win->base;
+   return (left < UP_FLUSH_CHUNKS)?left:UP_FLUSH_CHUNKS;
+}
@@ -0,0 +1,144 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "upWindow.h"
+
+#define TEST_SIZE (UP_CHUNK_SIZE * 9 + 50)
+
+static unsigned char object[TEST_SIZE];
+static unsigned char flash[TEST_SIZE];
+static unsigned long flashSize;
+
+static void makeObject (void)
+{
+   unsigned int index;
+   for (index = 0; index < TEST_SIZE; ++index) object[index] = (index * 7 + 3) & 0xFF;
+   flashSize = 0;
+}
+
+static UnivRetCode sendChunk (upWindow * win, unsigned short index)
+{
+   unsigned int length = (index == TEST_SIZE / UP_CHUNK_SIZE)?TEST_SIZE % UP_CHUNK_SIZE:UP_CHUNK_SIZE;
+   return upAccept (win, index, &object[index * UP_CHUNK_SIZE], length);
+}
+
+static void writeOut (upWindow * win)
+{
+   const unsigned char * data;
+   unsigned int size;
+   while ((size = upReady (win, &data)) > 0)
+   {
+      memcpy (&flash[flashSize], data, size);
+      flashSize += size;
+      upWritten (win);
+   }
+}
+
+void TestUpCrc32(CuTest* tc)
+{
+   unsigned long crc;
+   CuAssertTrue(tc, upCrc32 (0, (const unsigned char *)"123456789", 9) == 0xCBF43926UL);
+   // chaining gives the same answer as one pass
+   crc = upCrc32 (0, (const unsigned char *)"1234", 4);
+   CuAssertTrue(tc, upCrc32 (crc, (const unsigned char *)"56789", 5) == 0xCBF43926UL);
+}
+
+void TestUpInOrder(CuTest* tc)
+{
+   upWindow win;
+   unsigned short index;
+   makeObject ();
+   CuAssertTrue(tc, upInit (&win, TEST_SIZE, 0) == URC_SUCCESS);
+   CuAssertTrue(tc, win.chunks == 10);
+   for (index = 0; index < win.chunks; ++index)
+   {
+      CuAssertTrue(tc, sendChunk (&win, index) == URC_SUCCESS);
+      writeOut (&win);
+      // nothing leaves RAM until a whole group is in
+      CuAssertTrue(tc, flashSize % (UP_CHUNK_SIZE * UP_FLUSH_CHUNKS) == 0 || flashSize == TEST_SIZE);
+   }
+   CuAssertTrue(tc, upComplete (&win));
+   CuAssertTrue(tc, flashSize == TEST_SIZE);
+   CuAssertTrue(tc, memcmp (flash, object, TEST_SIZE) == 0);
+}
+
+void TestUpGapsAndAck(CuTest* tc)
+{
+   upWindow win;
+   upAck ack;
+   unsigned char shortChunk[10];
+   makeObject ();
+   upInit (&win, TEST_SIZE, 0);
+   sendChunk (&win, 0);
+   sendChunk (&win, 2);
+   sendChunk (&win, 3);
+   sendChunk (&win, 5);
+   sendChunk (&win, 2);
+   writeOut (&win);
+   CuAssertTrue(tc, flashSize == 0);
+   upGetAck (&win, &ack);
+   CuAssertTrue(tc, ack.base == 0);
+   CuAssertTrue(tc, ack.next == 1);
+   CuAssertTrue(tc, ack.received == 0x2D);
+   CuAssertTrue(tc, ack.missing == 0x12);
+
+   // the missing chunk releases the first group
+   sendChunk (&win, 1);
+   writeOut (&win);
+   CuAssertTrue(tc, flashSize == UP_CHUNK_SIZE * 4);
+   upGetAck (&win, &ack);
+   CuAssertTrue(tc, ack.base == 4);
+   CuAssertTrue(tc, ack.next == 4);
+   CuAssertTrue(tc, ack.received == 0x02);
+   CuAssertTrue(tc, ack.missing == 0x01);
+
+   // old repeats are fine, beyond the window and bad lengths are not
+   CuAssertTrue(tc, sendChunk (&win, 0) == URC_SUCCESS);
+   CuAssertTrue(tc, upAccept (&win, 9, shortChunk, sizeof (shortChunk)) == URC_FAIL);
+   CuAssertTrue(tc, upAccept (&win, 4, shortChunk, sizeof (shortChunk)) == URC_FAIL);
+   CuAssertTrue(tc, upAccept (&win, 10, shortChunk, sizeof (shortChunk)) == URC_FAIL);
+}
+
+void TestUpResume(CuTest* tc)
+{
+   upWindow win;
+   unsigned short index;
+   makeObject ();
+   upInit (&win, TEST_SIZE, 0);
+   for (index = 0; index < 7; ++index) sendChunk (&win, index);
+   writeOut (&win);
+   CuAssertTrue(tc, flashSize == UP_CHUNK_SIZE * 4);
+
+   // reset, the three chunks held in RAM are gone and asked for again
+   CuAssertTrue(tc, upInit (&win, TEST_SIZE, flashSize) == URC_SUCCESS);
+   CuAssertTrue(tc, win.base == 4);
+   for (index = 9; index >= 4; --index) sendChunk (&win, index);
+   writeOut (&win);
+   CuAssertTrue(tc, upComplete (&win));
+   CuAssertTrue(tc, memcmp (flash, object, TEST_SIZE) == 0);
+   CuAssertTrue(tc, upCrc32 (0, flash, flashSize) == upCrc32 (0, object, TEST_SIZE));
+
+   // torn or oversized writes can not be resumed
+   CuAssertTrue(tc, upInit (&win, TEST_SIZE, 100) == URC_FAIL);
+   CuAssertTrue(tc, upInit (&win, TEST_SIZE, TEST_SIZE + 1) == URC_FAIL);
+   CuAssertTrue(tc, upInit (&win, TEST_SIZE, TEST_SIZE) == URC_SUCCESS);
+   CuAssertTrue(tc, upComplete (&win));
+}
+
+/*-------------------------------------------------------------------------*
+ * main
+ *-------------------------------------------------------------------------*/
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestUpCrc32);
+   SUITE_ADD_TEST(suite, TestUpInOrder);
+   SUITE_ADD_TEST(suite, TestUpGapsAndAck);
+   SUITE_ADD_TEST(suite, TestUpResume);
+   return suite;
+}
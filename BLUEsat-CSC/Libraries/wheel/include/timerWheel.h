@@ -0,0 +1,63 @@
+/*
+ * timerWheel.h
+ *
+ *  Created on: Jun 12, 2013
+ *
+ *  Hierarchical timer wheel over a fixed set of timer numbers. Each level
+ *  has TW_SLOTS slots, a slot on level n spans TW_SLOTS^n time units, and
+ *  a timer sits in the slot of the lowest level its expiry fits. Adding
+ *  and cancelling unlink from a slot list, advancing by one unit empties
+ *  one level 0 slot and, every TW_SLOTS units, moves one slot of the level
+ *  above down. Nothing is ever sorted or searched.
+ *
+ *  Expired timers go on a due list and are taken off it one at a time.
+ *  Timers due in the same unit come out in no particular order. The time
+ *  unit is up to the caller, times are absolute and must not wrap while
+ *  timers are queued.
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+#include "UniversalReturnCode.h"
+
+#define TW_SLOT_BITS       6
+#define TW_SLOTS           (1 << TW_SLOT_BITS)
+#define TW_LEVELS          4
+#define TW_MAX_TIMERS      128
+#define TW_NONE            0xFF
+// Further out than this a timer waits in the last level and is moved down
+// again when that slot comes round
+#define TW_RANGE           (1UL << (TW_SLOT_BITS * TW_LEVELS))
+
+typedef struct //timerWheel
+{
+   unsigned long  expires[TW_MAX_TIMERS];
+   unsigned char  next[TW_MAX_TIMERS];
+   unsigned char  prev[TW_MAX_TIMERS];
+   unsigned short list[TW_MAX_TIMERS];    // slot or due list the timer is on
+   unsigned char  head[TW_LEVELS * TW_SLOTS + 1];
+   unsigned long  now;                    // next unit to be processed
+   unsigned int   count;                  // timers queued, due ones included
+}timerWheel;
+
+// Everything idle, now is the first unit that will be processed
+void twInit (timerWheel * wheel, unsigned long now);
+
+// Fails for a bad timer number or one already queued. An expiry that has
+// already passed is due at the next advance.
+UnivRetCode twAdd (timerWheel * wheel, unsigned int timer, unsigned long expires);
+
+// Fails if the timer is not queued, due timers can be cancelled as well
+UnivRetCode twCancel (timerWheel * wheel, unsigned int timer);
+
+int twQueued (const timerWheel * wheel, unsigned int timer);
+
+// Processes every unit up to and including now, returns how many timers
+// came due. A jump of more than a wheel turn, or back in time, puts every
+// timer back in from scratch rather than stepping through the units.
+unsigned int twAdvance (timerWheel * wheel, unsigned long now);
+
+// Takes the next due timer off the due list, TW_NONE when there is none
+unsigned int twNextDue (timerWheel * wheel);
+
+#endif /* TIMERWHEEL_H_ */
@@ -0,0 +1,169 @@
+/*
+ * timerWheel.c
+ *
+ *  Created on: Jun 12, 2013
+ */
+#include "timerWheel.h"
+
+#ifndef NULL
+#define NULL ((void *)0)
+#endif
+
+#define TW_MASK        (TW_SLOTS - 1)
+#define TW_DUE_LIST    (TW_LEVELS * TW_SLOTS)
+#define TW_IDLE        0xFFFF
+#define TW_SPAN(level) (1UL << (TW_SLOT_BITS * (level)))
+
+static void twLink (timerWheel * wheel, unsigned int timer, unsigned int list);
+static void twUnlink (timerWheel * wheel, unsigned int timer);
+static void twPlace (timerWheel * wheel, unsigned int timer);
+static void twCascade (timerWheel * wheel, unsigned int list);
+static void twRebase (timerWheel * wheel, unsigned long now);
+static unsigned int twStep (timerWheel * wheel);
+
+void twInit (timerWheel * wheel, unsigned long now)
+{
+   unsigned int index;
+   if (wheel == NULL) return;
+   for (index = 0; index < TW_MAX_TIMERS; ++index) wheel->list[index] = TW_IDLE;
+   for (index = 0; index <= TW_DUE_LIST; ++index) wheel->head[index] = TW_NONE;
+   wheel->now   = now;
+   wheel->count = 0;
+}
+
+UnivRetCode twAdd (timerWheel * wheel, unsigned int timer, unsigned long expires)
+{
+   if (wheel == NULL || timer >= TW_MAX_TIMERS || wheel->list[timer] != TW_IDLE) return URC_FAIL;
+   wheel->expires[timer] = expires;
+   twPlace (wheel, timer);
+   wheel->count++;
+   return URC_SUCCESS;
+}
+
+UnivRetCode twCancel (timerWheel * wheel, unsigned int timer)
+{
+   if (!twQueued (wheel, timer)) return URC_FAIL;
+   twUnlink (wheel, timer);
+   wheel->count--;
+   return URC_SUCCESS;
+}
+
+int twQueued (const timerWheel * wheel, unsigned int timer)
+{
+   if (wheel == NULL || timer >= TW_MAX_TIMERS) return 0;
+   return wheel->list[timer] != TW_IDLE;
+}
+
+unsigned int twAdvance (timerWheel * wheel, unsigned long now)
+{
+   unsigned int due = 0;
+   if (wheel == NULL) return 0;
+   if (now < wheel->now)
+   {
+      // still inside the unit processed last
+      if (now + 1 == wheel->now) return 0;
+      twRebase (wheel, now);
+   }
+   else if (now - wheel->now >= TW_SLOTS)
+   {
+      twRebase (wheel, now);
+   }
+   while (wheel->now <= now) due += twStep (wheel);
+   return due;
+}
+
+unsigned int twNextDue (timerWheel * wheel)
+{
+   unsigned int timer;
+   if (wheel == NULL) return TW_NONE;
+   timer = wheel->head[TW_DUE_LIST];
+   if (timer == TW_NONE) return TW_NONE;
+   twUnlink (wheel, timer);
+   wheel->count--;
+   return timer;
+}
+
+static void twLink (timerWheel * wheel, unsigned int timer, unsigned int list)
+{
+   unsigned int first = wheel->head[list];
+   wheel->next[timer] = first;
+   wheel->prev[timer] = TW_NONE;
+   if (first != TW_NONE) wheel->prev[first] = timer;
+   wheel->head[list]  = timer;
+   wheel->list[timer] = list;
+}
+
+static void twUnlink (timerWheel * wheel, unsigned int timer)
+{
+   unsigned int next = wheel->next[timer];
+   unsigned int prev = wheel->prev[timer];
+   if (prev != TW_NONE) wheel->next[prev] = next;
+   else                 wheel->head[wheel->list[timer]] = next;
+   if (next != TW_NONE) wheel->prev[next] = prev;
+   wheel->list[timer] = TW_IDLE;
+}
+
+// Lowest level whose span covers the wait, the slot is picked by the
+// expiry itself so it stays put as now moves on
+static void twPlace (timerWheel * wheel, unsigned int timer)
+{
+   unsigned long expires = wheel->expires[timer];
+   unsigned int level;
+   if (expires < wheel->now) expires = wheel->now;
+   if (expires - wheel->now >= TW_RANGE) expires = wheel->now + TW_RANGE - 1;
+   for (level = 0; level < TW_LEVELS - 1 && expires - wheel->now >= TW_SPAN(level + 1); ++level);
+   twLink (wheel, timer, level * TW_SLOTS + ((expires >> (TW_SLOT_BITS * level)) & TW_MASK));
+}
+
+// Everything in the slot is within one span of the level below now
+static void twCascade (timerWheel * wheel, unsigned int list)
+{
+   unsigned int timer;
+   while ((timer = wheel->head[list]) != TW_NONE)
+   {
+      twUnlink (wheel, timer);
+      twPlace (wheel, timer);
+   }
+}
+
+static void twRebase (timerWheel * wheel, unsigned long now)
+{
+   unsigned int list, timer;
+   unsigned int chain = TW_NONE;
+   for (list = 0; list < TW_DUE_LIST; ++list)
+   {
+      while ((timer = wheel->head[list]) != TW_NONE)
+      {
+         twUnlink (wheel, timer);
+         wheel->next[timer] = chain;
+         chain = timer;
+      }
+   }
+   wheel->now = now;
+   while (chain != TW_NONE)
+   {
+      timer = chain;
+      chain = wheel->next[timer];
+      twPlace (wheel, timer);
+   }
+}
+
+static unsigned int twStep (timerWheel * wheel)
+{
+   unsigned long now = wheel->now;
+   unsigned int level, timer;
+   unsigned int due = 0;
+   // each level moves down a slot once the level below has gone round
+   for (level = 1; level < TW_LEVELS && ((now >> (TW_SLOT_BITS * (level - 1))) & TW_MASK) == 0; ++level)
+   {
+      twCascade (wheel, level * TW_SLOTS + ((now >> (TW_SLOT_BITS * level)) & TW_MASK));
+   }
+   while ((timer = wheel->head[now & TW_MASK]) != TW_NONE)
+   {
+      twUnlink (wheel, timer);
+      twLink (wheel, timer, TW_DUE_LIST);
+      due++;
+   }
+   wheel->now = now + 1;
+   return due;
+}
@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CuTest.h"
+#include "timerWheel.h"
+
+static timerWheel wheel;
+
+// Steps one unit at a time and checks each timer comes due in its own unit
+static void runUntil (CuTest* tc, unsigned long until, const unsigned long * expires, unsigned int count)
+{
+   unsigned long now;
+   unsigned int timer;
+   for (now = wheel.now; now <= until; ++now)
+   {
+      twAdvance (&wheel, now);
+      while ((timer = twNextDue (&wheel)) != TW_NONE)
+      {
+         CuAssertTrue(tc, timer < count);
+         CuAssertTrue(tc, expires[timer] == now);
+      }
+   }
+}
+
+void TestTwEveryLevel(CuTest* tc)
+{
+   static const unsigned long expires[] = { 1005, 1063, 1064, 1700, 1000 + 4096, 1000 + 70000, 1000 + 300000 };
+   unsigned int timer, count = sizeof(expires) / sizeof(expires[0]);
+   twInit (&wheel, 1000);
+   for (timer = 0; timer < count; ++timer)
+   {
+      CuAssertTrue(tc, twAdd (&wheel, timer, expires[timer]) == URC_SUCCESS);
+   }
+   CuAssertTrue(tc, wheel.count == count);
+   // queued once only
+   CuAssertTrue(tc, twAdd (&wheel, 0, 2000) == URC_FAIL);
+   CuAssertTrue(tc, twAdd (&wheel, TW_MAX_TIMERS, 2000) == URC_FAIL);
+   runUntil (tc, 1000 + 300000, expires, count);
+   CuAssertTrue(tc, wheel.count == 0);
+}
+
+void TestTwCancel(CuTest* tc)
+{
+   static const unsigned long expires[] = { 50, 5000, 50 };
+   twInit (&wheel, 0);
+   twAdd (&wheel, 0, expires[0]);
+   twAdd (&wheel, 1, expires[1]);
+   twAdd (&wheel, 2, expires[2]);
+   CuAssertTrue(tc, twCancel (&wheel, 1) == URC_SUCCESS);
+   CuAssertTrue(tc, twCancel (&wheel, 1) == URC_FAIL);
+   CuAssertTrue(tc, !twQueued (&wheel, 1));
+   CuAssertTrue(tc, twAdvance (&wheel, 50) == 2);
+   // a due timer can still be called off
+   CuAssertTrue(tc, twCancel (&wheel, 2) == URC_SUCCESS);
+   CuAssertTrue(tc, twNextDue (&wheel) == 0);
+   CuAssertTrue(tc, twNextDue (&wheel) == TW_NONE);
+   CuAssertTrue(tc, twAdvance (&wheel, 6000) == 0);
+   // and the number is free again
+   CuAssertTrue(tc, twAdd (&wheel, 1, 6001) == URC_SUCCESS);
+   CuAssertTrue(tc, twAdvance (&wheel, 6001) == 1);
+}
+
+void TestTwPastAndJumps(CuTest* tc)
+{
+   twInit (&wheel, 100);
+   // already past, due on the next advance
+   twAdd (&wheel, 0, 10);
+   CuAssertTrue(tc, twAdvance (&wheel, 100) == 1);
+   CuAssertTrue(tc, twNextDue (&wheel) == 0);
+   // the clock set from the ground, far ahead then back again
+   twAdd (&wheel, 1, 500000);
+   twAdd (&wheel, 2, 400000000UL);
+   twAdd (&wheel, 3, 450000000UL);
+   CuAssertTrue(tc, twAdvance (&wheel, 400000000UL) == 2);
+   twNextDue (&wheel);
+   twNextDue (&wheel);
+   CuAssertTrue(tc, twAdvance (&wheel, 300000000UL) == 0);
+   CuAssertTrue(tc, twAdvance (&wheel, 449999999UL) == 0);
+   CuAssertTrue(tc, twAdvance (&wheel, 450000000UL) == 1);
+   CuAssertTrue(tc, twNextDue (&wheel) == 3);
+   // inside the unit just processed nothing happens
+   CuAssertTrue(tc, twAdvance (&wheel, 450000000UL) == 0);
+}
+
+void TestTwBeyondRange(CuTest* tc)
+{
+   unsigned long expires[2];
+   twInit (&wheel, 100);
+   expires[0] = TW_RANGE + 5000;
+   expires[1] = 2 * TW_RANGE + 7;
+   twAdd (&wheel, 0, expires[0]);
+   twAdd (&wheel, 1, expires[1]);
+   // a unit at a time across the last level wrapping, jumps would rebase
+   runUntil (tc, TW_RANGE + 6000, expires, 2);
+   CuAssertTrue(tc, wheel.count == 1);
+   twAdvance (&wheel, 2 * TW_RANGE);
+   CuAssertTrue(tc, twAdvance (&wheel, 2 * TW_RANGE + 7) == 1);
+   CuAssertTrue(tc, twNextDue (&wheel) == 1);
+}
+
+void TestTwFull(CuTest* tc)
+{
+   unsigned long expires[TW_MAX_TIMERS];
+   unsigned int timer;
+   srand (7);
+   twInit (&wheel, 20000);
+   for (timer = 0; timer < TW_MAX_TIMERS; ++timer)
+   {
+      expires[timer] = 20000 + rand () % 10000;
+      CuAssertTrue(tc, twAdd (&wheel, timer, expires[timer]) == URC_SUCCESS);
+   }
+   runUntil (tc, 30000, expires, TW_MAX_TIMERS);
+   CuAssertTrue(tc, wheel.count == 0);
+}
+
+CuSuite* CuGetSuite(void)
+{
+   CuSuite* suite = CuSuiteNew();
+   SUITE_ADD_TEST(suite, TestTwEveryLevel);
+   SUITE_ADD_TEST(suite, TestTwCancel);
+   SUITE_ADD_TEST(suite, TestTwPastAndJumps);
+   SUITE_ADD_TEST(suite, TestTwBeyondRange);
+   SUITE_ADD_TEST(suite, TestTwFull);
+   return suite;
+}
@@ -40,6 +40,21 @@ typedef enum
 	TASK_MODEM_DEMO,
 	TASK_TELEM_DEMO,
 	TASK_PROTOCOLS,
+	TASK_MAILBOX,
+	TASK_UPLINK,
+	TASK_UPLOAD,
+	TASK_FWUPDATE,
+	TASK_MODULES,
+	TASK_MODULE_0,		//one per loadable module slot
+	TASK_MODULE_1,
+	TASK_MODULE_2,
+	TASK_MODULE_3,
+	TASK_PLANNER,
+	TASK_SCHEDULE,
+	TASK_STRING_BENCH_DEMO,
+	TASK_IPC_BENCH_DEMO,
+	TASK_IPC_ECHO_DEMO,
+	TASK_UPLINK_CONSOLE,
 	/** Task ID end **/
 	NUM_TASKID,		/* <--- task ID list size */
 	/* Virtual task IDs */
@@ -64,11 +79,15 @@ typedef enum
 		TASK_TYPE				enTaskType;
 		TaskID					enTaskID;
 		UnivRetCode				enRetVal;
+		volatile portCHAR		cDone;		//set once the request replied to here completes
 	};
 #endif
 
 typedef struct taskToken *TaskToken;
 
+//a request in flight, its result is kept apart from the task token
+typedef struct taskToken *RequestHandle;
+
 //general message packet format for IPC
 typedef struct
 {
@@ -80,6 +99,71 @@ typedef struct
 
 #define NO_BLOCK			0
 
+//1 posts requests straight into the destination queue, 0 sends every
+//request through the command task to be forwarded
+#ifndef CMD_DIRECT_ROUTING
+	#define CMD_DIRECT_ROUTING	1
+#endif
+
+//asynchronous requests in flight across all tasks
+#define CMD_ASYNC_SLOTS		16
+
+//request lanes of a task queue, urgent requests are taken first
+typedef enum
+{
+	CMD_LANE_NORMAL,
+	CMD_LANE_URGENT,
+	CMD_NUM_LANES
+} CmdLane;
+
+//a normal request queued this long is taken ahead of urgent ones
+#define CMD_LANE_AGE_LIMIT	(50 / portTICK_RATE_MS)
+
+//queueing delay seen by one lane of a task, in ticks
+typedef struct
+{
+	unsigned portLONG	ulTaken;		//requests taken off the lane
+	unsigned portLONG	ulTotalWait;
+	unsigned portLONG	ulMaxWait;
+	unsigned portLONG	ulAged;			//taken ahead of waiting urgent requests
+} LaneStats;
+
+//who put an event on the command task's event ring
+typedef enum
+{
+	CMD_EVT_DTMF,		//tone pair from the DTMF decoders, first tone in the high nibble
+	CMD_EVT_UPLINK,		//the same code sent as a binary uplink command
+	CMD_NUM_EVT
+} CmdEventSource;
+
+//one event, a word so it is cheap to copy in and out of an interrupt
+typedef struct
+{
+	unsigned portCHAR	ucSource;
+	unsigned portCHAR	ucSpare;
+	unsigned portSHORT	usData;
+} CmdEvent;
+
+//room for 16 events, a power of two, and how many the command task takes at once
+#define CMD_EVT_RING_SIZE		(16 * sizeof(CmdEvent))
+#define CMD_EVT_BATCH			4
+
+typedef struct
+{
+	unsigned portLONG	ulPosted;
+	unsigned portLONG	ulDropped;		//ring was full
+	unsigned portLONG	ulBatches;		//drains that found something
+	unsigned portLONG	ulMaxBatch;
+} CmdEventStats;
+
+//pooled message payloads, size classes in bytes and blocks in each
+#define CMD_POOL_SMALL_SIZE		32
+#define CMD_POOL_SMALL_COUNT	16
+#define CMD_POOL_MEDIUM_SIZE	128
+#define CMD_POOL_MEDIUM_COUNT	8
+#define CMD_POOL_LARGE_SIZE		512
+#define CMD_POOL_LARGE_COUNT	2
+
 /**
  * \brief Initialise command service
  *
@@ -87,8 +171,6 @@ typedef struct
  */
 void vCommand_Init(unsigned portBASE_TYPE uxPriority);
 
-UnivRetCode dtmfRequest (MessagePacket *pMessagePacket);
-
 
 /**
  * \brief Attempt to process request & put request task to sleep
@@ -96,6 +178,10 @@ UnivRetCode dtmfRequest (MessagePacket *pMessagePacket);
  * \param[in] pMessagePacket Pointer to message packet to be processed.
  *
  * \param[in] block_time Time to wait when inserting into command service queue (ms).
+ *			Requests for other tasks go straight into the destination queue
+ *			under CMD_DIRECT_ROUTING and return BUSY at once if it is full,
+ *			the same answer the command task gives when forwarding.
+ *			The request goes on the lane set for the sender by vSetRequestLane.
  *			
  * \returns enum Containing the processed result
  */
@@ -103,6 +189,149 @@ UnivRetCode dtmfRequest (MessagePacket *pMessagePacket);
 
 UnivRetCode enProcessRequest (MessagePacket *pMessagePacket, portTickType block_time);
 
+/**
+ * \brief As enProcessRequest, on a chosen lane of the destination queue.
+ * Urgent requests to a task without an urgent lane join the normal lane.
+ *
+ * \param[in] pMessagePacket Pointer to message packet to be processed.
+ *
+ * \param[in] block_time Time to wait when inserting into command service queue.
+ *
+ * \param[in] enLane Lane to queue on.
+ *
+ * \returns enum Containing the processed result
+ */
+UnivRetCode enProcessRequestLane (MessagePacket *pMessagePacket, portTickType block_time, CmdLane enLane);
+
+/**
+ * \brief Submit a request without waiting for it to complete. The tag along
+ * data must stay valid until the request completes.
+ *
+ * \param[in] pMessagePacket Pointer to message packet, Token is the task
+ *			that will wait on or poll the handle.
+ *
+ * \param[in] block_time Time to wait when inserting into command service queue.
+ *
+ * \param[out] pxHandle Handle for the request in flight.
+ *
+ * \returns SUCCESS once queued, BUSY when every handle is in use or the
+ *			destination queue is full, or an invalid task code
+ */
+UnivRetCode enSubmitRequest (MessagePacket *pMessagePacket, portTickType block_time, RequestHandle *pxHandle);
+
+/**
+ * \brief Poll a request in flight
+ *
+ * \param[in] xHandle Handle from enSubmitRequest.
+ *
+ * \returns pdTRUE once it has completed
+ */
+portBASE_TYPE xRequestDone (RequestHandle xHandle);
+
+/**
+ * \brief Sleep until one of several requests completes. Only the task that
+ * submitted the requests may wait on them.
+ *
+ * \param[in] pxHandles Handles from enSubmitRequest, NULL entries are skipped.
+ *
+ * \param[in] usCount Number of handles.
+ *
+ * \param[in] block_time Longest time to wait.
+ *
+ * \returns Index of a completed handle, or -1 on timeout
+ */
+portBASE_TYPE xWaitAnyRequest (RequestHandle *pxHandles, unsigned portSHORT usCount, portTickType block_time);
+
+/**
+ * \brief Sleep until a request completes, then give its handle back
+ *
+ * \param[in] xHandle Handle from enSubmitRequest, not usable afterwards.
+ *
+ * \returns Processed result of the request
+ */
+UnivRetCode enWaitRequest (RequestHandle xHandle);
+
+/**
+ * \brief Take a payload buffer from the message pool. Whoever holds the
+ * buffer owns it, sending it with enSendMessage hands it to the receiver.
+ *
+ * \param[in] usSize Bytes needed, the smallest class with a free block is used.
+ *
+ * \returns Word aligned buffer, or NULL when nothing big enough is free
+ */
+void *pvMessageAlloc (unsigned portSHORT usSize);
+
+/**
+ * \brief Give a payload buffer back to the message pool
+ *
+ * \param[in] pvPayload Buffer from pvMessageAlloc, ignored if not pooled.
+ */
+void vMessageFree (void *pvPayload);
+
+/**
+ * \brief Tell pooled payloads apart from the stack data of a request
+ *
+ * \param[in] pvPayload Data of a received message packet.
+ *
+ * \returns pdTRUE when it came from pvMessageAlloc
+ */
+portBASE_TYPE xMessageIsPooled (const void *pvPayload);
+
+/**
+ * \brief Send a pooled payload without waiting for the receiver. Nothing is
+ * replied, the receiver frees the payload or sends it on.
+ *
+ * \param[in] pMessagePacket Pointer to message packet, Data is the pooled
+ *			payload and Token is not used.
+ *
+ * \param[in] block_time Time to wait when inserting into command service queue.
+ *
+ * \returns SUCCESS once the payload is handed over. On anything else the
+ *			sender still owns it.
+ */
+UnivRetCode enSendMessage (MessagePacket *pMessagePacket, portTickType block_time);
+
+/**
+ * \brief Post a notification straight into a task queue from an interrupt
+ *
+ * \param[in] pMessagePacket Pointer to message packet, Token should be NULL
+ *			as there is no request task to wake.
+ *
+ * \param[out] pxHigherPriorityTaskWoken Set to pdTRUE if a yield is required.
+ *
+ * \returns SUCCESS, BUSY when the queue is full or an invalid task code
+ */
+UnivRetCode enPostRequestFromISR (MessagePacket *pMessagePacket, signed portBASE_TYPE *pxHigherPriorityTaskWoken);
+
+/**
+ * \brief Hand an event to the command task from an interrupt. The record
+ * goes on a lock free ring and the command task is woken to drain it, so
+ * a burst is only lost once the ring itself is full.
+ *
+ * \param[in] enSource Who the event is from.
+ *
+ * \param[in] usData Event code, for DTMF sources the tone pair.
+ *
+ * \param[out] pxHigherPriorityTaskWoken Set to pdTRUE if a yield is required.
+ *
+ * \returns SUCCESS, BUSY when the ring is full or NO_QUEUE before the
+ *			command task is up
+ */
+UnivRetCode enPostEventFromISR (CmdEventSource enSource, unsigned portSHORT usData, signed portBASE_TYPE *pxHigherPriorityTaskWoken);
+
+/**
+ * \brief Same as enPostEventFromISR for tasks, interrupts are held off
+ * while the record is written so they can keep posting without a lock.
+ */
+UnivRetCode enPostEvent (CmdEventSource enSource, unsigned portSHORT usData);
+
+/**
+ * \brief Copy out the event ring counters
+ *
+ * \param[out] pxStats Destination for the snapshot
+ */
+void vGetEventStats(CmdEventStats *pxStats);
+
 /**
  * \brief Attempt to retrieve requestion from queue
  *
@@ -142,7 +371,9 @@ void vCompleteRequest(TaskToken taskToken, UnivRetCode enRetVal);
  *
  * \param[in] pvTaskFunction Task function.
  *			
- * \returns Task token for accessing services and applications
+ * \returns Task token for accessing services and applications, NULL if the
+ * task or its semaphore did not fit the heap. The command task prints the
+ * name of every task that failed once the scheduler starts.
  */
 
 TaskToken ActivateTask(TaskID 		enTaskID,
@@ -163,6 +394,40 @@ TaskToken ActivateTask(TaskID 		enTaskID,
  */
 unsigned portSHORT vActivateQueue(TaskToken taskToken, unsigned portSHORT usNumElement);
 
+/**
+ * \brief Give a task an urgent lane beside its queue. Costs a second queue
+ * and a semaphore from the heap, so only tasks that take urgent requests
+ * ask for one.
+ *
+ * \param[in] taskToken Task token of a task, its queue already activated.
+ *
+ * \param[in] usNumElement Number of urgent requests held
+ *
+ * \returns Size of lane been created
+ */
+unsigned portSHORT vActivateUrgentLane(TaskToken taskToken, unsigned portSHORT usNumElement);
+
+/**
+ * \brief Copy out the queueing delay counters of a lane
+ *
+ * \param[in] enTask Task whose queue the lane belongs to.
+ *
+ * \param[in] enLane Lane wanted.
+ *
+ * \param[out] pxStats Destination for the counters.
+ */
+void vGetLaneStats(TaskID enTask, CmdLane enLane, LaneStats *pxStats);
+
+/**
+ * \brief Put every request from a task on a lane, for tasks acting on
+ * ground commands. enProcessRequestLane still picks its own lane.
+ *
+ * \param[in] taskToken Task token of the sending task.
+ *
+ * \param[in] enLane Lane its requests go on from now.
+ */
+void vSetRequestLane(TaskToken taskToken, CmdLane enLane);
+
 /**
  * \brief Return Task token owner's task name
  *
@@ -206,4 +471,13 @@ void vSleep(unsigned portSHORT usTimeMS);
 	#define vShowAllTaskUnusedStack()
 #endif
 
+#ifndef NO_DEBUG
+	/**
+	 * \brief Print the longest hold and wait of every lock
+	 */
+	void vShowAllLockStats(void);
+#else
+	#define vShowAllLockStats()
+#endif
+
 #endif /* COMMAND_H_ */
@@ -19,9 +19,19 @@
 #include "command.h"
 #include "i2c.h"
 #include "semphr.h"
+#include "lock.h"
 #include "switching.h"
+#include "protocols.h"
+#include "commsControl.h"
+#include "prbs.h"
+#include "DTMF_Common.h"
+#include "blockPool.h"
+#include "events.h"
+#include "ring.h"
+#include "debug.h"
 
 #define CMD_Q_SIZE			1
+#define CMD_URGENT_Q_SIZE	2
 #define CMD_PUSH_BLK_TIME	0
 
 #define MAX_QUEUE_REQ_SIZE	10
@@ -36,11 +46,53 @@
 #define TX_2	8
 #define RESET   9
 
+//tone A, B or C picks the downlink class, the digit after it is the share of
+//that class lost last pass in tenths with 0 sent as Tone_0
+#define LOSS_REPORT_FIRST	(Tone_A << 4)
+#define LOSS_REPORT_LAST	(((Tone_A + RED_NUM_CLASSES) << 4) - 1)
+
+//* then a digit runs PRBS9, # then a digit PRBS15, for ten seconds a digit
+//with 0 counting as ten
+#define BERT_SECONDS_PER_DIGIT	10
+
+
+//what task queues carry, the request and when and how it was sent
+typedef struct
+{
+	MessagePacket		xPacket;
+	portTickType		xQueued;
+	unsigned portCHAR	ucLane;
+} QueuedPacket;
 
 static xQueueHandle 	xTaskQueueHandles	[NUM_TASKID];
+static xQueueHandle 	xTaskUrgentLanes	[NUM_TASKID];
+static xSemaphoreHandle	TaskDoorbells		[NUM_TASKID];	//given for every request on a task with lanes
+static LaneStats		LaneStatistics		[NUM_TASKID][CMD_NUM_LANES];
+static unsigned portCHAR RequestLanes		[NUM_TASKID];	//lane the requests of each task go on
 static struct taskToken TaskTokens			[NUM_TASKID];
 static xSemaphoreHandle	TaskSemphrs			[NUM_TASKID];
 static xTaskHandle 		TaskHandles			[NUM_TASKID];
+static portCHAR			*FailedTasks		[NUM_TASKID];	//names of tasks ActivateTask could not create
+
+//reply slots for asynchronous requests, a copy of the submitter's token each
+static struct taskToken AsyncSlots			[CMD_ASYNC_SLOTS];
+static unsigned portCHAR AsyncSlotUsed		[CMD_ASYNC_SLOTS];
+
+#define CMD_POOL_CLASSES	3
+#define CMD_POOL_WORDS(size, count)	((BP_BLOCK_SIZE(size) * (count)) / sizeof(unsigned long))
+
+//message payload pools, smallest class first
+static unsigned long	PoolSmall	[CMD_POOL_WORDS(CMD_POOL_SMALL_SIZE, CMD_POOL_SMALL_COUNT)];
+static unsigned long	PoolMedium	[CMD_POOL_WORDS(CMD_POOL_MEDIUM_SIZE, CMD_POOL_MEDIUM_COUNT)];
+static unsigned long	PoolLarge	[CMD_POOL_WORDS(CMD_POOL_LARGE_SIZE, CMD_POOL_LARGE_COUNT)];
+static blockPool		MessagePools[CMD_POOL_CLASSES];
+
+//events from interrupts, every interrupt is a producer but they do not nest
+//on this port and tasks post with interrupts held off, so there is only
+//ever one producer at a time and the ring needs no lock
+static unsigned long	EventStorage[CMD_EVT_RING_SIZE / sizeof(unsigned long)];
+static ringBuffer		xEventRing;
+static CmdEventStats	EventStatistics;
 
 #define INIT_SEMAPHORE_BLOCK_TIME      (portTICK_RATE_MS * 5)
 #define SLAVE_ADDRESS_PREFIX 32
@@ -48,12 +100,17 @@ static xTaskHandle 		TaskHandles			[NUM_TASKID];
 static xSemaphoreHandle initMutex = NULL;
 
 static portTASK_FUNCTION(vCommandTask, pvParameters);
+static UnivRetCode enRouteCheck(TaskID enDest);
+static UnivRetCode enPostRequest(MessagePacket *pMessagePacket, portTickType block_time, CmdLane enLane);
+static CmdLane enSenderLane(TaskID enSrc);
+static portBASE_TYPE xLaneSend(TaskID enTask, QueuedPacket *pxItem, portTickType block_time);
+static portBASE_TYPE xLaneSendFromISR(TaskID enTask, QueuedPacket *pxItem, signed portBASE_TYPE *pxHigherPriorityTaskWoken);
+static portBASE_TYPE xLaneReceive(TaskID enTask, QueuedPacket *pxItem, portTickType block_time);
+static unsigned portSHORT usDrainEvents(void);
+static void vCommandCode(unsigned portSHORT usCode);
 static void setupPortExpander (unsigned int bus);
 static void reset (unsigned int bus);
 
-extern int transmitTele;
-extern int transmitBeacon;
-
 void vCommand_Init(unsigned portBASE_TYPE uxPriority)
 {
 	unsigned portSHORT usIndex;
@@ -62,10 +119,25 @@ void vCommand_Init(unsigned portBASE_TYPE uxPriority)
 	for (usIndex = 0; usIndex < NUM_TASKID; usIndex++)
 	{
 		xTaskQueueHandles[usIndex]		= NULL;
+		xTaskUrgentLanes[usIndex]		= NULL;
+		TaskDoorbells[usIndex]			= NULL;
 		TaskTokens[usIndex].pcTaskName	= NULL;
 		TaskTokens[usIndex].enRetVal	= 0;
+		FailedTasks[usIndex]			= NULL;
+		RequestLanes[usIndex]			= CMD_LANE_NORMAL;
 	}
 
+	for (usIndex = 0; usIndex < CMD_ASYNC_SLOTS; usIndex++)
+	{
+		AsyncSlotUsed[usIndex] = 0;
+	}
+
+	bpInit(&MessagePools[0], PoolSmall, CMD_POOL_SMALL_SIZE, CMD_POOL_SMALL_COUNT);
+	bpInit(&MessagePools[1], PoolMedium, CMD_POOL_MEDIUM_SIZE, CMD_POOL_MEDIUM_COUNT);
+	bpInit(&MessagePools[2], PoolLarge, CMD_POOL_LARGE_SIZE, CMD_POOL_LARGE_COUNT);
+
+	ringInit(&xEventRing, (unsigned char *)EventStorage, CMD_EVT_RING_SIZE);
+
 	ActivateTask(TASK_COMMAND, 
 				 "Command",
 				 SEV_TASK_TYPE,
@@ -74,6 +146,8 @@ void vCommand_Init(unsigned portBASE_TYPE uxPriority)
 				 vCommandTask);
 
 	vActivateQueue(&TaskTokens[TASK_COMMAND], CMD_Q_SIZE);
+	//the doorbell of the lanes also wakes us for events on the ring
+	vActivateUrgentLane(&TaskTokens[TASK_COMMAND], CMD_URGENT_Q_SIZE);
 	vSemaphoreCreateBinary(initMutex);
 
 }
@@ -82,84 +156,55 @@ static portTASK_FUNCTION(vCommandTask, pvParameters)
 {
 	(void) pvParameters;
 	signed portBASE_TYPE xResult;
+	UnivRetCode enRoute;
+	QueuedPacket xItem;
 	MessagePacket incoming_packet;
+	unsigned portSHORT usEvents;
+	unsigned portSHORT usIndex;
 
 	setupPortExpander(BUS0);
+
+	//tasks that did not fit the heap at boot, every other task is up by now
+	for (usIndex = 0; usIndex < NUM_TASKID; usIndex++)
+	{
+		if (FailedTasks[usIndex] == NULL) continue;
+		vDebugPrint(&TaskTokens[TASK_COMMAND], "Task %s not started, %d bytes of heap left\n\r",
+					(unsigned portLONG)FailedTasks[usIndex], xPortGetFreeHeapSize(), NO_INSERT);
+	}
+
 	for ( ; ; )
 	{
-		xResult = xQueueReceive(xTaskQueueHandles[TASK_COMMAND], &incoming_packet, portMAX_DELAY);
-		if (xResult != pdTRUE) continue;
+		//a batch of events ahead of every request, the ring is woken on the
+		//same doorbell so anything posted after this look wakes us again
+		usEvents = usDrainEvents();
+
+		xResult = xLaneReceive(TASK_COMMAND, &xItem, NO_BLOCK);
+		if (xResult != pdTRUE)
+		{
+			if (usEvents == 0) xSemaphoreTake(TaskDoorbells[TASK_COMMAND], portMAX_DELAY);
+			continue;
+		}
+		incoming_packet = xItem.xPacket;
 
 		if (incoming_packet.Dest == TASK_COMMAND)
 		{
 			//TODO msg for command task
-            if (incoming_packet.Src == TASK_COMMAND)
-            {
-            	switch (incoming_packet.Data){
-					case TELE_MODE:
-						switching_OPMODE(DEVICE_MODE);
-						transmitTele = 1;
-						transmitBeacon = 1;
-						break;
-					case REPEATER_MODE:
-						transmitTele = 0;
-						transmitBeacon = 0;
-						break;
-					case LOOPBACK_MODE:
-						switching_OPMODE(REPEATER_MODE);
-						transmitTele = 0;
-						transmitBeacon = 0;
-						break;
-					case COMMAND_MODE:
-						switching_OPMODE(DEVICE_MODE);
-						transmitTele = 0;
-						transmitBeacon = 1;
-						break;
-					case RX_1:
-						switching_RX(RX_1);
-						break;
-					case RX_2:
-						switching_RX(RX_2);
-						break;
-					case TX_1:
-						switching_TX(TX_1);
-						break;
-					case TX_2:
-						switching_TX(TX_2);
-						break;
-					case RESET:
-						reset(BUS0);
-						break;
-            	}
-                // It was a message from the DTMF interrupt handler! :3
-            }
 		}
 		else
 		{
 			//TODO log error for exceptions
 			/***** exception check *****/
-			if (incoming_packet.Dest >= NUM_TASKID)
-			{
-				//return invalid task
-				vCompleteRequest(incoming_packet.Token, URC_CMD_INVALID_TASK);
-				continue;
-			}
-			else if (TaskTokens[incoming_packet.Dest].pcTaskName == NULL)
-			{
-				//return no task
-				vCompleteRequest(incoming_packet.Token, URC_CMD_NO_TASK);
-				continue;
-			}
-			else if (xTaskQueueHandles[incoming_packet.Dest] == NULL)
+			enRoute = enRouteCheck(incoming_packet.Dest);
+			if (enRoute != URC_SUCCESS)
 			{
-				//return no queue
-				vCompleteRequest(incoming_packet.Token, URC_CMD_NO_QUEUE);
+				//return invalid task, no task or no queue
+				vCompleteRequest(incoming_packet.Token, enRoute);
 				continue;
 			}
 			/***************************/
 
-			// forward msg to destination task Q
-			xResult = xQueueSend(xTaskQueueHandles[incoming_packet.Dest], &incoming_packet, NO_BLOCK);
+			// forward msg to destination task Q, same lane and time queued
+			xResult = xLaneSend(incoming_packet.Dest, &xItem, NO_BLOCK);
 
 			if (xResult == pdTRUE) continue;
 
@@ -169,60 +214,512 @@ static portTASK_FUNCTION(vCommandTask, pvParameters)
 	}
 }
 
+//returns how many events were handled, at most one batch
+static unsigned portSHORT usDrainEvents(void)
+{
+	CmdEvent xBatch[CMD_EVT_BATCH];
+	unsigned portSHORT usCount;
+	unsigned portSHORT usIndex;
+
+	usCount = ringPop(&xEventRing, (unsigned char *)xBatch, sizeof(xBatch)) / sizeof(CmdEvent);
+	if (usCount == 0) return 0;
+
+	for (usIndex = 0; usIndex < usCount; usIndex++)
+	{
+		if (xBatch[usIndex].ucSource < CMD_NUM_EVT) vCommandCode(xBatch[usIndex].usData);
+	}
+
+	taskENTER_CRITICAL();
+	{
+		EventStatistics.ulBatches++;
+		if (usCount > EventStatistics.ulMaxBatch) EventStatistics.ulMaxBatch = usCount;
+	}
+	taskEXIT_CRITICAL();
+
+	return usCount;
+}
+
+//a tone pair from the ground, or the same code sent over the uplink
+static void vCommandCode(unsigned portSHORT usCode)
+{
+	unsigned portLONG ulCode = usCode;
+	EventMode xMode;
+	portBASE_TYPE xModeChanged = pdFALSE;
+
+	switch (ulCode){
+		case TELE_MODE:
+			switching_OPMODE(DEVICE_MODE);
+			xMode.ucTelemetry = 1;
+			xMode.ucBeacon = 1;
+			xModeChanged = pdTRUE;
+			break;
+		case REPEATER_MODE:
+			xMode.ucTelemetry = 0;
+			xMode.ucBeacon = 0;
+			xModeChanged = pdTRUE;
+			break;
+		case LOOPBACK_MODE:
+			switching_OPMODE(REPEATER_MODE);
+			xMode.ucTelemetry = 0;
+			xMode.ucBeacon = 0;
+			xModeChanged = pdTRUE;
+			break;
+		case COMMAND_MODE:
+			switching_OPMODE(DEVICE_MODE);
+			xMode.ucTelemetry = 0;
+			xMode.ucBeacon = 1;
+			xModeChanged = pdTRUE;
+			break;
+		case RX_1:
+			switching_RX(RX_1);
+			break;
+		case RX_2:
+			switching_RX(RX_2);
+			break;
+		case TX_1:
+			switching_TX(TX_1);
+			break;
+		case TX_2:
+			switching_TX(TX_2);
+			break;
+		case RESET:
+			reset(BUS0);
+			break;
+		default:
+			if (ulCode >= LOSS_REPORT_FIRST && ulCode <= LOSS_REPORT_LAST)
+			{
+				unsigned portCHAR ucTenths = ulCode & 0xF;
+				if (ucTenths == Tone_0) ucTenths = 0;
+				enProtoFeedback((ulCode >> 4) - Tone_A, 10, ucTenths);
+			}
+			else if ((ulCode >> 4) == Tone_STAR || (ulCode >> 4) == Tone_HASH)
+			{
+				unsigned portCHAR ucDigits = ulCode & 0xF;
+				if (ucDigits >= Tone_1 && ucDigits <= Tone_0)
+				{
+					vComms_RequestBert(((ulCode >> 4) == Tone_STAR) ? PRBS_9 : PRBS_15,
+										ucDigits * BERT_SECONDS_PER_DIGIT);
+				}
+			}
+			break;
+	}
+
+	enEventPublish(&TaskTokens[TASK_COMMAND], EVT_DTMF_COMMAND, &ulCode, sizeof(ulCode));
+	if (xModeChanged)
+	{
+		enEventPublish(&TaskTokens[TASK_COMMAND], EVT_MODE_CHANGE, &xMode, sizeof(xMode));
+	}
+}
+
+/*
+ * Task tokens and queue handles are only written while a task and its queue
+ * are being activated, so senders can read them as a routing table without
+ * going through the command task.
+ */
+static UnivRetCode enRouteCheck(TaskID enDest)
+{
+	if (enDest >= NUM_TASKID) return URC_CMD_INVALID_TASK;
+	if (TaskTokens[enDest].pcTaskName == NULL) return URC_CMD_NO_TASK;
+	if (xTaskQueueHandles[enDest] == NULL) return URC_CMD_NO_QUEUE;
+	return URC_SUCCESS;
+}
+
+//insert request into command task queue, or the destination queue
+static UnivRetCode enPostRequest(MessagePacket *pMessagePacket, portTickType block_time, CmdLane enLane)
+{
+	QueuedPacket xItem;
+	TaskID enTask = TASK_COMMAND;
+	portTickType xBlock = block_time;
+
+#if (CMD_DIRECT_ROUTING == 1)
+	//everything but messages for the command task skips the forwarding hop,
+	//a full destination queue is still reported as busy straight away
+	if (pMessagePacket->Dest != TASK_COMMAND)
+	{
+		UnivRetCode enResult = enRouteCheck(pMessagePacket->Dest);
+		if (enResult != URC_SUCCESS) return enResult;
+		enTask = pMessagePacket->Dest;
+		xBlock = NO_BLOCK;
+	}
+#endif
+
+	xItem.xPacket = *pMessagePacket;
+	xItem.xQueued = xTaskGetTickCount();
+	xItem.ucLane = enLane;
+
+	if (xLaneSend(enTask, &xItem, xBlock) == pdTRUE) return URC_SUCCESS;
+	return URC_BUSY;
+}
+
+/*
+ * Tasks with an urgent lane sleep on their doorbell rather than a queue, it
+ * is given once for every request put on either lane.
+ */
+static portBASE_TYPE xLaneSend(TaskID enTask, QueuedPacket *pxItem, portTickType block_time)
+{
+	xQueueHandle xQueue = xTaskQueueHandles[enTask];
+
+	if (pxItem->ucLane == CMD_LANE_URGENT && xTaskUrgentLanes[enTask] != NULL) xQueue = xTaskUrgentLanes[enTask];
+
+	if (xQueueSend(xQueue, pxItem, block_time) != pdTRUE) return pdFALSE;
+	if (TaskDoorbells[enTask] != NULL) xSemaphoreGive(TaskDoorbells[enTask]);
+	return pdTRUE;
+}
+
+static portBASE_TYPE xLaneSendFromISR(TaskID enTask, QueuedPacket *pxItem, signed portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+	xQueueHandle xQueue = xTaskQueueHandles[enTask];
+
+	if (pxItem->ucLane == CMD_LANE_URGENT && xTaskUrgentLanes[enTask] != NULL) xQueue = xTaskUrgentLanes[enTask];
+
+	if (xQueueSendFromISR(xQueue, pxItem, pxHigherPriorityTaskWoken) != pdTRUE) return pdFALSE;
+	if (TaskDoorbells[enTask] != NULL) xSemaphoreGiveFromISR(TaskDoorbells[enTask], pxHigherPriorityTaskWoken);
+	return pdTRUE;
+}
+
+/*
+ * Urgent first, unless the oldest normal request has waited past the age
+ * limit. Each task is the only reader of its lanes, so what is peeked is
+ * what gets received.
+ */
+static portBASE_TYPE xLaneReceive(TaskID enTask, QueuedPacket *pxItem, portTickType block_time)
+{
+	xQueueHandle xNormal = xTaskQueueHandles[enTask];
+	xQueueHandle xUrgent = xTaskUrgentLanes[enTask];
+	portTickType xStart = xTaskGetTickCount();
+	portTickType xWaited;
+	portTickType xWait = block_time;
+	portBASE_TYPE xResult = pdFALSE;
+	portBASE_TYPE xAged = pdFALSE;
+	LaneStats *pxStats;
+
+	if (xUrgent == NULL)
+	{
+		xResult = xQueueReceive(xNormal, pxItem, block_time);
+	}
+	else
+	{
+		for ( ; ; )
+		{
+			if (xQueuePeek(xNormal, pxItem, NO_BLOCK) == pdTRUE
+				&& (xTaskGetTickCount() - pxItem->xQueued) >= CMD_LANE_AGE_LIMIT
+				&& uxQueueMessagesWaiting(xUrgent) > 0)
+			{
+				xAged = pdTRUE;
+				xResult = xQueueReceive(xNormal, pxItem, NO_BLOCK);
+			}
+			else
+			{
+				xResult = xQueueReceive(xUrgent, pxItem, NO_BLOCK);
+				if (xResult != pdTRUE) xResult = xQueueReceive(xNormal, pxItem, NO_BLOCK);
+			}
+			if (xResult == pdTRUE) break;
+
+			if (block_time != portMAX_DELAY)
+			{
+				xWaited = xTaskGetTickCount() - xStart;
+				if (xWaited >= block_time) break;
+				xWait = block_time - xWaited;
+			}
+			xSemaphoreTake(TaskDoorbells[enTask], xWait);
+		}
+	}
+
+	if (xResult != pdTRUE) return pdFALSE;
+
+	//forwarded requests keep their lane, a task without lanes takes them all as normal
+	pxStats = &LaneStatistics[enTask][(pxItem->ucLane < CMD_NUM_LANES) ? pxItem->ucLane : CMD_LANE_NORMAL];
+	xWaited = xTaskGetTickCount() - pxItem->xQueued;
+	taskENTER_CRITICAL();
+	{
+		pxStats->ulTaken++;
+		pxStats->ulTotalWait += xWaited;
+		if (xWaited > pxStats->ulMaxWait) pxStats->ulMaxWait = xWaited;
+		if (xAged) pxStats->ulAged++;
+	}
+	taskEXIT_CRITICAL();
+
+	return pdTRUE;
+}
+
 //TODO (1)review whether application specified block time be allowed while waiting for committed request
 UnivRetCode enProcessRequest (MessagePacket *pMessagePacket, portTickType block_time)
 {
+	//catch NO message packet input input
+	if (pMessagePacket == NULL || pMessagePacket->Token == NULL) return URC_FAIL;
+
+	return enProcessRequestLane(pMessagePacket, block_time, enSenderLane(pMessagePacket->Token->enTaskID));
+}
+
+UnivRetCode enProcessRequestLane (MessagePacket *pMessagePacket, portTickType block_time, CmdLane enLane)
+{
+	MessagePacket xPacket;
+	struct taskToken xReply;
+	UnivRetCode enResult;
+
 	//catch NO message packet input input
 	if (pMessagePacket == NULL) return URC_FAIL;
 
-	//insert quest into command task queue
-	if (xQueueSend(xTaskQueueHandles[TASK_COMMAND], pMessagePacket, block_time) == pdTRUE)
+	if (pMessagePacket->Token == NULL) return URC_FAIL;
+
+	//the reply goes to a slot on our stack rather than the task token, so
+	//an asynchronous request completing meanwhile can not overwrite it
+	xReply = *(pMessagePacket->Token);
+	xReply.cDone = pdFALSE;
+	xPacket = *pMessagePacket;
+	xPacket.Token = &xReply;
+
+	enResult = enPostRequest(&xPacket, block_time, enLane);
+	if (enResult != URC_SUCCESS) return enResult;
+
+	//put request task into sleep, asynchronous completions wake it as well
+	while (xReply.cDone == pdFALSE)
 	{
-        // XXX: ULTRA HACKYNESS (this shouldn't be here if this software was meant to be more robust)
-        // If a packet is sent FROM the COMMAND task, TO the COMMAND task, then it's just an interrupt handler
-        // somewhere, probably the DTMF handler, sending the COMMAND task a message.
-        if (pMessagePacket->Src == TASK_COMMAND && pMessagePacket->Dest == TASK_COMMAND){
-            // Yep, it was definitely successful! No possible errors at all!
-            return URC_SUCCESS;
-        } else {
-            //put request task into sleep
-            xSemaphoreTake(TaskSemphrs[(pMessagePacket->Token)->enTaskID], portMAX_DELAY);  //(1)
-            //return processed request result
-            return (pMessagePacket->Token)->enRetVal;
-        }
+		xSemaphoreTake(TaskSemphrs[xReply.enTaskID], portMAX_DELAY);  //(1)
 	}
-	else
+	//return processed request result
+	return xReply.enRetVal;
+}
+
+UnivRetCode enSubmitRequest (MessagePacket *pMessagePacket, portTickType block_time, RequestHandle *pxHandle)
+{
+	MessagePacket xPacket;
+	RequestHandle xHandle = NULL;
+	unsigned portSHORT usIndex;
+	UnivRetCode enResult;
+
+	if (pMessagePacket == NULL || pMessagePacket->Token == NULL || pxHandle == NULL) return URC_FAIL;
+
+	taskENTER_CRITICAL();
 	{
-		return URC_BUSY;
+		for (usIndex = 0; usIndex < CMD_ASYNC_SLOTS; usIndex++)
+		{
+			if (!AsyncSlotUsed[usIndex])
+			{
+				AsyncSlotUsed[usIndex] = 1;
+				xHandle = &AsyncSlots[usIndex];
+				break;
+			}
+		}
 	}
+	taskEXIT_CRITICAL();
+
+	if (xHandle == NULL) return URC_BUSY;
+
+	*xHandle = *(pMessagePacket->Token);
+	xHandle->cDone = pdFALSE;
+	xPacket = *pMessagePacket;
+	xPacket.Token = xHandle;
+
+	enResult = enPostRequest(&xPacket, block_time, enSenderLane(xHandle->enTaskID));
+	if (enResult != URC_SUCCESS)
+	{
+		AsyncSlotUsed[xHandle - AsyncSlots] = 0;
+		return enResult;
+	}
+
+	*pxHandle = xHandle;
+	return URC_SUCCESS;
 }
 
-UnivRetCode dtmfRequest (MessagePacket *pMessagePacket)
+portBASE_TYPE xRequestDone (RequestHandle xHandle)
 {
-	portBASE_TYPE a;
+	if (xHandle == NULL) return pdFALSE;
+	return (xHandle->cDone != pdFALSE) ? pdTRUE : pdFALSE;
+}
+
+portBASE_TYPE xWaitAnyRequest (RequestHandle *pxHandles, unsigned portSHORT usCount, portTickType block_time)
+{
+	portTickType xStart = xTaskGetTickCount();
+	portTickType xWaited;
+	portTickType xWait = portMAX_DELAY;
+	xSemaphoreHandle xSemaphore = NULL;
+	unsigned portSHORT usIndex;
+
+	if (pxHandles == NULL) return -1;
+
+	for ( ; ; )
+	{
+		//completions only give the semaphore, so look before every sleep
+		for (usIndex = 0; usIndex < usCount; usIndex++)
+		{
+			if (pxHandles[usIndex] == NULL) continue;
+			if (pxHandles[usIndex]->cDone != pdFALSE) return usIndex;
+			xSemaphore = TaskSemphrs[pxHandles[usIndex]->enTaskID];
+		}
+		if (xSemaphore == NULL) return -1;
+
+		if (block_time != portMAX_DELAY)
+		{
+			xWaited = xTaskGetTickCount() - xStart;
+			if (xWaited >= block_time) return -1;
+			xWait = block_time - xWaited;
+		}
+		xSemaphoreTake(xSemaphore, xWait);
+	}
+}
+
+UnivRetCode enWaitRequest (RequestHandle xHandle)
+{
+	UnivRetCode enResult;
+
+	if (xHandle == NULL) return URC_FAIL;
+
+	xWaitAnyRequest(&xHandle, 1, portMAX_DELAY);
+	enResult = xHandle->enRetVal;
+	AsyncSlotUsed[xHandle - AsyncSlots] = 0;
+
+	return enResult;
+}
+
+void *pvMessageAlloc (unsigned portSHORT usSize)
+{
+	void *pvPayload = NULL;
+	unsigned portSHORT usIndex;
+
+	taskENTER_CRITICAL();
+	{
+		//a bigger class rather than failing when the right one runs out
+		for (usIndex = 0; usIndex < CMD_POOL_CLASSES && pvPayload == NULL; usIndex++)
+		{
+			if (usSize <= MessagePools[usIndex].size) pvPayload = bpAlloc(&MessagePools[usIndex]);
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return pvPayload;
+}
+
+void vMessageFree (void *pvPayload)
+{
+	unsigned portSHORT usIndex;
+
+	if (pvPayload == NULL) return;
+
+	taskENTER_CRITICAL();
+	{
+		for (usIndex = 0; usIndex < CMD_POOL_CLASSES; usIndex++)
+		{
+			if (bpOwns(&MessagePools[usIndex], pvPayload))
+			{
+				bpFree(&MessagePools[usIndex], pvPayload);
+				break;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+portBASE_TYPE xMessageIsPooled (const void *pvPayload)
+{
+	unsigned portSHORT usIndex;
+
+	//pool memory never moves, no need to lock for a range check
+	for (usIndex = 0; usIndex < CMD_POOL_CLASSES; usIndex++)
+	{
+		if (bpOwns(&MessagePools[usIndex], pvPayload)) return pdTRUE;
+	}
+	return pdFALSE;
+}
+
+UnivRetCode enSendMessage (MessagePacket *pMessagePacket, portTickType block_time)
+{
+	MessagePacket xPacket;
+
+	if (pMessagePacket == NULL) return URC_FAIL;
+	if (!xMessageIsPooled((void *)pMessagePacket->Data)) return URC_CMD_BAD_ARG;
+
+	//no reply slot, the receiver completes nothing
+	xPacket = *pMessagePacket;
+	xPacket.Token = NULL;
+
+	return enPostRequest(&xPacket, block_time, enSenderLane(xPacket.Src));
+}
+
+UnivRetCode enPostRequestFromISR (MessagePacket *pMessagePacket, signed portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+	QueuedPacket xItem;
 	//catch NO message packet input input
 	if (pMessagePacket == NULL) return URC_FAIL;
+	if (pMessagePacket->Dest >= NUM_TASKID) return URC_CMD_INVALID_TASK;
+	if (xTaskQueueHandles[pMessagePacket->Dest] == NULL) return URC_CMD_NO_QUEUE;
+
+	xItem.xPacket = *pMessagePacket;
+	xItem.xQueued = xTaskGetTickCountFromISR();
+	xItem.ucLane = CMD_LANE_NORMAL;
 
-	//insert quest into command task queue
-	if (xQueueSendFromISR(xTaskQueueHandles[TASK_COMMAND], pMessagePacket, &a) == pdTRUE)
+	//insert straight into destination queue, nobody waits on the result
+	if (xLaneSendFromISR(pMessagePacket->Dest, &xItem, pxHigherPriorityTaskWoken) == pdTRUE)
 	{
 		return URC_SUCCESS;
 	}
-	return URC_FAIL;
+	return URC_BUSY;
+}
+
+UnivRetCode enPostEventFromISR (CmdEventSource enSource, unsigned portSHORT usData, signed portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+	CmdEvent xEvent;
+
+	if (enSource >= CMD_NUM_EVT) return URC_FAIL;
+	if (TaskDoorbells[TASK_COMMAND] == NULL) return URC_CMD_NO_QUEUE;
+
+	if (ringSpace(&xEventRing) < sizeof(xEvent))
+	{
+		EventStatistics.ulDropped++;
+		return URC_BUSY;
+	}
+
+	xEvent.ucSource = enSource;
+	xEvent.ucSpare = 0;
+	xEvent.usData = usData;
+	ringPush(&xEventRing, (unsigned char *)&xEvent, sizeof(xEvent));
+	EventStatistics.ulPosted++;
+
+	xSemaphoreGiveFromISR(TaskDoorbells[TASK_COMMAND], pxHigherPriorityTaskWoken);
+	return URC_SUCCESS;
+}
+
+UnivRetCode enPostEvent (CmdEventSource enSource, unsigned portSHORT usData)
+{
+	signed portBASE_TYPE xWoken = pdFALSE;
+	UnivRetCode enResult;
+
+	taskENTER_CRITICAL();
+	{
+		enResult = enPostEventFromISR(enSource, usData, &xWoken);
+	}
+	taskEXIT_CRITICAL();
+
+	//the command task may outrank us, nothing else gets a yield in for it
+	if (xWoken) taskYIELD();
+	return enResult;
+}
+
+void vGetEventStats(CmdEventStats *pxStats)
+{
+	if (pxStats == NULL) return;
+
+	taskENTER_CRITICAL();
+	{
+		*pxStats = EventStatistics;
+	}
+	taskEXIT_CRITICAL();
 }
 
 UnivRetCode enGetRequest (TaskToken taskToken,
 						MessagePacket *pMessagePacket,
 						portTickType block_time)
 {
+	QueuedPacket xItem;
 	//catch NO token and NO message packet input input
 	if (taskToken == NULL || pMessagePacket == NULL) return URC_FAIL;
 	//catch NO queue
 	if (xTaskQueueHandles[taskToken->enTaskID] == NULL) return URC_CMD_NO_QUEUE;
 
 	//retrieve request from queue and copy into given buffer
-	if (xQueueReceive(xTaskQueueHandles[taskToken->enTaskID], pMessagePacket, block_time) == pdTRUE)
+	if (xLaneReceive(taskToken->enTaskID, &xItem, block_time) == pdTRUE)
 	{
+		*pMessagePacket = xItem.xPacket;
 		return URC_SUCCESS;
 	}
 	else
@@ -235,8 +732,14 @@ void vCompleteRequest(TaskToken taskToken, UnivRetCode enRetVal)
 {
 	//catch NO token input
 	if (taskToken == NULL) return;
-	//store result value inside request task token
-	taskToken->enRetVal = enRetVal;
+	//store result value inside the reply slot, the flag last so a waiter
+	//never sees it set before the result is in
+	taskENTER_CRITICAL();
+	{
+		taskToken->enRetVal = enRetVal;
+		taskToken->cDone = pdTRUE;
+	}
+	taskEXIT_CRITICAL();
 	//wake request task from sleep
 	xSemaphoreGive(TaskSemphrs[taskToken->enTaskID]);
 }
@@ -258,21 +761,29 @@ TaskToken ActivateTask(TaskID 		enTaskID,
 		//detect task already exist
 		if (TaskTokens[enTaskID].pcTaskName == NULL)
 		{
-			//create task
-			xTaskCreate(pvTaskFunction, (signed portCHAR *)pcTaskName, usStackSize, NULL, uxPriority, &TaskHandles[enTaskID]);
-
-			//store task profile in array
-			TaskTokens[enTaskID].pcTaskName		= pcTaskName;
-			TaskTokens[enTaskID].enTaskType		= enTaskType;
-			TaskTokens[enTaskID].enTaskID		= enTaskID;
-
 			//create semaphore for task
 			vSemaphoreCreateBinary(TaskSemphrs[enTaskID]);
 
-			//exhaust task semaphore
-			xSemaphoreTake(TaskSemphrs[enTaskID], NO_BLOCK);
+			//create task, one the heap cannot hold stays unregistered so
+			//requests to it fail with URC_CMD_NO_TASK instead of waiting
+			if (TaskSemphrs[enTaskID] != NULL
+				&& xTaskCreate(pvTaskFunction, (signed portCHAR *)pcTaskName, usStackSize, NULL, uxPriority, &TaskHandles[enTaskID]) == pdPASS)
+			{
+				//store task profile in array
+				TaskTokens[enTaskID].pcTaskName		= pcTaskName;
+				TaskTokens[enTaskID].enTaskType		= enTaskType;
+				TaskTokens[enTaskID].enTaskID		= enTaskID;
+
+				//exhaust task semaphore
+				xSemaphoreTake(TaskSemphrs[enTaskID], NO_BLOCK);
 
-			taskToken = &TaskTokens[enTaskID];
+				taskToken = &TaskTokens[enTaskID];
+			}
+			else
+			{
+				//reported by the command task once the scheduler runs
+				FailedTasks[enTaskID] = pcTaskName;
+			}
 		}
 	}
 	taskEXIT_CRITICAL();
@@ -283,6 +794,9 @@ TaskToken ActivateTask(TaskID 		enTaskID,
 
 unsigned portSHORT vActivateQueue(TaskToken taskToken, unsigned portSHORT usNumElement)
 {
+	//catch NO token input, the task was never started
+	if (taskToken == NULL) return 0;
+
 	taskENTER_CRITICAL();
 	{
 		//detect queue already exist
@@ -292,7 +806,7 @@ unsigned portSHORT vActivateQueue(TaskToken taskToken, unsigned portSHORT usNumE
 			usNumElement = (usNumElement > MAX_QUEUE_REQ_SIZE) ? MAX_QUEUE_REQ_SIZE : usNumElement;
 
 			//create task queue memory
-			xTaskQueueHandles[taskToken->enTaskID] = xQueueCreate(usNumElement, sizeof(MessagePacket));
+			xTaskQueueHandles[taskToken->enTaskID] = xQueueCreate(usNumElement, sizeof(QueuedPacket));
 		}
 		else
 		{
@@ -305,6 +819,66 @@ unsigned portSHORT vActivateQueue(TaskToken taskToken, unsigned portSHORT usNumE
 	return usNumElement;
 }
 
+unsigned portSHORT vActivateUrgentLane(TaskToken taskToken, unsigned portSHORT usNumElement)
+{
+	TaskID enTask;
+
+	//catch NO token input, the task was never started
+	if (taskToken == NULL) return 0;
+	enTask = taskToken->enTaskID;
+
+	taskENTER_CRITICAL();
+	{
+		//lanes only make sense beside a queue, and only once
+		if (xTaskQueueHandles[enTask] != NULL && xTaskUrgentLanes[enTask] == NULL)
+		{
+			usNumElement = (usNumElement > MAX_QUEUE_REQ_SIZE) ? MAX_QUEUE_REQ_SIZE : usNumElement;
+
+			vSemaphoreCreateBinary(TaskDoorbells[enTask]);
+			if (TaskDoorbells[enTask] != NULL)
+			{
+				//the doorbell only rings for requests queued from here on
+				xSemaphoreTake(TaskDoorbells[enTask], NO_BLOCK);
+				xTaskUrgentLanes[enTask] = xQueueCreate(usNumElement, sizeof(QueuedPacket));
+			}
+			if (xTaskUrgentLanes[enTask] == NULL) usNumElement = 0;
+		}
+		else
+		{
+			usNumElement = 0;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return usNumElement;
+}
+
+void vGetLaneStats(TaskID enTask, CmdLane enLane, LaneStats *pxStats)
+{
+	if (enTask >= NUM_TASKID || enLane >= CMD_NUM_LANES || pxStats == NULL) return;
+
+	taskENTER_CRITICAL();
+	{
+		*pxStats = LaneStatistics[enTask][enLane];
+	}
+	taskEXIT_CRITICAL();
+}
+
+void vSetRequestLane(TaskToken taskToken, CmdLane enLane)
+{
+	//catch NO token input
+	if (taskToken == NULL || enLane >= CMD_NUM_LANES) return;
+
+	RequestLanes[taskToken->enTaskID] = enLane;
+}
+
+//requests with no lane given go on the one their sender was set to
+static CmdLane enSenderLane(TaskID enSrc)
+{
+	if (enSrc >= NUM_TASKID) return CMD_LANE_NORMAL;
+	return (CmdLane)RequestLanes[enSrc];
+}
+
 portCHAR *pcGetTaskName(TaskToken taskToken)
 {
 	//catch NO token input
@@ -360,12 +934,39 @@ void vSleep(unsigned portSHORT usTimeMS)
 	}
 #endif
 
+#ifndef NO_DEBUG
+	#include "debug.h"
+	void vShowAllLockStats(void)
+	{
+		unsigned portBASE_TYPE uxIndex;
+		LockStats xStats;
+
+		vDebugPrint(&TaskTokens[TASK_COMMAND],
+					"****** Lock Max Held / Max Wait (ticks) ******\n\r",
+					0, 0, 0);
+
+		//a print holds the UART lock itself, its own line shows up next time
+		for (uxIndex = 0; uxIndex < uxLockCount(); uxIndex++)
+		{
+			vLockGetStats(pxLockGet(uxIndex), &xStats);
+			vDebugPrint(&TaskTokens[TASK_COMMAND],
+						"%16s\t\t%d\t%d\n\r",
+						(unsigned portLONG)pxLockGet(uxIndex)->pcName,
+						(unsigned portLONG)xStats.xMaxHeld,
+						(unsigned portLONG)xStats.xMaxWait);
+		}
+	}
+#endif
+
 static void setupPortExpander (unsigned int bus){
 	int isValid = 1;
 	char command[2];
 	unsigned int length;
 	portBASE_TYPE returnVal;
 
+	//the expanders are set up register by register, nobody else in between
+	Comms_I2C_Lock(bus, portMAX_DELAY);
+
 //chip U8
 	command[0] = 0x00;
 	command[1] = (0x1<<6)+(0x1<<7);
@@ -468,6 +1069,7 @@ static void setupPortExpander (unsigned int bus){
 				(char*)&isValid, (char*)command, (short*)&length, initMutex, bus);
 	xSemaphoreTake(initMutex, INIT_SEMAPHORE_BLOCK_TIME);
 
+	Comms_I2C_Unlock(bus);
 }
 
 static void reset (unsigned int bus){
@@ -476,6 +1078,8 @@ static void reset (unsigned int bus){
 	unsigned int length;
 	portBASE_TYPE returnVal;
 
+	Comms_I2C_Lock(bus, portMAX_DELAY);
+
 //chip U8
 
 	command[0] = 0x12;
@@ -585,4 +1189,6 @@ static void reset (unsigned int bus){
 	returnVal = Comms_I2C_Master(SLAVE_ADDRESS_PREFIX + 2, I2C_WRITE,
 				(char*)&isValid, (char*)command, (short*)&length, initMutex, bus);
 	xSemaphoreTake(initMutex, INIT_SEMAPHORE_BLOCK_TIME);
+
+	Comms_I2C_Unlock(bus);
 }
@@ -17,9 +17,28 @@
 #include "service.h"
 
 #define TRANSMISSION_TIME	2000
+//longest wait for the frames of one cycle to leave the modem
+#define COMMS_TX_TIMEOUT	15000
+//how often the pass planner is checked while out of view
+#define COMMS_PHASE_POLL	1000
+
+//PRBS bytes generated per write to the modem in BERT mode
+#define COMMS_BERT_BLOCK	32
+//ticks between looks for the modem to finish frames queued before a BERT run
+#define COMMS_BERT_IDLE_POLL	20
 
 void vComms_Init(unsigned portBASE_TYPE uxPriority);
 
+/**
+ * \brief Replace the next downlink cycle with a PRBS bit error rate test.
+ * The sequence goes out raw through whichever modem path is switched in,
+ * with no framing, so Scripts/bert_check.pl can sync to it on the ground.
+ *
+ * \param[in] ucType prbsType to send
+ * \param[in] usSeconds How long to send for
+ */
+void vComms_RequestBert(unsigned portCHAR ucType, unsigned portSHORT usSeconds);
+
 int iSendData(TaskToken token, char *data, int size);
 
 #endif /* COMMS_H_ */
@@ -11,19 +11,22 @@
  */
 
 #include "service.h"
+#include "task.h"
 #include "commsControl.h"
 #include "switching.h"
 #include "modem.h"
 #include "debug.h"
 #include "telemetry_storage.h"
-#include "ax25.h"
 #include "lib_string.h"
 #include "Comms_DTMF.h"
+#include "channel.h"
+#include "protocols.h"
+#include "prbs.h"
+#include "planner.h"
+#include "fmtNum.h"
+#include "events.h"
 
 
-
-#define AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE 0xF0
-
 //global variable for modem usage
 int modem;
 
@@ -32,14 +35,34 @@ static TaskToken Comms_TaskToken;
 
 //prototype for task function
 static portTASK_FUNCTION(vCommsTask, pvParameters);
+/*
+ * Hand a text frame to the protocols service, the class picks how many
+ * copies go out. Returns once encoded so the text buffer can be reused
+ * straight away.
+ */
+static void vCommsQueueFrame(char *pcText, unsigned portSHORT usSize, unsigned portCHAR ucClass, unsigned portCHAR ucFlags);
+static void vCommsTxDone(void *pvTag, UnivRetCode enResult);
+static void vCommsRunBert(void);
+static unsigned portSHORT usCommsTelemText(char *pcOut, struct telem_storage_entry_t *pxEntry,
+										const char *pcLabel, unsigned portSHORT usFirst, unsigned portSHORT usCount);
+static void vCommsTakeEvents(portTickType xBlock);
+
+//given by the protocols service when the last frame of a cycle is sent
+static xSemaphoreHandle commsTxDone;
+
+//set by mode change events from the command task
+static unsigned portCHAR transmitTele = 1;
+static unsigned portCHAR transmitBeacon = 1;
 
-int transmitTele = 1;
-int transmitBeacon = 1;
+//newest telemetry entry published, read from storage until the first one
+static struct telem_storage_entry_t latestTelem;
+static unsigned portCHAR haveTelem = 0;
+static unsigned portCHAR eventsReady = 0;
 
+//pending BERT request, set by the command task
+static volatile unsigned portCHAR ucBertType;
+static volatile unsigned portSHORT usBertSeconds = 0;
 
-extern char DTMF_BUFF[DTMF_SIZE];
-extern int DTMF_BUFF_SP; //Start position
-extern int DTMF_BUFF_EP; //End position
 
 void vComms_Init(unsigned portBASE_TYPE uxPriority)
 {
@@ -51,6 +74,11 @@ void vComms_Init(unsigned portBASE_TYPE uxPriority)
 								   1024,
 								   vCommsTask);
 
+	vSemaphoreCreateBinary(commsTxDone);
+	xSemaphoreTake(commsTxDone, NO_BLOCK);
+
+	eventsReady = enEventSubscribe(Comms_TaskToken, EVT_TELEM_ENTRY) == URC_SUCCESS
+				&& enEventSubscribe(Comms_TaskToken, EVT_MODE_CHANGE) == URC_SUCCESS;
 }
 
 /*
@@ -66,13 +94,12 @@ void vComms_Init(unsigned portBASE_TYPE uxPriority)
 static portTASK_FUNCTION(vCommsTask, pvParameters)
 {
 	(void) pvParameters;
-	struct telem_storage_entry_t temp;
-	stateBlock present;
+	ChannelStats channelStats;
     char input [128];
-    char actual [128];
 
-    unsigned int actual_size = 128;
+    unsigned portSHORT size;
     int i, m;
+    ppPhase phase;
     switching_RX(0);
 	switching_OPMODE(DEVICE_MODE);
 
@@ -81,310 +108,84 @@ static portTASK_FUNCTION(vCommsTask, pvParameters)
 	switching_TX(0);
 	for ( ; ; )
 	{
+		if (usBertSeconds != 0)
+		{
+			vCommsRunBert();
+			continue;
+		}
+
+		//nothing in view, keep quiet until the next pass comes up
+		vCommsTakeEvents(NO_BLOCK);
+		phase = enPlannerPhase();
+		if (phase == PP_PHASE_IDLE)
+		{
+			vCommsTakeEvents(COMMS_PHASE_POLL / portTICK_RATE_MS);
+			continue;
+		}
+
 		m = 0;
 		// grab message from telem log
 		//telemetry_storage_read_index(0,&temp);
 		if (transmitTele){
-			m = telemetry_storage_read_cur(&temp);
-			vDebugPrint(Comms_TaskToken,"m = %d and time = %d\r\n",m,temp.timestamp,NO_INSERT);
-			input[0] = ((temp.timestamp & (63 << 6))>>6)/10 + '0';
-			input[1] = ((temp.timestamp & (63 << 6))>>6)%10 + '0';
-			input[2] = ':';
-			input[3] = (temp.timestamp & 63)/10 + '0';
-			input[4] = (temp.timestamp & 63)%10 + '0';
-			input[5] = '\r';
-			input[6] = 'T';
-			input[7] = 'X';
-			input[8] = ':';
-			input[9] = '\r';
-			for (i = 0; i < 7; i++ ){
-				if (i > 9){
-					input[10+i*7] = i - 10 +'A';
-				} else {
-					input[10+i*7] = i+'0';
-				}
-				input[10+i*7+1] = ':';
-				input[10+i*7+2] = temp.values[i]/20+'0';
-				input[10+i*7+3] = (temp.values[i]/2)%10+'0';
-				input[10+i*7+4] = '.';
-				if (temp.values[i]%2 == 0){
-					input[10+i*7+5] = '0';
-				} else {
-					input[10+i*7+5] = '5';
-				}
-				input[10+i*7+6] = '\r';
-			}
-
-			present.srcSize = 59;
-			present.src = input;
-			memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
-			memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
-
-			present.route.dest.callSignSize = 6;
-			present.route.src.callSignSize = 6;
-			present.route.dest.ssid = 1;
-			present.route.src.ssid = 1;
-			present.route.repeats  = NULL;
-			present.route.totalRepeats = 0;
-			present.route.type = Response;
-			present.presState = stateless;
-			present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
-			present.packetCnt = 0;
-			present.nxtIndex = 0;
-			present.mode = unconnected;
-			present.completed = false;
-
-			vSetToken(Comms_TaskToken);
-			actual_size = 128;
-			memset (actual, 0, 128);
-			ax25Entry (&present, actual, &actual_size );
-
-			//vDebugPrint(Comms_TaskToken, "%d, %33x\n\r",actual_size ,actual, NO_INSERT);
-			// TX and modem will be chosen by GS
-
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-			input[0] = ((temp.timestamp & (63 << 6))>>6)/10 + '0';
-			input[1] = ((temp.timestamp & (63 << 6))>>6)%10 + '0';
-			input[2] = ':';
-			input[3] = (temp.timestamp & 63)/10 + '0';
-			input[4] = (temp.timestamp & 63)%10 + '0';
-			input[5] = '\r';
-			input[6] = 'B';
-			input[7] = 'a';
-			input[8] = 't';
-			input[9] = 't';
-			input[10] = 'e';
-			input[11] = 'r';
-			input[12] = 'y';
-			input[13] = ':';
-			input[14] = '\r';
-
-			for (i = 0; i < 9; i++ ){
-				if (i > 9){
-					input[15+i*7] = i - 10 +'A';
-				} else {
-					input[15+i*7] = i+'0';
-				}
-				input[15+i*7+1] = ':';
-				input[15+i*7+2] = temp.values[i+7]/20+'0';
-				input[15+i*7+3] = (temp.values[i+7]/2)%10+'0';
-				input[15+i*7+4] = '.';
-				if (temp.values[i]%2 == 0){
-					input[15+i*7+5] = '0';
-				} else {
-					input[15+i*7+5] = '5';
-				}
-				input[15+i*7+6] = '\r';
-			}
-
-			present.srcSize = 78;
-			present.src = input;
-			memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
-			memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
-
-			present.route.dest.callSignSize = 6;
-			present.route.src.callSignSize = 6;
-			present.route.dest.ssid = 1;
-			present.route.src.ssid = 1;
-			present.route.repeats  = NULL;
-			present.route.totalRepeats = 0;
-			present.route.type = Response;
-			present.presState = stateless;
-			present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
-			present.packetCnt = 0;
-			present.nxtIndex = 0;
-			present.mode = unconnected;
-			present.completed = false;
-
-			actual_size = 128;
-			memset (actual, 0, 128);
-			ax25Entry (&present, actual, &actual_size );
-
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-
-			input[0] = ((temp.timestamp & (63 << 6))>>6)/10 + '0';
-			input[1] = ((temp.timestamp & (63 << 6))>>6)%10 + '0';
-			input[2] = ':';
-			input[3] = (temp.timestamp & 63)/10 + '0';
-			input[4] = (temp.timestamp & 63)%10 + '0';
-			input[5] = '\r';
-			input[6] = 'C';
-			input[7] = 'S';
-			input[8] = 'C';
-			input[9] = ':';
-			input[10] = '\r';
-
-			for (i = 0; i < 10; i++ ){
-				if (i > 9){
-					input[11+i*7] = i - 10 +'A';
-				} else {
-					input[11+i*7] = i+'0';
-				}
-				input[11+i*7+1] = ':';
-				input[11+i*7+2] = temp.values[i+16]/20+'0';
-				input[11+i*7+3] = (temp.values[i+16]/2)%10+'0';
-				input[11+i*7+4] = '.';
-				if (temp.values[i]%2 == 0){
-					input[11+i*7+5] = '0';
-				} else {
-					input[11+i*7+5] = '5';
-				}
-				input[11+i*7+6] = '\r';
-			}
-
-			present.srcSize = 81;
-			present.src = input;
-			memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
-			memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
-
-			present.route.dest.callSignSize = 6;
-			present.route.src.callSignSize = 6;
-			present.route.dest.ssid = 1;
-			present.route.src.ssid = 1;
-			present.route.repeats  = NULL;
-			present.route.totalRepeats = 0;
-			present.route.type = Response;
-			present.presState = stateless;
-			present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
-			present.packetCnt = 0;
-			present.nxtIndex = 0;
-			present.mode = unconnected;
-			present.completed = false;
-
-			actual_size = 128;
-			memset (actual, 0, 128);
-			ax25Entry (&present, actual, &actual_size );
-
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-
-			input[0] = ((temp.timestamp & (63 << 6))>>6)/10 + '0';
-			input[1] = ((temp.timestamp & (63 << 6))>>6)%10 + '0';
-			input[2] = ':';
-			input[3] = (temp.timestamp & 63)/10 + '0';
-			input[4] = (temp.timestamp & 63)%10 + '0';
-			input[5] = '\r';
-			input[6] = 'R';
-			input[7] = 'X';
-			input[8] = ':';
-			input[9] = '\r';
-
-			for (i = 0; i < 9; i++ ){
-				if (i > 9){
-					input[10+i*7] = i - 10 +'A';
-				} else {
-					input[10+i*7] = i+'0';
-				}
-				input[10+i*7+1] = ':';
-				input[10+i*7+2] = temp.values[i+26]/20+'0';
-				input[10+i*7+3] = (temp.values[i+26]/2)%10+'0';
-				input[10+i*7+4] = '.';
-				if (temp.values[i]%2 == 0){
-					input[10+i*7+5] = '0';
-				} else {
-					input[10+i*7+5] = '5';
-				}
-				input[10+i*7+6] = '\r';
-			}
-
-			present.srcSize = 73;
-			present.src = input;
-			memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
-			memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
-
-			present.route.dest.callSignSize = 6;
-			present.route.src.callSignSize = 6;
-			present.route.dest.ssid = 1;
-			present.route.src.ssid = 1;
-			present.route.repeats  = NULL;
-			present.route.totalRepeats = 0;
-			present.route.type = Response;
-			present.presState = stateless;
-			present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
-			present.packetCnt = 0;
-			present.nxtIndex = 0;
-			present.mode = unconnected;
-			present.completed = false;
-
-			actual_size = 128;
-			memset (actual, 0, 128);
-			ax25Entry (&present, actual, &actual_size );
-
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
-
-			Comms_Modem_Write_Str(actual, actual_size);
-			modem_takeSemaphore();
+			//entries from before the last reset until telemetry publishes
+			if (!haveTelem) m = telemetry_storage_read_cur(&latestTelem);
+			vDebugPrint(Comms_TaskToken,"m = %d and time = %d\r\n",m,latestTelem.timestamp,NO_INSERT);
+			size = usCommsTelemText(input, &latestTelem, "TX", 0, 7);
+			vCommsQueueFrame(input, size, RED_CLASS_TELEM, PROTO_FLAG_NONE);
+			size = usCommsTelemText(input, &latestTelem, "Battery", 7, 9);
+			vCommsQueueFrame(input, size, RED_CLASS_TELEM, PROTO_FLAG_NONE);
+			size = usCommsTelemText(input, &latestTelem, "CSC", 16, 10);
+			vCommsQueueFrame(input, size, RED_CLASS_TELEM, PROTO_FLAG_NONE);
+			size = usCommsTelemText(input, &latestTelem, "RX", 26, 9);
+			vCommsQueueFrame(input, size, RED_CLASS_TELEM, PROTO_FLAG_NONE);
 		}
 
-		vDebugPrint(Comms_TaskToken,"SP %d EP %d\r\n",DTMF_BUFF_SP,DTMF_BUFF_EP,NO_INSERT);
+		vChannel_GetStats(&channelStats);
+		vDebugPrint(Comms_TaskToken,"Channel busy %d percent, %d carriers, %d forced\r\n",
+					channelStats.ucOccupancy,channelStats.ulCarrierCount,channelStats.ulForced);
 
 		// compose string
 		// hh:mm:ss\tID:-cc.c\t....
 		//for (i = 0, m = 100000; i < 6; i++, m/=10){
 			//input[i] = ((temp.timestamp/m)%10) - '0';
 		//}
-		if (DTMF_BUFF_SP == DTMF_BUFF_EP){
+		size = Comms_DTMF_Read(input, DTMF_SIZE);
+		vDebugPrint(Comms_TaskToken,"%d DTMF tones\r\n",size,NO_INSERT,NO_INSERT);
+		if (size == 0){
 			memcpy (input,"No new DTMF\r",12);
-			present.srcSize = 12;
+			size = 12;
 		} else {
-			i = 0;
-			while (DTMF_BUFF_SP != DTMF_BUFF_EP){
-				if (DTMF_BUFF[DTMF_BUFF_SP] < 10){
-					input[i] = DTMF_BUFF[DTMF_BUFF_SP]+'0';
-				} else if (DTMF_BUFF[DTMF_BUFF_SP] == 10){
+			//converted in place, one character a tone
+			for (i = 0; i < size; i++){
+				if (input[i] < 10){
+					input[i] = input[i]+'0';
+				} else if (input[i] == 10){
 					input[i] = '0';
-				} else if (DTMF_BUFF[DTMF_BUFF_SP] == 11){
+				} else if (input[i] == 11){
 					input[i] = '*';
 				} else {
 					input[i] = '#';
 				}
-				i++;
-				DTMF_BUFF_SP = (DTMF_BUFF_SP + 1)% DTMF_SIZE;
 			}
 			input[i] = '\r';
-			present.srcSize = i+1;
+			size = i+1;
 		}
 
-		// call ax25 to encode it
-		present.src = input;
-		memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
-		memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
-
-		present.route.dest.callSignSize = 6;
-		present.route.src.callSignSize = 6;
-		present.route.dest.ssid = 1;
-		present.route.src.ssid = 1;
-		present.route.repeats  = NULL;
-		present.route.totalRepeats = 0;
-		present.route.type = Response;
-		present.presState = stateless;
-		present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
-		present.packetCnt = 0;
-		present.nxtIndex = 0;
-		present.mode = unconnected;
-		present.completed = false;
-
-		vSetToken(Comms_TaskToken);
-		actual_size = 64;
-		memset (actual, 0, 64);
-		ax25Entry (&present, actual, &actual_size );
-
-		vDebugPrint(Comms_TaskToken, "%d, %33x\n\r",actual_size ,actual, NO_INSERT);
-		// TX and modem will be chosen by GS
-
-		Comms_Modem_Write_Str(actual, actual_size);
-		modem_takeSemaphore();
-		Comms_Modem_Write_Str(actual, actual_size);
-		modem_takeSemaphore();
+		// last frame of the cycle closes the burst, the beacon can not key up
+		// until the protocols service reports it has left the modem
+		vCommsQueueFrame(input, size, RED_CLASS_STATUS, PROTO_FLAG_LAST);
+
+		//staged frames are held by protocols and go out when the pass opens
+		while (phase == PP_PHASE_STAGE)
+		{
+			vCommsTakeEvents(COMMS_PHASE_POLL / portTICK_RATE_MS);
+			phase = enPlannerPhase();
+		}
+
+		if (xSemaphoreTake(commsTxDone, COMMS_TX_TIMEOUT) != pdTRUE)
+		{
+			vDebugPrint(Comms_TaskToken,"Downlink did not complete\r\n",NO_INSERT,NO_INSERT,NO_INSERT);
+		}
 
 		vDebugPrint(Comms_TaskToken,"T\r\n",NO_INSERT,NO_INSERT,NO_INSERT);
 
@@ -400,6 +201,138 @@ static portTASK_FUNCTION(vCommsTask, pvParameters)
 		switching_TX_Device(AFSK_1);
 	}
 }
+
+/*
+ * Wait up to xBlock for an event, then take whatever else is queued. Only
+ * the newest telemetry entry is kept, read back from the storage slot the
+ * notice names.
+ */
+static void vCommsTakeEvents(portTickType xBlock)
+{
+	const Event *pxEvent;
+	const EventMode *pxMode;
+	const EventTelem *pxTelem;
+
+	//no event queue to sleep on, keep the old polling pace
+	if (!eventsReady)
+	{
+		vTaskDelay(xBlock);
+		return;
+	}
+
+	for (pxEvent = pxEventWait(Comms_TaskToken, xBlock);
+		pxEvent != NULL;
+		pxEvent = pxEventWait(Comms_TaskToken, NO_BLOCK))
+	{
+		if (pxEvent->enTopic == EVT_TELEM_ENTRY && pxEvent->usSize == sizeof(EventTelem))
+		{
+			pxTelem = (const EventTelem *)pxEvent->pvData;
+			haveTelem = telemetry_storage_read_index(pxTelem->usIndex, &latestTelem) == 0;
+		}
+		else if (pxEvent->enTopic == EVT_MODE_CHANGE && pxEvent->usSize == sizeof(EventMode))
+		{
+			pxMode = (const EventMode *)pxEvent->pvData;
+			transmitTele = pxMode->ucTelemetry;
+			transmitBeacon = pxMode->ucBeacon;
+		}
+		vEventRelease(pxEvent);
+	}
+
+	//a lost notice leaves latestTelem behind, take the newest from storage
+	if (usEventTakeMissed(Comms_TaskToken, EVT_TELEM_ENTRY) > 0)
+	{
+		haveTelem = telemetry_storage_read_cur(&latestTelem) == 0;
+	}
+}
+
+void vComms_RequestBert(unsigned portCHAR ucType, unsigned portSHORT usSeconds)
+{
+	ucBertType = ucType;
+	usBertSeconds = usSeconds;
+}
+
+/*
+ * Stream the PRBS through the modem character ring. The protocols pipeline
+ * is held for the whole run and the frames it already gave the modem are
+ * let out first, so uplink, mailbox and planner frames can not slip in
+ * between blocks when the ring runs dry.
+ */
+static void vCommsRunBert(void)
+{
+	prbsGen gen;
+	portCHAR block[COMMS_BERT_BLOCK];
+	portTickType xStart;
+	portTickType xDuration;
+	unsigned portLONG ulBlocks = 0;
+
+	xDuration = (portTickType)usBertSeconds * 1000 / portTICK_RATE_MS;
+	usBertSeconds = 0;
+	if (prbsInit(&gen, (prbsType)ucBertType) != URC_SUCCESS) return;
+
+	enProtoHold(Comms_TaskToken, pdTRUE);
+	while (Comms_Modem_Is_Sending()) vTaskDelay(COMMS_BERT_IDLE_POLL);
+
+	vDebugPrint(Comms_TaskToken,"BERT PRBS type %d for %d ticks\r\n",ucBertType,xDuration,NO_INSERT);
+	if (enChannel_Acquire(CHANNEL_DEF_MAX_WAIT) != URC_SUCCESS)
+	{
+		vDebugPrint(Comms_TaskToken,"Channel busy, forcing TX\r\n",NO_INSERT,NO_INSERT,NO_INSERT);
+	}
+
+	xStart = xTaskGetTickCount();
+	while ((xTaskGetTickCount() - xStart) < xDuration)
+	{
+		prbsFill(&gen, (unsigned char *)block, COMMS_BERT_BLOCK);
+		Comms_Modem_Write_Str(block, COMMS_BERT_BLOCK);
+		ulBlocks++;
+	}
+	//given by the modem each time the ring drains, the last time is the end
+	do
+	{
+		modem_takeSemaphore();
+	} while (Comms_Modem_Is_Sending());
+	vChannel_Release();
+	enProtoHold(Comms_TaskToken, pdFALSE);
+
+	vDebugPrint(Comms_TaskToken,"BERT sent %d bits\r\n",ulBlocks * COMMS_BERT_BLOCK * 8,NO_INSERT,NO_INSERT);
+}
+
+/*
+ * One block of readings in the fixed columns the ground decodes, see
+ * fmtReadings. Returns the length, 8 + label + 7 per value.
+ */
+static unsigned portSHORT usCommsTelemText(char *pcOut, struct telem_storage_entry_t *pxEntry,
+										const char *pcLabel, unsigned portSHORT usFirst, unsigned portSHORT usCount)
+{
+	return fmtReadings(pcOut, pxEntry->timestamp, pcLabel, &pxEntry->values[usFirst], usCount);
+}
+
+static void vCommsQueueFrame(char *pcText, unsigned portSHORT usSize, unsigned portCHAR ucClass, unsigned portCHAR ucFlags)
+{
+	ProtoRequest request;
+
+	request.pcData = pcText;
+	request.usSize = usSize;
+	request.ucClass = ucClass;
+	request.ucRepeat = 0;
+	request.ucFlags = ucFlags;
+	request.vNotify = (ucFlags & PROTO_FLAG_LAST) ? vCommsTxDone : NULL;
+	request.pvTag = NULL;
+
+	if (enProtoSubmit(Comms_TaskToken, &request) != URC_SUCCESS)
+	{
+		vDebugPrint(Comms_TaskToken,"Frame dropped\r\n",NO_INSERT,NO_INSERT,NO_INSERT);
+		//nothing will notify us, do not hold up the beacon
+		if (ucFlags & PROTO_FLAG_LAST) xSemaphoreGive(commsTxDone);
+	}
+}
+
+static void vCommsTxDone(void *pvTag, UnivRetCode enResult)
+{
+	(void) pvTag;
+	(void) enResult;
+	xSemaphoreGive(commsTxDone);
+}
+
 /*
 int iSendData(TaskToken token, char *data, int size)
 {
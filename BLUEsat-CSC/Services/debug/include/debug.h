@@ -48,6 +48,9 @@
 		 * %p		= Print value as pointer in hex
 		 * %d		= Print value in decimal
 		 *
+		 * Applications return before the print when there are no %s or %x
+		 * insertions, the format string itself must stay in place.
+		 *
 		 * \param[in] taskToken Task token from request task
 		 * \param[in] pcFormat Print format.
 		 * \param[in] pcInsertion_1 Insertion data 1.
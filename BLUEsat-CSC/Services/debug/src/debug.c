@@ -16,11 +16,13 @@
 #include "debug.h"
 #include "uart.h"
 #include "lib_string.h"
+#include "fmtNum.h"
 
 #define MSN(x)							   (x >> 0x4)	//Most Significant Nibble
 #define LSN(x)							   (x &  0xf)	//Least Significant Nibble
 
 #define DEBUG_Q_SIZE		5
+#define DEBUG_URGENT_Q_SIZE	2
 #define MAX_INSERTIONS		3
 #define MAX_ERROR_MSG_LEN	100
 
@@ -33,6 +35,14 @@ typedef struct
 
 #define DEBUG_CONTENT_SIZE	sizeof(DebugContent)
 
+//queued print that owns its insertions, the sender does not wait for it
+typedef struct
+{
+	TaskToken			taskToken;
+	portCHAR *			pcFormat;
+	unsigned portLONG	pulInsertions[MAX_INSERTIONS];
+} DebugMessage;
+
 //all static declaration goes in here
 #ifndef NO_DEBUG
 	static struct taskToken preScheduler_TaskToken = {	.pcTaskName = "BootSys",
@@ -46,6 +56,9 @@ typedef struct
 
 	//prototype for task function
 	static portTASK_FUNCTION(vDebugTask, pvParameters);
+	static UnivRetCode enDebugSend(TaskToken			taskToken,
+									portCHAR *			pcFormat,
+									unsigned portLONG *	pulInsertions);
 #endif /* NO_DEBUG */
 
 /**
@@ -109,6 +122,8 @@ void vPrintString(portCHAR const *pcPtr, unsigned portSHORT usLength);
 									vDebugTask);
 
 		vActivateQueue(Debug_TaskToken, DEBUG_Q_SIZE);
+		//ground command output gets ahead of queued prints
+		vActivateUrgentLane(Debug_TaskToken, DEBUG_URGENT_Q_SIZE);
 	}
 
 	static portTASK_FUNCTION(vDebugTask, pvParameters)
@@ -117,6 +132,7 @@ void vPrintString(portCHAR const *pcPtr, unsigned portSHORT usLength);
 		UnivRetCode enResult;
 		MessagePacket incoming_packet;
 		DebugContent *pContentHandle;
+		DebugMessage *pMessage;
 
 		for ( ; ; )
 		{
@@ -124,6 +140,15 @@ void vPrintString(portCHAR const *pcPtr, unsigned portSHORT usLength);
 
 			if (enResult != URC_SUCCESS) continue;
 
+			//pooled prints are ours to free and nobody waits on them
+			if (xMessageIsPooled((void *)incoming_packet.Data))
+			{
+				pMessage = (DebugMessage *)incoming_packet.Data;
+				enJPrint(pMessage->taskToken, pMessage->pcFormat, pMessage->pulInsertions);
+				vMessageFree(pMessage);
+				continue;
+			}
+
 			pContentHandle = (DebugContent *)incoming_packet.Data;
 
 			//complete request by passing the status to the sender
@@ -183,7 +208,10 @@ void vPrintString(portCHAR const *pcPtr, unsigned portSHORT usLength);
 		}
 		else if (taskToken->enTaskType == TYPE_APPLICATION)
 		{
-			//applications' debug message always gets queued
+			//applications' debug message always gets queued, without
+			//waiting for it when the insertions can be copied
+			if (enDebugSend(taskToken, pcFormat, pulInsertions) == URC_SUCCESS) return;
+
 			//create request packet
 			outgoing_packet.Src				= taskToken->enTaskID;
 			outgoing_packet.Dest			= TASK_DEBUG;
@@ -196,6 +224,50 @@ void vPrintString(portCHAR const *pcPtr, unsigned portSHORT usLength);
 		}
 	}
 
+	/*
+	 * %s and %x insertions point at the caller's data, which may be gone by
+	 * the time the debug task gets to it. Those prints wait as before, as do
+	 * all prints while the pool or the debug queue is full.
+	 */
+	static UnivRetCode enDebugSend(TaskToken			taskToken,
+									portCHAR *			pcFormat,
+									unsigned portLONG *	pulInsertions)
+	{
+		MessagePacket outgoing_packet;
+		DebugMessage *pMessage;
+		unsigned portLONG ulIndex;
+		unsigned portCHAR ucInsertion;
+		UnivRetCode enResult;
+
+		for (ulIndex = 0; pcFormat[ulIndex] != '\0'; ++ulIndex)
+		{
+			if (pcFormat[ulIndex] != '%') continue;
+			while (pcFormat[++ulIndex] >= '0' && pcFormat[ulIndex] <= '9');
+			if (pcFormat[ulIndex] == 's' || pcFormat[ulIndex] == 'x') return URC_FAIL;
+			if (pcFormat[ulIndex] == '\0') break;
+		}
+
+		pMessage = pvMessageAlloc(sizeof(DebugMessage));
+		if (pMessage == NULL) return URC_BUSY;
+
+		pMessage->taskToken = taskToken;
+		pMessage->pcFormat = pcFormat;
+		for (ucInsertion = 0; ucInsertion < MAX_INSERTIONS; ++ucInsertion)
+		{
+			pMessage->pulInsertions[ucInsertion] = pulInsertions[ucInsertion];
+		}
+
+		outgoing_packet.Src		= taskToken->enTaskID;
+		outgoing_packet.Dest	= TASK_DEBUG;
+		outgoing_packet.Token	= NULL;
+		outgoing_packet.Data	= (unsigned portLONG)pMessage;
+
+		enResult = enSendMessage(&outgoing_packet, NO_BLOCK);
+		if (enResult != URC_SUCCESS) vMessageFree(pMessage);
+
+		return enResult;
+	}
+
 #endif /* NO_DEBUG */
 
 UnivRetCode enJPrint(TaskToken 			taskToken,
@@ -310,22 +382,13 @@ UnivRetCode enPrintInsertion(portCHAR const *	pcFormat,
 	return URC_SUCCESS;
 }
 
-#define LONG_TO_DECIMAL_BYTE_SIZE	10
 void vPrintDecimal(unsigned portLONG ulValue)
 {
-	portCHAR pcBuffer[LONG_TO_DECIMAL_BYTE_SIZE + 1];	//include '\0'
-	unsigned portSHORT usIndex = LONG_TO_DECIMAL_BYTE_SIZE;
+	portCHAR pcBuffer[FMT_UNSIGNED_MAX_LEN + 1];	//include '\0'
 
-	memset(pcBuffer, '\0', LONG_TO_DECIMAL_BYTE_SIZE + 1);
-
-	do
-	{
-		pcBuffer[--usIndex] = ulValue % 10 + '0';
-		ulValue /= 10;
-	}
-	while (ulValue > 0 && usIndex > 0);
+	pcBuffer[fmtUnsigned(pcBuffer, ulValue, 0)] = '\0';
 
-	vPrintString(&pcBuffer[usIndex], LONG_TO_DECIMAL_BYTE_SIZE);
+	vPrintString(pcBuffer, FMT_UNSIGNED_MAX_LEN);
 }
 
 void vPrintHex(portCHAR const *pcPtr, unsigned portSHORT usLength)
@@ -0,0 +1,115 @@
+ /**
+ *  \file events.h
+ *
+ *  \brief Publish/subscribe event bus. A published payload is copied once
+ *  into a pooled message buffer and the same buffer is queued to every
+ *  subscriber, the last subscriber to release it gives it back.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-12 19:30:00 +1000 (Wed, 12 Jun 2013) $
+ *  \warning Payloads are read only, subscribers share one copy
+ *  \bug No Bugs for now
+ *  \note Subscriptions are made during initialisation and last for good.
+ *  Each subscribing task gets one event queue for all of its topics.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include "command.h"
+
+//subscribers a topic can have
+#define EVT_MAX_SUBSCRIBERS		4
+//events waiting in one subscriber's queue
+#define EVT_QUEUE_SIZE			4
+
+typedef enum
+{
+	EVT_TELEM_ENTRY,	//EventTelem below, a telemetry entry just stored
+	EVT_MODE_CHANGE,	//EventMode below
+	EVT_DTMF_COMMAND,	//unsigned portLONG tone code handled by the command task
+	EVT_STORAGE_LOW,	//TaskID of the memory service that ran out of free blocks
+	EVT_NUM_TOPICS
+} EventTopic;
+
+//payload of EVT_TELEM_ENTRY. The entry itself stays in telemetry storage,
+//a whole entry would take the large message class once per publish
+typedef struct
+{
+	unsigned portSHORT	usIndex;		//slot for telemetry_storage_read_index
+	unsigned portLONG	ulTimestamp;	//timestamp of the entry in that slot
+} EventTelem;
+
+//payload of EVT_MODE_CHANGE
+typedef struct
+{
+	unsigned portCHAR	ucTelemetry;	//telemetry frames are downlinked
+	unsigned portCHAR	ucBeacon;		//beacon keys up after each downlink
+} EventMode;
+
+typedef struct
+{
+	EventTopic			enTopic;
+	TaskID				enSrc;
+	unsigned portSHORT	usSize;
+	unsigned portCHAR	ucRefs;		//holders left, only touched by the bus
+	const void			*pvData;	//payload, usSize bytes
+} Event;
+
+/**
+ * \brief Subscribe a task to a topic. The task's event queue is created on
+ * its first subscription and the topic keeps the queue itself, so publishing
+ * does no lookups.
+ *
+ * \param[in] taskToken Task token of subscribing task
+ * \param[in] enTopic Topic to receive
+ *
+ * \returns URC_SUCCESS, URC_BUSY when the topic has no room left or
+ * URC_FAIL for a bad topic or no memory for the queue
+ */
+UnivRetCode enEventSubscribe(TaskToken taskToken, EventTopic enTopic);
+
+/**
+ * \brief Publish to every subscriber of a topic without waiting for them
+ *
+ * \param[in] taskToken Task token of publishing task
+ * \param[in] enTopic Topic published
+ * \param[in] pvData Payload, copied before returning
+ * \param[in] usSize Payload size in bytes
+ *
+ * \returns URC_SUCCESS once queued to all subscribers, URC_BUSY if the
+ * message pool is empty or a subscriber queue was full and missed it
+ */
+UnivRetCode enEventPublish(TaskToken taskToken, EventTopic enTopic, const void *pvData, unsigned portSHORT usSize);
+
+/**
+ * \brief Take the count of publishes a subscriber lost on a topic, to an
+ * empty pool or a full queue. A subscriber that missed one should fetch
+ * the state again from its source, e.g. telemetry storage.
+ *
+ * \param[in] taskToken Task token of subscribing task
+ * \param[in] enTopic Topic subscribed to
+ *
+ * \returns Publishes missed since the last call, the count is cleared
+ */
+unsigned portSHORT usEventTakeMissed(TaskToken taskToken, EventTopic enTopic);
+
+/**
+ * \brief Wait for the next event on any topic the task subscribed to
+ *
+ * \param[in] taskToken Task token of subscribing task
+ * \param[in] block_time Longest time to wait
+ *
+ * \returns Event, to be given back with vEventRelease, or NULL on timeout
+ */
+const Event *pxEventWait(TaskToken taskToken, portTickType block_time);
+
+/**
+ * \brief Done with an event, the payload is freed after its last holder
+ *
+ * \param[in] pxEvent Event from pxEventWait, not usable afterwards
+ */
+void vEventRelease(const Event *pxEvent);
+
+#endif /* EVENTS_H_ */
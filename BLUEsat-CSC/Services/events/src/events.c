@@ -0,0 +1,179 @@
+ /**
+ *  \file events.c
+ *
+ *  \brief Publish/subscribe event bus. A published payload is copied once
+ *  into a pooled message buffer and the same buffer is queued to every
+ *  subscriber, the last subscriber to release it gives it back.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-12 19:30:00 +1000 (Wed, 12 Jun 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note There is no task, publishing runs in the publisher and the
+ *  subscribers wake straight from their own queues.
+ */
+
+#include "service.h"
+#include "task.h"
+#include "queue.h"
+#include "events.h"
+#include "lib_string.h"
+
+static xQueueHandle xEventQueues		[NUM_TASKID];
+static xQueueHandle xTopicSubscribers	[EVT_NUM_TOPICS][EVT_MAX_SUBSCRIBERS];
+static unsigned portCHAR ucTopicCount	[EVT_NUM_TOPICS];
+//publishes each subscriber lost, cleared when it asks
+static unsigned portSHORT usTopicMissed	[EVT_NUM_TOPICS][EVT_MAX_SUBSCRIBERS];
+
+UnivRetCode enEventSubscribe(TaskToken taskToken, EventTopic enTopic)
+{
+	TaskID enTask = enGetTaskID(taskToken);
+	UnivRetCode enResult = URC_SUCCESS;
+	unsigned portCHAR ucIndex;
+
+	if (enTask >= NUM_TASKID || enTopic >= EVT_NUM_TOPICS) return URC_FAIL;
+
+	taskENTER_CRITICAL();
+	{
+		if (xEventQueues[enTask] == NULL)
+		{
+			xEventQueues[enTask] = xQueueCreate(EVT_QUEUE_SIZE, sizeof(Event *));
+		}
+
+		if (xEventQueues[enTask] == NULL)
+		{
+			enResult = URC_FAIL;
+		}
+		else
+		{
+			//subscribing twice still delivers once
+			for (ucIndex = 0; ucIndex < ucTopicCount[enTopic]; ucIndex++)
+			{
+				if (xTopicSubscribers[enTopic][ucIndex] == xEventQueues[enTask]) break;
+			}
+
+			if (ucIndex == ucTopicCount[enTopic])
+			{
+				if (ucIndex < EVT_MAX_SUBSCRIBERS)
+				{
+					xTopicSubscribers[enTopic][ucIndex] = xEventQueues[enTask];
+					usTopicMissed[enTopic][ucIndex] = 0;
+					ucTopicCount[enTopic]++;
+				}
+				else
+				{
+					enResult = URC_BUSY;
+				}
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return enResult;
+}
+
+UnivRetCode enEventPublish(TaskToken taskToken, EventTopic enTopic, const void *pvData, unsigned portSHORT usSize)
+{
+	Event *pxEvent;
+	UnivRetCode enResult = URC_SUCCESS;
+	unsigned portCHAR ucIndex;
+
+	if (enTopic >= EVT_NUM_TOPICS || (pvData == NULL && usSize > 0)) return URC_FAIL;
+	//nobody listening, nothing to copy
+	if (ucTopicCount[enTopic] == 0) return URC_SUCCESS;
+
+	pxEvent = pvMessageAlloc(sizeof(Event) + usSize);
+	if (pxEvent == NULL)
+	{
+		//nobody got it
+		taskENTER_CRITICAL();
+		{
+			for (ucIndex = 0; ucIndex < ucTopicCount[enTopic]; ucIndex++)
+			{
+				usTopicMissed[enTopic][ucIndex]++;
+			}
+		}
+		taskEXIT_CRITICAL();
+		return URC_BUSY;
+	}
+
+	pxEvent->enTopic = enTopic;
+	pxEvent->enSrc = enGetTaskID(taskToken);
+	pxEvent->usSize = usSize;
+	pxEvent->pvData = pxEvent + 1;
+	memcpy((void *)pxEvent->pvData, pvData, usSize);
+
+	//one reference for each subscriber and one held until every queue has
+	//it, so an early subscriber can not free it under the rest
+	pxEvent->ucRefs = ucTopicCount[enTopic] + 1;
+
+	for (ucIndex = 0; ucIndex < ucTopicCount[enTopic]; ucIndex++)
+	{
+		if (xQueueSend(xTopicSubscribers[enTopic][ucIndex], &pxEvent, NO_BLOCK) != pdTRUE)
+		{
+			taskENTER_CRITICAL();
+			{
+				usTopicMissed[enTopic][ucIndex]++;
+			}
+			taskEXIT_CRITICAL();
+			vEventRelease(pxEvent);
+			enResult = URC_BUSY;
+		}
+	}
+	vEventRelease(pxEvent);
+
+	return enResult;
+}
+
+unsigned portSHORT usEventTakeMissed(TaskToken taskToken, EventTopic enTopic)
+{
+	TaskID enTask = enGetTaskID(taskToken);
+	unsigned portSHORT usMissed = 0;
+	unsigned portCHAR ucIndex;
+
+	if (enTask >= NUM_TASKID || enTopic >= EVT_NUM_TOPICS || xEventQueues[enTask] == NULL) return 0;
+
+	taskENTER_CRITICAL();
+	{
+		for (ucIndex = 0; ucIndex < ucTopicCount[enTopic]; ucIndex++)
+		{
+			if (xTopicSubscribers[enTopic][ucIndex] == xEventQueues[enTask])
+			{
+				usMissed = usTopicMissed[enTopic][ucIndex];
+				usTopicMissed[enTopic][ucIndex] = 0;
+				break;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return usMissed;
+}
+
+const Event *pxEventWait(TaskToken taskToken, portTickType block_time)
+{
+	TaskID enTask = enGetTaskID(taskToken);
+	Event *pxEvent;
+
+	if (enTask >= NUM_TASKID || xEventQueues[enTask] == NULL) return NULL;
+
+	if (xQueueReceive(xEventQueues[enTask], &pxEvent, block_time) != pdTRUE) return NULL;
+	return pxEvent;
+}
+
+void vEventRelease(const Event *pxEvent)
+{
+	Event *pxHeld = (Event *)pxEvent;
+	unsigned portCHAR ucRefs;
+
+	if (pxHeld == NULL) return;
+
+	taskENTER_CRITICAL();
+	{
+		ucRefs = --pxHeld->ucRefs;
+	}
+	taskEXIT_CRITICAL();
+
+	if (ucRefs == 0) vMessageFree(pxHeld);
+}
@@ -0,0 +1,83 @@
+ /**
+ *  \file fwUpdate.h
+ *
+ *  \brief Firmware update service. A delta patch uploaded as an object is
+ *  applied against the running image into staging flash, and the staged
+ *  image is copied over the running one on the next boot.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-03 19:30:00 +1000 (Mon, 03 Jun 2013) $
+ *  \warning There is no fallback image. A reset part way through the boot
+ *  copy leaves a mixed image that may not start again.
+ *  \bug No Bugs for now
+ *  \note Patches are made on the ground with Scripts/delta_make.pl and
+ *  uploaded for owner TASK_FWUPDATE. The patch target has to be the image
+ *  exactly as programmed, vector checksum included.
+ */
+
+#ifndef FWUPDATE_H_
+#define FWUPDATE_H_
+
+#include "service.h"
+
+//running image, sectors 0 to 12
+#define FW_IMAGE_ADDR		0x00000000
+#define FW_IMAGE_MAX		0x00030000
+//sector 13 holds the install record, page 0 pending and page 1 committed
+#define FW_RECORD_ADDR		0x00030000
+//sectors 14 to 19 hold the staged image
+#define FW_STAGING_ADDR		0x00038000
+
+typedef enum
+{
+	FW_IDLE,
+	FW_STAGED,		//new image in staging flash and checked
+	FW_PENDING,		//installed at the next boot
+	FW_FAILED		//last patch did not apply, staging is not usable
+} FW_STATE;
+
+/**
+ * \brief Initialise firmware update service
+ *
+ * \param[in] uxPriority Priority for firmware update service.
+ */
+void vFwUpdate_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Install a pending staged image. Called first thing in boot,
+ * before any interrupt is enabled. Does not return if it installs.
+ */
+void vFwUpdate_Install(void);
+
+/**
+ * \brief Apply an uploaded patch to the running image into staging flash
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ucDID Data ID the patch was uploaded to
+ *
+ * \returns URC_SUCCESS once the staged image is checked, URC_FAIL if the
+ * patch is for another image or does not apply
+ */
+UnivRetCode enFwUpdateApply(TaskToken taskToken, unsigned portCHAR ucDID);
+
+/**
+ * \brief Mark the staged image for install and reset shortly after
+ *
+ * \param[in] taskToken Task token from request task
+ *
+ * \returns URC_SUCCESS, URC_FAIL if nothing is staged
+ */
+UnivRetCode enFwUpdateCommit(TaskToken taskToken);
+
+/**
+ * \brief State of the update
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[out] penState Current state
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enFwUpdateStatus(TaskToken taskToken, FW_STATE *penState);
+
+#endif /* FWUPDATE_H_ */
@@ -0,0 +1,379 @@
+ /**
+ *  \file fwUpdate.c
+ *
+ *  \brief Firmware update service. A delta patch uploaded as an object is
+ *  applied against the running image into staging flash, and the staged
+ *  image is copied over the running one on the next boot.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-03 19:30:00 +1000 (Mon, 03 Jun 2013) $
+ *  \warning There is no fallback image. A reset part way through the boot
+ *  copy leaves a mixed image that may not start again.
+ *  \bug No Bugs for now
+ *  \note The boot copy overwrites the code it would otherwise run from, so
+ *  it runs from RAM and calls the IAP in ROM directly. The record sector is
+ *  only erased when the next patch is applied, so an interrupted copy is
+ *  started again on the next boot.
+ */
+
+#include "service.h"
+#include "fwUpdate.h"
+#include "storage.h"
+#include "dltPatch.h"
+#include "iap.h"
+#include "watchdog.h"
+#include "lpc24xx.h"
+#include "debug.h"
+#include "task.h"
+
+#define FWUPDATE_Q_SIZE		1
+
+#define FW_RECORD_MAGIC		0x50555746UL	//"FWUP"
+#define FW_COMMIT_MAGIC		0x454E4F44UL	//"DONE"
+#define FW_RECORD_SECTOR	SECTOR13
+#define FW_STAGING_SECTOR	SECTOR14
+#define FW_BIG_SECTOR_SIZE	0x8000
+#define FW_PAGE				512
+#define FW_BLOCK			4096
+//time for the commit response to go down before the reset
+#define FW_RESET_DELAY		(5000 / portTICK_RATE_MS)
+
+typedef enum
+{
+	FWUPDATE_APPLY,
+	FWUPDATE_COMMIT,
+	FWUPDATE_STATUS
+} FWUPDATE_OPERATIONS;
+
+typedef struct
+{
+	FWUPDATE_OPERATIONS	Operation;
+	unsigned portCHAR	ucDID;
+	FW_STATE			*penState;
+} FwUpdateRequest;
+
+typedef struct
+{
+	unsigned portLONG	ulMagic;
+	unsigned portLONG	ulSize;
+	unsigned portLONG	ulCrc;
+	unsigned portLONG	ulCheck;	//inverted CRC
+} FwRecord;
+
+typedef void (*IAP)(unsigned portLONG *, unsigned portLONG *);
+
+//task token for accessing services
+static TaskToken FwUpdate_TaskToken;
+
+static FW_STATE enState;
+static FwRecord xStaged;
+static dltPatch xPatch;
+//word aligned for the IAP, also the out buffer of the patch
+static unsigned portLONG pulBlock[FW_BLOCK / sizeof(unsigned portLONG)];
+static unsigned portLONG pulCommand[MAX_COMMAND_SIZE];
+static unsigned portLONG pulResult[MAX_RESULT_SIZE];
+
+//prototype for task function
+static portTASK_FUNCTION(vFwUpdateTask, pvParameters);
+static UnivRetCode enFwUpdateStage(unsigned portCHAR ucDID);
+static UnivRetCode enFwUpdateMark(void);
+static unsigned int uiFwPatchRead(void *pvCtx, unsigned long ulOffset, unsigned char *pucBuffer, unsigned int uiSize);
+static UnivRetCode enFwStageWrite(void *pvCtx, unsigned long ulOffset, const unsigned char *pucData, unsigned int uiSize);
+static void vFwUpdateReset(void);
+static UnivRetCode enFwUpdateProcessRequest(TaskToken taskToken, FwUpdateRequest *pxRequest);
+static unsigned portLONG ulFwIap(unsigned portLONG ulCode,
+								unsigned portLONG ulArg1,
+								unsigned portLONG ulArg2,
+								unsigned portLONG ulArg3)
+								__attribute__ ((long_call, section(".fastcode")));
+static void vFwUpdateCopy(unsigned portLONG ulSize) __attribute__ ((long_call, section(".fastcode")));
+
+void vFwUpdate_Init(unsigned portBASE_TYPE uxPriority)
+{
+	enState = FW_IDLE;
+
+	FwUpdate_TaskToken = ActivateTask(TASK_FWUPDATE,
+									"FwUpdate",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vFwUpdateTask);
+
+	vActivateQueue(FwUpdate_TaskToken, FWUPDATE_Q_SIZE);
+}
+
+static portTASK_FUNCTION(vFwUpdateTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	FwUpdateRequest *pxRequest;
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(FwUpdate_TaskToken, &incoming_packet, portMAX_DELAY);
+
+		if (enResult != URC_SUCCESS) continue;
+
+		pxRequest = (FwUpdateRequest *)incoming_packet.Data;
+
+		switch (pxRequest->Operation)
+		{
+			case FWUPDATE_APPLY		:	enResult = enFwUpdateStage(pxRequest->ucDID);
+										break;
+
+			case FWUPDATE_COMMIT	:	enResult = enFwUpdateMark();
+										break;
+
+			case FWUPDATE_STATUS	:	enResult = URC_SUCCESS;
+										break;
+
+			default					:	enResult = URC_FAIL;
+										break;
+		}
+
+		if (pxRequest->penState != NULL) *pxRequest->penState = enState;
+
+		vCompleteRequest(incoming_packet.Token, enResult);
+
+		if (enState == FW_PENDING)
+		{
+			vTaskDelay(FW_RESET_DELAY);
+			vFwUpdateReset();
+		}
+	}
+}
+
+/*
+ * The patch is checked against the running image before anything is
+ * erased, the staged result is checked again as read back from flash.
+ */
+static UnivRetCode enFwUpdateStage(unsigned portCHAR ucDID)
+{
+	dltHeader xHeader;
+
+	if (enState == FW_PENDING) return URC_FAIL;
+
+	dltInit(&xPatch, uiFwPatchRead, enFwStageWrite, &ucDID, (unsigned char *)pulBlock, FW_BLOCK);
+	if (dltReadHeader(&xPatch, &xHeader) != URC_SUCCESS) return URC_FAIL;
+	if (xHeader.sourceSize > FW_IMAGE_MAX || xHeader.targetSize > FW_IMAGE_MAX) return URC_FAIL;
+
+	if (dltCrc32(0, (const unsigned char *)FW_IMAGE_ADDR, xHeader.sourceSize) != xHeader.sourceCrc)
+	{
+		vDebugPrint(FwUpdate_TaskToken, "Patch is not for this image\n\r", NO_INSERT, NO_INSERT, NO_INSERT);
+		return URC_FAIL;
+	}
+
+	//staging is about to change, the old record must not install it
+	enState = FW_FAILED;
+	if (Erase_Sector(FW_RECORD_SECTOR, FW_RECORD_SECTOR) != CMD_SUCCESS) return URC_FAIL;
+
+	if (dltApply(&xPatch, (const unsigned char *)FW_IMAGE_ADDR) != URC_SUCCESS)
+	{
+		vDebugPrint(FwUpdate_TaskToken, "Patch failed at %d bytes\n\r", xPatch.written, NO_INSERT, NO_INSERT);
+		return URC_FAIL;
+	}
+
+	if (dltCrc32(0, (const unsigned char *)FW_STAGING_ADDR, xHeader.targetSize) != xHeader.targetCrc)
+	{
+		vDebugPrint(FwUpdate_TaskToken, "Staged image does not read back\n\r", NO_INSERT, NO_INSERT, NO_INSERT);
+		return URC_FAIL;
+	}
+
+	xStaged.ulMagic = FW_RECORD_MAGIC;
+	xStaged.ulSize = xHeader.targetSize;
+	xStaged.ulCrc = xHeader.targetCrc;
+	xStaged.ulCheck = ~xHeader.targetCrc;
+	enState = FW_STAGED;
+	vDebugPrint(FwUpdate_TaskToken, "Staged %d byte image, CRC %x\n\r", xStaged.ulSize, xStaged.ulCrc, NO_INSERT);
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enFwUpdateMark(void)
+{
+	unsigned int uiIndex;
+
+	if (enState != FW_STAGED) return URC_FAIL;
+
+	for (uiIndex = 0; uiIndex < FW_PAGE / sizeof(unsigned portLONG); uiIndex++) pulBlock[uiIndex] = 0xFFFFFFFF;
+	*(FwRecord *)pulBlock = xStaged;
+
+	if (Ram_To_Flash((void *)FW_RECORD_ADDR, pulBlock, KB_HALF) != CMD_SUCCESS) return URC_FAIL;
+
+	enState = FW_PENDING;
+	vDebugPrint(FwUpdate_TaskToken, "Image installs on reset\n\r", NO_INSERT, NO_INSERT, NO_INSERT);
+	return URC_SUCCESS;
+}
+
+static unsigned int uiFwPatchRead(void *pvCtx, unsigned long ulOffset, unsigned char *pucBuffer, unsigned int uiSize)
+{
+	unsigned portLONG ulRead = 0;
+
+	if (enDataRead(FwUpdate_TaskToken, *(unsigned portCHAR *)pvCtx, ulOffset, uiSize,
+					(portCHAR *)pucBuffer, &ulRead) != URC_SUCCESS) return 0;
+	return ulRead;
+}
+
+/*
+ * Blocks come out of the patch in order, so each staging sector is erased
+ * as the first block for it arrives. pucData is our own block buffer.
+ */
+static UnivRetCode enFwStageWrite(void *pvCtx, unsigned long ulOffset, const unsigned char *pucData, unsigned int uiSize)
+{
+	SECTORS enSector;
+	unsigned char *pucBlock = (unsigned char *)pulBlock;
+
+	(void) pvCtx;
+	(void) pucData;
+
+	if (ulOffset % FW_BIG_SECTOR_SIZE == 0)
+	{
+		enSector = (SECTORS)(FW_STAGING_SECTOR + ulOffset / FW_BIG_SECTOR_SIZE);
+		if (Erase_Sector(enSector, enSector) != CMD_SUCCESS) return URC_FAIL;
+	}
+
+	//the last block is padded out with erased bytes
+	for ( ; uiSize < FW_BLOCK; uiSize++) pucBlock[uiSize] = 0xFF;
+
+	if (Ram_To_Flash((void *)(FW_STAGING_ADDR + ulOffset), pulBlock, KB_FOUR) != CMD_SUCCESS) return URC_FAIL;
+	return URC_SUCCESS;
+}
+
+static void vFwUpdateReset(void)
+{
+	taskDISABLE_INTERRUPTS();
+	WDTC = 0xFF;
+	WDMOD = WDEN | WDRESET;
+	WDFEED = 0xAA;
+	WDFEED = 0x55;
+	for ( ; ; );
+}
+
+void vFwUpdate_Install(void)
+{
+	const FwRecord *pxRecord = (const FwRecord *)FW_RECORD_ADDR;
+	const unsigned portLONG *pulCommit = (const unsigned portLONG *)(FW_RECORD_ADDR + FW_PAGE);
+
+	if (pxRecord->ulMagic != FW_RECORD_MAGIC || pxRecord->ulCheck != ~pxRecord->ulCrc) return;
+	if (*pulCommit == FW_COMMIT_MAGIC) return;
+	if (pxRecord->ulSize > FW_IMAGE_MAX) return;
+
+	//staging went bad since it was checked, keep running what we have
+	if (dltCrc32(0, (const unsigned char *)FW_STAGING_ADDR, pxRecord->ulSize) != pxRecord->ulCrc) return;
+
+	vFwUpdateCopy(pxRecord->ulSize);
+}
+
+/*
+ * RAM only from here, the flash code is being replaced underneath. No
+ * library calls, and the loops copy through volatile pointers so the
+ * compiler does not turn them into calls to memcpy.
+ */
+static unsigned portLONG ulFwIap(unsigned portLONG ulCode,
+								unsigned portLONG ulArg1,
+								unsigned portLONG ulArg2,
+								unsigned portLONG ulArg3)
+{
+	IAP iap_entry = (IAP)IAP_LOCATION;
+
+	pulCommand[0] = ulCode;
+	pulCommand[1] = ulArg1;
+	pulCommand[2] = ulArg2;
+	pulCommand[3] = ulArg3;
+	pulCommand[4] = configCPU_CLOCK_KHZ_RAW;
+	iap_entry(pulCommand, pulResult);
+	return pulResult[0];
+}
+
+static void vFwUpdateCopy(unsigned portLONG ulSize)
+{
+	volatile const unsigned portLONG *pulFrom;
+	volatile unsigned portLONG *pulTo;
+	unsigned portLONG ulOffset;
+	unsigned portLONG ulSector;
+	unsigned portLONG ulIndex;
+	unsigned portLONG ulFailed = 0;
+
+	for (ulOffset = 0; ulOffset < ulSize; ulOffset += FW_BLOCK)
+	{
+		//4K sectors up to 32K, 32K sectors after
+		ulSector = (ulOffset < FW_BIG_SECTOR_SIZE) ? ulOffset / FW_BLOCK
+													: SECTOR8 + (ulOffset - FW_BIG_SECTOR_SIZE) / FW_BIG_SECTOR_SIZE;
+		if (ulOffset < FW_BIG_SECTOR_SIZE || ulOffset % FW_BIG_SECTOR_SIZE == 0)
+		{
+			ulFwIap(PREP_SECT, ulSector, ulSector, 0);
+			ulFwIap(ERASE_SECTS, ulSector, ulSector, 0);
+		}
+
+		pulFrom = (volatile const unsigned portLONG *)(FW_STAGING_ADDR + ulOffset);
+		pulTo = pulBlock;
+		for (ulIndex = 0; ulIndex < FW_BLOCK / sizeof(unsigned portLONG); ulIndex++) pulTo[ulIndex] = pulFrom[ulIndex];
+
+		ulFwIap(PREP_SECT, ulSector, ulSector, 0);
+		ulFwIap(COPY_RAM_TO_FLASH, FW_IMAGE_ADDR + ulOffset, (unsigned portLONG)pulBlock, FW_BLOCK);
+		if (ulFwIap(COMPARE_ADDRS, FW_IMAGE_ADDR + ulOffset, (unsigned portLONG)pulBlock, FW_BLOCK) != CMD_SUCCESS) ulFailed++;
+
+		WDFEED = 0xAA;
+		WDFEED = 0x55;
+	}
+
+	//without the commit page the copy runs again on the next boot
+	if (ulFailed == 0)
+	{
+		pulTo = pulBlock;
+		for (ulIndex = 0; ulIndex < FW_PAGE / sizeof(unsigned portLONG); ulIndex++) pulTo[ulIndex] = 0xFFFFFFFF;
+		pulTo[0] = FW_COMMIT_MAGIC;
+		ulFwIap(PREP_SECT, FW_RECORD_SECTOR, FW_RECORD_SECTOR, 0);
+		ulFwIap(COPY_RAM_TO_FLASH, FW_RECORD_ADDR + FW_PAGE, (unsigned portLONG)pulBlock, FW_PAGE);
+	}
+
+	WDTC = 0xFF;
+	WDMOD = WDEN | WDRESET;
+	WDFEED = 0xAA;
+	WDFEED = 0x55;
+	for ( ; ; );
+}
+
+static UnivRetCode enFwUpdateProcessRequest(TaskToken taskToken, FwUpdateRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_FWUPDATE;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enFwUpdateApply(TaskToken taskToken, unsigned portCHAR ucDID)
+{
+	FwUpdateRequest xRequest;
+
+	xRequest.Operation = FWUPDATE_APPLY;
+	xRequest.ucDID = ucDID;
+	xRequest.penState = NULL;
+
+	return enFwUpdateProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enFwUpdateCommit(TaskToken taskToken)
+{
+	FwUpdateRequest xRequest;
+
+	xRequest.Operation = FWUPDATE_COMMIT;
+	xRequest.penState = NULL;
+
+	return enFwUpdateProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enFwUpdateStatus(TaskToken taskToken, FW_STATE *penState)
+{
+	FwUpdateRequest xRequest;
+
+	xRequest.Operation = FWUPDATE_STATUS;
+	xRequest.penState = penState;
+
+	return enFwUpdateProcessRequest(taskToken, &xRequest);
+}
@@ -0,0 +1,106 @@
+ /**
+ *  \file mailbox.h
+ *
+ *  \brief Store and forward mailbox. Messages uplinked for a callsign are
+ *  kept in internal flash through the storage service and downlinked as
+ *  bulk traffic when the recipient asks for them.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-29 21:15:00 +1000 (Wed, 29 May 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note Each message is one storage object, a MailboxHeader followed by
+ *  the body. The index is rebuilt from those headers at start up and is
+ *  only held in RAM.
+ */
+
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include "service.h"
+#include "mbxIndex.h"
+
+#define MAILBOX_MAX_BODY	1024
+
+typedef struct
+{
+	mbxAddr				xTo;
+	mbxAddr				xFrom;
+	unsigned portSHORT	usSeq;
+	unsigned portSHORT	usSize;		//body bytes following the header
+} MailboxHeader;
+
+/**
+ * \brief Initialise mailbox service
+ *
+ * \param[in] uxPriority Priority for mailbox service.
+ */
+void vMailbox_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Store a message for a recipient
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxTo Recipient
+ * \param[in] pxFrom Sender
+ * \param[in] pcBody Message text
+ * \param[in] usSize Bytes of text, at most MAILBOX_MAX_BODY
+ * \param[out] pusSeq Sequence number given to the message, may be NULL
+ *
+ * \returns URC_SUCCESS, URC_BUSY when the mailbox is full or URC_FAIL
+ */
+UnivRetCode enMailboxPost(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						const mbxAddr *pxFrom,
+						portCHAR *pcBody,
+						unsigned portSHORT usSize,
+						unsigned portSHORT *pusSeq);
+
+/**
+ * \brief List messages waiting for a recipient, oldest first
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxTo Recipient
+ * \param[in] usAfterSeq Only list messages after this one, 0 for all
+ * \param[out] pxEntries Destination for the index entries
+ * \param[in] ucMax Room in pxEntries
+ * \param[out] pucCount Entries written
+ *
+ * \returns URC_SUCCESS or URC_FAIL
+ */
+UnivRetCode enMailboxList(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usAfterSeq,
+						mbxEntry *pxEntries,
+						unsigned portCHAR ucMax,
+						unsigned portCHAR *pucCount);
+
+/**
+ * \brief Downlink a message as bulk frames. The first frame carries the
+ * addresses and size, every frame starts "M<seq>/<part> " in hex.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxTo Recipient
+ * \param[in] usSeq Message to send
+ *
+ * \returns URC_SUCCESS once queued for downlink, URC_FAIL if not found
+ */
+UnivRetCode enMailboxSend(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usSeq);
+
+/**
+ * \brief Remove a message
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxTo Recipient
+ * \param[in] usSeq Message to remove
+ *
+ * \returns URC_SUCCESS or URC_FAIL if not found
+ */
+UnivRetCode enMailboxDelete(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usSeq);
+
+#endif /* MAILBOX_H_ */
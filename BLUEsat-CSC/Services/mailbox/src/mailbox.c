@@ -0,0 +1,374 @@
+ /**
+ *  \file mailbox.c
+ *
+ *  \brief Store and forward mailbox. Messages uplinked for a callsign are
+ *  kept in internal flash through the storage service and downlinked as
+ *  bulk traffic when the recipient asks for them.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-29 21:15:00 +1000 (Wed, 29 May 2013) $
+ *  \warning Storage hands out one object per data ID, so the mailbox
+ *  holds at most MBX_MAX_MSGS messages
+ *  \bug No Bugs for now
+ *  \note Lookups and listings are binary searches on the RAM index, flash
+ *  is only touched for the message itself
+ */
+
+#include "service.h"
+#include "mailbox.h"
+#include "storage.h"
+#include "protocols.h"
+#include "debug.h"
+#include "lib_string.h"
+#include "fmtNum.h"
+
+#define MAILBOX_Q_SIZE		2
+
+//"M<seq>/<part> " ahead of every downlink frame
+#define MAILBOX_PREFIX_SIZE	9
+#define MAILBOX_CHUNK_SIZE	(PROTO_MAX_PAYLOAD - MAILBOX_PREFIX_SIZE)
+
+typedef enum
+{
+	MAILBOX_POST,
+	MAILBOX_LIST,
+	MAILBOX_SEND,
+	MAILBOX_DELETE
+} MAILBOX_OPERATIONS;
+
+typedef struct
+{
+	MAILBOX_OPERATIONS	Operation;
+	const mbxAddr		*pxTo;
+	const mbxAddr		*pxFrom;
+	portCHAR			*pcBody;
+	unsigned portSHORT	usSize;
+	unsigned portSHORT	usSeq;
+	unsigned portSHORT	*pusSeqRet;
+	mbxEntry			*pxEntries;
+	unsigned portCHAR	ucMax;
+	unsigned portCHAR	*pucCountRet;
+} MailboxRequest;
+
+//task token for accessing services
+static TaskToken Mailbox_TaskToken;
+
+static mbxIndex xIndex;
+static portCHAR pcFrame[PROTO_MAX_PAYLOAD];
+
+//prototype for task function
+static portTASK_FUNCTION(vMailboxTask, pvParameters);
+static void vMailboxRebuild(void);
+static UnivRetCode enMailboxStore(MailboxRequest *pxRequest);
+static UnivRetCode enMailboxDownlink(const mbxAddr *pxTo, unsigned portSHORT usSeq);
+static UnivRetCode enMailboxRemove(const mbxAddr *pxTo, unsigned portSHORT usSeq);
+static unsigned portSHORT usMailboxPrefix(unsigned portSHORT usSeq, unsigned portCHAR ucPart);
+static unsigned portSHORT usMailboxAddr(portCHAR *pcOut, const mbxAddr *pxAddr);
+static UnivRetCode enMailboxProcessRequest(TaskToken taskToken, MailboxRequest *pxRequest);
+
+void vMailbox_Init(unsigned portBASE_TYPE uxPriority)
+{
+	mbxInit(&xIndex);
+
+	Mailbox_TaskToken = ActivateTask(TASK_MAILBOX,
+									"Mailbox",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE * 2,
+									vMailboxTask);
+
+	vActivateQueue(Mailbox_TaskToken, MAILBOX_Q_SIZE);
+	//every mailbox request comes from the ground during a pass
+	vSetRequestLane(Mailbox_TaskToken, CMD_LANE_URGENT);
+}
+
+static portTASK_FUNCTION(vMailboxTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	MailboxRequest *pxRequest;
+
+	vMailboxRebuild();
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Mailbox_TaskToken, &incoming_packet, portMAX_DELAY);
+
+		if (enResult != URC_SUCCESS) continue;
+
+		pxRequest = (MailboxRequest *)incoming_packet.Data;
+
+		switch (pxRequest->Operation)
+		{
+			case MAILBOX_POST	:	enResult = enMailboxStore(pxRequest);
+									break;
+
+			case MAILBOX_LIST	:	*(pxRequest->pucCountRet) = mbxList(&xIndex,
+																		pxRequest->pxTo,
+																		pxRequest->usSeq,
+																		pxRequest->pxEntries,
+																		pxRequest->ucMax);
+									enResult = URC_SUCCESS;
+									break;
+
+			case MAILBOX_SEND	:	enResult = enMailboxDownlink(pxRequest->pxTo, pxRequest->usSeq);
+									break;
+
+			case MAILBOX_DELETE	:	enResult = enMailboxRemove(pxRequest->pxTo, pxRequest->usSeq);
+									break;
+
+			default				:	enResult = URC_FAIL;
+									break;
+		}
+
+		vCompleteRequest(incoming_packet.Token, enResult);
+	}
+}
+
+/*
+ * Storage keeps every message under its own data ID, read the headers back
+ * once so the index survives a reset.
+ */
+static void vMailboxRebuild(void)
+{
+	MailboxHeader xHeader;
+	mbxEntry xEntry;
+	unsigned portLONG ulSize;
+	unsigned portLONG ulRead;
+	unsigned portCHAR ucSlot;
+
+	for (ucSlot = 0; ucSlot < MBX_MAX_MSGS; ucSlot++)
+	{
+		if (enDataSize(Mailbox_TaskToken, ucSlot, &ulSize) != URC_SUCCESS) continue;
+		if (ulSize < sizeof(MailboxHeader)) continue;
+		if (enDataRead(Mailbox_TaskToken, ucSlot, 0, sizeof(MailboxHeader),
+						(portCHAR *)&xHeader, &ulRead) != URC_SUCCESS) continue;
+
+		//half written message, drop it
+		if (ulRead != sizeof(MailboxHeader) || ulSize != sizeof(MailboxHeader) + xHeader.usSize)
+		{
+			enDataDelete(Mailbox_TaskToken, ucSlot);
+			continue;
+		}
+
+		xEntry.to = xHeader.xTo;
+		xEntry.seq = xHeader.usSeq;
+		xEntry.size = xHeader.usSize;
+		xEntry.slot = ucSlot;
+		mbxInsert(&xIndex, &xEntry);
+	}
+
+	vDebugPrint(Mailbox_TaskToken, "%d messages waiting\n\r", xIndex.count, NO_INSERT, NO_INSERT);
+}
+
+static UnivRetCode enMailboxStore(MailboxRequest *pxRequest)
+{
+	MailboxHeader xHeader;
+	mbxEntry xEntry;
+	unsigned portCHAR ucSlot;
+
+	if (pxRequest->pxTo == NULL || pxRequest->pxFrom == NULL) return URC_FAIL;
+	if (pxRequest->pcBody == NULL || pxRequest->usSize > MAILBOX_MAX_BODY) return URC_FAIL;
+
+	ucSlot = mbxFreeSlot(&xIndex);
+	if (ucSlot == MBX_NO_SLOT) return URC_BUSY;
+
+	xHeader.xTo = *(pxRequest->pxTo);
+	xHeader.xFrom = *(pxRequest->pxFrom);
+	xHeader.usSeq = xIndex.nextSeq;
+	xHeader.usSize = pxRequest->usSize;
+
+	if (enDataStore(Mailbox_TaskToken, ucSlot, sizeof(MailboxHeader), (portCHAR *)&xHeader) != URC_SUCCESS)
+	{
+		return URC_FAIL;
+	}
+	if (pxRequest->usSize > 0 &&
+		enDataAppend(Mailbox_TaskToken, ucSlot, pxRequest->usSize, pxRequest->pcBody) != URC_SUCCESS)
+	{
+		enDataDelete(Mailbox_TaskToken, ucSlot);
+		return URC_FAIL;
+	}
+
+	xEntry.to = xHeader.xTo;
+	xEntry.seq = xHeader.usSeq;
+	xEntry.size = xHeader.usSize;
+	xEntry.slot = ucSlot;
+	if (mbxInsert(&xIndex, &xEntry) != URC_SUCCESS) return URC_FAIL;
+
+	if (pxRequest->pusSeqRet != NULL) *(pxRequest->pusSeqRet) = xEntry.seq;
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enMailboxDownlink(const mbxAddr *pxTo, unsigned portSHORT usSeq)
+{
+	ProtoRequest xProto;
+	MailboxHeader xHeader;
+	mbxEntry *pxEntry;
+	unsigned portLONG ulOffset;
+	unsigned portLONG ulRead;
+	unsigned portSHORT usLength;
+	unsigned portCHAR ucPart;
+	int iFound;
+
+	iFound = mbxFind(&xIndex, pxTo, usSeq);
+	if (iFound < 0) return URC_FAIL;
+	pxEntry = &xIndex.entries[iFound];
+
+	if (enDataRead(Mailbox_TaskToken, pxEntry->slot, 0, sizeof(MailboxHeader),
+					(portCHAR *)&xHeader, &ulRead) != URC_SUCCESS) return URC_FAIL;
+
+	xProto.ucClass = RED_CLASS_BULK;
+	xProto.ucRepeat = 0;
+	xProto.vNotify = NULL;
+	xProto.pvTag = NULL;
+	xProto.pcData = pcFrame;
+
+	//part 0: "<to> DE <from> <size>"
+	usLength = usMailboxPrefix(usSeq, 0);
+	usLength += usMailboxAddr(&pcFrame[usLength], &xHeader.xTo);
+	memcpy(&pcFrame[usLength], " DE ", 4);
+	usLength += 4;
+	usLength += usMailboxAddr(&pcFrame[usLength], &xHeader.xFrom);
+	pcFrame[usLength++] = ' ';
+	usLength += fmtUnsigned(&pcFrame[usLength], xHeader.usSize, 4);
+	pcFrame[usLength++] = '\r';
+	xProto.usSize = usLength;
+	xProto.ucFlags = (xHeader.usSize == 0) ? PROTO_FLAG_LAST : PROTO_FLAG_NONE;
+	if (enProtoSubmit(Mailbox_TaskToken, &xProto) != URC_SUCCESS) return URC_FAIL;
+
+	for (ulOffset = 0, ucPart = 1; ulOffset < xHeader.usSize; ulOffset += ulRead, ucPart++)
+	{
+		usLength = usMailboxPrefix(usSeq, ucPart);
+		if (enDataRead(Mailbox_TaskToken, pxEntry->slot, sizeof(MailboxHeader) + ulOffset,
+						MAILBOX_CHUNK_SIZE, &pcFrame[usLength], &ulRead) != URC_SUCCESS || ulRead == 0)
+		{
+			return URC_FAIL;
+		}
+		if (ulRead > xHeader.usSize - ulOffset) ulRead = xHeader.usSize - ulOffset;
+
+		xProto.usSize = usLength + ulRead;
+		xProto.ucFlags = (ulOffset + ulRead >= xHeader.usSize) ? PROTO_FLAG_LAST : PROTO_FLAG_NONE;
+		if (enProtoSubmit(Mailbox_TaskToken, &xProto) != URC_SUCCESS) return URC_FAIL;
+	}
+
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enMailboxRemove(const mbxAddr *pxTo, unsigned portSHORT usSeq)
+{
+	unsigned portCHAR ucSlot;
+
+	if (mbxRemove(&xIndex, pxTo, usSeq, &ucSlot) != URC_SUCCESS) return URC_FAIL;
+	return enDataDelete(Mailbox_TaskToken, ucSlot);
+}
+
+static unsigned portSHORT usMailboxPrefix(unsigned portSHORT usSeq, unsigned portCHAR ucPart)
+{
+	static const portCHAR pcHex[] = "0123456789ABCDEF";
+
+	pcFrame[0] = 'M';
+	pcFrame[1] = pcHex[(usSeq >> 12) & 0xF];
+	pcFrame[2] = pcHex[(usSeq >> 8) & 0xF];
+	pcFrame[3] = pcHex[(usSeq >> 4) & 0xF];
+	pcFrame[4] = pcHex[usSeq & 0xF];
+	pcFrame[5] = '/';
+	pcFrame[6] = pcHex[ucPart >> 4];
+	pcFrame[7] = pcHex[ucPart & 0xF];
+	pcFrame[8] = ' ';
+	return MAILBOX_PREFIX_SIZE;
+}
+
+//callsign without padding then -ssid
+static unsigned portSHORT usMailboxAddr(portCHAR *pcOut, const mbxAddr *pxAddr)
+{
+	unsigned portSHORT usLength = 0;
+	unsigned portSHORT usIndex;
+
+	for (usIndex = 0; usIndex < MBX_CALL_SIZE && pxAddr->call[usIndex] != ' '; usIndex++)
+	{
+		pcOut[usLength++] = pxAddr->call[usIndex];
+	}
+	pcOut[usLength++] = '-';
+	usLength += fmtUnsigned(&pcOut[usLength], pxAddr->ssid, 1);
+	return usLength;
+}
+
+static UnivRetCode enMailboxProcessRequest(TaskToken taskToken, MailboxRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_MAILBOX;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enMailboxPost(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						const mbxAddr *pxFrom,
+						portCHAR *pcBody,
+						unsigned portSHORT usSize,
+						unsigned portSHORT *pusSeq)
+{
+	MailboxRequest xRequest;
+
+	xRequest.Operation = MAILBOX_POST;
+	xRequest.pxTo = pxTo;
+	xRequest.pxFrom = pxFrom;
+	xRequest.pcBody = pcBody;
+	xRequest.usSize = usSize;
+	xRequest.pusSeqRet = pusSeq;
+
+	return enMailboxProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enMailboxList(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usAfterSeq,
+						mbxEntry *pxEntries,
+						unsigned portCHAR ucMax,
+						unsigned portCHAR *pucCount)
+{
+	MailboxRequest xRequest;
+
+	if (pxEntries == NULL || pucCount == NULL) return URC_FAIL;
+
+	xRequest.Operation = MAILBOX_LIST;
+	xRequest.pxTo = pxTo;
+	xRequest.usSeq = usAfterSeq;
+	xRequest.pxEntries = pxEntries;
+	xRequest.ucMax = ucMax;
+	xRequest.pucCountRet = pucCount;
+
+	return enMailboxProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enMailboxSend(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usSeq)
+{
+	MailboxRequest xRequest;
+
+	xRequest.Operation = MAILBOX_SEND;
+	xRequest.pxTo = pxTo;
+	xRequest.usSeq = usSeq;
+
+	return enMailboxProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enMailboxDelete(TaskToken taskToken,
+						const mbxAddr *pxTo,
+						unsigned portSHORT usSeq)
+{
+	MailboxRequest xRequest;
+
+	xRequest.Operation = MAILBOX_DELETE;
+	xRequest.pxTo = pxTo;
+	xRequest.usSeq = usSeq;
+
+	return enMailboxProcessRequest(taskToken, &xRequest);
+}
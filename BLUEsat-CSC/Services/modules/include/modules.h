@@ -0,0 +1,102 @@
+ /**
+ *  \file modules.h
+ *
+ *  \brief Loadable module service. Applications packed as modules are
+ *  uploaded into storage, loaded into external RAM and started without
+ *  touching the firmware image.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-05 21:10:00 +1000 (Wed, 05 Jun 2013) $
+ *  \warning A slot is loaded once per boot. External RAM is never given
+ *  back, so a new version of a module starts after the next reset.
+ *  \bug No Bugs for now
+ *  \note Modules are uploaded for owner TASK_MODULES with data ID
+ *  MODULE_DID(slot), and run as task TASK_MODULE_0 plus the slot number.
+ *  They include this header for the export table only, everything in the
+ *  firmware is reached through it.
+ */
+
+#ifndef MODULES_H_
+#define MODULES_H_
+
+#include "FreeRTOS.h"
+#include "command.h"
+#include "UniversalReturnCode.h"
+
+#define MODULE_SLOTS			4
+#define MODULE_SLOT_SIZE		0x4000
+#define MODULE_TASK_PRIORITY	(configMAX_PRIORITIES - 3)		//same as compiled in applications
+#define MODULE_DID(slot)		((slot) + 1)
+
+//bump when entries are added to the end of ModuleExports
+#define MODULE_EXPORTS_VERSION	1
+
+typedef struct
+{
+	unsigned portLONG	ulVersion;
+	TaskToken			(*ActivateTask)(TaskID, portCHAR *, TASK_TYPE, unsigned portBASE_TYPE,
+										unsigned portSHORT, pdTASK_CODE);
+	unsigned portSHORT	(*vActivateQueue)(TaskToken, unsigned portSHORT);
+	UnivRetCode			(*enGetRequest)(TaskToken, MessagePacket *, portTickType);
+	void				(*vCompleteRequest)(TaskToken, UnivRetCode);
+	UnivRetCode			(*enProcessRequest)(MessagePacket *, portTickType);
+	TaskID				(*enGetTaskID)(TaskToken);
+	void				(*vDebugPrint)(TaskToken, portCHAR *, unsigned portLONG,
+										unsigned portLONG, unsigned portLONG);
+	void				(*vTaskDelay)(portTickType);
+	UnivRetCode			(*enDataStore)(TaskToken, unsigned portCHAR, unsigned portLONG, portCHAR *);
+	UnivRetCode			(*enDataRead)(TaskToken, unsigned portCHAR, unsigned portLONG, unsigned portLONG,
+										portCHAR *, unsigned portLONG *);
+	UnivRetCode			(*enDataDelete)(TaskToken, unsigned portCHAR);
+} ModuleExports;
+
+/**
+ * \brief Module entry point, run from the module service. It should
+ * ActivateTask its task with the ID and priority given and return.
+ */
+typedef UnivRetCode (*ModuleEntry)(const ModuleExports *pxExports,
+									TaskID enTaskID,
+									unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Initialise module service, after the memory service
+ *
+ * \param[in] uxPriority Priority for module service.
+ */
+void vModules_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Load the module stored for a slot and run its entry point
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ucSlot Slot number
+ *
+ * \returns URC_SUCCESS, URC_BUSY if the slot is already loaded, URC_FAIL
+ * for a missing or bad module
+ */
+UnivRetCode enModuleLoad(TaskToken taskToken, unsigned portCHAR ucSlot);
+
+/**
+ * \brief Choose whether a slot is loaded at boot
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ucSlot Slot number
+ * \param[in] ucEnable Non zero to load it at boot
+ *
+ * \returns URC_SUCCESS or URC_FAIL
+ */
+UnivRetCode enModuleBoot(TaskToken taskToken, unsigned portCHAR ucSlot, unsigned portCHAR ucEnable);
+
+/**
+ * \brief Slots loaded now and slots loaded at boot, one bit per slot
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[out] pucLoaded Slots running
+ * \param[out] pucBoot Slots loaded at boot
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enModuleStatus(TaskToken taskToken, unsigned portCHAR *pucLoaded, unsigned portCHAR *pucBoot);
+
+#endif /* MODULES_H_ */
@@ -0,0 +1,293 @@
+ /**
+ *  \file modules.c
+ *
+ *  \brief Loadable module service. Applications packed as modules are
+ *  uploaded into storage, loaded into external RAM and started without
+ *  touching the firmware image.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-05 21:10:00 +1000 (Wed, 05 Jun 2013) $
+ *  \warning A slot is loaded once per boot. External RAM is never given
+ *  back, so a new version of a module starts after the next reset.
+ *  \bug No Bugs for now
+ *  \note The slots are taken from external RAM once at start up. The boot
+ *  list is kept in storage so a module turned on from the ground stays on.
+ */
+
+#include "service.h"
+#include "modules.h"
+#include "modImage.h"
+#include "memory.h"
+#include "storage.h"
+#include "lib_string.h"
+#include "debug.h"
+#include "task.h"
+
+#define MODULES_Q_SIZE		2
+//data ID of our own boot list
+#define MODULES_BOOT_DID	0
+//relocations read from storage at a time
+#define MODULES_RELOC_READ	16
+
+typedef enum
+{
+	MODULES_LOAD,
+	MODULES_BOOT,
+	MODULES_STATUS
+} MODULES_OPERATIONS;
+
+typedef struct
+{
+	MODULES_OPERATIONS	Operation;
+	unsigned portCHAR	ucSlot;
+	unsigned portCHAR	ucEnable;
+	unsigned portCHAR	*pucLoaded;
+	unsigned portCHAR	*pucBoot;
+} ModulesRequest;
+
+//task token for accessing services
+static TaskToken Modules_TaskToken;
+
+static unsigned portCHAR *pucSlots[MODULE_SLOTS];
+static unsigned portCHAR ucLoaded;
+static unsigned portCHAR ucBoot;
+
+static void vModuleDebugPrint(TaskToken taskToken,
+							portCHAR *pcFormat,
+							unsigned portLONG ulInsertion_1,
+							unsigned portLONG ulInsertion_2,
+							unsigned portLONG ulInsertion_3);
+
+static const ModuleExports xExports =
+{
+	MODULE_EXPORTS_VERSION,
+	ActivateTask,
+	vActivateQueue,
+	enGetRequest,
+	vCompleteRequest,
+	enProcessRequest,
+	enGetTaskID,
+	vModuleDebugPrint,
+	vTaskDelay,
+	enDataStore,
+	enDataRead,
+	enDataDelete
+};
+
+//prototype for task function
+static portTASK_FUNCTION(vModulesTask, pvParameters);
+static UnivRetCode enModuleStart(unsigned portCHAR ucSlot);
+static UnivRetCode enModuleSetBoot(unsigned portCHAR ucSlot, unsigned portCHAR ucEnable);
+static UnivRetCode enModulesProcessRequest(TaskToken taskToken, ModulesRequest *pxRequest);
+
+void vModules_Init(unsigned portBASE_TYPE uxPriority)
+{
+	unsigned portCHAR ucSlot;
+
+	for (ucSlot = 0; ucSlot < MODULE_SLOTS; ucSlot++)
+	{
+		pucSlots[ucSlot] = pvJMalloc(MODULE_SLOT_SIZE);
+	}
+	ucLoaded = 0;
+	ucBoot = 0;
+
+	Modules_TaskToken = ActivateTask(TASK_MODULES,
+									"Modules",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vModulesTask);
+
+	vActivateQueue(Modules_TaskToken, MODULES_Q_SIZE);
+}
+
+static portTASK_FUNCTION(vModulesTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	ModulesRequest *pxRequest;
+	unsigned portLONG ulRead = 0;
+	unsigned portCHAR ucSlot;
+
+	//modules turned on from the ground come back after a reset
+	enDataRead(Modules_TaskToken, MODULES_BOOT_DID, 0, sizeof(ucBoot), (portCHAR *)&ucBoot, &ulRead);
+	if (ulRead != sizeof(ucBoot)) ucBoot = 0;
+
+	for (ucSlot = 0; ucSlot < MODULE_SLOTS; ucSlot++)
+	{
+		if (ucBoot & (1 << ucSlot)) enModuleStart(ucSlot);
+	}
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Modules_TaskToken, &incoming_packet, portMAX_DELAY);
+
+		if (enResult != URC_SUCCESS) continue;
+
+		pxRequest = (ModulesRequest *)incoming_packet.Data;
+
+		switch (pxRequest->Operation)
+		{
+			case MODULES_LOAD	:	enResult = enModuleStart(pxRequest->ucSlot);
+									break;
+
+			case MODULES_BOOT	:	enResult = enModuleSetBoot(pxRequest->ucSlot, pxRequest->ucEnable);
+									break;
+
+			case MODULES_STATUS	:	enResult = URC_SUCCESS;
+									break;
+
+			default				:	enResult = URC_FAIL;
+									break;
+		}
+
+		if (pxRequest->pucLoaded != NULL) *pxRequest->pucLoaded = ucLoaded;
+		if (pxRequest->pucBoot != NULL) *pxRequest->pucBoot = ucBoot;
+
+		vCompleteRequest(incoming_packet.Token, enResult);
+	}
+}
+
+/*
+ * Everything is checked before the entry point runs. A module that fails
+ * part way leaves its slot unused and can be loaded again once fixed.
+ */
+static UnivRetCode enModuleStart(unsigned portCHAR ucSlot)
+{
+	unsigned portCHAR pucBuffer[MODULES_RELOC_READ * MOD_RELOC_SIZE];
+	unsigned portCHAR *pucLoad;
+	unsigned portLONG ulObjectSize = 0;
+	unsigned portLONG ulRead = 0;
+	unsigned portLONG ulOffset;
+	unsigned portLONG ulIndex;
+	unsigned portLONG ulCount;
+	modHeader xHeader;
+	ModuleEntry xEntry;
+	UnivRetCode enResult;
+
+	if (ucSlot >= MODULE_SLOTS) return URC_FAIL;
+	if (ucLoaded & (1 << ucSlot)) return URC_BUSY;
+	if (pucSlots[ucSlot] == NULL) return URC_FAIL;
+	pucLoad = pucSlots[ucSlot];
+
+	if (enDataSize(Modules_TaskToken, MODULE_DID(ucSlot), &ulObjectSize) != URC_SUCCESS) return URC_FAIL;
+	if (enDataRead(Modules_TaskToken, MODULE_DID(ucSlot), 0, MOD_HEADER_SIZE,
+					(portCHAR *)pucBuffer, &ulRead) != URC_SUCCESS) return URC_FAIL;
+	if (ulRead != MOD_HEADER_SIZE) return URC_FAIL;
+
+	if (modReadHeader(pucBuffer, ulObjectSize, &xHeader) != URC_SUCCESS) return URC_FAIL;
+	if (xHeader.exports > MODULE_EXPORTS_VERSION || modSpace(&xHeader) > MODULE_SLOT_SIZE)
+	{
+		vDebugPrint(Modules_TaskToken, "Module %d does not fit this firmware\n\r", ucSlot, NO_INSERT, NO_INSERT);
+		return URC_FAIL;
+	}
+
+	//code and data straight into the slot, bss cleared after it
+	ulRead = 0;
+	if (enDataRead(Modules_TaskToken, MODULE_DID(ucSlot), MOD_HEADER_SIZE, xHeader.imageSize,
+					(portCHAR *)pucLoad, &ulRead) != URC_SUCCESS) return URC_FAIL;
+	if (ulRead != xHeader.imageSize) return URC_FAIL;
+	memset(&pucLoad[xHeader.imageSize], 0, modSpace(&xHeader) - xHeader.imageSize);
+
+	ulOffset = MOD_HEADER_SIZE + xHeader.imageSize;
+	for (ulIndex = 0; ulIndex < xHeader.relocCount; ulIndex += ulCount)
+	{
+		ulCount = xHeader.relocCount - ulIndex;
+		if (ulCount > MODULES_RELOC_READ) ulCount = MODULES_RELOC_READ;
+
+		ulRead = 0;
+		if (enDataRead(Modules_TaskToken, MODULE_DID(ucSlot), ulOffset + ulIndex * MOD_RELOC_SIZE,
+						ulCount * MOD_RELOC_SIZE, (portCHAR *)pucBuffer, &ulRead) != URC_SUCCESS) return URC_FAIL;
+		if (ulRead != ulCount * MOD_RELOC_SIZE) return URC_FAIL;
+
+		if (modRelocate(pucLoad, &xHeader, pucBuffer, ulCount, (unsigned portLONG)pucLoad) != URC_SUCCESS) return URC_FAIL;
+	}
+
+	xEntry = (ModuleEntry)((unsigned portLONG)pucLoad + xHeader.entry);
+	enResult = xEntry(&xExports, (TaskID)(TASK_MODULE_0 + ucSlot), MODULE_TASK_PRIORITY);
+
+	//the task may exist even when the entry reports a failure, never load over it
+	ucLoaded |= (1 << ucSlot);
+	vDebugPrint(Modules_TaskToken, "Module %d started at %x\n\r", ucSlot, (unsigned portLONG)pucLoad, NO_INSERT);
+
+	return enResult;
+}
+
+static UnivRetCode enModuleSetBoot(unsigned portCHAR ucSlot, unsigned portCHAR ucEnable)
+{
+	unsigned portCHAR ucNew;
+
+	if (ucSlot >= MODULE_SLOTS) return URC_FAIL;
+
+	ucNew = (ucEnable) ? (ucBoot | (1 << ucSlot)) : (ucBoot & ~(1 << ucSlot));
+	if (ucNew == ucBoot) return URC_SUCCESS;
+
+	if (enDataStore(Modules_TaskToken, MODULES_BOOT_DID, sizeof(ucNew), (portCHAR *)&ucNew) != URC_SUCCESS) return URC_FAIL;
+	ucBoot = ucNew;
+	return URC_SUCCESS;
+}
+
+//vDebugPrint can be compiled out, modules still need something to call
+static void vModuleDebugPrint(TaskToken taskToken,
+							portCHAR *pcFormat,
+							unsigned portLONG ulInsertion_1,
+							unsigned portLONG ulInsertion_2,
+							unsigned portLONG ulInsertion_3)
+{
+	(void) taskToken;
+	(void) pcFormat;
+	(void) ulInsertion_1;
+	(void) ulInsertion_2;
+	(void) ulInsertion_3;
+	vDebugPrint(taskToken, pcFormat, ulInsertion_1, ulInsertion_2, ulInsertion_3);
+}
+
+static UnivRetCode enModulesProcessRequest(TaskToken taskToken, ModulesRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_MODULES;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enModuleLoad(TaskToken taskToken, unsigned portCHAR ucSlot)
+{
+	ModulesRequest xRequest;
+
+	xRequest.Operation = MODULES_LOAD;
+	xRequest.ucSlot = ucSlot;
+	xRequest.pucLoaded = NULL;
+	xRequest.pucBoot = NULL;
+
+	return enModulesProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enModuleBoot(TaskToken taskToken, unsigned portCHAR ucSlot, unsigned portCHAR ucEnable)
+{
+	ModulesRequest xRequest;
+
+	xRequest.Operation = MODULES_BOOT;
+	xRequest.ucSlot = ucSlot;
+	xRequest.ucEnable = ucEnable;
+	xRequest.pucLoaded = NULL;
+	xRequest.pucBoot = NULL;
+
+	return enModulesProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enModuleStatus(TaskToken taskToken, unsigned portCHAR *pucLoaded, unsigned portCHAR *pucBoot)
+{
+	ModulesRequest xRequest;
+
+	xRequest.Operation = MODULES_STATUS;
+	xRequest.pucLoaded = pucLoaded;
+	xRequest.pucBoot = pucBoot;
+
+	return enModulesProcessRequest(taskToken, &xRequest);
+}
@@ -0,0 +1,89 @@
+ /**
+ *  \file planner.h
+ *
+ *  \brief Downlink pass planner. Ground station passes are uplinked ahead
+ *  of time, the downlink is encoded and held just before each pass and
+ *  sent in one burst when it opens.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-07 20:40:00 +1000 (Fri, 07 Jun 2013) $
+ *  \warning Passes are in seconds since 2000-01-01 00:00:00 UTC, the RTC
+ *  has to be set with enPlannerSetTime before any of them apply
+ *  \bug No Bugs for now
+ *  \note With no passes, or the clock not set, the phase stays
+ *  PP_PHASE_PASS and the downlink runs on its fixed cadence as before.
+ */
+
+#ifndef PLANNER_H_
+#define PLANNER_H_
+
+#include "service.h"
+#include "ppTable.h"
+
+//frames are encoded and held this long before a pass starts
+#define PLANNER_LEAD		60
+
+/**
+ * \brief Initialise pass planner service
+ *
+ * \param[in] uxPriority Priority for pass planner service.
+ */
+void vPlanner_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Add a ground station pass, the table is kept across resets
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ulStart Acquisition of signal, seconds since 2000
+ * \param[in] ulStop Loss of signal, seconds since 2000
+ *
+ * \returns URC_SUCCESS, URC_FAIL for an empty window, overlap or a full table
+ */
+UnivRetCode enPlannerAdd(TaskToken taskToken, unsigned portLONG ulStart, unsigned portLONG ulStop);
+
+/**
+ * \brief Remove every pass, the downlink goes back to its fixed cadence
+ *
+ * \param[in] taskToken Task token from request task
+ *
+ * \returns URC_SUCCESS or URC_FAIL
+ */
+UnivRetCode enPlannerClear(TaskToken taskToken);
+
+/**
+ * \brief Set the RTC from the ground
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ulSeconds Seconds since 2000
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enPlannerSetTime(TaskToken taskToken, unsigned portLONG ulSeconds);
+
+/**
+ * \brief Pass table size and current time
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[out] pucCount Passes held, may be NULL
+ * \param[out] pulNow Seconds since 2000, 0 while the clock is not set, may be NULL
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enPlannerStatus(TaskToken taskToken, unsigned portCHAR *pucCount, unsigned portLONG *pulNow);
+
+/**
+ * \brief RTC time, safe to call from any task without blocking
+ *
+ * \returns Seconds since 2000, 0 while the clock is not set
+ */
+unsigned portLONG ulPlannerNow(void);
+
+/**
+ * \brief Current phase, safe to call from any task without blocking
+ *
+ * \returns ppPhase of the last planner tick
+ */
+ppPhase enPlannerPhase(void);
+
+#endif /* PLANNER_H_ */
@@ -0,0 +1,267 @@
+ /**
+ *  \file planner.c
+ *
+ *  \brief Downlink pass planner. Ground station passes are uplinked ahead
+ *  of time, the downlink is encoded and held just before each pass and
+ *  sent in one burst when it opens.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-07 20:40:00 +1000 (Fri, 07 Jun 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note The phase is worked out once a second from the RTC. Holding and
+ *  releasing frames is left to the protocols service, the comms task only
+ *  reads the phase to decide when to produce a cycle.
+ */
+
+#include "service.h"
+#include "planner.h"
+#include "protocols.h"
+#include "storage.h"
+#include "rtc.h"
+#include "debug.h"
+
+#define PLANNER_Q_SIZE		2
+#define PLANNER_TICK		(1000 / portTICK_RATE_MS)
+//data ID of the pass table
+#define PLANNER_TABLE_DID	0
+//2000-01-01 was a Saturday
+#define PLANNER_EPOCH_WDAY	6
+
+typedef enum
+{
+	PLANNER_ADD,
+	PLANNER_CLEAR,
+	PLANNER_SET_TIME,
+	PLANNER_STATUS
+} PLANNER_OPERATIONS;
+
+typedef struct
+{
+	PLANNER_OPERATIONS	Operation;
+	unsigned portLONG	ulStart;
+	unsigned portLONG	ulStop;
+	unsigned portCHAR	*pucCount;
+	unsigned portLONG	*pulNow;
+} PlannerRequest;
+
+//task token for accessing services
+static TaskToken Planner_TaskToken;
+
+static ppTable xTable;
+//written by the planner task only, read by anyone
+static volatile ppPhase enPhase;
+
+//prototype for task function
+static portTASK_FUNCTION(vPlannerTask, pvParameters);
+static void vPlannerUpdate(void);
+static void vPlannerSave(void);
+static void vPlannerSetTime(unsigned portLONG ulSeconds);
+static UnivRetCode enPlannerProcessRequest(TaskToken taskToken, PlannerRequest *pxRequest);
+
+void vPlanner_Init(unsigned portBASE_TYPE uxPriority)
+{
+	ppInit(&xTable);
+	enPhase = PP_PHASE_PASS;
+
+	Planner_TaskToken = ActivateTask(TASK_PLANNER,
+									"Planner",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vPlannerTask);
+
+	vActivateQueue(Planner_TaskToken, PLANNER_Q_SIZE);
+}
+
+static portTASK_FUNCTION(vPlannerTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	PlannerRequest *pxRequest;
+	unsigned portLONG ulRead = 0;
+
+	//passes uplinked before a reset still apply
+	enDataRead(Planner_TaskToken, PLANNER_TABLE_DID, 0, sizeof(xTable), (portCHAR *)&xTable, &ulRead);
+	if (ulRead != sizeof(xTable) || xTable.count > PP_MAX_PASSES) ppInit(&xTable);
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Planner_TaskToken, &incoming_packet, PLANNER_TICK);
+
+		if (enResult == URC_SUCCESS)
+		{
+			pxRequest = (PlannerRequest *)incoming_packet.Data;
+
+			switch (pxRequest->Operation)
+			{
+				case PLANNER_ADD		:	enResult = ppAdd(&xTable, pxRequest->ulStart, pxRequest->ulStop);
+											if (enResult == URC_SUCCESS) vPlannerSave();
+											break;
+
+				case PLANNER_CLEAR		:	ppInit(&xTable);
+											vPlannerSave();
+											enResult = URC_SUCCESS;
+											break;
+
+				case PLANNER_SET_TIME	:	vPlannerSetTime(pxRequest->ulStart);
+											enResult = URC_SUCCESS;
+											break;
+
+				case PLANNER_STATUS		:	enResult = URC_SUCCESS;
+											break;
+
+				default					:	enResult = URC_FAIL;
+											break;
+			}
+
+			if (pxRequest->pucCount != NULL) *pxRequest->pucCount = (unsigned portCHAR)xTable.count;
+			if (pxRequest->pulNow != NULL) *pxRequest->pulNow = ulPlannerNow();
+
+			vCompleteRequest(incoming_packet.Token, enResult);
+		}
+
+		vPlannerUpdate();
+	}
+}
+
+/*
+ * Frames are held from the start of the lead until the pass opens, any
+ * other change of phase lets them go.
+ */
+static void vPlannerUpdate(void)
+{
+	unsigned portLONG ulNow = ulPlannerNow();
+	ppPhase enNew;
+
+	if (ulNow != 0 && ppExpire(&xTable, ulNow) > 0) vPlannerSave();
+
+	if (ulNow == 0 || xTable.count == 0)
+	{
+		enNew = PP_PHASE_PASS;
+	}
+	else
+	{
+		enNew = ppGetPhase(&xTable, ulNow, PLANNER_LEAD, NULL);
+	}
+
+	if (enNew == enPhase) return;
+
+	if (enNew == PP_PHASE_STAGE)
+	{
+		enProtoHold(Planner_TaskToken, pdTRUE);
+	}
+	else if (enPhase == PP_PHASE_STAGE)
+	{
+		enProtoHold(Planner_TaskToken, pdFALSE);
+	}
+
+	vDebugPrint(Planner_TaskToken, "Phase %d at %d\n\r", enNew, ulNow, NO_INSERT);
+	enPhase = enNew;
+}
+
+static void vPlannerSave(void)
+{
+	UnivRetCode enResult;
+
+	if (xTable.count == 0)
+	{
+		enResult = enDataDelete(Planner_TaskToken, PLANNER_TABLE_DID);
+	}
+	else
+	{
+		enResult = enDataStore(Planner_TaskToken, PLANNER_TABLE_DID, sizeof(xTable), (portCHAR *)&xTable);
+	}
+
+	if (enResult != URC_SUCCESS)
+	{
+		vDebugPrint(Planner_TaskToken, "Pass table not saved\n\r", NO_INSERT, NO_INSERT, NO_INSERT);
+	}
+}
+
+unsigned portLONG ulPlannerNow(void)
+{
+	rtc_time_t xTime;
+
+	rtc_get_current_time(&xTime);
+
+	return ppSeconds(xTime.rtcYear, xTime.rtcMon, xTime.rtcMday, xTime.rtcHour, xTime.rtcMin, xTime.rtcSec);
+}
+
+static void vPlannerSetTime(unsigned portLONG ulSeconds)
+{
+	rtc_time_t xTime;
+
+	ppCalendar(ulSeconds, &xTime.rtcYear, &xTime.rtcMon, &xTime.rtcMday,
+				&xTime.rtcHour, &xTime.rtcMin, &xTime.rtcSec);
+	xTime.rtcWday = (ulSeconds / 86400 + PLANNER_EPOCH_WDAY) % 7;
+	xTime.rtcYday = (ulSeconds - ppSeconds(xTime.rtcYear, 1, 1, 0, 0, 0)) / 86400 + 1;
+
+	rtc_set_current_time(xTime);
+}
+
+static UnivRetCode enPlannerProcessRequest(TaskToken taskToken, PlannerRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_PLANNER;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enPlannerAdd(TaskToken taskToken, unsigned portLONG ulStart, unsigned portLONG ulStop)
+{
+	PlannerRequest xRequest;
+
+	xRequest.Operation = PLANNER_ADD;
+	xRequest.ulStart = ulStart;
+	xRequest.ulStop = ulStop;
+	xRequest.pucCount = NULL;
+	xRequest.pulNow = NULL;
+
+	return enPlannerProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enPlannerClear(TaskToken taskToken)
+{
+	PlannerRequest xRequest;
+
+	xRequest.Operation = PLANNER_CLEAR;
+	xRequest.pucCount = NULL;
+	xRequest.pulNow = NULL;
+
+	return enPlannerProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enPlannerSetTime(TaskToken taskToken, unsigned portLONG ulSeconds)
+{
+	PlannerRequest xRequest;
+
+	xRequest.Operation = PLANNER_SET_TIME;
+	xRequest.ulStart = ulSeconds;
+	xRequest.pucCount = NULL;
+	xRequest.pulNow = NULL;
+
+	return enPlannerProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enPlannerStatus(TaskToken taskToken, unsigned portCHAR *pucCount, unsigned portLONG *pulNow)
+{
+	PlannerRequest xRequest;
+
+	xRequest.Operation = PLANNER_STATUS;
+	xRequest.pucCount = pucCount;
+	xRequest.pulNow = pulNow;
+
+	return enPlannerProcessRequest(taskToken, &xRequest);
+}
+
+ppPhase enPlannerPhase(void)
+{
+	return enPhase;
+}
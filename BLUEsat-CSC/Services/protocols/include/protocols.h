@@ -0,0 +1,109 @@
+ /**
+ *  \file protocols.h
+ *
+ *  \brief Protocol stack service. Producers hand over payloads, the
+ *  service encodes them into pooled frame buffers and queues those to the
+ *  modem while the next payload is being encoded.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-25 16:20:00 +1000 (Sat, 25 May 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note No Notes for now
+ */
+
+#ifndef PROTOCOLS_H_
+#define PROTOCOLS_H_
+
+#include "service.h"
+#include "redundancy.h"
+#include "ax25Config.h"
+
+//number of encoded frame buffers shared by all producers
+#define PROTO_POOL_SIZE			4
+//room for TXDELAY, two copies of a full frame with stuffing and TXTAIL
+#define PROTO_FRAME_BUFF_SIZE	640
+
+//request flags
+#define PROTO_FLAG_NONE			0x00
+#define PROTO_FLAG_LAST			0x01	//end of burst, TXTAIL is appended
+#define PROTO_FLAG_HOLD			0x02	//control only, see enProtoHold
+#define PROTO_FLAG_RELEASE		0x04
+
+/**
+ * \brief Notification that a submitted payload has left the modem, run from
+ * the protocols task. Must not block.
+ */
+typedef void (*ProtoNotify)(void *pvTag, UnivRetCode enResult);
+
+//every info field starts "#csq " with class digit c and hex sequence number sq,
+//the ground station reports sequence gaps per class back to us
+#define PROTO_SEQ_HEADER_SIZE	5
+#define PROTO_MAX_PAYLOAD		(SIZE_ACT_INFO - PROTO_SEQ_HEADER_SIZE)
+
+typedef struct
+{
+	portCHAR			*pcData;	//only needs to stay valid until submit returns
+	unsigned portSHORT	usSize;		//at most PROTO_MAX_PAYLOAD
+	unsigned portCHAR	ucClass;	//redClass, picks redundancy and sequence
+	unsigned portCHAR	ucRepeat;	//copies sent back to back, 0 lets the class decide
+	unsigned portCHAR	ucFlags;
+	ProtoNotify			vNotify;	//may be NULL
+	void				*pvTag;
+} ProtoRequest;
+
+/**
+ * \brief Initialise protocol stack service
+ *
+ * \param[in] uxPriority Priority for protocol stack service.
+ */
+void vProtocols_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Encode a payload as AX.25 UI frames and queue it for downlink.
+ * Returns once the payload is encoded, before it is transmitted.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxRequest Payload and notification details
+ *
+ * \returns URC_SUCCESS once queued, URC_BUSY if the service is backed up
+ */
+UnivRetCode enProtoSubmit(TaskToken taskToken, ProtoRequest *pxRequest);
+
+/**
+ * \brief Hold encoded frames back instead of sending them, or release
+ * everything held. Holds are counted, every hold needs its own release and
+ * frames go out after the last one. Released frames go out back to back
+ * behind a single TXDELAY, status class first, then telemetry, then bulk.
+ * Producers block in enProtoSubmit once every pool buffer is held. Frames
+ * already given to the modem still go out.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] xHoldFrames pdTRUE to hold, pdFALSE to release
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enProtoHold(TaskToken taskToken, portBASE_TYPE xHoldFrames);
+
+/**
+ * \brief Frame loss reported by the ground station for one pass. Safe to
+ * call from any task, it does not go through the protocols task queue.
+ *
+ * \param[in] ucClass Traffic class the report is for
+ * \param[in] ulExpected Sequence numbers spanned during the pass
+ * \param[in] ulLost Sequence numbers missing
+ *
+ * \returns URC_SUCCESS or URC_FAIL for a bad report
+ */
+UnivRetCode enProtoFeedback(unsigned portCHAR ucClass, unsigned portLONG ulExpected, unsigned portLONG ulLost);
+
+/**
+ * \brief Copy out the redundancy choice and audit counters of a class
+ *
+ * \param[in] ucClass Traffic class
+ * \param[out] pxState Destination for the snapshot
+ */
+void vProtoGetRedundancy(unsigned portCHAR ucClass, redClassState *pxState);
+
+#endif /* PROTOCOLS_H_ */
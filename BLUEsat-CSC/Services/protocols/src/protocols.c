@@ -0,0 +1,475 @@
+ /**
+ *  \file protocols.c
+ *
+ *  \brief Protocol stack service. Producers hand over payloads, the
+ *  service encodes them into pooled frame buffers and queues those to the
+ *  modem while the next payload is being encoded.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-25 16:20:00 +1000 (Sat, 25 May 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note The pipeline has three stages. A producer request is accepted by
+ *  the task queue, the task encodes it into a free pool buffer and hands the
+ *  buffer to the modem, and the modem interrupt hands the buffer back through
+ *  a completion ring and wakes the task. No stage polls the next one. While held, encoded
+ *  frames are kept back and go out together, highest value class first,
+ *  when released.
+ */
+
+#include "service.h"
+#include "protocols.h"
+#include "ax25.h"
+#include "modem.h"
+#include "channel.h"
+#include "lib_string.h"
+#include "debug.h"
+#include "task.h"
+#include "ring.h"
+
+#define AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE 0xF0
+
+//producer requests plus a wake up from the modem interrupt, more wake ups
+//are not needed while one is queued
+#define PROTO_Q_SIZE	(PROCTOCOLS_Q_SIZE + 1)
+
+//tx done slots, a power of two with room for every pool buffer and the
+//preamble, the most the modem can ever have to hand back
+#define PROTO_DONE_SLOTS	8
+#if (PROTO_POOL_SIZE + 1) > PROTO_DONE_SLOTS
+	#error "PROTO_DONE_SLOTS must cover the frame pool and the preamble"
+#endif
+
+typedef struct
+{
+	portCHAR			cData[PROTO_FRAME_BUFF_SIZE];
+	unsigned portSHORT	usLength;
+	unsigned portCHAR	ucClass;
+	portBASE_TYPE		xFollows;	//opened with one flag, needs the modem still sending
+	ProtoNotify			vNotify;
+	void				*pvTag;
+} ProtoFrame;
+
+//task token for accessing services
+static TaskToken Protocols_TaskToken;
+
+static ProtoFrame xFramePool[PROTO_POOL_SIZE];
+static ProtoFrame *pxFreeFrames[PROTO_POOL_SIZE];
+static unsigned portBASE_TYPE uxFreeCount;
+//frames handed to the modem that have not come back yet
+static unsigned portBASE_TYPE uxInFlight;
+//tags of sent frames, filled by the modem interrupt and drained by the task
+static void *pvDoneStorage[PROTO_DONE_SLOTS];
+static ringBuffer xDoneRing;
+
+//repeat count and sequence numbers per traffic class
+static redController xRedundancy;
+
+//frames encoded while held, in send order. Holds are counted, the planner
+//and a BERT run may overlap and frames go out after the last release
+static unsigned portBASE_TYPE uxHolds;
+static ProtoFrame *pxStaged[PROTO_POOL_SIZE];
+static unsigned portBASE_TYPE uxStagedCount;
+//TXDELAY queued ahead of a one flag frame that finds the modem idle
+static portCHAR pcPreamble[TXDELAY_FLAGS];
+//send order of the staged classes, responses then telemetry then bulk
+static const unsigned portCHAR ucClassRank[RED_NUM_CLASSES] = { 1, 0, 2 };
+
+//requests waiting for a pool buffer, their producers are still blocked
+static MessagePacket xDeferred[PROCTOCOLS_Q_SIZE];
+static unsigned portBASE_TYPE uxDeferredHead;
+static unsigned portBASE_TYPE uxDeferredCount;
+
+//prototype for task function
+static portTASK_FUNCTION(vProtocolsTask, pvParameters);
+static void vProtoTxDone(void *pvTag, signed portBASE_TYPE *pxHigherPriorityTaskWoken);
+static void vProtoDrainDone(void);
+static void vProtoProcessRequest(MessagePacket *pxPacket);
+static UnivRetCode enProtoEncode(ProtoRequest *pxRequest, ProtoFrame *pxFrame);
+static void vProtoStage(ProtoFrame *pxFrame);
+static void vProtoSendStaged(void);
+static portBASE_TYPE xProtoQueueFrame(ProtoFrame *pxFrame);
+
+void vProtocols_Init(unsigned portBASE_TYPE uxPriority)
+{
+	unsigned portBASE_TYPE uxIndex;
+
+	for (uxIndex = 0; uxIndex < PROTO_POOL_SIZE; uxIndex++)
+	{
+		pxFreeFrames[uxIndex] = &xFramePool[uxIndex];
+	}
+	uxFreeCount = PROTO_POOL_SIZE;
+	uxInFlight = 0;
+	uxDeferredHead = 0;
+	uxDeferredCount = 0;
+	uxHolds = 0;
+	uxStagedCount = 0;
+	memset(pcPreamble, FLAG, TXDELAY_FLAGS);
+	ringInit(&xDoneRing, (unsigned char *)pvDoneStorage, sizeof(pvDoneStorage));
+	redInit(&xRedundancy);
+
+	Protocols_TaskToken = ActivateTask(TASK_PROTOCOLS,
+										"Protocols",
+										SEV_TASK_TYPE,
+										uxPriority,
+										512,
+										vProtocolsTask);
+
+	//no task to drain completions, the modem keeps no hook
+	if (Protocols_TaskToken == NULL) return;
+
+	vActivateQueue(Protocols_TaskToken, PROTO_Q_SIZE);
+
+	Comms_Modem_Set_TxDone_Hook(vProtoTxDone);
+}
+
+static portTASK_FUNCTION(vProtocolsTask, pvParameters)
+{
+	(void) pvParameters;
+	MessagePacket incoming_packet;
+
+	vSetToken(Protocols_TaskToken);
+
+	for ( ; ; )
+	{
+		//every pass, a completion whose wake up found the queue full is
+		//picked up behind the request that filled it
+		vProtoDrainDone();
+
+		if (enGetRequest(Protocols_TaskToken, &incoming_packet, portMAX_DELAY) != URC_SUCCESS) continue;
+
+		if (incoming_packet.Token == NULL && incoming_packet.Src == TASK_PROTOCOLS)
+		{
+			//wake up from the modem interrupt, the work is in the ring
+			continue;
+		}
+		else if (((ProtoRequest *)incoming_packet.Data)->pcData == NULL &&
+				(((ProtoRequest *)incoming_packet.Data)->ucFlags & (PROTO_FLAG_HOLD | PROTO_FLAG_RELEASE)))
+		{
+			//hold and release need no buffer, they are never deferred
+			if (((ProtoRequest *)incoming_packet.Data)->ucFlags & PROTO_FLAG_HOLD)
+			{
+				uxHolds++;
+			}
+			else if (uxHolds > 0)
+			{
+				uxHolds--;
+			}
+			if (uxHolds == 0) vProtoSendStaged();
+			vCompleteRequest(incoming_packet.Token, URC_SUCCESS);
+		}
+		else
+		{
+			vProtoProcessRequest(&incoming_packet);
+		}
+	}
+}
+
+/*
+ * Hand back every frame the modem has finished, no frame for the preamble.
+ */
+static void vProtoDrainDone(void)
+{
+	ProtoFrame *pxFrame;
+
+	while (ringPop(&xDoneRing, (unsigned char *)&pxFrame, sizeof(pxFrame)) == sizeof(pxFrame))
+	{
+		uxInFlight--;
+
+		if (pxFrame != NULL)
+		{
+			if (pxFrame->vNotify != NULL) pxFrame->vNotify(pxFrame->pvTag, URC_SUCCESS);
+			pxFreeFrames[uxFreeCount++] = pxFrame;
+		}
+
+		//modem queue is shorter than the pool, top it up from staging
+		if (uxHolds == 0) vProtoSendStaged();
+
+		if (uxInFlight == 0) vChannel_Release();
+
+		//a buffer is free again, serve the oldest waiting producer. The
+		//preamble hands no buffer back, the pool may still be empty
+		if (uxDeferredCount > 0 && uxFreeCount > 0)
+		{
+			uxDeferredCount--;
+			vProtoProcessRequest(&xDeferred[uxDeferredHead]);
+			uxDeferredHead = (uxDeferredHead + 1) % PROCTOCOLS_Q_SIZE;
+		}
+	}
+}
+
+/*
+ * Encode a request into a free pool buffer and hand it to the modem, or
+ * defer it while the pool is empty. The producer is released as soon as
+ * the encoder is done with its data.
+ */
+static void vProtoProcessRequest(MessagePacket *pxPacket)
+{
+	ProtoRequest *pxRequest = (ProtoRequest *)pxPacket->Data;
+	ProtoFrame *pxFrame;
+	UnivRetCode enResult;
+
+	//hold the producer until a frame buffer comes back
+	if (uxFreeCount == 0)
+	{
+		if (uxDeferredCount < PROCTOCOLS_Q_SIZE)
+		{
+			xDeferred[(uxDeferredHead + uxDeferredCount) % PROCTOCOLS_Q_SIZE] = *pxPacket;
+			uxDeferredCount++;
+		}
+		else
+		{
+			vCompleteRequest(pxPacket->Token, URC_BUSY);
+		}
+		return;
+	}
+	pxFrame = pxFreeFrames[--uxFreeCount];
+
+	enResult = enProtoEncode(pxRequest, pxFrame);
+	vCompleteRequest(pxPacket->Token, enResult);
+
+	if (enResult != URC_SUCCESS)
+	{
+		pxFreeFrames[uxFreeCount++] = pxFrame;
+		return;
+	}
+
+	if (uxHolds != 0)
+	{
+		vProtoStage(pxFrame);
+		return;
+	}
+
+	//frames the modem could not take yet stay ahead of this one
+	if (uxStagedCount != 0)
+	{
+		vProtoStage(pxFrame);
+		vProtoSendStaged();
+		return;
+	}
+
+	//first frame of a transmission claims the channel
+	if (uxInFlight == 0)
+	{
+		if (enChannel_Acquire(CHANNEL_DEF_MAX_WAIT) != URC_SUCCESS)
+		{
+			vDebugPrint(Protocols_TaskToken, "Channel busy, forcing TX\r\n", NO_INSERT, NO_INSERT, NO_INSERT);
+		}
+	}
+
+	if (xProtoQueueFrame(pxFrame) == pdTRUE) return;
+
+	//a preamble can take the modem slot this frame needed, the queue only
+	//fills with frames on air, so stage it for the next tx done to send
+	vProtoStage(pxFrame);
+	if (uxInFlight == 0) vChannel_Release();
+}
+
+/*
+ * A frame opens with TXDELAY when the modem is idle and one flag when it
+ * follows a frame still on air, as the modem tells it rather than our own
+ * count which lags the interrupt, and ends with TXTAIL when the producer
+ * marks it last. Every copy carries the same class and sequence header so
+ * the ground station can tell repeats from gaps.
+ */
+static UnivRetCode enProtoEncode(ProtoRequest *pxRequest, ProtoFrame *pxFrame)
+{
+	static const portCHAR pcHex[] = "0123456789ABCDEF";
+	portCHAR pcInfo[PROTO_SEQ_HEADER_SIZE + PROTO_MAX_PAYLOAD];
+	stateBlock present;
+	burstBlock burst;
+	unsigned int uiSize;
+	unsigned portCHAR ucCopy;
+	unsigned portCHAR ucRepeat;
+	unsigned portCHAR ucSeq;
+
+	if (pxRequest == NULL || pxRequest->pcData == NULL || pxRequest->usSize == 0) return URC_FAIL;
+	if (pxRequest->usSize > PROTO_MAX_PAYLOAD || pxRequest->ucClass >= RED_NUM_CLASSES) return URC_FAIL;
+
+	taskENTER_CRITICAL();
+	{
+		ucRepeat = redNextFrame(&xRedundancy, (redClass)pxRequest->ucClass, &ucSeq);
+	}
+	taskEXIT_CRITICAL();
+	if (pxRequest->ucRepeat != 0) ucRepeat = pxRequest->ucRepeat;
+
+	pcInfo[0] = '#';
+	pcInfo[1] = '0' + pxRequest->ucClass;
+	pcInfo[2] = pcHex[ucSeq >> 4];
+	pcInfo[3] = pcHex[ucSeq & 0xF];
+	pcInfo[4] = ' ';
+	memcpy (&pcInfo[PROTO_SEQ_HEADER_SIZE], pxRequest->pcData, pxRequest->usSize);
+
+	present.src = pcInfo;
+	present.srcSize = PROTO_SEQ_HEADER_SIZE + pxRequest->usSize;
+	memcpy (present.route.dest.callSign,"BLUSAT",CALLSIGN_SIZE);
+	memcpy (present.route.src.callSign, "BLUEGS",CALLSIGN_SIZE);
+	present.route.dest.callSignSize = 6;
+	present.route.src.callSignSize = 6;
+	present.route.dest.ssid = 1;
+	present.route.src.ssid = 1;
+	present.route.repeats  = NULL;
+	present.route.totalRepeats = 0;
+	present.route.type = Response;
+	present.presState = stateless;
+	present.pid = AX25_PID_NO_LAYER3_PROTOCOL_UI_MODE;
+	present.packetCnt = 0;
+	present.nxtIndex = 0;
+	present.mode = unconnected;
+	present.completed = false;
+
+	//staged frames get their TXDELAY queued ahead of them when released
+	pxFrame->xFollows = (uxHolds != 0 || Comms_Modem_Is_Sending()) ? pdTRUE : pdFALSE;
+
+	memset (pxFrame->cData, 0, PROTO_FRAME_BUFF_SIZE);
+	if (ax25BurstStart (&burst, pxFrame->cData, PROTO_FRAME_BUFF_SIZE,
+						(pxFrame->xFollows) ? 1 : TXDELAY_FLAGS) != generationSuccess) return URC_FAIL;
+
+	for (ucCopy = 0; ucCopy < ucRepeat; ucCopy++)
+	{
+		present.nxtIndex = 0;
+		if (ax25BurstAdd (&burst, &present) != generationSuccess)
+		{
+			//long payloads may not fit every copy, send the ones that do
+			if (ucCopy == 0) return URC_FAIL;
+			break;
+		}
+	}
+
+	//staged frames are reordered, any of them may end up last
+	if (ax25BurstEnd (&burst, ((pxRequest->ucFlags & PROTO_FLAG_LAST) || uxHolds != 0) ? TXTAIL_FLAGS : 0,
+						&uiSize) != generationSuccess) return URC_FAIL;
+
+	pxFrame->usLength = (unsigned portSHORT)uiSize;
+	pxFrame->ucClass = pxRequest->ucClass;
+	pxFrame->vNotify = pxRequest->vNotify;
+	pxFrame->pvTag = pxRequest->pvTag;
+	return URC_SUCCESS;
+}
+
+//after any staged frame of the same or higher value
+static void vProtoStage(ProtoFrame *pxFrame)
+{
+	unsigned portBASE_TYPE uxPlace;
+
+	for (uxPlace = uxStagedCount; uxPlace > 0; uxPlace--)
+	{
+		if (ucClassRank[pxStaged[uxPlace - 1]->ucClass] <= ucClassRank[pxFrame->ucClass]) break;
+		pxStaged[uxPlace] = pxStaged[uxPlace - 1];
+	}
+	pxStaged[uxPlace] = pxFrame;
+	uxStagedCount++;
+}
+
+static void vProtoSendStaged(void)
+{
+	unsigned portBASE_TYPE uxIndex;
+
+	if (uxStagedCount == 0) return;
+
+	if (uxInFlight == 0)
+	{
+		if (enChannel_Acquire(CHANNEL_DEF_MAX_WAIT) != URC_SUCCESS)
+		{
+			vDebugPrint(Protocols_TaskToken, "Channel busy, forcing TX\r\n", NO_INSERT, NO_INSERT, NO_INSERT);
+		}
+	}
+
+	while (uxStagedCount > 0 && xProtoQueueFrame(pxStaged[0]) == pdTRUE)
+	{
+		uxStagedCount--;
+		for (uxIndex = 0; uxIndex < uxStagedCount; uxIndex++) pxStaged[uxIndex] = pxStaged[uxIndex + 1];
+	}
+
+	//nothing went out, nothing will come back to release our claim
+	if (uxInFlight == 0) vChannel_Release();
+}
+
+/*
+ * Hand a frame to the modem. One encoded to follow a frame that has since
+ * left the modem gets the TXDELAY queued ahead of it. The timer interrupt
+ * can not finish a frame between the look and the queue.
+ */
+static portBASE_TYPE xProtoQueueFrame(ProtoFrame *pxFrame)
+{
+	portBASE_TYPE xQueued;
+
+	portENTER_CRITICAL();
+	{
+		if (pxFrame->xFollows && !Comms_Modem_Is_Sending() &&
+			Comms_Modem_Queue_Frame(pcPreamble, TXDELAY_FLAGS, NULL) == pdTRUE) uxInFlight++;
+
+		xQueued = Comms_Modem_Queue_Frame(pxFrame->cData, pxFrame->usLength, pxFrame);
+		if (xQueued == pdTRUE) uxInFlight++;
+	}
+	portEXIT_CRITICAL();
+
+	return xQueued;
+}
+
+UnivRetCode enProtoHold(TaskToken taskToken, portBASE_TYPE xHoldFrames)
+{
+	ProtoRequest xRequest;
+
+	xRequest.pcData = NULL;
+	xRequest.usSize = 0;
+	xRequest.ucFlags = (xHoldFrames) ? PROTO_FLAG_HOLD : PROTO_FLAG_RELEASE;
+
+	return enProtoSubmit(taskToken, &xRequest);
+}
+
+/*
+ * Modem interrupt context. The tag goes into the completion ring, which
+ * can not fill, then a wake up onto our queue. A wake up that does not fit
+ * is not needed, a full queue keeps the task running through the ring.
+ */
+static void vProtoTxDone(void *pvTag, signed portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+	MessagePacket outgoing_packet;
+
+	ringPush(&xDoneRing, (unsigned char *)&pvTag, sizeof(pvTag));
+
+	outgoing_packet.Token = NULL;
+	outgoing_packet.Src = TASK_PROTOCOLS;
+	outgoing_packet.Dest = TASK_PROTOCOLS;
+	outgoing_packet.Data = 0;
+
+	enPostRequestFromISR(&outgoing_packet, pxHigherPriorityTaskWoken);
+}
+
+UnivRetCode enProtoSubmit(TaskToken taskToken, ProtoRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_PROTOCOLS;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enProtoFeedback(unsigned portCHAR ucClass, unsigned portLONG ulExpected, unsigned portLONG ulLost)
+{
+	UnivRetCode enResult;
+
+	taskENTER_CRITICAL();
+	{
+		enResult = redFeedback(&xRedundancy, (redClass)ucClass, ulExpected, ulLost);
+	}
+	taskEXIT_CRITICAL();
+
+	return enResult;
+}
+
+void vProtoGetRedundancy(unsigned portCHAR ucClass, redClassState *pxState)
+{
+	if (ucClass >= RED_NUM_CLASSES || pxState == NULL) return;
+
+	taskENTER_CRITICAL();
+	{
+		*pxState = xRedundancy.cls[ucClass];
+	}
+	taskEXIT_CRITICAL();
+}
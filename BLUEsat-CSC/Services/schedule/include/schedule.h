@@ -0,0 +1,83 @@
+ /**
+ *  \file schedule.h
+ *
+ *  \brief Time tagged command service. Uplink commands are stored with the
+ *  time they are due and run through the uplink service when it comes,
+ *  so timed actions no longer have to be sent during a pass.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-12 21:30:00 +1000 (Wed, 12 Jun 2013) $
+ *  \warning Times are RTC seconds since 2000, nothing runs until the clock
+ *  has been set with enPlannerSetTime
+ *  \bug No Bugs for now
+ *  \note Entries are kept in storage so they survive a reset. One that is
+ *  more than SCHEDULE_LATE_LIMIT overdue when it comes round, after a long
+ *  outage for instance, is dropped rather than run.
+ */
+
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+#include "service.h"
+#include "timerWheel.h"
+
+#define SCHEDULE_MAX_ENTRIES	TW_MAX_TIMERS
+#define SCHEDULE_LATE_LIMIT		600
+
+typedef struct
+{
+	unsigned portSHORT	usHeld;		//entries waiting
+	unsigned portLONG	ulRun;		//handed to the uplink service since start up
+	unsigned portLONG	ulMissed;	//dropped for being too late
+} ScheduleStatus;
+
+/**
+ * \brief Initialise time tagged command service
+ *
+ * \param[in] uxPriority Priority for time tagged command service.
+ */
+void vSchedule_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Store a command frame to run later. The response goes down with
+ * the sequence number of the stored frame once it has run.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ulTime Seconds since 2000, or seconds from now if xRelative
+ * \param[in] xRelative pdTRUE when ulTime is relative
+ * \param[in] pucFrame Command frame as it would be uplinked
+ * \param[in] usSize Bytes in the frame
+ * \param[out] pucEntry Entry number for cancelling, may be NULL
+ *
+ * \returns URC_SUCCESS, URC_CMD_BAD_ARG for a damaged frame or one with
+ * too many arguments, URC_FAIL when full or the clock is not set
+ */
+UnivRetCode enScheduleAdd(TaskToken taskToken,
+						unsigned portLONG ulTime,
+						portBASE_TYPE xRelative,
+						const unsigned portCHAR *pucFrame,
+						unsigned portSHORT usSize,
+						unsigned portCHAR *pucEntry);
+
+/**
+ * \brief Drop a stored command before it runs
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] ucEntry Entry number from enScheduleAdd
+ *
+ * \returns URC_SUCCESS or URC_FAIL if nothing is stored there
+ */
+UnivRetCode enScheduleCancel(TaskToken taskToken, unsigned portCHAR ucEntry);
+
+/**
+ * \brief Entries held and counters
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[out] pxStatus Destination for the snapshot
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enScheduleStatus(TaskToken taskToken, ScheduleStatus *pxStatus);
+
+#endif /* SCHEDULE_H_ */
@@ -0,0 +1,351 @@
+ /**
+ *  \file schedule.c
+ *
+ *  \brief Time tagged command service. Uplink commands are stored with the
+ *  time they are due and run through the uplink service when it comes,
+ *  so timed actions no longer have to be sent during a pass.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-12 21:30:00 +1000 (Wed, 12 Jun 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note Entries wait in a timer wheel keyed by RTC second, so adding,
+ *  cancelling and finding what is due do not depend on how many are held.
+ *  Storage holds them a page at a time, a change rewrites one page.
+ */
+
+#include "service.h"
+#include "schedule.h"
+#include "planner.h"
+#include "uplink.h"
+#include "storage.h"
+#include "debug.h"
+
+#define SCHEDULE_Q_SIZE			2
+#define SCHEDULE_TICK			(1000 / portTICK_RATE_MS)
+//entries kept in one storage object, the data ID is the page number plus one
+#define SCHEDULE_PAGE_ENTRIES	8
+#define SCHEDULE_PAGES			(SCHEDULE_MAX_ENTRIES / SCHEDULE_PAGE_ENTRIES)
+#define SCHEDULE_PAGE_DID(page)	((page) + 1)
+
+typedef enum
+{
+	SCHEDULE_ADD,
+	SCHEDULE_CANCEL,
+	SCHEDULE_STATUS
+} SCHEDULE_OPERATIONS;
+
+typedef struct
+{
+	SCHEDULE_OPERATIONS		Operation;
+	unsigned portLONG		ulTime;
+	portBASE_TYPE			xRelative;
+	const unsigned portCHAR	*pucFrame;
+	unsigned portSHORT		usSize;
+	unsigned portCHAR		ucEntry;
+	unsigned portCHAR		*pucEntry;
+	ScheduleStatus			*pxStatus;
+} ScheduleRequest;
+
+//due 0 marks a free entry, nothing can be scheduled for the epoch itself
+typedef struct
+{
+	unsigned portLONG	ulDue;
+	UplinkCommand		xCommand;
+} ScheduleEntry;
+
+//task token for accessing services
+static TaskToken Schedule_TaskToken;
+
+static ScheduleEntry xEntries[SCHEDULE_MAX_ENTRIES];
+static timerWheel xWheel;
+//free entry numbers used as a stack
+static unsigned portCHAR pucFree[SCHEDULE_MAX_ENTRIES];
+static unsigned portSHORT usFree;
+//pages changed since they were last written
+static unsigned portLONG ulDirty;
+static unsigned portLONG ulRun;
+static unsigned portLONG ulMissed;
+
+//prototype for task function
+static portTASK_FUNCTION(vScheduleTask, pvParameters);
+static void vScheduleLoad(unsigned portLONG ulNow);
+static void vScheduleRun(void);
+static void vScheduleRelease(unsigned portCHAR ucEntry);
+static void vScheduleSave(void);
+static UnivRetCode enScheduleStore(ScheduleRequest *pxRequest);
+static UnivRetCode enScheduleDrop(unsigned portCHAR ucEntry);
+static UnivRetCode enScheduleProcessRequest(TaskToken taskToken, ScheduleRequest *pxRequest);
+
+void vSchedule_Init(unsigned portBASE_TYPE uxPriority)
+{
+	usFree = 0;
+	ulDirty = 0;
+	ulRun = 0;
+	ulMissed = 0;
+
+	Schedule_TaskToken = ActivateTask(TASK_SCHEDULE,
+									"Schedule",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vScheduleTask);
+
+	vActivateQueue(Schedule_TaskToken, SCHEDULE_Q_SIZE);
+}
+
+static portTASK_FUNCTION(vScheduleTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	ScheduleRequest *pxRequest;
+
+	//commands stored before a reset still run
+	vScheduleLoad(ulPlannerNow());
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Schedule_TaskToken, &incoming_packet, SCHEDULE_TICK);
+
+		if (enResult == URC_SUCCESS)
+		{
+			pxRequest = (ScheduleRequest *)incoming_packet.Data;
+
+			switch (pxRequest->Operation)
+			{
+				case SCHEDULE_ADD		:	enResult = enScheduleStore(pxRequest);
+											break;
+
+				case SCHEDULE_CANCEL	:	enResult = enScheduleDrop(pxRequest->ucEntry);
+											break;
+
+				case SCHEDULE_STATUS	:	pxRequest->pxStatus->usHeld = SCHEDULE_MAX_ENTRIES - usFree;
+											pxRequest->pxStatus->ulRun = ulRun;
+											pxRequest->pxStatus->ulMissed = ulMissed;
+											enResult = URC_SUCCESS;
+											break;
+
+				default					:	enResult = URC_FAIL;
+											break;
+			}
+
+			vCompleteRequest(incoming_packet.Token, enResult);
+		}
+
+		vScheduleRun();
+		vScheduleSave();
+	}
+}
+
+static void vScheduleLoad(unsigned portLONG ulNow)
+{
+	unsigned portLONG ulRead;
+	unsigned portSHORT usPage;
+	unsigned portSHORT usEntry;
+
+	twInit(&xWheel, ulNow);
+
+	for (usPage = 0; usPage < SCHEDULE_PAGES; usPage++)
+	{
+		ulRead = 0;
+		enDataRead(Schedule_TaskToken, SCHEDULE_PAGE_DID(usPage), 0,
+					sizeof(ScheduleEntry) * SCHEDULE_PAGE_ENTRIES,
+					(portCHAR *)&xEntries[usPage * SCHEDULE_PAGE_ENTRIES], &ulRead);
+		if (ulRead != sizeof(ScheduleEntry) * SCHEDULE_PAGE_ENTRIES)
+		{
+			for (usEntry = 0; usEntry < SCHEDULE_PAGE_ENTRIES; usEntry++)
+			{
+				xEntries[usPage * SCHEDULE_PAGE_ENTRIES + usEntry].ulDue = 0;
+			}
+		}
+	}
+
+	//highest numbers pushed first so entries are handed out from 0 up
+	for (usEntry = SCHEDULE_MAX_ENTRIES; usEntry > 0; usEntry--)
+	{
+		if (xEntries[usEntry - 1].ulDue == 0
+			|| xEntries[usEntry - 1].xCommand.ucSize > UPLINK_RUN_ARGS_MAX
+			|| twAdd(&xWheel, usEntry - 1, xEntries[usEntry - 1].ulDue) != URC_SUCCESS)
+		{
+			xEntries[usEntry - 1].ulDue = 0;
+			pucFree[usFree++] = usEntry - 1;
+		}
+	}
+}
+
+/*
+ * Catching up is one wheel step per second missed, a longer gap or the
+ * clock being set puts the entries back in from scratch instead.
+ */
+static void vScheduleRun(void)
+{
+	unsigned portLONG ulNow = ulPlannerNow();
+	unsigned int uiEntry;
+
+	if (ulNow == 0) return;
+
+	twAdvance(&xWheel, ulNow);
+
+	while ((uiEntry = twNextDue(&xWheel)) != TW_NONE)
+	{
+		if (ulNow - xEntries[uiEntry].ulDue > SCHEDULE_LATE_LIMIT)
+		{
+			ulMissed++;
+			vDebugPrint(Schedule_TaskToken, "Entry %d missed by %d s\n\r",
+						uiEntry, ulNow - xEntries[uiEntry].ulDue, NO_INSERT);
+		}
+		else if (enUplinkRun(Schedule_TaskToken, &xEntries[uiEntry].xCommand) != URC_SUCCESS)
+		{
+			//uplink backed up, this and anything else due waits a second
+			twAdd(&xWheel, uiEntry, ulNow);
+			break;
+		}
+		else
+		{
+			ulRun++;
+		}
+		vScheduleRelease(uiEntry);
+	}
+}
+
+static void vScheduleRelease(unsigned portCHAR ucEntry)
+{
+	xEntries[ucEntry].ulDue = 0;
+	pucFree[usFree++] = ucEntry;
+	ulDirty |= 1UL << (ucEntry / SCHEDULE_PAGE_ENTRIES);
+}
+
+static void vScheduleSave(void)
+{
+	unsigned portSHORT usPage;
+	unsigned portSHORT usEntry;
+	portBASE_TYPE xEmpty;
+	UnivRetCode enResult;
+
+	for (usPage = 0; ulDirty != 0 && usPage < SCHEDULE_PAGES; usPage++)
+	{
+		if (!(ulDirty & (1UL << usPage))) continue;
+		ulDirty &= ~(1UL << usPage);
+
+		xEmpty = pdTRUE;
+		for (usEntry = 0; usEntry < SCHEDULE_PAGE_ENTRIES; usEntry++)
+		{
+			if (xEntries[usPage * SCHEDULE_PAGE_ENTRIES + usEntry].ulDue != 0) xEmpty = pdFALSE;
+		}
+
+		if (xEmpty)
+		{
+			enResult = enDataDelete(Schedule_TaskToken, SCHEDULE_PAGE_DID(usPage));
+		}
+		else
+		{
+			enResult = enDataStore(Schedule_TaskToken, SCHEDULE_PAGE_DID(usPage),
+									sizeof(ScheduleEntry) * SCHEDULE_PAGE_ENTRIES,
+									(portCHAR *)&xEntries[usPage * SCHEDULE_PAGE_ENTRIES]);
+		}
+
+		if (enResult != URC_SUCCESS && !xEmpty)
+		{
+			vDebugPrint(Schedule_TaskToken, "Page %d not saved\n\r", usPage, NO_INSERT, NO_INSERT);
+		}
+	}
+}
+
+static UnivRetCode enScheduleStore(ScheduleRequest *pxRequest)
+{
+	unsigned portLONG ulNow = ulPlannerNow();
+	unsigned portLONG ulDue = pxRequest->ulTime;
+	cmdRequest xParsed;
+	ScheduleEntry *pxEntry;
+	unsigned portCHAR ucEntry;
+	unsigned int uiIndex;
+
+	if (cmdParse(pxRequest->pucFrame, pxRequest->usSize, &xParsed) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (xParsed.argsSize > UPLINK_RUN_ARGS_MAX) return URC_CMD_BAD_ARG;
+	if (ulNow == 0 || usFree == 0) return URC_FAIL;
+
+	//relative times are fixed now, a reset does not start them again
+	if (pxRequest->xRelative) ulDue += ulNow;
+	if (ulDue == 0) return URC_FAIL;
+
+	ucEntry = pucFree[--usFree];
+	pxEntry = &xEntries[ucEntry];
+	pxEntry->ulDue = ulDue;
+	pxEntry->xCommand.usOpcode = xParsed.opcode;
+	pxEntry->xCommand.ucSeq = xParsed.seq;
+	pxEntry->xCommand.ucSize = xParsed.argsSize;
+	for (uiIndex = 0; uiIndex < xParsed.argsSize; uiIndex++)
+	{
+		pxEntry->xCommand.pucArgs[uiIndex] = xParsed.args[uiIndex];
+	}
+
+	twAdd(&xWheel, ucEntry, ulDue);
+	ulDirty |= 1UL << (ucEntry / SCHEDULE_PAGE_ENTRIES);
+
+	if (pxRequest->pucEntry != NULL) *pxRequest->pucEntry = ucEntry;
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enScheduleDrop(unsigned portCHAR ucEntry)
+{
+	if (twCancel(&xWheel, ucEntry) != URC_SUCCESS) return URC_FAIL;
+	vScheduleRelease(ucEntry);
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enScheduleProcessRequest(TaskToken taskToken, ScheduleRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_SCHEDULE;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enScheduleAdd(TaskToken taskToken,
+						unsigned portLONG ulTime,
+						portBASE_TYPE xRelative,
+						const unsigned portCHAR *pucFrame,
+						unsigned portSHORT usSize,
+						unsigned portCHAR *pucEntry)
+{
+	ScheduleRequest xRequest;
+
+	if (pucFrame == NULL) return URC_CMD_BAD_ARG;
+
+	xRequest.Operation = SCHEDULE_ADD;
+	xRequest.ulTime = ulTime;
+	xRequest.xRelative = xRelative;
+	xRequest.pucFrame = pucFrame;
+	xRequest.usSize = usSize;
+	xRequest.pucEntry = pucEntry;
+
+	return enScheduleProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enScheduleCancel(TaskToken taskToken, unsigned portCHAR ucEntry)
+{
+	ScheduleRequest xRequest;
+
+	xRequest.Operation = SCHEDULE_CANCEL;
+	xRequest.ucEntry = ucEntry;
+
+	return enScheduleProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enScheduleStatus(TaskToken taskToken, ScheduleStatus *pxStatus)
+{
+	ScheduleRequest xRequest;
+
+	if (pxStatus == NULL) return URC_FAIL;
+
+	xRequest.Operation = SCHEDULE_STATUS;
+	xRequest.pxStatus = pxStatus;
+
+	return enScheduleProcessRequest(taskToken, &xRequest);
+}
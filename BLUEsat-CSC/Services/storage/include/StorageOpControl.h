@@ -28,6 +28,7 @@ typedef enum
 	//temp op code
 	STORAGE_FORMAT, 		//format flash sectors
 	STORAGE_STATUS, 		//print flash status
+	STORAGE_BATCH,			//run a vector of the operations above back to back
 } STORAGE_OPERATIONS;
 
 #define OP_BIT_SIZE		3
@@ -48,6 +49,10 @@ typedef struct
 
 #define STORAGE_CONTENT_SIZE	sizeof(StorageContent)
 
+//a STORAGE_BATCH request points Ptr at an array of Size StorageContent and
+//pulRetValue at Size result codes, one for each operation in order
+#define STORAGE_BATCH_OPS(pStorageContent)	((StorageContent *)(pStorageContent)->Ptr)
+
 /**
  * \brief Process storage message received by different memory tasks
  *
@@ -17,6 +17,7 @@
 
 #include "command.h"
 #include "UniversalReturnCode.h"
+#include "StorageOpControl.h"
 
 /**
  * \brief Initialise storage service
@@ -98,6 +99,138 @@ UnivRetCode enDataAppend(TaskToken taskToken,
 						unsigned portLONG ulSize,
 						portCHAR *pcData);
 
+/*
+ * The calls below work on data owned by another task, for services that
+ * fill or read objects on behalf of an application such as uploads. The
+ * owner picks the AID, the request task is still the one put to sleep.
+ */
+
+/**
+ * \brief Delete data of another task
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] enOwner	Task that owns the data
+ * \param[in] ucDID		Data ID
+ *
+ * \returns URC_SUCCESS or URC_FAIL of the operation
+ */
+UnivRetCode enDataDeleteFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID);
+
+/**
+ * \brief Return the stored data size of another task
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] enOwner	Task that owns the data
+ * \param[in] ucDID		Data ID
+ * \param[out] pulSize	Pointer to location for storing return size
+ *
+ * \returns URC_SUCCESS or URC_FAIL of the operation
+ */
+UnivRetCode enDataSizeFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG *pulDataSize);
+
+/**
+ * \brief Read stored data of another task
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] enOwner			Task that owns the data
+ * \param[in] ucDID				Data ID
+ * \param[in] ulOffset			Offset point for data read in bytes
+ * \param[in] ulSize			Number of bytes to be read
+ * \param[out] pucBuffer		Pointer to data return buffer
+ * \param[out] pulReadRetSize	Pointer to location for storing return size
+ *
+ * \returns URC_SUCCESS or URC_FAIL of the operation
+ */
+UnivRetCode enDataReadFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulOffset,
+							unsigned portLONG ulSize,
+							portCHAR *pucBuffer,
+							unsigned portLONG *pulReadRetSize);
+
+/**
+ * \brief Append data of another task
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] enOwner	Task that owns the data
+ * \param[in] ucDID		Data ID
+ * \param[in] ulSize	Bytes of data to be stored
+ * \param[in] pcData	Pointer to data
+ *
+ * \returns URC_SUCCESS or URC_FAIL of the operation
+ */
+UnivRetCode enDataAppendFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData);
+
+/**
+ * \brief Run several operations on own data in one request. The memory task
+ * works through them back to back and wakes the caller once.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxOps			Operations, filled in as for the single calls
+ * \param[in] usCount		Number of operations
+ * \param[out] pulResults	Result code of each operation, may be NULL
+ *
+ * \returns URC_SUCCESS when every operation succeeded, otherwise URC_FAIL
+ */
+UnivRetCode enDataBatch(TaskToken taskToken,
+						StorageContent *pxOps,
+						unsigned portSHORT usCount,
+						unsigned portLONG *pulResults);
+
+/*
+ * Asynchronous versions return once the request is queued. The request
+ * details and the data stay with the caller until the handle completes,
+ * then enWaitRequest gives the result.
+ */
+
+/**
+ * \brief Store data for given AID & DID without waiting
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pStorageContent	Request details, kept until completion
+ * \param[in] ucDID				Data ID
+ * \param[in] ulSize			Bytes of data to be stored
+ * \param[in] pcData			Pointer to data, kept until completion
+ * \param[out] pxHandle			Handle for the request in flight
+ *
+ * \returns URC_SUCCESS once queued, or why it could not be
+ */
+UnivRetCode enDataStoreAsync(TaskToken taskToken,
+							StorageContent *pStorageContent,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData,
+							RequestHandle *pxHandle);
+
+/**
+ * \brief Append data for given AID & DID without waiting
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pStorageContent	Request details, kept until completion
+ * \param[in] ucDID				Data ID
+ * \param[in] ulSize			Bytes of data to be stored
+ * \param[in] pcData			Pointer to data, kept until completion
+ * \param[out] pxHandle			Handle for the request in flight
+ *
+ * \returns URC_SUCCESS once queued, or why it could not be
+ */
+UnivRetCode enDataAppendAsync(TaskToken taskToken,
+							StorageContent *pStorageContent,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData,
+							RequestHandle *pxHandle);
+
 #ifndef NO_DEBUG
 	/**
 	 * \brief Send no data command for debug purpose
@@ -18,6 +18,7 @@
 #include "debug.h"
 #include "gsa.h"
 #include "StorageOpControl.h"
+#include "events.h"
 
 #define FLASH_Q_SIZE	1
 
@@ -198,7 +199,13 @@ static unsigned portLONG WriteBufferFn(unsigned portLONG ulBlockAddr)
 	//TODO implement smart wear leveling free block selection scheme
 	//TODO implement data write treatment on write failure
 	if (ulBlockAddr == (unsigned portLONG)NULL) ulBlockAddr = ulGetNextFreeBlock(&IntFlashCore, INTFLASH_START_SECTOR_ADDR, INTFLASH_END_SECTOR_ADDR);
-	if (ulBlockAddr == (unsigned portLONG)NULL) return ulBlockAddr;
+	if (ulBlockAddr == (unsigned portLONG)NULL)
+	{
+		//out of free blocks, let whoever cares start clearing space
+		TaskID enSelf = TASK_MEM_INT_FLASH;
+		enEventPublish(Flash_TaskToken, EVT_STORAGE_LOW, &enSelf, sizeof(enSelf));
+		return ulBlockAddr;
+	}
 
 	if (Ram_To_Flash((void *)ulBlockAddr, (void *)IntFlashCore.BlockBuffer, IntFlashCore.BlockSize) != CMD_SUCCESS) return 0;
 
@@ -14,6 +14,10 @@
 
 #include "StorageOpControl.h"
 
+static UnivRetCode enProcessStorageBatch(GSACore *pGSACore,
+										unsigned portCHAR ucAID,
+										StorageContent *pStorageContent);
+
 UnivRetCode enProcessStorageReq(GSACore *pGSACore,
 								unsigned portCHAR ucAID,
 								StorageContent *pStorageContent)
@@ -47,6 +51,8 @@ UnivRetCode enProcessStorageReq(GSACore *pGSACore,
 							if (pStorageContent->pulRetValue != NULL) *(pStorageContent->pulRetValue) = ulRetVal;
 							break;
 
+		case STORAGE_BATCH	:return enProcessStorageBatch(pGSACore, ucAID, pStorageContent);
+
 		case STORAGE_READ	:pGSACore->DebugTrace("AID: %d requested Read\n\r", ucAID, 0, 0);
 							ulRetVal = ulGSARead(pGSACore,
 												ucAID,
@@ -65,3 +71,31 @@ UnivRetCode enProcessStorageReq(GSACore *pGSACore,
 
 	return URC_SUCCESS;
 }
+
+/*
+ * Every operation runs even after one fails, the caller sees each result.
+ * Batches do not nest.
+ */
+static UnivRetCode enProcessStorageBatch(GSACore *pGSACore,
+										unsigned portCHAR ucAID,
+										StorageContent *pStorageContent)
+{
+	StorageContent *pOps = STORAGE_BATCH_OPS(pStorageContent);
+	unsigned portLONG ulIndex;
+	UnivRetCode enResult;
+	UnivRetCode enBatchResult = URC_SUCCESS;
+
+	if (pOps == NULL) return URC_FAIL;
+
+	pGSACore->DebugTrace("AID: %d requested Batch of %d\n\r", ucAID, pStorageContent->Size, 0);
+	for (ulIndex = 0; ulIndex < pStorageContent->Size; ulIndex++)
+	{
+		if (pOps[ulIndex].Operation == STORAGE_BATCH) enResult = URC_FAIL;
+		else enResult = enProcessStorageReq(pGSACore, ucAID, &pOps[ulIndex]);
+
+		if (pStorageContent->pulRetValue != NULL) pStorageContent->pulRetValue[ulIndex] = enResult;
+		if (enResult != URC_SUCCESS) enBatchResult = URC_FAIL;
+	}
+
+	return enBatchResult;
+}
@@ -20,6 +20,7 @@
 #include "StorageOpControl.h"
 
 #define STOAGE_Q_SIZE	1
+#define STORAGE_URGENT_Q_SIZE	1
 
 //task token for accessing services
 static TaskToken Storage_TaskToken;
@@ -31,11 +32,21 @@ static portTASK_FUNCTION(vStorageTask, pvParameters);
  * \brief Forward request to different memory management depend on requester taskID
  *
  * \param[in] taskToken Task token from request task
+ * \param[in] enOwner Task whose data is accessed, picks the AID
  * \param[in] pStorageContent Request details
  *
  * \returns Request result or URC_FAIL of the operation
  */
-static UnivRetCode enStorageForwardSwitch(TaskToken taskToken, StorageContent *pStorageContent);
+static UnivRetCode enStorageForwardSwitch(TaskToken taskToken, TaskID enOwner, StorageContent *pStorageContent);
+
+/**
+ * \brief Pick the memory task holding a requester's data
+ *
+ * \param[in] enOwner Task whose data is accessed
+ *
+ * \returns Memory task ID, or NO_TASK when the owner is not on the storage list
+ */
+static TaskID enStorageDest(TaskID enOwner);
 
 void vStorage_Init(unsigned portBASE_TYPE uxPriority)
 {
@@ -47,6 +58,8 @@ void vStorage_Init(unsigned portBASE_TYPE uxPriority)
 								vStorageTask);
 
 	vActivateQueue(Storage_TaskToken, STOAGE_Q_SIZE);
+	//ground commands get ahead of logging
+	vActivateUrgentLane(Storage_TaskToken, STORAGE_URGENT_Q_SIZE);
 
 #ifndef MEM_TEST
 	//initialise internal flash memory management
@@ -73,22 +86,18 @@ static portTASK_FUNCTION(vStorageTask, pvParameters)
 	}
 }
 
-static UnivRetCode enStorageForwardSwitch(TaskToken taskToken, StorageContent *pStorageContent)
+static UnivRetCode enStorageForwardSwitch(TaskToken taskToken, TaskID enOwner, StorageContent *pStorageContent)
 {
 	MessagePacket outgoing_packet;
 
-	outgoing_packet.Src			= taskToken->enTaskID;
+	//memory tasks take the AID from the source, the token still wakes the requester
+	outgoing_packet.Src			= enOwner;
 	outgoing_packet.Token		= taskToken;
 	outgoing_packet.Data		= (unsigned portLONG)pStorageContent;
 
 	//forward to different memory type
-	switch (outgoing_packet.Src)
-	{
-		case	TASK_STORAGE_DEMO:	outgoing_packet.Dest = TASK_MEM_INT_FLASH;
-									break;
-
-		default					:	return URC_MEM_NOT_ON_STORAGE_LIST;
-	}
+	outgoing_packet.Dest = enStorageDest(enOwner);
+	if (outgoing_packet.Dest == NO_TASK) return URC_MEM_NOT_ON_STORAGE_LIST;
 
 	vDebugPrint(Storage_TaskToken,
 				"Forwarded %50s request!\n\r",
@@ -99,8 +108,41 @@ static UnivRetCode enStorageForwardSwitch(TaskToken taskToken, StorageContent *p
 	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
 }
 
+static TaskID enStorageDest(TaskID enOwner)
+{
+	switch (enOwner)
+	{
+		case	TASK_STORAGE_DEMO:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_MAILBOX	:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_UPLOAD		:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_FWUPDATE	:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_MODULES	:
+		case	TASK_MODULE_0	:
+		case	TASK_MODULE_1	:
+		case	TASK_MODULE_2	:
+		case	TASK_MODULE_3	:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_PLANNER	:	return TASK_MEM_INT_FLASH;
+
+		case	TASK_SCHEDULE	:	return TASK_MEM_INT_FLASH;
+
+		default					:	return NO_TASK;
+	}
+}
+
 UnivRetCode enDataDelete(TaskToken taskToken,
 						unsigned portCHAR ucDID)
+{
+	return enDataDeleteFor(taskToken, taskToken->enTaskID, ucDID);
+}
+
+UnivRetCode enDataDeleteFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID)
 {
 	StorageContent storageContent;
 
@@ -111,12 +153,20 @@ UnivRetCode enDataDelete(TaskToken taskToken,
 	storageContent.pulRetValue	= NULL;
 	storageContent.Ptr			= NULL;
 
-	return enStorageForwardSwitch(taskToken, &storageContent);
+	return enStorageForwardSwitch(taskToken, enOwner, &storageContent);
 }
 
 UnivRetCode enDataSize(TaskToken taskToken,
 						unsigned portCHAR ucDID,
 						unsigned portLONG *pulDataSize)
+{
+	return enDataSizeFor(taskToken, taskToken->enTaskID, ucDID, pulDataSize);
+}
+
+UnivRetCode enDataSizeFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG *pulDataSize)
 {
 	StorageContent storageContent;
 
@@ -127,7 +177,7 @@ UnivRetCode enDataSize(TaskToken taskToken,
 	storageContent.pulRetValue	= pulDataSize;
 	storageContent.Ptr			= NULL;
 
-	return enStorageForwardSwitch(taskToken, &storageContent);
+	return enStorageForwardSwitch(taskToken, enOwner, &storageContent);
 }
 
 UnivRetCode enDataRead(TaskToken taskToken,
@@ -136,6 +186,17 @@ UnivRetCode enDataRead(TaskToken taskToken,
 						unsigned portLONG ulSize,
 						portCHAR *pucBuffer,
 						unsigned portLONG *pulReadRetSize)
+{
+	return enDataReadFor(taskToken, taskToken->enTaskID, ucDID, ulOffset, ulSize, pucBuffer, pulReadRetSize);
+}
+
+UnivRetCode enDataReadFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulOffset,
+							unsigned portLONG ulSize,
+							portCHAR *pucBuffer,
+							unsigned portLONG *pulReadRetSize)
 {
 	StorageContent storageContent;
 
@@ -148,7 +209,7 @@ UnivRetCode enDataRead(TaskToken taskToken,
 	storageContent.Size			= ulSize;
 	storageContent.pulRetValue	= pulReadRetSize;
 
-	return enStorageForwardSwitch(taskToken, &storageContent);
+	return enStorageForwardSwitch(taskToken, enOwner, &storageContent);
 }
 
 UnivRetCode enDataStore(TaskToken taskToken,
@@ -166,13 +227,22 @@ UnivRetCode enDataStore(TaskToken taskToken,
 	storageContent.Size			= ulSize;
 	storageContent.pulRetValue	= NULL;
 
-	return enStorageForwardSwitch(taskToken, &storageContent);
+	return enStorageForwardSwitch(taskToken, taskToken->enTaskID, &storageContent);
 }
 
 UnivRetCode enDataAppend(TaskToken taskToken,
 						unsigned portCHAR ucDID,
 						unsigned portLONG ulSize,
 						portCHAR *pcData)
+{
+	return enDataAppendFor(taskToken, taskToken->enTaskID, ucDID, ulSize, pcData);
+}
+
+UnivRetCode enDataAppendFor(TaskToken taskToken,
+							TaskID enOwner,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData)
 {
 	StorageContent storageContent;
 
@@ -184,7 +254,75 @@ UnivRetCode enDataAppend(TaskToken taskToken,
 	storageContent.Size			= ulSize;
 	storageContent.pulRetValue	= NULL;
 
-	return enStorageForwardSwitch(taskToken, &storageContent);
+	return enStorageForwardSwitch(taskToken, enOwner, &storageContent);
+}
+
+UnivRetCode enDataBatch(TaskToken taskToken,
+						StorageContent *pxOps,
+						unsigned portSHORT usCount,
+						unsigned portLONG *pulResults)
+{
+	StorageContent storageContent;
+
+	if (pxOps == NULL) return URC_FAIL;
+
+	storageContent.Operation	= STORAGE_BATCH;
+	storageContent.DID			= 0;
+	storageContent.Ptr			= (portCHAR *)pxOps;
+	storageContent.Size			= usCount;
+	storageContent.pulRetValue	= pulResults;
+
+	return enStorageForwardSwitch(taskToken, taskToken->enTaskID, &storageContent);
+}
+
+static UnivRetCode enStorageSubmit(TaskToken taskToken, StorageContent *pStorageContent, RequestHandle *pxHandle)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Src			= taskToken->enTaskID;
+	outgoing_packet.Dest		= enStorageDest(taskToken->enTaskID);
+	outgoing_packet.Token		= taskToken;
+	outgoing_packet.Data		= (unsigned portLONG)pStorageContent;
+
+	if (outgoing_packet.Dest == NO_TASK) return URC_MEM_NOT_ON_STORAGE_LIST;
+
+	return enSubmitRequest(&outgoing_packet, portMAX_DELAY, pxHandle);
+}
+
+UnivRetCode enDataStoreAsync(TaskToken taskToken,
+							StorageContent *pStorageContent,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData,
+							RequestHandle *pxHandle)
+{
+	if (ucDID >= (1 << DID_BIT_SIZE)) return URC_MEM_INVALID_DID;
+
+	pStorageContent->Operation		= STORAGE_STORE;
+	pStorageContent->DID			= ucDID;
+	pStorageContent->Ptr			= pcData;
+	pStorageContent->Size			= ulSize;
+	pStorageContent->pulRetValue	= NULL;
+
+	return enStorageSubmit(taskToken, pStorageContent, pxHandle);
+}
+
+UnivRetCode enDataAppendAsync(TaskToken taskToken,
+							StorageContent *pStorageContent,
+							unsigned portCHAR ucDID,
+							unsigned portLONG ulSize,
+							portCHAR *pcData,
+							RequestHandle *pxHandle)
+{
+	if (ucDID >= (1 << DID_BIT_SIZE)) return URC_MEM_INVALID_DID;
+
+	pStorageContent->Operation		= STORAGE_APPEND;
+	pStorageContent->DID			= ucDID;
+	pStorageContent->Ptr			= pcData;
+	pStorageContent->Size			= ulSize;
+	pStorageContent->pulRetValue	= NULL;
+
+	return enStorageSubmit(taskToken, pStorageContent, pxHandle);
 }
 
 #ifndef NO_DEBUG
@@ -199,6 +337,6 @@ UnivRetCode enDataAppend(TaskToken taskToken,
 		storageContent.Size			= 0;
 		storageContent.pulRetValue	= NULL;
 
-		return enStorageForwardSwitch(taskToken, &storageContent);
+		return enStorageForwardSwitch(taskToken, taskToken->enTaskID, &storageContent);
 	}
 #endif
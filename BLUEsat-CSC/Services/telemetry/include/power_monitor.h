@@ -8,10 +8,19 @@
 #ifndef POWER_MONITOR_H_
 #define POWER_MONITOR_H_
 
+#include "UniversalReturnCode.h"
+
 #define POWER_MON_COUNT 16
 
 void power_mon_core_semph_create(void);
 
+/* Works out the conversion of every channel from the build time lists. */
+void power_monitor_scale_init(void);
+
+/* New range and shunt for one channel, for calibration from the ground.
+ * A channel that fails keeps reading 0 until it is calibrated. */
+UnivRetCode power_monitor_calibrate(unsigned int channel, unsigned int vRange, unsigned int shuntOhm);
+
 void power_monitor_sweep(unsigned int bus, unsigned short *voltages, unsigned short *currents);
 
 #endif /* POWER_MONITOR_H_ */
@@ -23,7 +23,8 @@ typedef enum
 typedef enum
 {
     TELEM_READ_SINGLE = 0,
-    TELEM_READ_LATEST
+    TELEM_READ_LATEST,
+    TELEM_READ_BATCH
 } telem_operation;
 
 typedef struct
@@ -36,12 +37,21 @@ typedef struct
 
     char *buffer;
     char size;
+
+    /* Batch only: buffer holds index commands run back to back, results
+     * gets one code per command and may be NULL. */
+    UnivRetCode *results;
 } telem_command_t;
 
 extern TaskToken telemTaskToken;
 
 UnivRetCode enTelemServiceMessageSend(TaskToken taskToken, unsigned portLONG data);
 
+/* Several reads in one request, the sensors are swept once for all of them.
+ * Returns URC_SUCCESS when every command succeeded. */
+UnivRetCode enTelemBatch(TaskToken taskToken, telem_command_t *commands,
+        unsigned int count, UnivRetCode *results);
+
 UnivRetCode vTelemInit(unsigned portBASE_TYPE uxPriority);
 
 #endif /* TELEMETRY_H_ */
@@ -14,15 +14,26 @@
 #include "debug.h"
 #include "power_monitor.h"
 #include "telemetry.h"
+#include "scale.h"
 
 #define SLAVE_ADDRESS_PREFIX        24 /* 11000 << 1 = 110000 */
 #define POWER_MON_BLOCK_TIME       (portTICK_RATE_MS * 5)
+#define POWER_MON_CODE_MAX         4095 /* 12 bit conversions. */
+#define POWER_MON_FULL_SCALE       4096
+#define POWER_MON_V_HIGH_MV        26520
+#define POWER_MON_V_LOW_MV         6650
+#define POWER_MON_I_SENSE          105840 /* Full scale sense, scaled by 1000 for uA. */
 
 static xSemaphoreHandle powerMonMutex;
 static int vRangesList[POWER_MON_COUNT] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 static int shuntOhmList[POWER_MON_COUNT] = {1000000, 1000000, 1000000, 1000000, 1000000, 1000000,
         1000000, 1000000, 1000000, 1000000, 1000000, 1000000, 1000000, 1000000};
 
+/* Q format conversions per channel, worked out from the lists above. */
+static scaleChannel voltageScale[POWER_MON_COUNT];
+static scaleChannel currentScale[POWER_MON_COUNT];
+static unsigned int scaleValid[POWER_MON_COUNT];
+
 static unsigned int
 power_monitor_write(unsigned int bus, unsigned int addr, char *cmd, unsigned int writeByte)
 {
@@ -65,36 +76,75 @@ power_mon_core_semph_create(void)
 }
 
 /* Note shuntOhm is in Ohm. Original C# code is in MOhm. */
+UnivRetCode
+power_monitor_calibrate(unsigned int channel, unsigned int vRange, unsigned int shuntOhm)
+{
+    UnivRetCode result;
+
+    if (channel >= POWER_MON_COUNT) return URC_CMD_BAD_ARG;
+
+    /* Divides happen here, once, not per sample. */
+    scaleValid[channel] = 0;
+    result = scaleMake(&voltageScale[channel], vRange ? POWER_MON_V_HIGH_MV : POWER_MON_V_LOW_MV,
+            POWER_MON_FULL_SCALE, POWER_MON_CODE_MAX);
+    if (result != URC_SUCCESS) return result;
+    result = scaleMake(&currentScale[channel], POWER_MON_I_SENSE * 1000ULL,
+            (unsigned long long)POWER_MON_FULL_SCALE * shuntOhm, POWER_MON_CODE_MAX);
+    if (result != URC_SUCCESS) return result;
+
+    vRangesList[channel] = vRange;
+    shuntOhmList[channel] = shuntOhm;
+    scaleValid[channel] = 1;
+    return URC_SUCCESS;
+}
+
+void
+power_monitor_scale_init(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < POWER_MON_COUNT; i++) {
+        if (power_monitor_calibrate(i, vRangesList[i], shuntOhmList[i]) != URC_SUCCESS) {
+            vDebugPrint(telemTaskToken, "POWER | Dev %d has no calibration\n\r", i, NO_INSERT, NO_INSERT);
+        }
+    }
+}
+
 static void
-power_monitor_read_voltage_current(unsigned int bus, unsigned int addr, unsigned int vRange,
-        unsigned int shuntOhm, unsigned short *voltage, unsigned short *current)
+power_monitor_read_voltage_current(unsigned int bus, unsigned int addr, unsigned int channel,
+        unsigned short *voltage, unsigned short *current)
 {
     char command[10];
     char result[10];
     unsigned int nbytes;
     unsigned int iCode;
     unsigned int vCode;
-    unsigned int vInt;
-    unsigned int iInt;
+    unsigned int vInt = 0;
+    unsigned int iInt = 0;
 
     /* Write the 1 byte command. */
     memset(command, 0, 10);
     command[0] = (1 << 1 | 1 << 3); /* V_ONCE, I_ONCE */
-    if (!vRange) command[0] |= (1 << 4); /* VRANGE */
+    if (!vRangesList[channel]) command[0] |= (1 << 4); /* VRANGE */
+    Comms_I2C_Lock(bus, portMAX_DELAY);
     nbytes = power_monitor_write(bus, addr, command, 1);
 
     vSleep(10);
     /* Read 3 bytes. */
     memset(result, 0, 10);
     nbytes = power_monitor_read(bus, addr, result, 3);
+    Comms_I2C_Unlock(bus);
 
     vCode = (result[0] << 4) | (result[2] >> 4);
     iCode = (result[1] << 4) | (result[2] & 0xF);
     vDebugPrint(telemTaskToken, "POWER | vCode is %d\n\r", vCode, NO_INSERT, NO_INSERT);
     vDebugPrint(telemTaskToken, "POWER | iCode is %d\n\r", iCode, NO_INSERT, NO_INSERT);
 
-    vInt = vCode * (vRange ? 26520 : 6650) / 4096; /* mV */
-    iInt = (iCode * 105840 / 4096) * 1000 / shuntOhm; /* uA */
+    /* Was vCode * 26520 / 4096 and (iCode * 105840 / 4096) * 1000 / shuntOhm. */
+    if (scaleValid[channel]) {
+        vInt = scaleApply(&voltageScale[channel], vCode); /* mV */
+        iInt = scaleApply(&currentScale[channel], iCode); /* uA */
+    }
 
     /* Cast to short. */
     *voltage = (unsigned short)vInt;
@@ -110,8 +160,8 @@ power_monitor_sweep(unsigned int bus, unsigned short *voltages, unsigned short *
 
     startAddr = 0x60;
     for (i = 0; i < POWER_MON_COUNT; i++) {
-        power_monitor_read_voltage_current(bus, (startAddr >> 1), vRangesList[i],
-                shuntOhmList[i], &voltages[i], &currents[i]);
+        power_monitor_read_voltage_current(bus, (startAddr >> 1), i,
+                &voltages[i], &currents[i]);
         startAddr += 2;
     }
 }
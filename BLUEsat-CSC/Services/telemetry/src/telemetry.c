@@ -17,6 +17,7 @@
 #include "telemetry_sensor_map.h"
 #include "power_monitor.h"
 #include "rtc.h"
+#include "events.h"
 
 //#define TELEM_DEBUG 1
 
@@ -24,6 +25,7 @@
 #define TRANSLATOR_COUNT                4
 #define MAX_TRANSLATOR_SENSOR_COUNT     10
 #define TELEM_QUEUE_SIZE                16
+#define TELEM_URGENT_Q_SIZE             2
 
 /* Telemetry I2C control definition. */
 #define TELEM_SEMAPHORE_BLOCK_TIME      (portTICK_RATE_MS * 5)
@@ -39,7 +41,7 @@ static xSemaphoreHandle telemMutex;
 
 static int magicNum = 0;
 
-static void
+static int
 telemetry_read_single(unsigned int index, char *buffer, unsigned int size)
 {
     /* Perform memory access for a single entry. */
@@ -50,7 +52,9 @@ telemetry_read_single(unsigned int index, char *buffer, unsigned int size)
     struct telem_storage_entry_t *ptr;
 #endif
 
-    telemetry_storage_read_index(index, &entry);
+    if (telemetry_storage_read_index(index, &entry) != 0) {
+        return -1;
+    }
     memcpy(buffer, &entry, nbytes);
     /********** testing. *************/
     vDebugPrint(telemTaskToken, "TELEM | Now check the content is actually stored - single...\n\r",
@@ -61,9 +65,10 @@ telemetry_read_single(unsigned int index, char *buffer, unsigned int size)
     ptr = (struct telem_storage_entry_t *)buffer;
     telemetry_print_entry_content(ptr);
 #endif
+    return 0;
 }
 
-static void
+static int
 telemetry_read_latest(char *buffer, unsigned int size)
 {
     /* Perform memory access for the latest entry. */
@@ -74,7 +79,9 @@ telemetry_read_latest(char *buffer, unsigned int size)
     struct telem_storage_entry_t *ptr;
 #endif
 
-    telemetry_storage_read_cur(&entry);
+    if (telemetry_storage_read_cur(&entry) != 0) {
+        return -1;
+    }
     memcpy(buffer, &entry, nbytes);
 
     /********** testing. *************/
@@ -84,6 +91,48 @@ telemetry_read_latest(char *buffer, unsigned int size)
     ptr = (struct telem_storage_entry_t *)buffer;
     telemetry_print_entry_content(ptr);
 #endif
+    return 0;
+}
+
+static UnivRetCode
+telemetry_command(telem_command_t *command)
+{
+    switch (command->operation)
+    {
+        case TELEM_READ_SINGLE:
+            vDebugPrint(telemTaskToken, "Message | read single sensor...\n\r", NO_INSERT,
+                    NO_INSERT, NO_INSERT);
+            return (telemetry_read_single(command->index, command->buffer,
+                    command->size) == 0) ? URC_SUCCESS : URC_FAIL;
+        case TELEM_READ_LATEST:
+            vDebugPrint(telemTaskToken, "Message | read latest sensor...\n\r", NO_INSERT,
+                    NO_INSERT, NO_INSERT);
+            return (telemetry_read_latest(command->buffer, command->size) == 0) ?
+                    URC_SUCCESS : URC_FAIL;
+        default:
+            return URC_FAIL;
+    }
+}
+
+/* Commands of a batch run back to back against the one sweep. Every command
+ * runs even after one fails, batches do not nest. */
+static UnivRetCode
+telemetry_batch(telem_command_t *batch)
+{
+    telem_command_t *commands = (telem_command_t *)batch->buffer;
+    UnivRetCode result;
+    UnivRetCode batchResult = URC_SUCCESS;
+    unsigned int i;
+
+    if (commands == NULL) return URC_FAIL;
+
+    for (i = 0; i < batch->index; i++) {
+        result = (commands[i].operation == TELEM_READ_BATCH) ?
+                URC_FAIL : telemetry_command(&commands[i]);
+        if (batch->results != NULL) batch->results[i] = result;
+        if (result != URC_SUCCESS) batchResult = URC_FAIL;
+    }
+    return batchResult;
 }
 
 static void
@@ -132,6 +181,7 @@ telemetry_sensor_poll(void)
     rtc_time_t time;
     int i;
     struct telem_storage_entry_t entry;
+    EventTelem notice;
     memset((char *)&entry, 0, sizeof(struct telem_storage_entry_t));
     for (i = 0; i < TRANSLATOR_COUNT; i++) {
         telemetry_core_conversion(BUS2, i);
@@ -160,7 +210,11 @@ telemetry_sensor_poll(void)
 
     //power_monitor_print(&(entry.voltages[0]), &(entry.currents[0]));
     /* Store the data in memory. */
+    notice.usIndex = cur - (struct telem_storage_entry_t *)TELEM_STORAGE_BASE_ADDR;
+    notice.ulTimestamp = entry.timestamp;
     telemetry_storage_write(&entry);
+    /* Subscribers read the slot back, the notice fits a small message block. */
+    enEventPublish(telemTaskToken, EVT_TELEM_ENTRY, &notice, sizeof(notice));
 }
 
 void
@@ -180,6 +234,7 @@ static portTASK_FUNCTION(vTelemTask, pvParameters)
     UnivRetCode enResult;
     MessagePacket incomingPacket;
     telem_command_t *pComamndHandle;
+    UnivRetCode enCommandResult;
     //rtc_time_t time;
 
     /* Test feed dog. */
@@ -197,6 +252,7 @@ static portTASK_FUNCTION(vTelemTask, pvParameters)
     telem_core_semph_create();
     /* Set up power monitor semaphore. */
     power_mon_core_semph_create();
+    power_monitor_scale_init();
     telemetry_storage_reset();
     telemetry_storage_init();
 
@@ -216,26 +272,14 @@ static portTASK_FUNCTION(vTelemTask, pvParameters)
                     NO_INSERT, NO_INSERT);
         /* Process command. */
         pComamndHandle = (telem_command_t *)incomingPacket.Data;
-        switch (pComamndHandle->operation)
-        {
-            case TELEM_READ_SINGLE:
-                vDebugPrint(telemTaskToken, "Message | read single sensor...\n\r", NO_INSERT,
-                        NO_INSERT, NO_INSERT);
-                telemetry_read_single(pComamndHandle->index, pComamndHandle->buffer,
-                        pComamndHandle->size);
-                break;
-            case TELEM_READ_LATEST:
-                vDebugPrint(telemTaskToken, "Message | read latest sensor...\n\r", NO_INSERT,
-                        NO_INSERT, NO_INSERT);
-                telemetry_read_latest(pComamndHandle->buffer, pComamndHandle->size);
-                break;
-            default:
-                vCompleteRequest(incomingPacket.Token, URC_FAIL);
-                break;
+        if (pComamndHandle->operation == TELEM_READ_BATCH) {
+            enCommandResult = telemetry_batch(pComamndHandle);
+        } else {
+            enCommandResult = telemetry_command(pComamndHandle);
         }
 
         /* Complete request by passing the status to the sender. */
-        vCompleteRequest(incomingPacket.Token, URC_SUCCESS);
+        vCompleteRequest(incomingPacket.Token, enCommandResult);
     }
 }
 
@@ -253,6 +297,23 @@ UnivRetCode enTelemServiceMessageSend(TaskToken taskToken, unsigned portLONG dat
     return enProcessRequest(&outgoingPacket, portMAX_DELAY);
 }
 
+UnivRetCode
+enTelemBatch(TaskToken taskToken, telem_command_t *commands,
+        unsigned int count, UnivRetCode *results)
+{
+    telem_command_t batch;
+
+    if (commands == NULL) return URC_FAIL;
+
+    batch.operation = TELEM_READ_BATCH;
+    batch.index = count;
+    batch.buffer = (char *)commands;
+    batch.size = 0;
+    batch.results = results;
+
+    return enTelemServiceMessageSend(taskToken, (unsigned portLONG)&batch);
+}
+
 UnivRetCode
 vTelemInit(unsigned portBASE_TYPE uxPriority)
 {
@@ -264,6 +325,8 @@ vTelemInit(unsigned portBASE_TYPE uxPriority)
                                 vTelemTask);
 
     vActivateQueue(telemTaskToken, TELEM_QUEUE_SIZE);
+    //ground commands get ahead of queued sweeps
+    vActivateUrgentLane(telemTaskToken, TELEM_URGENT_Q_SIZE);
 
     return URC_SUCCESS;
 }
@@ -37,6 +37,9 @@ telemetry_core_read(unsigned int bus, unsigned int interface, char *sensorID)
     memset(readBuf, 0, 10);
     memset(command, 0, 10);
 
+    /* The bridge keeps 1-wire state between writes, hold the bus throughout. */
+    Comms_I2C_Lock(bus, portMAX_DELAY);
+
     /* Passive config. */
     command[0] = 0xD2;
     command[1] = 0xF0;
@@ -125,6 +128,7 @@ telemetry_core_read(unsigned int bus, unsigned int interface, char *sensorID)
     returnVal = Comms_I2C_Master(SLAVE_ADDRESS_PREFIX + interface, I2C_READ,
             (char*)&isValid, (char*)&readBuf[1], (short*)&length, telemMutex, bus);
     xSemaphoreTake(telemMutex, TELEM_CORE_BLOCK_TIME);
+    Comms_I2C_Unlock(bus);
 
     return ((readBuf[1] << 8) | readBuf[0]);
 }
@@ -163,6 +167,8 @@ telemetry_core_conversion(unsigned int bus, unsigned int interface)
     unsigned int length;
     portBASE_TYPE returnVal;
 
+    Comms_I2C_Lock(bus, portMAX_DELAY);
+
     /* Reset the state machine (I2C to 1 wire). */
     command[0] = 0xF0;
     length = 1;
@@ -212,6 +218,7 @@ telemetry_core_conversion(unsigned int bus, unsigned int interface)
     returnVal = Comms_I2C_Master(SLAVE_ADDRESS_PREFIX + interface, I2C_WRITE,
             (char*)&isValid, (char*)command, (short*)&length, telemMutex, bus);
     xSemaphoreTake(telemMutex, TELEM_CORE_BLOCK_TIME);
+    Comms_I2C_Unlock(bus);
 
     /* Sleep for 1 second. */
     vSleep(750);
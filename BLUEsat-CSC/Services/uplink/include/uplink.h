@@ -0,0 +1,142 @@
+ /**
+ *  \file uplink.h
+ *
+ *  \brief Uplink command service. Binary command frames received from the
+ *  ground are checked, dispatched through an opcode table and answered
+ *  with a response frame on the downlink.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-30 20:40:00 +1000 (Thu, 30 May 2013) $
+ *  \warning No Warnings for now
+ *  \bug No Bugs for now
+ *  \note Frame layout and the handler table live in Libraries/cmdFrame.
+ *  Opcodes below 0x0100 are the built in commands, services register
+ *  their own above that.
+ */
+
+#ifndef UPLINK_H_
+#define UPLINK_H_
+
+#include "service.h"
+#include "cmdFrame.h"
+
+//built in opcodes
+#define UPLINK_OP_PING			0x0001
+#define UPLINK_OP_DTMF_CODE		0x0002	//same actions as the DTMF keypad
+#define UPLINK_OP_BERT			0x0010
+#define UPLINK_OP_LOSS_REPORT	0x0011
+#define UPLINK_OP_MAIL_POST		0x0020
+#define UPLINK_OP_MAIL_LIST		0x0021
+#define UPLINK_OP_MAIL_SEND		0x0022
+#define UPLINK_OP_MAIL_DELETE	0x0023
+#define UPLINK_OP_UPLOAD_OPEN	0x0030
+#define UPLINK_OP_UPLOAD_CHUNK	0x0031	//only answered every UPLOAD_ACK_EVERY chunks
+#define UPLINK_OP_UPLOAD_STATUS	0x0032
+#define UPLINK_OP_UPLOAD_ABORT	0x0033
+#define UPLINK_OP_FW_APPLY		0x0040	//patch uploaded for TASK_FWUPDATE, takes a few seconds
+#define UPLINK_OP_FW_COMMIT		0x0041	//resets into the new image after answering
+#define UPLINK_OP_MODULE_LOAD	0x0050
+#define UPLINK_OP_MODULE_BOOT	0x0051
+#define UPLINK_OP_MODULE_STATUS	0x0052
+#define UPLINK_OP_PASS_ADD		0x0060
+#define UPLINK_OP_PASS_CLEAR	0x0061
+#define UPLINK_OP_TIME_SET		0x0062
+#define UPLINK_OP_PASS_STATUS	0x0063
+#define UPLINK_OP_SCHED_ADD		0x0070	//stores a command frame to run later
+#define UPLINK_OP_SCHED_CANCEL	0x0071
+#define UPLINK_OP_SCHED_STATUS	0x0072
+
+//argument types, multi byte numbers are big endian
+#define UPLINK_ARG_CODE			0x01	//1 byte, DTMF command code
+#define UPLINK_ARG_TO			0x02	//7 bytes, callsign then ssid
+#define UPLINK_ARG_FROM			0x03	//7 bytes, callsign then ssid
+#define UPLINK_ARG_SEQ			0x04	//2 bytes, mailbox sequence number
+#define UPLINK_ARG_BODY			0x05	//message text
+#define UPLINK_ARG_CLASS		0x06	//1 byte, redundancy class
+#define UPLINK_ARG_EXPECTED		0x07	//2 bytes, frames expected
+#define UPLINK_ARG_LOST			0x08	//2 bytes, frames lost
+#define UPLINK_ARG_PRBS			0x09	//1 byte, prbsType
+#define UPLINK_ARG_SECONDS		0x0A	//2 bytes, test length
+#define UPLINK_ARG_ENTRIES		0x0B	//sequence and size, 2 bytes each a message
+#define UPLINK_ARG_OWNER		0x0C	//1 byte, task ID the object belongs to
+#define UPLINK_ARG_DID			0x0D	//1 byte, storage data ID
+#define UPLINK_ARG_SIZE			0x0E	//4 bytes, object size
+#define UPLINK_ARG_CRC			0x0F	//4 bytes, CRC-32 of the object
+#define UPLINK_ARG_INDEX		0x10	//2 bytes, chunk number
+#define UPLINK_ARG_DATA			0x11	//chunk data
+#define UPLINK_ARG_UPLOAD_ACK	0x12	//state, next, base, received and missing bitmaps
+#define UPLINK_ARG_SLOT			0x13	//1 byte, module slot
+#define UPLINK_ARG_ENABLE		0x14	//1 byte, non zero to turn on
+#define UPLINK_ARG_MODULES		0x15	//2 bytes, slots loaded then slots loaded at boot
+#define UPLINK_ARG_START		0x16	//4 bytes, seconds since 2000
+#define UPLINK_ARG_STOP			0x17	//4 bytes, seconds since 2000
+#define UPLINK_ARG_TIME			0x18	//4 bytes, seconds since 2000
+#define UPLINK_ARG_PASSES		0x19	//1 byte phase, 1 byte passes held, 4 bytes time
+#define UPLINK_ARG_DELAY		0x1A	//4 bytes, seconds from now
+#define UPLINK_ARG_FRAME		0x1B	//a whole command frame
+#define UPLINK_ARG_ENTRY		0x1C	//1 byte, schedule entry
+#define UPLINK_ARG_SCHEDULE		0x1D	//2 bytes entries held, 4 bytes run, 4 bytes missed
+
+#define UPLINK_ADDR_SIZE		7
+//argument bytes a stored command can carry
+#define UPLINK_RUN_ARGS_MAX		24
+
+//a parsed command kept to run later, see enUplinkRun
+typedef struct
+{
+	unsigned portSHORT	usOpcode;
+	unsigned portCHAR	ucSeq;
+	unsigned portCHAR	ucSize;
+	unsigned portCHAR	pucArgs[UPLINK_RUN_ARGS_MAX];
+} UplinkCommand;
+
+/**
+ * \brief Initialise uplink command service
+ *
+ * \param[in] uxPriority Priority for uplink command service.
+ */
+void vUplink_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Add a command handler. Meant for start up, before the frames
+ * start arriving.
+ *
+ * \param[in] usOpcode Opcode without the response bit
+ * \param[in] xHandler Run from the uplink task, may call other services
+ *
+ * \returns URC_SUCCESS, URC_FAIL when the opcode is taken or the table full
+ */
+UnivRetCode enUplinkRegister(unsigned portSHORT usOpcode, cmdHandler xHandler);
+
+/**
+ * \brief Hand over a received command frame, the info field of a UI frame
+ * addressed to us. Returns once the command has run and the response is
+ * queued for downlink.
+ *
+ * This is the only way a frame reaches the dispatcher. There is no AX.25
+ * receive path yet, the one caller is the uplink console task, which reads
+ * frames as hex lines from the debug UART (not built with NO_DEBUG).
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pcFrame Frame bytes
+ * \param[in] usSize Bytes in the frame
+ *
+ * \returns URC_SUCCESS when answered, URC_FAIL for a damaged frame
+ */
+UnivRetCode enUplinkFrame(TaskToken taskToken, const portCHAR *pcFrame, unsigned portSHORT usSize);
+
+/**
+ * \brief Run a stored command on the uplink task as if it had just been
+ * received, without the repeat check. Does not wait for it, the response
+ * goes out on the downlink like any other.
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] pxCommand Command, copied before this returns
+ *
+ * \returns URC_SUCCESS once handed over, URC_BUSY if the uplink service
+ * is backed up
+ */
+UnivRetCode enUplinkRun(TaskToken taskToken, const UplinkCommand *pxCommand);
+
+#endif /* UPLINK_H_ */
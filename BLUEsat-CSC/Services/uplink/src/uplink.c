@@ -0,0 +1,698 @@
+ /**
+ *  \file uplink.c
+ *
+ *  \brief Uplink command service. Binary command frames received from the
+ *  ground are checked, dispatched through an opcode table and answered
+ *  with a response frame on the downlink.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-05-30 20:40:00 +1000 (Thu, 30 May 2013) $
+ *  \warning Nothing decodes AX.25 on the receive side yet. Until it does
+ *  the console task takes frames as hex lines from the debug UART.
+ *  \bug No Bugs for now
+ *  \note A frame repeated by the ground station is answered from the last
+ *  response, so a command only ever runs once per sequence number
+ */
+
+#include "service.h"
+#include "uplink.h"
+#include "protocols.h"
+#include "mailbox.h"
+#include "upload.h"
+#include "fwUpdate.h"
+#include "modules.h"
+#include "planner.h"
+#include "schedule.h"
+#include "commsControl.h"
+#include "prbs.h"
+#include "debug.h"
+#include "task.h"
+
+#define UPLINK_Q_SIZE		2
+#define UPLINK_LIST_MAX		16
+#define UPLINK_ACK_SIZE		9
+//two hex digits a byte, spaces between them allowed
+#define UPLINK_LINE_MAX		(CMD_MAX_FRAME * 3)
+
+typedef struct
+{
+	const portCHAR		*pcFrame;
+	unsigned portSHORT	usSize;
+} UplinkRequest;
+
+//task token for accessing services
+static TaskToken Uplink_TaskToken;
+
+static cmdDispatcher xDispatcher;
+static unsigned portCHAR pucResponse[CMD_MAX_FRAME];
+
+#ifndef NO_DEBUG
+static TaskToken Console_TaskToken;
+static portCHAR pcConsoleLine[UPLINK_LINE_MAX + 1];
+static portCHAR pcConsoleFrame[CMD_MAX_FRAME];
+#endif
+
+//prototype for task function
+static portTASK_FUNCTION(vUplinkTask, pvParameters);
+#ifndef NO_DEBUG
+static portTASK_FUNCTION(vUplinkConsoleTask, pvParameters);
+static signed portSHORT sUplinkHexFrame(const portCHAR *pcLine, portCHAR *pcFrame);
+#endif
+static unsigned portSHORT usUplinkShort(const cmdArg *pxArg);
+static unsigned portLONG ulUplinkLong(const cmdArg *pxArg);
+static void vUplinkPutLong(unsigned portCHAR *pucOut, unsigned portLONG ulValue);
+static UnivRetCode enUplinkAnswer(unsigned int uiResponseSize);
+static void vUplinkRunStored(const UplinkCommand *pxCommand);
+static UnivRetCode enUplinkUploadAck(cmdBuilder *pxResponse, const UploadStatus *pxStatus);
+
+static UnivRetCode enUplinkAddr(const cmdRequest *pxRequest, unsigned portCHAR ucType, mbxAddr *pxAddr);
+static UnivRetCode enUplinkPing(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkDtmfCode(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkBert(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkLossReport(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkMailPost(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkMailList(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkMailSend(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkMailDelete(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkUploadOpen(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkUploadChunk(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkUploadStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkUploadAbort(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkFwApply(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkFwCommit(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkModuleLoad(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkModuleBoot(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkModuleStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkPassAdd(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkPassClear(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkTimeSet(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkPassStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkSchedAdd(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkSchedCancel(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+static UnivRetCode enUplinkSchedStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse);
+
+void vUplink_Init(unsigned portBASE_TYPE uxPriority)
+{
+	cmdInit(&xDispatcher);
+
+	cmdRegister(&xDispatcher, UPLINK_OP_PING, enUplinkPing);
+	cmdRegister(&xDispatcher, UPLINK_OP_DTMF_CODE, enUplinkDtmfCode);
+	cmdRegister(&xDispatcher, UPLINK_OP_BERT, enUplinkBert);
+	cmdRegister(&xDispatcher, UPLINK_OP_LOSS_REPORT, enUplinkLossReport);
+	cmdRegister(&xDispatcher, UPLINK_OP_MAIL_POST, enUplinkMailPost);
+	cmdRegister(&xDispatcher, UPLINK_OP_MAIL_LIST, enUplinkMailList);
+	cmdRegister(&xDispatcher, UPLINK_OP_MAIL_SEND, enUplinkMailSend);
+	cmdRegister(&xDispatcher, UPLINK_OP_MAIL_DELETE, enUplinkMailDelete);
+	cmdRegister(&xDispatcher, UPLINK_OP_UPLOAD_OPEN, enUplinkUploadOpen);
+	cmdRegister(&xDispatcher, UPLINK_OP_UPLOAD_CHUNK, enUplinkUploadChunk);
+	cmdRegister(&xDispatcher, UPLINK_OP_UPLOAD_STATUS, enUplinkUploadStatus);
+	cmdRegister(&xDispatcher, UPLINK_OP_UPLOAD_ABORT, enUplinkUploadAbort);
+	cmdRegister(&xDispatcher, UPLINK_OP_FW_APPLY, enUplinkFwApply);
+	cmdRegister(&xDispatcher, UPLINK_OP_FW_COMMIT, enUplinkFwCommit);
+	cmdRegister(&xDispatcher, UPLINK_OP_MODULE_LOAD, enUplinkModuleLoad);
+	cmdRegister(&xDispatcher, UPLINK_OP_MODULE_BOOT, enUplinkModuleBoot);
+	cmdRegister(&xDispatcher, UPLINK_OP_MODULE_STATUS, enUplinkModuleStatus);
+	cmdRegister(&xDispatcher, UPLINK_OP_PASS_ADD, enUplinkPassAdd);
+	cmdRegister(&xDispatcher, UPLINK_OP_PASS_CLEAR, enUplinkPassClear);
+	cmdRegister(&xDispatcher, UPLINK_OP_TIME_SET, enUplinkTimeSet);
+	cmdRegister(&xDispatcher, UPLINK_OP_PASS_STATUS, enUplinkPassStatus);
+	cmdRegister(&xDispatcher, UPLINK_OP_SCHED_ADD, enUplinkSchedAdd);
+	cmdRegister(&xDispatcher, UPLINK_OP_SCHED_CANCEL, enUplinkSchedCancel);
+	cmdRegister(&xDispatcher, UPLINK_OP_SCHED_STATUS, enUplinkSchedStatus);
+
+	Uplink_TaskToken = ActivateTask(TASK_UPLINK,
+									"Uplink",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE * 2,
+									vUplinkTask);
+
+	vActivateQueue(Uplink_TaskToken, UPLINK_Q_SIZE);
+	//ground commands overtake background traffic on the service queues
+	vSetRequestLane(Uplink_TaskToken, CMD_LANE_URGENT);
+
+#ifndef NO_DEBUG
+	//ground station stand in until the radio decodes frames
+	Console_TaskToken = ActivateTask(TASK_UPLINK_CONSOLE,
+									"UplinkConsole",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vUplinkConsoleTask);
+	vSetRequestLane(Console_TaskToken, CMD_LANE_URGENT);
+#endif
+}
+
+static portTASK_FUNCTION(vUplinkTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	UplinkRequest *pxRequest;
+	unsigned int uiResponseSize;
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Uplink_TaskToken, &incoming_packet, portMAX_DELAY);
+
+		if (enResult != URC_SUCCESS) continue;
+
+		//stored commands come as pooled messages with nobody waiting
+		if (incoming_packet.Token == NULL)
+		{
+			vUplinkRunStored((const UplinkCommand *)incoming_packet.Data);
+			vMessageFree((void *)incoming_packet.Data);
+			continue;
+		}
+
+		pxRequest = (UplinkRequest *)incoming_packet.Data;
+
+		enResult = cmdDispatch(&xDispatcher,
+								(const unsigned portCHAR *)pxRequest->pcFrame,
+								pxRequest->usSize,
+								pucResponse,
+								&uiResponseSize);
+
+		if (enResult == URC_SUCCESS) enResult = enUplinkAnswer(uiResponseSize);
+
+		vCompleteRequest(incoming_packet.Token, enResult);
+	}
+}
+
+#ifndef NO_DEBUG
+/*
+ * One command frame a line, in hex, from the debug UART. Each line runs
+ * exactly as a frame from the radio would, the answer goes to the downlink.
+ */
+static portTASK_FUNCTION(vUplinkConsoleTask, pvParameters)
+{
+	(void) pvParameters;
+	signed portSHORT sSize;
+
+	for ( ; ; )
+	{
+		if (usDebugRead(pcConsoleLine, UPLINK_LINE_MAX) == 0) continue;
+
+		sSize = sUplinkHexFrame(pcConsoleLine, pcConsoleFrame);
+		if (sSize <= 0)
+		{
+			vDebugPrint(Console_TaskToken, "UPLINK | not a hex frame\r\n", NO_INSERT, NO_INSERT, NO_INSERT);
+			continue;
+		}
+
+		vDebugPrint(Console_TaskToken, "UPLINK | %d bytes, result %d\r\n", sSize,
+					enUplinkFrame(Console_TaskToken, pcConsoleFrame, (unsigned portSHORT)sSize), NO_INSERT);
+	}
+}
+
+//bytes decoded, or -1 for an odd digit count, a bad character or too long
+static signed portSHORT sUplinkHexFrame(const portCHAR *pcLine, portCHAR *pcFrame)
+{
+	signed portSHORT sSize = 0;
+	unsigned portCHAR ucDigit;
+	unsigned portCHAR ucDigits = 0;
+	portCHAR cChar;
+
+	for ( ; *pcLine != '\0'; pcLine++)
+	{
+		cChar = *pcLine;
+		if (cChar == ' ') continue;
+
+		if (cChar >= '0' && cChar <= '9') ucDigit = cChar - '0';
+		else if (cChar >= 'a' && cChar <= 'f') ucDigit = cChar - 'a' + 10;
+		else if (cChar >= 'A' && cChar <= 'F') ucDigit = cChar - 'A' + 10;
+		else return -1;
+
+		if ((ucDigits & 1) == 0)
+		{
+			if (sSize == CMD_MAX_FRAME) return -1;
+			pcFrame[sSize] = ucDigit << 4;
+		}
+		else
+		{
+			pcFrame[sSize++] |= ucDigit;
+		}
+		ucDigits++;
+	}
+
+	return (ucDigits & 1) ? -1 : sSize;
+}
+#endif
+
+//batched acknowledgements leave some commands without a response
+static UnivRetCode enUplinkAnswer(unsigned int uiResponseSize)
+{
+	ProtoRequest xDownlink;
+
+	if (uiResponseSize == 0) return URC_SUCCESS;
+
+	xDownlink.pcData = (portCHAR *)pucResponse;
+	xDownlink.usSize = (unsigned portSHORT)uiResponseSize;
+	xDownlink.ucClass = RED_CLASS_STATUS;
+	xDownlink.ucRepeat = 0;
+	xDownlink.ucFlags = PROTO_FLAG_LAST;
+	xDownlink.vNotify = NULL;
+	xDownlink.pvTag = NULL;
+	return enProtoSubmit(Uplink_TaskToken, &xDownlink);
+}
+
+static void vUplinkRunStored(const UplinkCommand *pxCommand)
+{
+	cmdRequest xRequest;
+	unsigned int uiResponseSize;
+
+	xRequest.seq = pxCommand->ucSeq;
+	xRequest.opcode = pxCommand->usOpcode;
+	xRequest.args = pxCommand->pucArgs;
+	xRequest.argsSize = pxCommand->ucSize;
+
+	if (cmdExecute(&xDispatcher, &xRequest, pucResponse, &uiResponseSize) == URC_SUCCESS)
+	{
+		enUplinkAnswer(uiResponseSize);
+	}
+}
+
+static unsigned portSHORT usUplinkShort(const cmdArg *pxArg)
+{
+	return (pxArg->value[0] << 8) | pxArg->value[1];
+}
+
+static unsigned portLONG ulUplinkLong(const cmdArg *pxArg)
+{
+	return ((unsigned portLONG)pxArg->value[0] << 24) | ((unsigned portLONG)pxArg->value[1] << 16) |
+			(pxArg->value[2] << 8) | pxArg->value[3];
+}
+
+static void vUplinkPutLong(unsigned portCHAR *pucOut, unsigned portLONG ulValue)
+{
+	pucOut[0] = (ulValue >> 24) & 0xFF;
+	pucOut[1] = (ulValue >> 16) & 0xFF;
+	pucOut[2] = (ulValue >> 8) & 0xFF;
+	pucOut[3] = ulValue & 0xFF;
+}
+
+static UnivRetCode enUplinkAddr(const cmdRequest *pxRequest, unsigned portCHAR ucType, mbxAddr *pxAddr)
+{
+	cmdArg xArg;
+
+	if (cmdFindArg(pxRequest, ucType, UPLINK_ADDR_SIZE, &xArg) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	mbxMakeAddr(pxAddr, (const char *)xArg.value, MBX_CALL_SIZE, xArg.value[MBX_CALL_SIZE]);
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enUplinkPing(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	(void) pxRequest;
+	(void) pxResponse;
+	return URC_SUCCESS;
+}
+
+/*
+ * Runs on the command task like a tone pair from the DTMF decoder would,
+ * so keypad and binary commands can not race each other on the switches.
+ */
+static UnivRetCode enUplinkDtmfCode(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xArg;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_CODE, 1, &xArg) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enPostEvent(CMD_EVT_UPLINK, xArg.value[0]);
+}
+
+static UnivRetCode enUplinkBert(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xType;
+	cmdArg xSeconds;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_PRBS, 1, &xType) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SECONDS, 2, &xSeconds) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (xType.value[0] >= PRBS_NUM_TYPES || usUplinkShort(&xSeconds) == 0) return URC_CMD_BAD_ARG;
+
+	vComms_RequestBert(xType.value[0], usUplinkShort(&xSeconds));
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enUplinkLossReport(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xClass;
+	cmdArg xExpected;
+	cmdArg xLost;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_CLASS, 1, &xClass) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_EXPECTED, 2, &xExpected) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_LOST, 2, &xLost) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enProtoFeedback(xClass.value[0], usUplinkShort(&xExpected), usUplinkShort(&xLost));
+}
+
+static UnivRetCode enUplinkMailPost(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	mbxAddr xTo;
+	mbxAddr xFrom;
+	cmdArg xBody;
+	unsigned portSHORT usSeq;
+	unsigned portCHAR pucSeq[2];
+	UnivRetCode enResult;
+
+	if (enUplinkAddr(pxRequest, UPLINK_ARG_TO, &xTo) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (enUplinkAddr(pxRequest, UPLINK_ARG_FROM, &xFrom) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_BODY, 0, &xBody) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	enResult = enMailboxPost(Uplink_TaskToken, &xTo, &xFrom,
+							(portCHAR *)xBody.value, xBody.length, &usSeq);
+	if (enResult != URC_SUCCESS) return enResult;
+
+	pucSeq[0] = usSeq >> 8;
+	pucSeq[1] = usSeq & 0xFF;
+	return cmdBuildArg(pxResponse, UPLINK_ARG_SEQ, 2, pucSeq);
+}
+
+static UnivRetCode enUplinkMailList(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	mbxAddr xTo;
+	mbxEntry pxEntries[UPLINK_LIST_MAX];
+	unsigned portCHAR pucList[UPLINK_LIST_MAX * 4];
+	unsigned portSHORT usAfter = 0;
+	unsigned portCHAR ucCount;
+	unsigned portCHAR ucIndex;
+	cmdArg xArg;
+	UnivRetCode enResult;
+
+	if (enUplinkAddr(pxRequest, UPLINK_ARG_TO, &xTo) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SEQ, 2, &xArg) == URC_SUCCESS) usAfter = usUplinkShort(&xArg);
+
+	enResult = enMailboxList(Uplink_TaskToken, &xTo, usAfter, pxEntries, UPLINK_LIST_MAX, &ucCount);
+	if (enResult != URC_SUCCESS) return enResult;
+
+	for (ucIndex = 0; ucIndex < ucCount; ucIndex++)
+	{
+		pucList[ucIndex * 4]		= pxEntries[ucIndex].seq >> 8;
+		pucList[ucIndex * 4 + 1]	= pxEntries[ucIndex].seq & 0xFF;
+		pucList[ucIndex * 4 + 2]	= pxEntries[ucIndex].size >> 8;
+		pucList[ucIndex * 4 + 3]	= pxEntries[ucIndex].size & 0xFF;
+	}
+	//ground asks again after the last sequence listed for the next page
+	return cmdBuildArg(pxResponse, UPLINK_ARG_ENTRIES, ucCount * 4, pucList);
+}
+
+static UnivRetCode enUplinkMailSend(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	mbxAddr xTo;
+	cmdArg xSeq;
+
+	(void) pxResponse;
+	if (enUplinkAddr(pxRequest, UPLINK_ARG_TO, &xTo) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SEQ, 2, &xSeq) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enMailboxSend(Uplink_TaskToken, &xTo, usUplinkShort(&xSeq));
+}
+
+static UnivRetCode enUplinkMailDelete(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	mbxAddr xTo;
+	cmdArg xSeq;
+
+	(void) pxResponse;
+	if (enUplinkAddr(pxRequest, UPLINK_ARG_TO, &xTo) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SEQ, 2, &xSeq) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enMailboxDelete(Uplink_TaskToken, &xTo, usUplinkShort(&xSeq));
+}
+
+static UnivRetCode enUplinkUploadAck(cmdBuilder *pxResponse, const UploadStatus *pxStatus)
+{
+	unsigned portCHAR pucAck[UPLINK_ACK_SIZE];
+
+	pucAck[0] = pxStatus->enState;
+	pucAck[1] = pxStatus->xAck.next >> 8;
+	pucAck[2] = pxStatus->xAck.next & 0xFF;
+	pucAck[3] = pxStatus->xAck.base >> 8;
+	pucAck[4] = pxStatus->xAck.base & 0xFF;
+	pucAck[5] = pxStatus->xAck.received >> 8;
+	pucAck[6] = pxStatus->xAck.received & 0xFF;
+	pucAck[7] = pxStatus->xAck.missing >> 8;
+	pucAck[8] = pxStatus->xAck.missing & 0xFF;
+
+	return cmdBuildArg(pxResponse, UPLINK_ARG_UPLOAD_ACK, UPLINK_ACK_SIZE, pucAck);
+}
+
+static UnivRetCode enUplinkUploadOpen(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xOwner;
+	cmdArg xDID;
+	cmdArg xSize;
+	cmdArg xCrc;
+	UploadStatus xStatus;
+	UnivRetCode enResult;
+
+	if (cmdFindArg(pxRequest, UPLINK_ARG_OWNER, 1, &xOwner) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_DID, 1, &xDID) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SIZE, 4, &xSize) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_CRC, 4, &xCrc) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	enResult = enUploadOpen(Uplink_TaskToken, (TaskID)xOwner.value[0], xDID.value[0],
+							ulUplinkLong(&xSize), ulUplinkLong(&xCrc), &xStatus);
+	if (enResult != URC_SUCCESS) return enResult;
+
+	return enUplinkUploadAck(pxResponse, &xStatus);
+}
+
+static UnivRetCode enUplinkUploadChunk(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xIndex;
+	cmdArg xData;
+	UploadStatus xStatus;
+	UnivRetCode enResult;
+
+	if (cmdFindArg(pxRequest, UPLINK_ARG_INDEX, 2, &xIndex) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_DATA, 0, &xData) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	//left as is when the upload service never sees the chunk, answer then
+	xStatus.enState = UPLOAD_IDLE;
+	xStatus.xAck.next = 0;
+	xStatus.xAck.base = 0;
+	xStatus.xAck.received = 0;
+	xStatus.xAck.missing = 0;
+	xStatus.ucAckDue = 1;
+
+	enResult = enUploadChunk(Uplink_TaskToken, usUplinkShort(&xIndex),
+							(portCHAR *)xData.value, xData.length, &xStatus);
+
+	if (!xStatus.ucAckDue) return URC_CMD_NO_REPLY;
+	if (enUplinkUploadAck(pxResponse, &xStatus) != URC_SUCCESS) return URC_FAIL;
+	return enResult;
+}
+
+static UnivRetCode enUplinkUploadStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	UploadStatus xStatus;
+
+	(void) pxRequest;
+	if (enUploadStatus(Uplink_TaskToken, &xStatus) != URC_SUCCESS) return URC_FAIL;
+	return enUplinkUploadAck(pxResponse, &xStatus);
+}
+
+static UnivRetCode enUplinkUploadAbort(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	(void) pxRequest;
+	(void) pxResponse;
+	return enUploadAbort(Uplink_TaskToken);
+}
+
+static UnivRetCode enUplinkFwApply(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xDID;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_DID, 1, &xDID) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enFwUpdateApply(Uplink_TaskToken, xDID.value[0]);
+}
+
+static UnivRetCode enUplinkFwCommit(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	(void) pxRequest;
+	(void) pxResponse;
+	return enFwUpdateCommit(Uplink_TaskToken);
+}
+
+static UnivRetCode enUplinkModuleLoad(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xSlot;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SLOT, 1, &xSlot) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enModuleLoad(Uplink_TaskToken, xSlot.value[0]);
+}
+
+static UnivRetCode enUplinkModuleBoot(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xSlot;
+	cmdArg xEnable;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_SLOT, 1, &xSlot) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_ENABLE, 1, &xEnable) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enModuleBoot(Uplink_TaskToken, xSlot.value[0], xEnable.value[0]);
+}
+
+static UnivRetCode enUplinkModuleStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	unsigned portCHAR pucSlots[2];
+
+	(void) pxRequest;
+	if (enModuleStatus(Uplink_TaskToken, &pucSlots[0], &pucSlots[1]) != URC_SUCCESS) return URC_FAIL;
+	return cmdBuildArg(pxResponse, UPLINK_ARG_MODULES, sizeof(pucSlots), pucSlots);
+}
+
+static UnivRetCode enUplinkPassAdd(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xStart;
+	cmdArg xStop;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_START, 4, &xStart) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_STOP, 4, &xStop) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enPlannerAdd(Uplink_TaskToken, ulUplinkLong(&xStart), ulUplinkLong(&xStop));
+}
+
+static UnivRetCode enUplinkPassClear(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	(void) pxRequest;
+	(void) pxResponse;
+	return enPlannerClear(Uplink_TaskToken);
+}
+
+static UnivRetCode enUplinkTimeSet(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xTime;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_TIME, 4, &xTime) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enPlannerSetTime(Uplink_TaskToken, ulUplinkLong(&xTime));
+}
+
+static UnivRetCode enUplinkPassStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	unsigned portCHAR pucPasses[6];
+	unsigned portLONG ulNow = 0;
+	ppPhase enPhase;
+
+	(void) pxRequest;
+	if (enPlannerStatus(Uplink_TaskToken, &pucPasses[1], &ulNow) != URC_SUCCESS) return URC_FAIL;
+
+	enPhase = enPlannerPhase();
+	pucPasses[0] = (unsigned portCHAR)enPhase;
+	vUplinkPutLong(&pucPasses[2], ulNow);
+
+	return cmdBuildArg(pxResponse, UPLINK_ARG_PASSES, sizeof(pucPasses), pucPasses);
+}
+
+static UnivRetCode enUplinkSchedAdd(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xTime;
+	cmdArg xFrame;
+	portBASE_TYPE xRelative = pdFALSE;
+	unsigned portCHAR ucEntry;
+	UnivRetCode enResult;
+
+	if (cmdFindArg(pxRequest, UPLINK_ARG_FRAME, 0, &xFrame) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_TIME, 4, &xTime) != URC_SUCCESS)
+	{
+		if (cmdFindArg(pxRequest, UPLINK_ARG_DELAY, 4, &xTime) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+		xRelative = pdTRUE;
+	}
+
+	enResult = enScheduleAdd(Uplink_TaskToken, ulUplinkLong(&xTime), xRelative,
+							xFrame.value, xFrame.length, &ucEntry);
+	if (enResult != URC_SUCCESS) return enResult;
+
+	return cmdBuildArg(pxResponse, UPLINK_ARG_ENTRY, 1, &ucEntry);
+}
+
+static UnivRetCode enUplinkSchedCancel(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	cmdArg xEntry;
+
+	(void) pxResponse;
+	if (cmdFindArg(pxRequest, UPLINK_ARG_ENTRY, 1, &xEntry) != URC_SUCCESS) return URC_CMD_BAD_ARG;
+
+	return enScheduleCancel(Uplink_TaskToken, xEntry.value[0]);
+}
+
+static UnivRetCode enUplinkSchedStatus(const cmdRequest *pxRequest, cmdBuilder *pxResponse)
+{
+	unsigned portCHAR pucSchedule[10];
+	ScheduleStatus xStatus;
+
+	(void) pxRequest;
+	if (enScheduleStatus(Uplink_TaskToken, &xStatus) != URC_SUCCESS) return URC_FAIL;
+
+	pucSchedule[0] = xStatus.usHeld >> 8;
+	pucSchedule[1] = xStatus.usHeld & 0xFF;
+	vUplinkPutLong(&pucSchedule[2], xStatus.ulRun);
+	vUplinkPutLong(&pucSchedule[6], xStatus.ulMissed);
+
+	return cmdBuildArg(pxResponse, UPLINK_ARG_SCHEDULE, sizeof(pucSchedule), pucSchedule);
+}
+
+UnivRetCode enUplinkRegister(unsigned portSHORT usOpcode, cmdHandler xHandler)
+{
+	UnivRetCode enResult;
+
+	taskENTER_CRITICAL();
+	{
+		enResult = cmdRegister(&xDispatcher, usOpcode, xHandler);
+	}
+	taskEXIT_CRITICAL();
+
+	return enResult;
+}
+
+UnivRetCode enUplinkFrame(TaskToken taskToken, const portCHAR *pcFrame, unsigned portSHORT usSize)
+{
+	MessagePacket outgoing_packet;
+	UplinkRequest xRequest;
+
+	xRequest.pcFrame = pcFrame;
+	xRequest.usSize = usSize;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_UPLINK;
+	outgoing_packet.Data = (unsigned portLONG)&xRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enUplinkRun(TaskToken taskToken, const UplinkCommand *pxCommand)
+{
+	MessagePacket outgoing_packet;
+	UplinkCommand *pxCopy;
+	UnivRetCode enResult;
+
+	if (pxCommand == NULL || pxCommand->ucSize > UPLINK_RUN_ARGS_MAX) return URC_FAIL;
+
+	pxCopy = (UplinkCommand *)pvMessageAlloc(sizeof(UplinkCommand));
+	if (pxCopy == NULL) return URC_BUSY;
+	*pxCopy = *pxCommand;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_UPLINK;
+	outgoing_packet.Data = (unsigned portLONG)pxCopy;
+
+	enResult = enSendMessage(&outgoing_packet, NO_BLOCK);
+	if (enResult != URC_SUCCESS) vMessageFree(pxCopy);
+
+	return enResult;
+}
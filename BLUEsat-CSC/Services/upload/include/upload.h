@@ -0,0 +1,105 @@
+ /**
+ *  \file upload.h
+ *
+ *  \brief Object upload service. An object is sent up in numbered chunks
+ *  which are written straight into storage for the owning task, with
+ *  acknowledgements going back down every few chunks.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-01 14:05:00 +1000 (Sat, 01 Jun 2013) $
+ *  \warning One upload at a time, opening another replaces it
+ *  \bug No Bugs for now
+ *  \note The session is kept in storage so an upload carries on over later
+ *  passes and resets. The whole object CRC is checked against what was read
+ *  back from flash, not against what was received.
+ */
+
+#ifndef UPLOAD_H_
+#define UPLOAD_H_
+
+#include "service.h"
+#include "upWindow.h"
+
+//chunks accepted between acknowledgements
+#define UPLOAD_ACK_EVERY	8
+
+typedef enum
+{
+	UPLOAD_IDLE,
+	UPLOAD_RECEIVING,
+	UPLOAD_DONE,		//written and CRC checked
+	UPLOAD_CRC_FAIL		//object removed, open again to restart
+} UPLOAD_STATE;
+
+typedef struct
+{
+	UPLOAD_STATE		enState;
+	upAck				xAck;
+	unsigned portCHAR	ucAckDue;	//time to tell the ground station
+} UploadStatus;
+
+/**
+ * \brief Initialise upload service
+ *
+ * \param[in] uxPriority Priority for upload service.
+ */
+void vUpload_Init(unsigned portBASE_TYPE uxPriority);
+
+/**
+ * \brief Start an upload, or pick up the one already open for the same
+ * object, size and CRC
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] enOwner Task the object is stored for, picks the AID
+ * \param[in] ucDID Data ID of the object
+ * \param[in] ulSize Object size in bytes
+ * \param[in] ulCrc CRC-32 of the whole object
+ * \param[out] pxStatus Where to resume from
+ *
+ * \returns URC_SUCCESS or URC_FAIL
+ */
+UnivRetCode enUploadOpen(TaskToken taskToken,
+						TaskID enOwner,
+						unsigned portCHAR ucDID,
+						unsigned portLONG ulSize,
+						unsigned portLONG ulCrc,
+						UploadStatus *pxStatus);
+
+/**
+ * \brief Hand over one chunk of the open upload
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[in] usIndex Chunk number
+ * \param[in] pcData Chunk data, UP_CHUNK_SIZE bytes except for the last
+ * \param[in] usSize Bytes in the chunk
+ * \param[out] pxStatus Progress, ucAckDue says whether to report it
+ *
+ * \returns URC_SUCCESS, URC_FAIL for a chunk outside the window
+ */
+UnivRetCode enUploadChunk(TaskToken taskToken,
+						unsigned portSHORT usIndex,
+						portCHAR *pcData,
+						unsigned portSHORT usSize,
+						UploadStatus *pxStatus);
+
+/**
+ * \brief Progress of the current upload
+ *
+ * \param[in] taskToken Task token from request task
+ * \param[out] pxStatus Progress
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enUploadStatus(TaskToken taskToken, UploadStatus *pxStatus);
+
+/**
+ * \brief Drop the current upload and what has been written of it
+ *
+ * \param[in] taskToken Task token from request task
+ *
+ * \returns URC_SUCCESS
+ */
+UnivRetCode enUploadAbort(TaskToken taskToken);
+
+#endif /* UPLOAD_H_ */
@@ -0,0 +1,373 @@
+ /**
+ *  \file upload.c
+ *
+ *  \brief Object upload service. An object is sent up in numbered chunks
+ *  which are written straight into storage for the owning task, with
+ *  acknowledgements going back down every few chunks.
+ *
+ *  \version 1.0
+ *
+ *  $Date: 2013-06-01 14:05:00 +1000 (Sat, 01 Jun 2013) $
+ *  \warning One upload at a time, opening another replaces it
+ *  \bug No Bugs for now
+ *  \note Chunks wait in the window until a storage block worth is in and
+ *  are then appended, so external SRAM is never used for staging
+ */
+
+#include "service.h"
+#include "upload.h"
+#include "storage.h"
+#include "debug.h"
+
+#define UPLOAD_Q_SIZE		2
+//data ID of our own session record
+#define UPLOAD_SESSION_DID	0
+
+typedef enum
+{
+	UPLOAD_OPEN,
+	UPLOAD_CHUNK,
+	UPLOAD_STATUS,
+	UPLOAD_ABORT
+} UPLOAD_OPERATIONS;
+
+typedef struct
+{
+	UPLOAD_OPERATIONS	Operation;
+	TaskID				enOwner;
+	unsigned portCHAR	ucDID;
+	unsigned portLONG	ulSize;
+	unsigned portLONG	ulCrc;
+	unsigned portSHORT	usIndex;
+	portCHAR			*pcData;
+	unsigned portSHORT	usChunkSize;
+	UploadStatus		*pxStatus;
+} UploadRequest;
+
+typedef struct
+{
+	unsigned portCHAR	ucOwner;
+	unsigned portCHAR	ucDID;
+	unsigned portLONG	ulSize;
+	unsigned portLONG	ulCrc;
+} UploadSession;
+
+//task token for accessing services
+static TaskToken Upload_TaskToken;
+
+static UploadSession xSession;
+static UPLOAD_STATE enState;
+static upWindow xWindow;
+static unsigned portCHAR ucSinceAck;
+static portCHAR pcVerify[UP_CHUNK_SIZE];
+
+//prototype for task function
+static portTASK_FUNCTION(vUploadTask, pvParameters);
+static void vUploadResume(void);
+static UnivRetCode enUploadStart(UploadRequest *pxRequest);
+static UnivRetCode enUploadAccept(UploadRequest *pxRequest);
+static UnivRetCode enUploadWriteOut(void);
+static void vUploadVerify(void);
+static void vUploadDrop(void);
+static void vUploadFillStatus(UploadStatus *pxStatus);
+static UnivRetCode enUploadProcessRequest(TaskToken taskToken, UploadRequest *pxRequest);
+
+void vUpload_Init(unsigned portBASE_TYPE uxPriority)
+{
+	enState = UPLOAD_IDLE;
+
+	Upload_TaskToken = ActivateTask(TASK_UPLOAD,
+									"Upload",
+									SEV_TASK_TYPE,
+									uxPriority,
+									SERV_STACK_SIZE,
+									vUploadTask);
+
+	vActivateQueue(Upload_TaskToken, UPLOAD_Q_SIZE);
+	//chunks arrive during a pass, their storage writes go ahead of logging
+	vSetRequestLane(Upload_TaskToken, CMD_LANE_URGENT);
+}
+
+static portTASK_FUNCTION(vUploadTask, pvParameters)
+{
+	(void) pvParameters;
+	UnivRetCode enResult;
+	MessagePacket incoming_packet;
+	UploadRequest *pxRequest;
+
+	vUploadResume();
+
+	for ( ; ; )
+	{
+		enResult = enGetRequest(Upload_TaskToken, &incoming_packet, portMAX_DELAY);
+
+		if (enResult != URC_SUCCESS) continue;
+
+		pxRequest = (UploadRequest *)incoming_packet.Data;
+
+		switch (pxRequest->Operation)
+		{
+			case UPLOAD_OPEN	:	enResult = enUploadStart(pxRequest);
+									break;
+
+			case UPLOAD_CHUNK	:	enResult = enUploadAccept(pxRequest);
+									break;
+
+			case UPLOAD_STATUS	:	enResult = URC_SUCCESS;
+									break;
+
+			case UPLOAD_ABORT	:	vUploadDrop();
+									enResult = URC_SUCCESS;
+									break;
+
+			default				:	enResult = URC_FAIL;
+									break;
+		}
+
+		if (pxRequest->pxStatus != NULL) vUploadFillStatus(pxRequest->pxStatus);
+
+		vCompleteRequest(incoming_packet.Token, enResult);
+	}
+}
+
+/*
+ * Whatever reached flash before a reset is kept, the chunks that were
+ * still in the window are asked for again.
+ */
+static void vUploadResume(void)
+{
+	unsigned portLONG ulRead = 0;
+	unsigned portLONG ulWritten = 0;
+
+	if (enDataRead(Upload_TaskToken, UPLOAD_SESSION_DID, 0, sizeof(UploadSession),
+					(portCHAR *)&xSession, &ulRead) != URC_SUCCESS) return;
+	if (ulRead != sizeof(UploadSession)) return;
+
+	enDataSizeFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID, &ulWritten);
+
+	if (upInit(&xWindow, xSession.ulSize, ulWritten) != URC_SUCCESS)
+	{
+		//torn write, start the object again
+		enDataDeleteFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID);
+		upInit(&xWindow, xSession.ulSize, 0);
+	}
+
+	enState = UPLOAD_RECEIVING;
+	ucSinceAck = 0;
+	if (upComplete(&xWindow)) vUploadVerify();
+}
+
+static UnivRetCode enUploadStart(UploadRequest *pxRequest)
+{
+	unsigned portLONG ulWritten = 0;
+
+	//same object again, carry on from where it got to
+	if (enState != UPLOAD_IDLE &&
+		xSession.ucOwner == pxRequest->enOwner &&
+		xSession.ucDID == pxRequest->ucDID &&
+		xSession.ulSize == pxRequest->ulSize &&
+		xSession.ulCrc == pxRequest->ulCrc &&
+		enState != UPLOAD_CRC_FAIL)
+	{
+		ucSinceAck = 0;
+		return URC_SUCCESS;
+	}
+
+	vUploadDrop();
+	if (upInit(&xWindow, pxRequest->ulSize, 0) != URC_SUCCESS) return URC_FAIL;
+
+	xSession.ucOwner = pxRequest->enOwner;
+	xSession.ucDID = pxRequest->ucDID;
+	xSession.ulSize = pxRequest->ulSize;
+	xSession.ulCrc = pxRequest->ulCrc;
+
+	//an object already stored whole may be this one, uploaded before a reset
+	if (enDataSizeFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID, &ulWritten) != URC_SUCCESS) return URC_FAIL;
+
+	if (enDataStore(Upload_TaskToken, UPLOAD_SESSION_DID, sizeof(UploadSession),
+					(portCHAR *)&xSession) != URC_SUCCESS) return URC_FAIL;
+
+	enState = UPLOAD_RECEIVING;
+	ucSinceAck = 0;
+
+	if (ulWritten == xSession.ulSize)
+	{
+		upInit(&xWindow, xSession.ulSize, ulWritten);
+		vUploadVerify();
+	}
+	else if (ulWritten > 0)
+	{
+		enDataDeleteFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID);
+	}
+
+	return URC_SUCCESS;
+}
+
+static UnivRetCode enUploadAccept(UploadRequest *pxRequest)
+{
+	UnivRetCode enResult;
+
+	if (enState != UPLOAD_RECEIVING)
+	{
+		ucSinceAck = UPLOAD_ACK_EVERY;
+		return (enState == UPLOAD_DONE) ? URC_SUCCESS : URC_FAIL;
+	}
+
+	enResult = upAccept(&xWindow, pxRequest->usIndex,
+						(const unsigned char *)pxRequest->pcData, pxRequest->usChunkSize);
+
+	//a refused chunk means the ground station is ahead of us, tell it now
+	ucSinceAck = (enResult == URC_SUCCESS) ? ucSinceAck + 1 : UPLOAD_ACK_EVERY;
+
+	if (enUploadWriteOut() != URC_SUCCESS) return URC_FAIL;
+
+	if (upComplete(&xWindow))
+	{
+		vUploadVerify();
+		ucSinceAck = UPLOAD_ACK_EVERY;
+	}
+
+	return enResult;
+}
+
+static UnivRetCode enUploadWriteOut(void)
+{
+	const unsigned char *pucData;
+	unsigned int uiSize;
+
+	while ((uiSize = upReady(&xWindow, &pucData)) > 0)
+	{
+		//the group stays in the window and goes again with the next chunk
+		if (enDataAppendFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID,
+							uiSize, (portCHAR *)pucData) != URC_SUCCESS) return URC_FAIL;
+		upWritten(&xWindow);
+	}
+
+	return URC_SUCCESS;
+}
+
+static void vUploadVerify(void)
+{
+	unsigned portLONG ulOffset;
+	unsigned portLONG ulRead;
+	unsigned portLONG ulCrc = 0;
+
+	for (ulOffset = 0; ulOffset < xSession.ulSize; ulOffset += ulRead)
+	{
+		ulRead = 0;
+		enDataReadFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID, ulOffset,
+						UP_CHUNK_SIZE, pcVerify, &ulRead);
+		if (ulRead == 0) break;
+		ulCrc = upCrc32(ulCrc, (const unsigned char *)pcVerify, ulRead);
+	}
+
+	if (ulOffset == xSession.ulSize && ulCrc == xSession.ulCrc)
+	{
+		enState = UPLOAD_DONE;
+		enDataDelete(Upload_TaskToken, UPLOAD_SESSION_DID);
+		vDebugPrint(Upload_TaskToken, "Upload of %d bytes verified\n\r", xSession.ulSize, NO_INSERT, NO_INSERT);
+		return;
+	}
+
+	vDebugPrint(Upload_TaskToken, "Upload CRC %x, expected %x\n\r", ulCrc, xSession.ulCrc, NO_INSERT);
+	enDataDeleteFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID);
+	enDataDelete(Upload_TaskToken, UPLOAD_SESSION_DID);
+	enState = UPLOAD_CRC_FAIL;
+}
+
+static void vUploadDrop(void)
+{
+	if (enState == UPLOAD_RECEIVING)
+	{
+		enDataDeleteFor(Upload_TaskToken, xSession.ucOwner, xSession.ucDID);
+		enDataDelete(Upload_TaskToken, UPLOAD_SESSION_DID);
+	}
+	enState = UPLOAD_IDLE;
+}
+
+static void vUploadFillStatus(UploadStatus *pxStatus)
+{
+	pxStatus->enState = enState;
+	pxStatus->ucAckDue = (ucSinceAck >= UPLOAD_ACK_EVERY);
+	if (pxStatus->ucAckDue) ucSinceAck = 0;
+
+	if (enState == UPLOAD_IDLE)
+	{
+		pxStatus->xAck.next = 0;
+		pxStatus->xAck.base = 0;
+		pxStatus->xAck.received = 0;
+		pxStatus->xAck.missing = 0;
+		return;
+	}
+	upGetAck(&xWindow, &pxStatus->xAck);
+}
+
+static UnivRetCode enUploadProcessRequest(TaskToken taskToken, UploadRequest *pxRequest)
+{
+	MessagePacket outgoing_packet;
+
+	outgoing_packet.Token = taskToken;
+	outgoing_packet.Src = enGetTaskID(taskToken);
+	outgoing_packet.Dest = TASK_UPLOAD;
+	outgoing_packet.Data = (unsigned portLONG)pxRequest;
+
+	return enProcessRequest(&outgoing_packet, portMAX_DELAY);
+}
+
+UnivRetCode enUploadOpen(TaskToken taskToken,
+						TaskID enOwner,
+						unsigned portCHAR ucDID,
+						unsigned portLONG ulSize,
+						unsigned portLONG ulCrc,
+						UploadStatus *pxStatus)
+{
+	UploadRequest xRequest;
+
+	if (enOwner >= NUM_TASKID) return URC_CMD_INVALID_TASK;
+
+	xRequest.Operation = UPLOAD_OPEN;
+	xRequest.enOwner = enOwner;
+	xRequest.ucDID = ucDID;
+	xRequest.ulSize = ulSize;
+	xRequest.ulCrc = ulCrc;
+	xRequest.pxStatus = pxStatus;
+
+	return enUploadProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enUploadChunk(TaskToken taskToken,
+						unsigned portSHORT usIndex,
+						portCHAR *pcData,
+						unsigned portSHORT usSize,
+						UploadStatus *pxStatus)
+{
+	UploadRequest xRequest;
+
+	xRequest.Operation = UPLOAD_CHUNK;
+	xRequest.usIndex = usIndex;
+	xRequest.pcData = pcData;
+	xRequest.usChunkSize = usSize;
+	xRequest.pxStatus = pxStatus;
+
+	return enUploadProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enUploadStatus(TaskToken taskToken, UploadStatus *pxStatus)
+{
+	UploadRequest xRequest;
+
+	xRequest.Operation = UPLOAD_STATUS;
+	xRequest.pxStatus = pxStatus;
+
+	return enUploadProcessRequest(taskToken, &xRequest);
+}
+
+UnivRetCode enUploadAbort(TaskToken taskToken)
+{
+	UploadRequest xRequest;
+
+	xRequest.Operation = UPLOAD_ABORT;
+	xRequest.pxStatus = NULL;
+
+	return enUploadProcessRequest(taskToken, &xRequest);
+}
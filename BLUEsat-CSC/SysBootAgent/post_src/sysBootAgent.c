@@ -13,6 +13,11 @@ unsigned int initDrivers(void)
 {
     rtc_time_t time;
 
+#ifdef FWUPDATE_H_
+	//staged firmware goes in before anything else starts, does not return if it does
+	vFwUpdate_Install();
+#endif//
+
 #ifdef GPIO_H_
 	Gpio_Init();
 #endif//
@@ -64,8 +69,10 @@ unsigned int initDrivers(void)
 	return 0;
 }
 
-//Priority used for all service tasks
-#define SERV_TASK_PRIORITY	30
+//Priority used for all service tasks, the command task runs one above and
+//applications one below. Kept under configMAX_PRIORITIES, anything higher
+//is clamped to the top level and lock.h could not raise a holder past anyone
+#define SERV_TASK_PRIORITY	(configMAX_PRIORITIES - 2)
 
 unsigned int initServices(void)
 {
@@ -82,7 +89,7 @@ unsigned int initServices(void)
 
 #ifdef STORAGE_H_
 	//memory task
-	//vStorage_Init(SERV_TASK_PRIORITY);
+	vStorage_Init(SERV_TASK_PRIORITY);
 #endif//*/
 
 #ifdef DEBUG_H_
@@ -102,6 +109,45 @@ unsigned int initServices(void)
 	Comms_DTMF_Init();
 #endif
 
+#ifdef PROTOCOLS_H_
+	vProtocols_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef MAILBOX_H_
+	//store and forward mailbox, needs storage and protocols
+	vMailbox_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef UPLOAD_H_
+	//chunked object uploads into storage
+	vUpload_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef FWUPDATE_H_
+	//firmware patches applied into staging flash
+	vFwUpdate_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef MODULES_H_
+	//loadable modules in external RAM, needs memory and storage
+	vModules_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef PLANNER_H_
+	//pass schedule, holds downlink frames through protocols
+	vPlanner_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef SCHEDULE_H_
+	//time tagged commands, run through uplink
+	vSchedule_Init(SERV_TASK_PRIORITY);
+#endif
+
+#ifdef UPLINK_H_
+	//binary command frames, answers go out through protocols
+	vUplink_Init(SERV_TASK_PRIORITY);
+#endif
+
 #ifdef COMMS_H_
 	vComms_Init(SERV_TASK_PRIORITY);
 #endif
@@ -109,7 +155,7 @@ unsigned int initServices(void)
 }
 
 //Priority used for all application tasks
-#define APP_TASK_PRIORITY		25
+#define APP_TASK_PRIORITY		(SERV_TASK_PRIORITY - 1)
 
 unsigned int initApplications(void)
 {
@@ -157,5 +203,15 @@ unsigned int initApplications(void)
 #ifdef COMMSDEMO_H_
 	//vCommsDemo_Init(APP_TASK_PRIORITY);
 #endif
+
+#ifdef STRING_BENCH_DEMO_H_
+	//Timing of memcpy, memset and memcmp against the byte loops
+	//vStringBenchDemo_Init(APP_TASK_PRIORITY);
+#endif
+
+#ifdef IPC_BENCH_DEMO_H_
+	//Request round trips, build with CMD_DIRECT_ROUTING 0 to compare
+	//vIpcBenchDemo_Init(APP_TASK_PRIORITY);
+#endif
 	return 0;
 }
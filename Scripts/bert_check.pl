@@ -0,0 +1,62 @@
+use strict;
+use warnings;
+use Getopt::Long;
+use bert_check qw(check_bits read_bits read_wav demod_afsk);
+
+my $type   = 9;
+my $format = 'text';
+
+unless ( GetOptions ('type=i' => \$type, 'format=s' => \$format) && @ARGV == 1 )
+{
+   usage();
+   exit 0;
+}
+
+my $file = $ARGV[0];
+my $bits;
+if ($format eq 'wav')
+{
+   my ($samples, $rate) = read_wav($file);
+   $bits = demod_afsk($samples, $rate);
+}
+else
+{
+   $bits = read_bits($file, $format eq 'bin');
+}
+
+my $result = check_bits($bits, $type);
+unless ($result->{synced})
+{
+   print "No PRBS$type found in $file\n";
+   exit 1;
+}
+
+printf <<MOO_SQUID, $type, $result->{skipped}, $result->{bits}, $result->{errors}, $result->{ber}, $result->{bursts}, $result->{longest_burst}, $result->{sync_losses};
+BERT Results (PRBS%d)
+---------------------
+Bits hunting sync : %d
+Bits checked      : %d
+Bit errors        : %d
+Bit error rate    : %.3e
+Error bursts      : %d
+Longest burst     : %d bits
+Sync losses       : %d
+MOO_SQUID
+exit 0;
+
+sub usage
+{
+   print <<MOO_SQUID;
+Bluesat Downlink Bit Error Rate Checker
+---------------------------------------
+   perl bert_check.pl [--type 9|15] [--format text|bin|wav] <capture>
+
+   Syncs to the PRBS sent by the satellite in BERT mode and reports bit
+and burst error statistics. text captures hold demodulated bits as 0 and
+1 characters, bin captures hold the bytes least significant bit first and
+wav captures are demodulated as 1200 baud Bell 202 AFSK. Captured bits
+must already be NRZI decoded, wav captures are decoded here.
+
+Example: perl bert_check.pl --type 15 --format wav pass.wav
+MOO_SQUID
+}
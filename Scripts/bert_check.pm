@@ -0,0 +1,243 @@
+package bert_check;
+
+use strict;
+use Exporter;
+use vars qw($VERSION @ISA @EXPORT @EXPORT_OK %EXPORT_TAGS);
+use constant {
+        MARK_HZ        => 1200,
+        SPACE_HZ       => 2200,
+        BAUD           => 1200,
+        LOCK_WINDOW    => 64,      # bits watched for loss of sync
+        LOCK_ERRORS    => 16,      # errors in the window that drop sync
+        PI             => 4 * atan2(1, 1)
+    };
+$VERSION     = 1.00;
+@ISA         = qw(Exporter);
+@EXPORT      = ();
+@EXPORT_OK   = qw( prbs_bits check_bits read_bits read_wav demod_afsk nrzi_decode);
+
+# Same polynomials as Libraries/prbs, order and tap places back
+my %polynomials = (
+                     9  => [9, 5],
+                     15 => [15, 14]
+                  );
+
+sub polynomial
+{
+   my $type = shift;
+   die "Unknown PRBS type $type\n" unless exists $polynomials{$type};
+   return @{$polynomials{$type}};
+}
+
+# Reference sequence from the all ones state, as the satellite sends it
+sub prbs_bits
+{
+   my ($type, $count) = @_;
+   my ($order, $tap) = polynomial($type);
+   my $mask  = (1 << $order) - 1;
+   my $state = $mask;
+   my @bits;
+   for (1..$count)
+   {
+      my $bit = (($state >> ($order - 1)) ^ ($state >> ($tap - 1))) & 1;
+      $state = (($state << 1) | $bit) & $mask;
+      push (@bits, $bit);
+   }
+   return \@bits;
+}
+
+# Sync by predicting each received bit from the ones before it, then run a
+# local generator and count where the received bits differ. Errors less
+# than one register length apart are counted as one burst.
+sub check_bits
+{
+   my ($bits, $type) = @_;
+   my ($order, $tap) = polynomial($type);
+   my $mask = (1 << $order) - 1;
+   my $result = {
+                  bits          => 0,
+                  errors        => 0,
+                  bursts        => 0,
+                  longest_burst => 0,
+                  sync_losses   => 0,
+                  skipped       => 0,
+                  synced        => 0
+                };
+   my ($reg, $filled, $run) = (0, 0, 0);
+   my $locked = 0;
+   my @window;
+   my $windowErrors = 0;
+   my ($lastError, $burstStart);
+
+   foreach my $bit (@$bits)
+   {
+      unless ($locked)
+      {
+         $result->{skipped}++;
+         my $predicted = (($reg >> ($order - 1)) ^ ($reg >> ($tap - 1))) & 1;
+         $run = ($filled >= $order && $predicted == $bit) ? $run + 1 : 0;
+         $reg = (($reg << 1) | $bit) & $mask;
+         $filled++;
+         if ($run >= 2 * $order)
+         {
+            $locked = 1;
+            $result->{synced} = 1;
+            @window = ();
+            $windowErrors = 0;
+            undef $lastError;
+         }
+         next;
+      }
+
+      my $expected = (($reg >> ($order - 1)) ^ ($reg >> ($tap - 1))) & 1;
+      $reg = (($reg << 1) | $expected) & $mask;
+      my $error = ($expected != $bit) ? 1 : 0;
+      my $position = $result->{bits}++;
+
+      if ($error)
+      {
+         $result->{errors}++;
+         if (!defined $lastError || $position - $lastError >= $order)
+         {
+            $result->{bursts}++;
+            $burstStart = $position;
+         }
+         my $length = $position - $burstStart + 1;
+         $result->{longest_burst} = $length if $length > $result->{longest_burst};
+         $lastError = $position;
+      }
+
+      push (@window, $error);
+      $windowErrors += $error;
+      $windowErrors -= shift(@window) if @window > LOCK_WINDOW;
+      if ($windowErrors > LOCK_ERRORS)
+      {
+         # slipped or lost the signal, hunt again from the received bits
+         $result->{sync_losses}++;
+         $locked = 0;
+         ($reg, $filled, $run) = (0, 0, 0);
+      }
+   }
+   $result->{ber} = ($result->{bits} > 0) ? $result->{errors} / $result->{bits} : 0;
+   return $result;
+}
+
+# Captured bits, either text of 0 and 1 characters or raw bytes sent LSB first
+sub read_bits
+{
+   my ($file, $binary) = @_;
+   open (my $fh, '<', $file) or die "Can not open $file: $!\n";
+   binmode $fh;
+   local $/;
+   my $data = <$fh>;
+   close $fh;
+   my @bits;
+   if ($binary)
+   {
+      foreach my $byte (unpack ('C*', $data))
+      {
+         push (@bits, ($byte >> $_) & 1) for (0..7);
+      }
+   }
+   else
+   {
+      @bits = map { $_ + 0 } ($data =~ /([01])/g);
+   }
+   return \@bits;
+}
+
+# PCM wav, 8 or 16 bit, first channel only
+sub read_wav
+{
+   my $file = shift;
+   open (my $fh, '<', $file) or die "Can not open $file: $!\n";
+   binmode $fh;
+   local $/;
+   my $data = <$fh>;
+   close $fh;
+   die "$file is not a wav file\n" unless substr($data, 0, 4) eq 'RIFF' && substr($data, 8, 4) eq 'WAVE';
+
+   my ($channels, $rate, $width, $samples);
+   my $pos = 12;
+   while ($pos + 8 <= length $data)
+   {
+      my ($id, $size) = unpack ('A4 V', substr($data, $pos, 8));
+      if ($id eq 'fmt')
+      {
+         my $format;
+         ($format, $channels, $rate) = unpack ('v v V', substr($data, $pos + 8, 8));
+         $width = unpack ('v', substr($data, $pos + 22, 2));
+         die "$file is not PCM\n" unless $format == 1;
+      }
+      elsif ($id eq 'data')
+      {
+         die "$file has no format chunk\n" unless defined $rate;
+         my $raw = substr($data, $pos + 8, $size);
+         my @all = ($width == 8) ? map { $_ - 128 } unpack ('C*', $raw) : unpack ('s<*', $raw);
+         $samples = [ @all[ grep { $_ % $channels == 0 } 0..$#all ] ];
+      }
+      $pos += 8 + $size + ($size & 1);
+   }
+   die "$file has no samples\n" unless defined $samples;
+   return ($samples, $rate);
+}
+
+# Bell 202 tones to NRZI decoded bits. Mark and space energy over a sliding
+# bit period picks the tone, a phase accumulator pulled toward tone changes
+# picks the sampling instant.
+sub demod_afsk
+{
+   my ($samples, $rate) = @_;
+   my $period = $rate / BAUD;
+   my $window = int($period + 0.5);
+   my @mark  = (2 * PI * MARK_HZ / $rate, 0, 0);
+   my @space = (2 * PI * SPACE_HZ / $rate, 0, 0);
+   my (@history, @tones);
+   my $phase = 0;
+   my $previous = 0;
+
+   for my $n (0..$#$samples)
+   {
+      my $s = $samples->[$n];
+      my @terms = ($s * cos($mark[0] * $n), $s * sin($mark[0] * $n),
+                   $s * cos($space[0] * $n), $s * sin($space[0] * $n));
+      push (@history, \@terms);
+      $mark[1]  += $terms[0]; $mark[2]  += $terms[1];
+      $space[1] += $terms[2]; $space[2] += $terms[3];
+      if (@history > $window)
+      {
+         my $old = shift @history;
+         $mark[1]  -= $old->[0]; $mark[2]  -= $old->[1];
+         $space[1] -= $old->[2]; $space[2] -= $old->[3];
+      }
+      my $tone = (($mark[1] ** 2 + $mark[2] ** 2) > ($space[1] ** 2 + $space[2] ** 2)) ? 1 : 0;
+
+      if ($tone != $previous)
+      {
+         $phase -= ($phase - $period / 2) * 0.3;
+      }
+      $previous = $tone;
+
+      $phase += 1;
+      if ($phase >= $period)
+      {
+         $phase -= $period;
+         push (@tones, $tone);
+      }
+   }
+   return nrzi_decode(\@tones);
+}
+
+# The modem toggles the tone for a 0 and holds it for a 1
+sub nrzi_decode
+{
+   my $tones = shift;
+   my @bits;
+   for my $i (1..$#$tones)
+   {
+      push (@bits, ($tones->[$i] == $tones->[$i - 1]) ? 1 : 0);
+   }
+   return \@bits;
+}
+
+1;
@@ -0,0 +1,86 @@
+#!perl
+
+use strict;
+use warnings;
+use Test::More 'no_plan';
+my @subs = qw (prbs_bits check_bits read_bits read_wav demod_afsk nrzi_decode);
+use_ok( 'bert_check',@subs) or exit;
+
+# Generator
+# ---------
+my $bits = bert_check::prbs_bits(9, 1022);
+is_deeply ([@$bits[0..510]], [@$bits[511..1021]], 'prbs_bits: PRBS9 repeats every 511 bits');
+my $ones = 0;
+$ones += $_ for @$bits[0..510];
+ok ($ones == 256, 'prbs_bits: PRBS9 is balanced');
+ok (!eval { bert_check::prbs_bits(7, 10); 1 }, 'prbs_bits: Unknown type is rejected');
+
+# Checker
+# -------
+my $result = bert_check::check_bits(bert_check::prbs_bits(15, 5000), 15);
+ok ($result->{synced}, 'check_bits: Clean stream syncs');
+ok ($result->{errors} == 0 && $result->{bursts} == 0, 'check_bits: Clean stream has no errors');
+ok ($result->{bits} + $result->{skipped} == 5000, 'check_bits: Every bit is accounted for');
+
+# join mid sequence and flip isolated bits and one burst
+$bits = bert_check::prbs_bits(9, 4000);
+my @rx = @$bits[100..3999];
+$rx[1000] ^= 1;
+$rx[2000] ^= 1;
+$rx[$_] ^= 1 for (3000, 3002, 3005);
+$result = bert_check::check_bits(\@rx, 9);
+ok ($result->{errors} == 5, 'check_bits: Counts each flipped bit once');
+ok ($result->{bursts} == 3, 'check_bits: Groups close errors into bursts');
+ok ($result->{longest_burst} == 6, 'check_bits: Measures the longest burst');
+ok ($result->{sync_losses} == 0, 'check_bits: Isolated errors keep sync');
+
+# a slip in the stream loses sync and finds it again
+@rx = (@$bits[0..1999], @$bits[2100..3999]);
+$result = bert_check::check_bits(\@rx, 9);
+ok ($result->{sync_losses} == 1, 'check_bits: Slip drops sync');
+ok ($result->{bits} > 3500, 'check_bits: Sync is found again after a slip');
+
+$result = bert_check::check_bits([map { int(rand(2)) } 1..2000], 15);
+ok (!$result->{synced}, 'check_bits: Noise does not sync');
+
+# Captures
+# --------
+my $testFile = 'bert_check_test.tmp';
+open (my $fh, '>', $testFile);
+binmode $fh;
+print $fh pack ('C*', 0x01, 0x80);
+close $fh;
+is_deeply (bert_check::read_bits($testFile, 1), [1,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,1], 'read_bits: Binary is LSB first');
+open ($fh, '>', $testFile);
+print $fh "10 11\n0";
+close $fh;
+is_deeply (bert_check::read_bits($testFile, 0), [1,0,1,1,0], 'read_bits: Text skips whitespace');
+
+is_deeply (bert_check::nrzi_decode([0,0,1,0,0]), [1,0,0,1], 'nrzi_decode: Held tone is a 1');
+
+# AFSK round trip through a wav file
+my $rate = 9600;
+$bits = bert_check::prbs_bits(9, 600);
+my ($tone, $phase) = (0, 0);
+my @samples;
+foreach my $bit (@$bits)
+{
+   $tone = !$tone unless $bit;
+   for (1..$rate / 1200)
+   {
+      $phase += 2 * 3.14159265 * ($tone ? 1200 : 2200) / $rate;
+      push (@samples, int(12000 * sin($phase)));
+   }
+}
+my $pcm = pack ('s<*', @samples);
+open ($fh, '>', $testFile);
+binmode $fh;
+print $fh 'RIFF', pack ('V', 36 + length $pcm), 'WAVE';
+print $fh 'fmt ', pack ('V v v V V v v', 16, 1, 1, $rate, $rate * 2, 2, 16);
+print $fh 'data', pack ('V', length $pcm), $pcm;
+close $fh;
+my ($wav, $wavRate) = bert_check::read_wav($testFile);
+ok ($wavRate == $rate && @$wav == @samples, 'read_wav: Reads rate and samples');
+$result = bert_check::check_bits(bert_check::demod_afsk($wav, $wavRate), 9);
+ok ($result->{synced} && $result->{errors} == 0, 'demod_afsk: Clean tones decode without errors');
+unlink $testFile;
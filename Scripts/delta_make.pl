@@ -0,0 +1,49 @@
+use strict;
+use warnings;
+use delta_make qw(make_patch apply_patch read_image write_image);
+
+# chunk size and rate of the upload path
+my $chunk = 128;
+my $baud  = 1200;
+
+unless (@ARGV == 3)
+{
+   usage();
+   exit 0;
+}
+
+my ($oldFile, $newFile, $patchFile) = @ARGV;
+my $old = read_image($oldFile);
+my $new = read_image($newFile);
+my $patch = make_patch($old, $new);
+
+# never hand over a patch the satellite would refuse
+die "Patch does not reproduce $newFile\n" unless apply_patch($old, $patch) eq $new;
+write_image($patchFile, $patch);
+
+printf <<MOO_SQUID, length $new, length $patch, 100 * length($patch) / length($new), int((length($patch) + $chunk - 1) / $chunk), length($patch) * 8 / $baud, length($new) * 8 / $baud;
+Delta Patch
+-----------
+Full image        : %d bytes
+Patch             : %d bytes (%.1f%%)
+Upload chunks     : %d
+Airtime, patch    : %.0f s
+Airtime, image    : %.0f s
+MOO_SQUID
+exit 0;
+
+sub usage
+{
+   print <<MOO_SQUID;
+Bluesat Firmware Delta Patch Maker
+----------------------------------
+   perl delta_make.pl <running image> <new image> <patch>
+
+   Builds a patch that turns the image running on the satellite into the
+new one. Both must be the raw bytes as programmed, vector checksum
+included. The patch is checked by applying it here before it is written,
+upload it to the firmware update service and apply it there.
+
+Example: perl delta_make.pl flight-1.4.bin flight-1.5.bin 1.4-1.5.dlt
+MOO_SQUID
+}
@@ -0,0 +1,221 @@
+package delta_make;
+
+use strict;
+use Exporter;
+use vars qw($VERSION @ISA @EXPORT @EXPORT_OK %EXPORT_TAGS);
+use constant {
+        MAGIC          => 0x31544C44,  # "DLT1", same as Libraries/delta
+        OP_END         => 0x00,
+        OP_COPY        => 0x01,
+        OP_INSERT      => 0x02,
+        OP_EDIT        => 0x03,
+        BLOCK          => 8,           # bytes hashed to find matches
+        CANDIDATES     => 8,           # source places tried for each block
+        MAX_GAP        => 8,           # mismatches in a row that end a region
+        MIN_MATCHES    => 12           # matching bytes worth a region
+    };
+$VERSION     = 1.00;
+@ISA         = qw(Exporter);
+@EXPORT      = ();
+@EXPORT_OK   = qw( crc32 make_patch apply_patch read_image write_image);
+
+sub crc32
+{
+   my ($data, $crc) = @_;
+   $crc = ~($crc || 0) & 0xFFFFFFFF;
+   foreach my $byte (unpack ('C*', $data))
+   {
+      $crc ^= $byte;
+      $crc = ($crc & 1) ? (($crc >> 1) ^ 0xEDB88320) : ($crc >> 1) for (1..8);
+   }
+   return ~$crc & 0xFFFFFFFF;
+}
+
+sub varint
+{
+   my $value = shift;
+   my $out = '';
+   while ($value >= 0x80)
+   {
+      $out .= chr(($value & 0x7F) | 0x80);
+      $value >>= 7;
+   }
+   return $out . chr($value);
+}
+
+sub move
+{
+   my $move = shift;
+   return varint($move < 0 ? -$move * 2 - 1 : $move * 2);
+}
+
+# Walk forward from a source and target place while the bytes mostly agree.
+# Returns the region length and how many bytes in it match.
+sub extend
+{
+   my ($old, $new, $s, $t) = @_;
+   my ($i, $last, $matches) = (0, -1, 0);
+   my $limit = length($old) - $s;
+   $limit = length($new) - $t if length($new) - $t < $limit;
+   for ($i = 0; $i < $limit && $i - $last <= MAX_GAP; $i++)
+   {
+      next if substr($old, $s + $i, 1) ne substr($new, $t + $i, 1);
+      $last = $i;
+      $matches++;
+   }
+   return ($last + 1, $matches);
+}
+
+sub region
+{
+   my ($old, $new, $move, $s, $t, $length) = @_;
+   my @runs;
+   my $i = 0;
+   while ($i < $length)
+   {
+      if (substr($old, $s + $i, 1) eq substr($new, $t + $i, 1))
+      {
+         $i++;
+         next;
+      }
+      my $start = $i;
+      $i++ while ($i < $length && substr($old, $s + $i, 1) ne substr($new, $t + $i, 1));
+      push (@runs, [$start, $i - $start]);
+   }
+   return chr(OP_COPY) . move($move) . varint($length) unless @runs;
+
+   my $out = chr(OP_EDIT) . move($move) . varint($length) . varint(scalar @runs);
+   my $end = 0;
+   foreach my $run (@runs)
+   {
+      $out .= varint($run->[0] - $end) . varint($run->[1]) . substr($new, $t + $run->[0], $run->[1]);
+      $end = $run->[0] + $run->[1];
+   }
+   return $out;
+}
+
+# Greedy: carry on from where the last region ended in the source, or jump
+# to wherever the next block of the target is found. Bytes neither covers
+# go in as literals.
+sub make_patch
+{
+   my ($old, $new) = @_;
+   my %index;
+   for (my $s = 0; $s + BLOCK <= length $old; $s++)
+   {
+      my $list = $index{substr($old, $s, BLOCK)} ||= [];
+      push (@$list, $s) if @$list < CANDIDATES;
+   }
+
+   my $patch = pack ('V5', MAGIC, length $old, crc32($old), length $new, crc32($new));
+   my ($t, $sourceEnd, $align) = (0, 0, 0);
+   my $literal = '';
+   while ($t < length $new)
+   {
+      my @candidates = ($t + $align);
+      push (@candidates, @{$index{substr($new, $t, BLOCK)} || []}) if $t + BLOCK <= length $new;
+      my ($best, $bestLength, $bestMatches) = (undef, 0, 0);
+      foreach my $s (@candidates)
+      {
+         next if $s < 0 || $s >= length $old;
+         my ($length, $matches) = extend($old, $new, $s, $t);
+         next if $matches < MIN_MATCHES || $matches * 2 < $length;
+         ($best, $bestLength, $bestMatches) = ($s, $length, $matches) if $matches > $bestMatches;
+      }
+      unless (defined $best)
+      {
+         $literal .= substr($new, $t++, 1);
+         next;
+      }
+      $patch .= chr(OP_INSERT) . varint(length $literal) . $literal if length $literal;
+      $literal = '';
+      $patch .= region($old, $new, $best - $sourceEnd, $best, $t, $bestLength);
+      $sourceEnd = $best + $bestLength;
+      $align = $best - $t;
+      $t += $bestLength;
+   }
+   $patch .= chr(OP_INSERT) . varint(length $literal) . $literal if length $literal;
+   return $patch . chr(OP_END);
+}
+
+# Reference for the flight code, dies on anything it would refuse
+sub apply_patch
+{
+   my ($old, $patch) = @_;
+   my $pos = 0;
+   my $byte = sub {
+      die "Patch is truncated\n" if $pos >= length $patch;
+      return ord(substr($patch, $pos++, 1));
+   };
+   my $number = sub {
+      my ($value, $shift, $b) = (0, 0);
+      do { $b = $byte->(); $value |= ($b & 0x7F) << $shift; $shift += 7; } while ($b & 0x80);
+      return $value;
+   };
+   my $bytes = sub {
+      my $count = shift;
+      die "Patch is truncated\n" if $pos + $count > length $patch;
+      $pos += $count;
+      return substr($patch, $pos - $count, $count);
+   };
+
+   my ($magic, $oldSize, $oldCrc, $newSize, $newCrc) = unpack ('V5', $bytes->(20));
+   die "Not a patch\n" unless $magic == MAGIC;
+   die "Patch was made against a different image\n" unless $oldSize == length $old && $oldCrc == crc32($old);
+
+   my ($new, $s) = ('', 0);
+   for (;;)
+   {
+      my $op = $byte->();
+      last if $op == OP_END;
+      if ($op == OP_INSERT)
+      {
+         $new .= $bytes->($number->());
+         next;
+      }
+      die "Unknown opcode $op\n" unless $op == OP_COPY || $op == OP_EDIT;
+      my $zigzag = $number->();
+      $s += ($zigzag & 1) ? -(($zigzag + 1) >> 1) : $zigzag >> 1;
+      my $length = $number->();
+      die "Region outside the image\n" if $s < 0 || $s + $length > length $old;
+      my $region = substr($old, $s, $length);
+      if ($op == OP_EDIT)
+      {
+         my $at = 0;
+         for (1..$number->())
+         {
+            $at += $number->();
+            my $run = $number->();
+            substr($region, $at, $run) = $bytes->($run);
+            $at += $run;
+         }
+      }
+      $new .= $region;
+      $s += $length;
+   }
+   die "Result is the wrong size\n" unless length $new == $newSize;
+   die "Result fails its CRC\n" unless crc32($new) == $newCrc;
+   return $new;
+}
+
+sub read_image
+{
+   my $file = shift;
+   open (my $fh, '<', $file) or die "Can not open $file: $!\n";
+   binmode $fh;
+   local $/;
+   my $data = <$fh>;
+   close $fh;
+   return $data;
+}
+
+sub write_image
+{
+   my ($file, $data) = @_;
+   open (my $fh, '>', $file) or die "Can not write $file: $!\n";
+   binmode $fh;
+   print $fh $data;
+   close $fh;
+}
+
+1;
@@ -0,0 +1,79 @@
+#!perl
+
+use strict;
+use warnings;
+use Test::More 'no_plan';
+my @subs = qw (crc32 make_patch apply_patch read_image write_image);
+use_ok( 'delta_make',@subs) or exit;
+
+# Basics
+# ------
+ok (delta_make::crc32('123456789') == 0xCBF43926, 'crc32: Check value');
+ok (delta_make::crc32('56789', delta_make::crc32('1234')) == 0xCBF43926, 'crc32: Chains');
+
+my $old = 'the quick brown fox jumps over the lazy dog ' x 8;
+my $new = $old;
+substr($new, 50, 5) = 'crown';
+substr($new, 200, 0) = 'and then sat down ';
+my $patch = delta_make::make_patch($old, $new);
+ok (delta_make::apply_patch($old, $patch) eq $new, 'make_patch: Round trip on text');
+ok (delta_make::apply_patch($new, delta_make::make_patch($new, '')) eq '', 'make_patch: Empty target');
+ok (!eval { delta_make::apply_patch($new, $patch); 1 }, 'apply_patch: Wrong source is refused');
+ok (!eval { delta_make::apply_patch($old, substr($patch, 0, -1)); 1 }, 'apply_patch: Truncated patch is refused');
+
+# Firmware images
+# ---------------
+# ARM code with calls every few words, literal pools of addresses into the
+# image and RAM, and strings at the end. Each change below mimics one rebuild.
+sub image
+{
+   my (%opt) = @_;
+   my $size = $opt{size};
+   my $shiftAt = $opt{shift_at} // $size;
+   my $shift = $opt{shift} // 0;
+   my $seed = 4321;
+   my @words;
+   for (my $offset = 0; $offset < $size; $offset += 4)
+   {
+      $seed = ($seed * 1103515245 + 12345) & 0x7FFFFFFF;
+      my $word;
+      if ($offset % 64 == 60)
+      {
+         my $to = ($seed >> 4) % $size;
+         $to += $shift if $to >= $shiftAt;
+         $word = ($seed & 1) ? 0x40000000 + ($seed >> 8) % 0x10000 : $to;
+      }
+      elsif ($offset % 16 == 8)
+      {
+         my $to = (($seed >> 4) % $size) & ~3;
+         my $from = $offset + (($offset >= $shiftAt) ? $shift : 0);
+         $to += $shift if $to >= $shiftAt;
+         $word = 0xEB000000 | ((($to - $from - 8) >> 2) & 0xFFFFFF);
+      }
+      else
+      {
+         $word = 0xE0000000 | ($seed & 0x0FFFFFFF);
+      }
+      $word = $opt{edit}->($offset, $word) if $opt{edit};
+      push (@words, $word);
+   }
+   my $code = pack ('V*', @words);
+   substr($code, $shiftAt, 0) = pack ('V*', map { 0xE1A00000 | $_ } 1..($shift / 4)) if $shift;
+   return $code . join ('', map { "telemetry channel $_ out of range\0" } 1..200);
+}
+
+my $base = image(size => 64 * 1024);
+my %changes = (
+   'constant changed'  => image(size => 64 * 1024, edit => sub { $_[0] == 0x4000 ? 0xE3A00005 : $_[1] }),
+   'function inserted' => image(size => 64 * 1024, shift_at => 0x6000, shift => 256),
+   'string reworded'   => do { my $i = $base; substr($i, -2000, 9) = 'telemetry'; substr($i, -2000, 9) = 'TELEMETRY'; $i },
+);
+foreach my $name (sort keys %changes)
+{
+   my $target = $changes{$name};
+   my $patch = delta_make::make_patch($base, $target);
+   ok (delta_make::apply_patch($base, $patch) eq $target, "make_patch: Round trip, $name");
+   diag (sprintf ("%-18s image %6d bytes  patch %6d bytes  %5.1f%%",
+                  $name, length $target, length $patch, 100 * length($patch) / length($target)));
+   ok (length($patch) * 10 < length($target), "make_patch: Under a tenth of the image, $name");
+}
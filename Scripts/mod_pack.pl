@@ -0,0 +1,67 @@
+use strict;
+use warnings;
+use Getopt::Long;
+use mod_pack qw(pack_module read_module);
+
+my $entry   = 0;
+my $bss     = 0;
+my $exports = 1;
+my $delta   = mod_pack::DELTA;
+
+unless ( GetOptions ('entry=o' => \$entry, 'bss=o' => \$bss, 'exports=i' => \$exports, 'delta=o' => \$delta)
+         && @ARGV == 3 )
+{
+   usage();
+   exit 0;
+}
+
+my ($lowFile, $highFile, $outFile) = @ARGV;
+my $module = pack_module(read_file($lowFile), read_file($highFile),
+                         entry => $entry, bss => $bss, exports => $exports, delta => $delta);
+my $parsed = read_module($module);
+
+open (my $fh, '>', $outFile) or die "Can not write $outFile: $!\n";
+binmode $fh;
+print $fh $module;
+close $fh;
+
+printf <<MOO_SQUID, length $parsed->{image}, $parsed->{bss}, scalar @{$parsed->{relocs}}, $parsed->{entry}, length $module;
+Module
+------
+Code and data     : %d bytes
+Bss               : %d bytes
+Relocations       : %d
+Entry             : 0x%X
+Object to upload  : %d bytes
+MOO_SQUID
+exit 0;
+
+sub read_file
+{
+   my $file = shift;
+   open (my $fh, '<', $file) or die "Can not open $file: $!\n";
+   binmode $fh;
+   local $/;
+   my $data = <$fh>;
+   close $fh;
+   return $data;
+}
+
+sub usage
+{
+   print <<MOO_SQUID;
+Bluesat Loadable Module Packer
+------------------------------
+   perl mod_pack.pl [--entry offset] [--bss size] [--exports version]
+                    [--delta 0x10000] <module at 0> <module at delta> <out>
+
+   Links of the same module at address 0 and at delta, as raw binaries
+with code then initialised data, are compared word by word to find the
+relocations. Build with -fPIC so only pointers in data and literal pools
+change. Upload the result to the module service and load it from there.
+
+Example: arm-elf-objcopy -O binary payload0.elf payload0.bin
+         arm-elf-objcopy -O binary payload1.elf payload1.bin
+         perl mod_pack.pl --bss 0x120 payload0.bin payload1.bin payload.mod
+MOO_SQUID
+}
@@ -0,0 +1,71 @@
+package mod_pack;
+
+use strict;
+use Exporter;
+use vars qw($VERSION @ISA @EXPORT @EXPORT_OK %EXPORT_TAGS);
+use constant {
+        MAGIC          => 0x31444F4D,  # "MOD1", same as Libraries/module
+        HEADER_SIZE    => 24,
+        DELTA          => 0x10000      # second link address
+    };
+$VERSION     = 1.00;
+@ISA         = qw(Exporter);
+@EXPORT      = ();
+@EXPORT_OK   = qw( pack_module read_module load_module);
+
+# The module linked at 0 and at DELTA. Words that differ by exactly DELTA
+# hold addresses inside the module, any other difference means the code
+# is not position independent and can not be loaded.
+sub pack_module
+{
+   my ($low, $high, %opt) = @_;
+   my $delta = $opt{delta} // DELTA;
+   die "Images differ in size\n" unless length $low == length $high;
+   $low  .= "\0" x (-length($low) % 4);
+   $high .= "\0" x (-length($high) % 4);
+   my @low  = unpack ('V*', $low);
+   my @high = unpack ('V*', $high);
+   my @relocs;
+   for my $index (0..$#low)
+   {
+      next if $low[$index] == $high[$index];
+      die sprintf ("Word at 0x%X is not relocatable\n", $index * 4)
+         unless (($high[$index] - $low[$index]) & 0xFFFFFFFF) == $delta;
+      push (@relocs, $index * 4);
+   }
+   my $entry = $opt{entry} // 0;
+   die "Entry is outside the module\n" unless ($entry & ~1) < length $low;
+   return pack ('V6', MAGIC, length $low, $opt{bss} // 0, $entry, scalar @relocs, $opt{exports} // 1)
+          . $low . pack ('V*', @relocs);
+}
+
+sub read_module
+{
+   my $module = shift;
+   die "Module is too short\n" if length $module < HEADER_SIZE;
+   my ($magic, $size, $bss, $entry, $count, $exports) = unpack ('V6', $module);
+   die "Not a module\n" unless $magic == MAGIC;
+   die "Module size does not match its header\n" unless length $module == HEADER_SIZE + $size + 4 * $count;
+   return {
+            image   => substr($module, HEADER_SIZE, $size),
+            bss     => $bss,
+            entry   => $entry,
+            exports => $exports,
+            relocs  => [ unpack ('V*', substr($module, HEADER_SIZE + $size)) ]
+          };
+}
+
+# What the loader leaves in memory at base, bss included
+sub load_module
+{
+   my ($module, $base) = @_;
+   my $parsed = read_module($module);
+   my $image = $parsed->{image};
+   foreach my $offset (@{$parsed->{relocs}})
+   {
+      substr($image, $offset, 4) = pack ('V', (unpack ('V', substr($image, $offset, 4)) + $base) & 0xFFFFFFFF);
+   }
+   return $image . ("\0" x (($parsed->{bss} + 3) & ~3));
+}
+
+1;
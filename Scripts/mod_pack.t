@@ -0,0 +1,35 @@
+#!perl
+
+use strict;
+use warnings;
+use Test::More 'no_plan';
+my @subs = qw (pack_module read_module load_module);
+use_ok( 'mod_pack',@subs) or exit;
+
+# A module as linked at a given base: code, a literal pool pointing at a
+# string and a function, then a data table of pointers
+sub link_at
+{
+   my $base = shift;
+   my @words = map { 0xE1A00000 | $_ } 0..15;
+   $words[6] = $base + 0x48;            # literal pool, string address
+   $words[7] = ($base + 0x10) | 1;      # thumb function pointer
+   my $data = pack ('V3', $base + 0x10, $base + 0x20, 7);
+   return pack ('V*', @words) . "hello\0\0\0" . $data;
+}
+
+my $module = mod_pack::pack_module(link_at(0), link_at(0x10000), bss => 10, entry => 0x11, exports => 2);
+my $parsed = mod_pack::read_module($module);
+ok (length $module == 24 + 84 + 4 * 4, 'pack_module: Object size');
+is_deeply ($parsed->{relocs}, [24, 28, 72, 76], 'pack_module: Relocations found');
+ok ($parsed->{entry} == 0x11 && $parsed->{bss} == 10 && $parsed->{exports} == 2, 'pack_module: Header fields');
+ok (mod_pack::load_module($module, 0x81004000) eq link_at(0x81004000) . ("\0" x 12), 'load_module: Same as linking there');
+
+# relocation adds with wrap around like the target does
+ok (mod_pack::load_module($module, 0xFFFFFF00) eq link_at(0xFFFFFF00) . ("\0" x 12), 'load_module: Wraps at 32 bits');
+
+my $broken = link_at(0x10000);
+substr($broken, 8, 4) = pack ('V', 0x12345678);
+ok (!eval { mod_pack::pack_module(link_at(0), $broken); 1 }, 'pack_module: Absolute code is refused');
+ok (!eval { mod_pack::pack_module(link_at(0), link_at(0x10000), entry => 84); 1 }, 'pack_module: Entry outside is refused');
+ok (!eval { mod_pack::read_module(substr($module, 0, -2)); 1 }, 'read_module: Truncated module is refused');